@@ -50,6 +50,10 @@ protected:
 
         editor->update();
 
+        // The scene view and the game cameras share the snapshot taken after the scene update.
+        engine->update_scene();
+        editor->render_views();
+
         engine->frame_end();
     }
 
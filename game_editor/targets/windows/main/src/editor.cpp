@@ -31,6 +31,7 @@
 #include "editor_windows/geometry_buffer_inspector_window.hpp"
 #include "editor_windows/log_window.hpp"
 #include "editor_windows/material_editor_window.hpp"
+#include "editor_windows/resource_memory_window.hpp"
 #include "editor_windows/scene_hierarchy_window.hpp"
 #include "editor_windows/scene_view_window.hpp"
 
@@ -50,7 +51,8 @@ Editor::Editor(Engine *engine)
         return std::make_unique<SceneViewWindow>(engine->window().graphics(),
                                                  engine->world_module().scene(), engine->scene_renderer(),
                                                  engine->resources(),
-                                                 *scene_gizmo_, component_registry_impl());
+                                                 *scene_gizmo_, component_registry_impl(),
+                                                 engine->scene_spatial_index(), scene_view_window_);
     });
 
     window_manager().register_window<SceneHierarchyWindow>([=]() {
@@ -81,6 +83,10 @@ Editor::Editor(Engine *engine)
         return std::make_unique<GeometryBufferInspectorWindow>(engine->scene_rendering_context());
     });
 
+    window_manager().register_window<ResourceMemoryWindow>([=]() {
+        return std::make_unique<ResourceMemoryWindow>(engine->resource_residency());
+    });
+
     register_menu_item("Window/Control", [=]() {
         auto &window = window_manager().get_window<ControlWindow>();
         window.focus();
@@ -121,6 +127,11 @@ Editor::Editor(Engine *engine)
         window.focus();
     });
 
+    register_menu_item("Window/Resource Memory", [&]() {
+        auto &window = window_manager().get_window<ResourceMemoryWindow>();
+        window.focus();
+    });
+
     {
         using namespace component_editors;
 
@@ -258,3 +269,9 @@ void Editor::update() {
         ImGui::ShowDemoWindow(&open);
     }
 }
+
+void Editor::render_views() {
+    if (scene_view_window_) {
+        scene_view_window_->render();
+    }
+}
@@ -11,6 +11,8 @@
 #include "editor_gui.hpp"
 #include "scene_gizmo_impl.hpp"
 
+class SceneViewWindow;
+
 class Editor final : public nodec_scene_editor::impl::SceneEditorImpl {
 public:
     enum class Mode {
@@ -56,6 +58,11 @@ public:
 
     void update();
 
+    /**
+     * @brief Renders the scene view. Call it after Engine::update_scene(), so it shares the snapshot of the game cameras.
+     */
+    void render_views();
+
     State state() const noexcept {
         return state_;
     }
@@ -67,6 +74,9 @@ private:
     bool do_one_step_{false};
     std::unique_ptr<EditorGui> editor_gui_;
     std::unique_ptr<SceneGizmoImpl> scene_gizmo_;
+
+    //! The scene view window, or nullptr while it does not exist.
+    SceneViewWindow *scene_view_window_{nullptr};
 };
 
 #endif
\ No newline at end of file
@@ -25,7 +25,7 @@ public:
                 // if empty, set resource to null.
                 resource.reset();
             } else {
-                auto new_resource = resources_.registry().get_resource<T>(new_name).get();
+                auto new_resource = resources_.registry().get_resource_direct<T>(new_name);
                 resource = new_resource ? new_resource : resource;
             }
         }
@@ -6,6 +6,16 @@
 void GeometryBufferInspectorWindow::on_gui() {
     ImGui::Text("Geometry Buffer Count: %d", rendering_context_.geometry_buffer_count());
 
+    {
+        const auto stats = rendering_context_.render_target_stats();
+        constexpr float MIB = 1024.0f * 1024.0f;
+        ImGui::Text("Pooled Textures: %d", static_cast<int>(stats.texture_count));
+        ImGui::Text("Allocated: %.1f MiB", stats.allocated_bytes / MIB);
+        ImGui::Text("Requested: %.1f MiB", stats.requested_bytes / MIB);
+        ImGui::Text("Saved: %.1f MiB", stats.saved_bytes() / MIB);
+    }
+    ImGui::Separator();
+
     for (auto iter = rendering_context_.shader_resource_view_begin();
          iter != rendering_context_.shader_resource_view_end(); ++iter) {
         auto &name = iter->first;
@@ -88,7 +88,7 @@ void MaterialEditorWindow::on_gui() {
 
     auto &buffer = imessentials::get_text_buffer(1024, material_name);
     if (ImGui::InputText("Target", buffer.data(), buffer.size(), ImGuiInputTextFlags_EnterReturnsTrue)) {
-        target_material_ = resources_.registry().get_resource<Material>(buffer.data()).get();
+        target_material_ = resources_.registry().get_resource_direct<Material>(buffer.data());
     }
 
     ImGui::Separator();
@@ -108,7 +108,7 @@ void MaterialEditorWindow::on_gui() {
             if (new_name.empty()) {
                 target_material_->set_shader(nullptr);
             } else {
-                auto shader_to_set = resources_.registry().get_resource<Shader>(new_name).get();
+                auto shader_to_set = resources_.registry().get_resource_direct<Shader>(new_name);
                 if (shader_to_set) target_material_->set_shader(shader_to_set);
             }
         }
@@ -204,7 +204,7 @@ void MaterialEditorWindow::on_gui() {
                     if (new_name.empty()) {
                         current.texture.reset();
                     } else {
-                        auto texture_to_set = resources_.registry().get_resource<Texture>(new_name).get();
+                        auto texture_to_set = resources_.registry().get_resource_direct<Texture>(new_name);
 
                         if (texture_to_set) current.texture = texture_to_set;
                     }
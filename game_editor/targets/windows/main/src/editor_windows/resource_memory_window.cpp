@@ -0,0 +1,61 @@
+#include "resource_memory_window.hpp"
+
+#include <algorithm>
+
+void ResourceMemoryWindow::on_gui() {
+    constexpr float MIB = 1024.0f * 1024.0f;
+
+    ImGui::Text("Resources: %d", static_cast<int>(residency_.count()));
+    ImGui::Text("Total: %.1f MiB", residency_.total_bytes() / MIB);
+    ImGui::Text("Evicted: %llu", static_cast<unsigned long long>(residency_.evicted_count()));
+
+    {
+        // Zero keeps no unreferenced resource.
+        float budget = residency_.budget() / MIB;
+        if (ImGui::InputFloat("Budget (MiB)", &budget, 16.0f, 128.0f, "%.0f", ImGuiInputTextFlags_EnterReturnsTrue)) {
+            residency_.set_budget(static_cast<std::uint64_t>((std::max)(0.0f, budget) * MIB));
+        }
+    }
+    ImGui::Separator();
+
+    if (ImGui::BeginTable("resource-types", 3)) {
+        ImGui::TableSetupColumn("Type");
+        ImGui::TableSetupColumn("Count");
+        ImGui::TableSetupColumn("MiB");
+        ImGui::TableHeadersRow();
+
+        for (const auto &usage : residency_.bytes_by_type()) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(usage.type.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", static_cast<int>(usage.count));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", usage.bytes / MIB);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Separator();
+
+    ImGui::InputInt("Largest", &largest_count_);
+    largest_count_ = (std::max)(0, largest_count_);
+
+    if (ImGui::BeginTable("resource-largest", 3)) {
+        ImGui::TableSetupColumn("Path");
+        ImGui::TableSetupColumn("MiB");
+        ImGui::TableSetupColumn("In Use");
+        ImGui::TableHeadersRow();
+
+        for (const auto &entry : residency_.largest(static_cast<std::size_t>(largest_count_))) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(entry.path.c_str());
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", entry.type.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", entry.bytes / MIB);
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(entry.referenced ? "Yes" : "No");
+        }
+        ImGui::EndTable();
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef NODEC_GAME_EDITOR__EDITOR_WINDOWS__RESOURCE_MEMORY_WINDOW_HPP_
+#define NODEC_GAME_EDITOR__EDITOR_WINDOWS__RESOURCE_MEMORY_WINDOW_HPP_
+
+#include <imgui.h>
+
+#include <imessentials/window.hpp>
+
+#include <resources/resource_residency.hpp>
+
+class ResourceMemoryWindow : public imessentials::BaseWindow {
+public:
+    ResourceMemoryWindow(ResourceResidency &residency)
+        : BaseWindow("Resource Memory", nodec::Vector2f(400, 500)),
+          residency_(residency) {
+    }
+
+    void on_gui() override;
+
+private:
+    ResourceResidency &residency_;
+    int largest_count_{20};
+};
+
+#endif
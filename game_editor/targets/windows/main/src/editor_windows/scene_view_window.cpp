@@ -9,10 +9,13 @@
 
 SceneViewWindow::SceneViewWindow(
     Graphics &gfx, nodec_scene::Scene &scene, SceneRenderer &renderer, nodec_resources::Resources &resources,
-    SceneGizmoImpl &scene_gizmo, nodec_scene_editor::ComponentRegistry &component_registry)
+    SceneGizmoImpl &scene_gizmo, nodec_scene_editor::ComponentRegistry &component_registry,
+    const SceneSpatialIndex &spatial_index, SceneViewWindow *&active_window)
     : BaseWindow("Scene View##EditorWindows", nodec::Vector2f(VIEW_WIDTH, VIEW_HEIGHT)),
       scene_gizmo_(scene_gizmo), component_registry_(component_registry), resources_(resources),
-      scene_(scene), renderer_(renderer) {
+      spatial_index_(spatial_index), active_window_(active_window), scene_(scene), renderer_(renderer) {
+    active_window_ = this;
+
     // Generate the render target textures.
     D3D11_TEXTURE2D_DESC texture_desc{};
     texture_desc.Width = VIEW_WIDTH;
@@ -74,6 +77,12 @@ SceneViewWindow::SceneViewWindow(
     }
 }
 
+SceneViewWindow::~SceneViewWindow() {
+    if (active_window_ == this) {
+        active_window_ = nullptr;
+    }
+}
+
 void SceneViewWindow::on_gui() {
     using namespace nodec;
     using namespace DirectX;
@@ -188,21 +197,23 @@ void SceneViewWindow::on_gui() {
             view_ = math::inv(view_inverse_);
 
             camera_state_.update_transform(view_inverse_);
-
-            renderer_.render(scene_, camera_state_, render_target_view_.Get(), *rendering_context_);
         }
 
         {
+            // The gizmos are entities. They are replaced here, before the engine captures the scene,
+            // since the game cameras render after the scene view from the same snapshot.
             using namespace nodec_scene_editor;
+            scene_gizmo_renderer_->clear_gizmos(scene_);
             SceneGuiContext context{scene_.registry()};
             for (auto &pair : component_registry_) {
                 pair.second->editor().on_scene_gui(scene_gizmo_, context);
             }
-            scene_gizmo_renderer_->render(scene_, view_, projection_, *render_target_view_.Get(), *rendering_context_);
-            scene_gizmo_renderer_->clear_gizmos(scene_);
         }
+        render_requested_ = true;
 
+        const auto image_position = ImGui::GetCursorScreenPos();
         ImGui::Image((void *)shader_resource_view_.Get(), ImVec2(VIEW_WIDTH, VIEW_HEIGHT));
+        const bool image_clicked = ImGui::IsItemHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left);
 
         ImGuizmo::SetDrawlist();
         ImGuizmo::SetRect(ImGui::GetWindowPos().x, ImGui::GetWindowPos().y, VIEW_WIDTH, VIEW_HEIGHT);
@@ -227,6 +238,50 @@ void SceneViewWindow::on_gui() {
                 local_to_world->dirty = true;
             }
         }();
+
+        // The click on the gizmo belongs to the gizmo.
+        if (image_clicked && !ImGuizmo::IsOver() && !ImGuizmo::IsUsing()) {
+            pick_entity(ImVec2(io.MousePos.x - image_position.x, io.MousePos.y - image_position.y));
+        }
     }
     ImGui::EndChild();
 }
+
+void SceneViewWindow::render() {
+    if (!render_requested_) return;
+    render_requested_ = false;
+
+    renderer_.render(scene_, camera_state_, render_target_view_.Get(), *rendering_context_);
+    scene_gizmo_renderer_->render(scene_, view_, projection_, *render_target_view_.Get(), *rendering_context_);
+}
+
+void SceneViewWindow::pick_entity(const ImVec2 &mouse_position) {
+    using namespace DirectX;
+    using namespace nodec_scene;
+    using namespace nodec_scene_editor::components;
+
+    // Unproject the mouse position on the near and far planes.
+    const float x = mouse_position.x / VIEW_WIDTH * 2.0f - 1.0f;
+    const float y = 1.0f - mouse_position.y / VIEW_HEIGHT * 2.0f;
+    const auto matrix_vp_inverse = XMMatrixInverse(nullptr, camera_state_.matrix_v() * camera_state_.matrix_p());
+    const auto near_point = XMVector3TransformCoord(XMVectorSet(x, y, 0.0f, 1.0f), matrix_vp_inverse);
+    const auto far_point = XMVector3TransformCoord(XMVectorSet(x, y, 1.0f, 1.0f), matrix_vp_inverse);
+
+    XMFLOAT3 origin;
+    XMFLOAT3 direction;
+    XMStoreFloat3(&origin, near_point);
+    XMStoreFloat3(&direction, XMVectorSubtract(far_point, near_point));
+
+    auto &scene_registry = scene_.registry();
+
+    SceneEntity hit_entity{nodec::entities::null_entity};
+    float hit_distance;
+    if (!spatial_index_.raycast(origin, direction, 1.0f, hit_entity, hit_distance)) return;
+    if (!scene_registry.is_valid(hit_entity)) return;
+
+    {
+        auto view = scene_registry.view<Selected>();
+        scene_registry.remove_component<Selected>(view.begin(), view.end());
+    }
+    scene_registry.emplace_component<Selected>(hit_entity);
+}
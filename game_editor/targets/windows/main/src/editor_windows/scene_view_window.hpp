@@ -15,6 +15,7 @@
 
 #include <graphics/graphics.hpp>
 #include <rendering/scene_renderer.hpp>
+#include <rendering/scene_spatial_index.hpp>
 
 #include "../scene_gizmo_impl.hpp"
 #include "../scene_gizmo_renderer.hpp"
@@ -27,16 +28,39 @@ class SceneViewWindow final : public imessentials::BaseWindow {
 public:
     SceneViewWindow(Graphics &gfx, nodec_scene::Scene &scene, SceneRenderer &renderer,
                     nodec_resources::Resources &,
-                    SceneGizmoImpl &scene_gizmo, nodec_scene_editor::ComponentRegistry &component_regsitry);
+                    SceneGizmoImpl &scene_gizmo, nodec_scene_editor::ComponentRegistry &component_regsitry,
+                    const SceneSpatialIndex &spatial_index, SceneViewWindow *&active_window);
+
+    ~SceneViewWindow();
 
     void on_gui() override;
 
+    /**
+     * @brief Renders the scene and the gizmos seen from the camera moved in on_gui().
+     *
+     * It is called after Engine::update_scene(), so the view shares the snapshot of the game cameras.
+     * It does not change the registry.
+     */
+    void render();
+
+private:
+    /**
+     * @brief Selects the entity under the mouse by the world bounds in the spatial index.
+     *
+     * @param mouse_position The mouse position relative to the top left of the view.
+     */
+    void pick_entity(const ImVec2 &mouse_position);
+
 private:
     nodec_scene::Scene &scene_;
     SceneRenderer &renderer_;
     SceneGizmoImpl &scene_gizmo_;
     nodec_scene_editor::ComponentRegistry &component_registry_;
     nodec_resources::Resources &resources_;
+    const SceneSpatialIndex &spatial_index_;
+
+    //! Points to this window while it lives, so the editor can render it after the scene update.
+    SceneViewWindow *&active_window_;
 
     Microsoft::WRL::ComPtr<ID3D11Texture2D> texture_;
     Microsoft::WRL::ComPtr<ID3D11RenderTargetView> render_target_view_;
@@ -53,6 +77,9 @@ private:
     ImGuizmo::MODE gizmo_mode_{ImGuizmo::LOCAL};
 
     bool scene_view_dragging_{false};
+
+    //! Set by on_gui() when the view is shown in the frame.
+    bool render_requested_{false};
 };
 
 #endif
\ No newline at end of file
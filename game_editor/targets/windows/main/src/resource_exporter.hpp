@@ -13,6 +13,8 @@
 
 #include <nodec/resource_management/resource_registry.hpp>
 
+#include <rendering/mesh_file.hpp>
+
 #include <assimp/matrix4x4.h>
 #include <assimp/scene.h>
 
@@ -81,11 +83,11 @@ inline void ProcessNode(
         auto materialIndex = pScene->mMeshes[meshIndex]->mMaterialIndex;
 
         std::string meshPath = Formatter() << resource_name_prefix << nameMap.at(Formatter() << "mesh-" << meshIndex).target;
-        auto mesh = resourceRegistry.get_resource<Mesh>(meshPath).get();
+        auto mesh = resourceRegistry.get_resource_direct<Mesh>(meshPath);
         meshRenderer->meshes.push_back(mesh);
 
         std::string materialPath = Formatter() << resource_name_prefix << nameMap.at(Formatter() << "material-" << materialIndex).target;
-        auto material = resourceRegistry.get_resource<Material>(materialPath).get();
+        auto material = resourceRegistry.get_resource_direct<Material>(materialPath);
         meshRenderer->materials.push_back(material);
     }
 
@@ -98,7 +100,6 @@ inline void ProcessNode(
 
 inline bool ExportMesh(aiMesh *pMesh, const std::string &destPath) {
     using namespace nodec;
-    using namespace nodec_rendering::resources;
 
     std::ofstream out(destPath, std::ios::binary);
 
@@ -106,42 +107,62 @@ inline bool ExportMesh(aiMesh *pMesh, const std::string &destPath) {
         return false;
     }
 
-    // cereal::JSONOutputArchive archive(out);
-    cereal::PortableBinaryOutputArchive archive(out);
-
-    SerializableMesh mesh;
+    // The meshes are written in the mesh file, which the engine maps and uploads without parsing.
+    std::vector<CompactVertex> vertices;
+    vertices.reserve(pMesh->mNumVertices);
 
+    Vector3f min, max;
     for (unsigned int i = 0; i < pMesh->mNumVertices; ++i) {
         auto &position = pMesh->mVertices[i];
         auto &normal = pMesh->mNormals[i];
 
-        SerializableMesh::Vertex vert;
-        vert.position.set(position.x, position.y, position.z);
-        vert.normal.set(normal.x, normal.y, normal.z);
-
+        Vector2f uv;
         if (pMesh->mTextureCoords[0]) {
-            auto &uv = pMesh->mTextureCoords[0][i];
-            vert.uv.set(uv.x, uv.y);
+            auto &source_uv = pMesh->mTextureCoords[0][i];
+            uv.set(source_uv.x, source_uv.y);
         }
 
+        Vector3f tangent;
         if (pMesh->mTangents) {
-            auto &tangent = pMesh->mTangents[i];
-            vert.tangent.set(tangent.x, tangent.y, tangent.z);
+            auto &source_tangent = pMesh->mTangents[i];
+            tangent.set(source_tangent.x, source_tangent.y, source_tangent.z);
+        }
+
+        const Vector3f vertex_position(position.x, position.y, position.z);
+        vertices.push_back(pack_compact_vertex(vertex_position, Vector3f(normal.x, normal.y, normal.z), uv, tangent));
+
+        if (i == 0) {
+            min = max = vertex_position;
+            continue;
         }
-        mesh.vertices.push_back(vert);
+        min.set((std::min)(min.x, position.x), (std::min)(min.y, position.y), (std::min)(min.z, position.z));
+        max.set((std::max)(max.x, position.x), (std::max)(max.y, position.y), (std::max)(max.z, position.z));
     }
 
+    std::vector<std::uint32_t> triangles;
+    triangles.reserve(static_cast<std::size_t>(pMesh->mNumFaces) * 3);
     for (unsigned int i = 0; i < pMesh->mNumFaces; ++i) {
         // 3 indices per face
         auto &face = pMesh->mFaces[i];
 
         assert(face.mNumIndices == 3 && "Only 3 indices available. Make sure to set aiProcess_Triangulate on call Assimp::Importer::ReadFile.");
         for (unsigned int j = 0; j < face.mNumIndices; ++j) {
-            mesh.triangles.emplace_back(face.mIndices[j]);
+            triangles.push_back(face.mIndices[j]);
         }
     }
 
-    archive(cereal::make_nvp("mesh", mesh));
+    gfx::BoundingBox bounds;
+    bounds.center = (min + max) / 2.0f;
+    bounds.extents = (max - min) / 2.0f;
+
+    try {
+        mesh_file::write_mesh_file(out, VertexFormat::Compact,
+                                   vertices.data(), static_cast<std::uint32_t>(vertices.size()),
+                                   triangles.data(), static_cast<std::uint32_t>(triangles.size()),
+                                   bounds);
+    } catch (...) {
+        return false;
+    }
 
     return true;
 }
@@ -100,8 +100,9 @@ void SceneGizmoRenderer::render(nodec_scene::Scene &scene,
             }
 
             auto *mesh_backend = static_cast<MeshBackend *>(wire.mesh.get());
+            gizmo_wire_shader->bind_input_layout(mesh_backend->vertex_format);
             mesh_backend->bind(&gfx_);
-            device_context.DrawIndexed(mesh_backend->triangles.size(), 0, 0);
+            device_context.DrawIndexed(mesh_backend->index_count(), 0, 0);
         });
 }
 
@@ -0,0 +1,39 @@
+// --- HLSL Shader Instancing Interface ---
+// The instanced vertex shaders (<pass>_vs_instanced.hlsl, vertex_instanced.hlsl) include this interface.
+//
+// The model matrices are streamed per instance instead of through cbModelProperties.
+// The matrices are stored as the rows of the row-major (DirectXMath) representation,
+// so they are multiplied from the right side of the row vector.
+
+struct InstanceIn
+{
+    float4 matrixM0 : INSTANCE_MATRIX_M0;
+    float4 matrixM1 : INSTANCE_MATRIX_M1;
+    float4 matrixM2 : INSTANCE_MATRIX_M2;
+    float4 matrixM3 : INSTANCE_MATRIX_M3;
+    float4 matrixMInverse0 : INSTANCE_MATRIX_M_INVERSE0;
+    float4 matrixMInverse1 : INSTANCE_MATRIX_M_INVERSE1;
+    float4 matrixMInverse2 : INSTANCE_MATRIX_M_INVERSE2;
+    float4 matrixMInverse3 : INSTANCE_MATRIX_M_INVERSE3;
+};
+
+float4x4 InstanceMatrixM(InstanceIn instance)
+{
+    return float4x4(instance.matrixM0, instance.matrixM1, instance.matrixM2, instance.matrixM3);
+}
+
+float3x3 InstanceMatrixMInverse3x3(InstanceIn instance)
+{
+    return float3x3(instance.matrixMInverse0.xyz, instance.matrixMInverse1.xyz, instance.matrixMInverse2.xyz);
+}
+
+// Same as ModelToWorldNormal() for the instanced model matrix.
+float3 InstanceModelToWorldNormal(InstanceIn instance, float3 normal)
+{
+    return normalize(mul(InstanceMatrixMInverse3x3(instance), normal));
+}
+
+float4 WorldToClipPosition(float4 worldPos)
+{
+    return mul(sceneProperties.matrixP, mul(sceneProperties.matrixV, worldPos));
+}
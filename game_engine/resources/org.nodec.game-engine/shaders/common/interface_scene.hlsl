@@ -14,14 +14,21 @@ struct PointLight {
     float intensity;
 };
 
-#define MAX_NUM_OF_POINT_LIGHTS 1024
-
+// The point lights are bound as a structured buffer by the shaders which need them.
 struct SceneLighting
 {
     float4 ambientColor;
     int numOfPointLights;
     DirectionalLight directional;
-    PointLight pointLights[MAX_NUM_OF_POINT_LIGHTS];
+};
+
+// The layout of the point light clusters.
+// The depth slice of the view-space depth z is floor(log(z) * zSliceScale + zSliceBias).
+struct LightClusters
+{
+    uint3 clusterCount;
+    float zSliceScale;
+    float zSliceBias;
 };
 
 struct SceneProperties
@@ -31,6 +38,7 @@ struct SceneProperties
     float4x4 matrixPInverse;
     float4x4 matrixV;
     float4x4 matrixVInverse;
+    LightClusters clusters;
     SceneLighting lights;
 };
 
@@ -0,0 +1,18 @@
+// --- HLSL Shader Sprite Interface ---
+// The sprite vertex shaders (<pass>_vs_sprite.hlsl, vertex_sprite.hlsl) include this interface.
+//
+// The quads of a sprite batch are already transformed into the world space on the CPU,
+// so the model properties are not used. Each vertex carries the color of its sprite.
+
+struct SpriteIn
+{
+    float3 position : POSITION;
+    float3 normal : NORMAL;
+    float2 texcoord : TEXCOORD0;
+    float4 color : COLOR0;
+};
+
+float4 SpriteWorldToClipPosition(float4 worldPos)
+{
+    return mul(sceneProperties.matrixP, mul(sceneProperties.matrixV, worldPos));
+}
@@ -8,6 +8,7 @@ struct V2P {
     float3 position_world : POSITION;
     float3 normal_world : NORMAL;
     float4 depth : TEXCOORD1;
+    float4 color : COLOR0;
 };
 
 struct MaterialProperties {
@@ -10,7 +10,7 @@
 PSOut PSMain(V2P input) : SV_Target {
     PSOut output;
 
-    float4 color = materialProperties.color;
+    float4 color = materialProperties.color * input.color;
 
     if (textureConfig.texHasFlag & 0x01) {
         float4 pixel = texImage.Sample(sampler_texImage, input.texcoord);
@@ -18,6 +18,9 @@ V2P VSMain(VSIn input) {
 
     output.texcoord = input.texcoord;
 
+    // The color of the single image is given by the material.
+    output.color = float4(1, 1, 1, 1);
+
     output.depth = output.position;
 
     return output;
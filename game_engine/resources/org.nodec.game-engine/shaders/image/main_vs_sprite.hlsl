@@ -0,0 +1,25 @@
+#include "interface.hlsl"
+#include "../common/interface_sprite.hlsl"
+
+V2P VSMain(SpriteIn input) {
+    V2P output;
+
+    const float4 pos = float4(input.position, 1);
+    output.position = SpriteWorldToClipPosition(pos);
+    output.position_world = input.position;
+
+    float3 normal_world = input.normal;
+    float3 forward_camera = normalize(sceneProperties.cameraPos.xyz - output.position_world);
+
+    if (dot(normal_world, forward_camera) < 0) {
+        normal_world = -normal_world;
+    }
+    output.normal_world = normal_world;
+
+    output.texcoord = input.texcoord;
+    output.color = input.color;
+
+    output.depth = output.position;
+
+    return output;
+}
\ No newline at end of file
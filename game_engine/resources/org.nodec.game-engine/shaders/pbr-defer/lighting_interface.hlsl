@@ -7,6 +7,21 @@ Texture2D texDepth : register(t3);
 
 SamplerState sampler_tex : register(s0);
 
+StructuredBuffer<PointLight> pointLights : register(t18);
+
+// (offset, count) into clusterLightIndices for each cluster.
+StructuredBuffer<uint2> clusterRanges : register(t16);
+StructuredBuffer<uint> clusterLightIndices : register(t17);
+
+uint ClusterIndex(const in float2 uv, const in float viewDepth) {
+    const uint3 count = sceneProperties.clusters.clusterCount;
+    const uint x = min((uint)(uv.x * count.x), count.x - 1);
+    const uint y = min((uint)(uv.y * count.y), count.y - 1);
+    const float slice = floor(log(viewDepth) * sceneProperties.clusters.zSliceScale + sceneProperties.clusters.zSliceBias);
+    const uint z = (uint)clamp(slice, 0, count.z - 1);
+    return (z * count.y + y) * count.x + x;
+}
+
 struct V2P {
     float4 position : SV_Position;
     float2 texcoord : TEXCOORD0;
@@ -50,15 +50,18 @@ float4 PSMain(V2P input) : SV_TARGET {
     float3 outDiffuseSpecular = float3(0.0f, 0.0f, 0.0f);
 
     // --- Point lights ---
-    for (int i = 0; i < sceneProperties.lights.numOfPointLights; ++i) {
-        const float distance = length(sceneProperties.lights.pointLights[i].position - worldPosition);
-        if (sceneProperties.lights.pointLights[i].range < distance) continue;
+    // Only the lights assigned to the cluster of this pixel can reach it.
+    const uint2 clusterRange = clusterRanges[ClusterIndex(input.texcoord, viewSpacePosition.z)];
+    for (uint c = 0; c < clusterRange.y; ++c) {
+        const uint i = clusterLightIndices[clusterRange.x + c];
+        const float distance = length(pointLights[i].position - worldPosition);
+        if (pointLights[i].range < distance) continue;
 
-        const float3 wi = normalize(sceneProperties.lights.pointLights[i].position - worldPosition);
+        const float3 wi = normalize(pointLights[i].position - worldPosition);
 
         // inverse-square law.
-        const float3 radiance = sceneProperties.lights.pointLights[i].color
-                                * sceneProperties.lights.pointLights[i].intensity
+        const float3 radiance = pointLights[i].color
+                                * pointLights[i].intensity
                                 * (1 / (distance * distance));
 
         outDiffuseSpecular += BRDF(surface, wi, -viewDir) * radiance * saturate(dot(surface.normal, wi));
@@ -0,0 +1,26 @@
+/**
+* pbr (instanced)
+* @require Shader Model 4 (/4_0)
+*/
+
+#include "interface.hlsl"
+#include "../common/interface_instance.hlsl"
+
+
+V2P VSMain(VSIn input, InstanceIn instance)
+{
+    V2P output;
+    
+    const float4x4 matrixM = InstanceMatrixM(instance);
+    const float4 worldPos = mul(float4(input.position, 1), matrixM);
+    output.position = WorldToClipPosition(worldPos);
+    output.worldPos = worldPos.xyz;
+    
+    output.worldNormal = InstanceModelToWorldNormal(instance, input.normal);
+    
+    output.worldTangent = normalize(mul(float4(input.tangent, 0), matrixM).xyz);
+    
+    output.texcoord = input.texcoord;
+    
+    return output;
+}
@@ -0,0 +1,12 @@
+#include "../../common/interface_scene.hlsl"
+
+// --- each pass properties ---
+// The low resolution source, and the full resolution depth as the guide.
+Texture2D texSource : register(t0);
+Texture2D texDepth : register(t1);
+// ---
+
+struct V2P {
+    float4 position : SV_Position;
+    float2 texcoord : TEXCOORD0;
+};
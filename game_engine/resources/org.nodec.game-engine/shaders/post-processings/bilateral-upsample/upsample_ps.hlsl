@@ -0,0 +1,47 @@
+#include "upsample_interface.hlsl"
+
+float ViewDepth(int2 texel) {
+    const float nonLinearDepth = texDepth.Load(int3(texel, 0)).r;
+    const float4 position = mul(sceneProperties.matrixPInverse, float4(0, 0, nonLinearDepth, 1));
+    return position.z / position.w;
+}
+
+// Joint bilateral upsampling.
+// The four source texels around the pixel are weighted by the bilinear weights,
+// and by how close their depth is to the depth of the pixel, so the edges do not bleed.
+// The depth of a source texel is taken from the guide at its center.
+float4 PSMain(V2P input) : SV_TARGET {
+    float sourceWidth, sourceHeight;
+    texSource.GetDimensions(sourceWidth, sourceHeight);
+    float guideWidth, guideHeight;
+    texDepth.GetDimensions(guideWidth, guideHeight);
+
+    const float2 sourceSize = float2(sourceWidth, sourceHeight);
+    const float2 guideScale = float2(guideWidth, guideHeight) / sourceSize;
+    const int2 sourceMax = int2(sourceSize) - 1;
+
+    const float2 sourcePosition = input.texcoord * sourceSize - 0.5;
+    const int2 base = int2(floor(sourcePosition));
+    const float2 f = sourcePosition - base;
+
+    const float depth = ViewDepth(int2(input.position.xy));
+
+    float4 sum = 0;
+    float weightSum = 0;
+
+    [unroll]
+    for (int i = 0; i < 4; ++i) {
+        const int2 offset = int2(i & 1, i >> 1);
+        const int2 texel = clamp(base + offset, int2(0, 0), sourceMax);
+
+        const float2 bilinear = lerp(1 - f, f, float2(offset));
+        const float texelDepth = ViewDepth(int2((texel + 0.5) * guideScale));
+        const float difference = abs(depth - texelDepth) / max(abs(depth), 1e-3);
+        const float weight = bilinear.x * bilinear.y / (1e-3 + difference);
+
+        sum += texSource.Load(int3(texel, 0)) * weight;
+        weightSum += weight;
+    }
+
+    return sum / max(weightSum, 1e-5);
+}
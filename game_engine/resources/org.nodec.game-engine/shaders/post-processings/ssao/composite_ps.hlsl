@@ -0,0 +1,7 @@
+#include "composite_interface.hlsl"
+
+float4 PSMain(V2P input) : SV_TARGET {
+    const float occlusion = texOcclusion.Sample(sampler_tex, input.texcoord).r;
+    const float3 illumination = texScreen.Sample(sampler_tex, input.texcoord).rgb * occlusion;
+    return float4(illumination, 1.0f);
+}
@@ -70,7 +70,6 @@ float4 PSMain(V2P input) : SV_TARGET {
     // occlusion  = pow(occlusion, magnitude);
     // occlusion  = contrast * (occlusion - 0.5) + 0.5;
 
-    float3 illumination = texScreen.Sample(sampler_tex, input.texcoord) * occlusion;
-    return float4(illumination, 1.0f);
-    //return float4(occlusion.xxx, 1.0f);
+    // The composite pass upsamples the occlusion and applies it to the screen.
+    return float4(occlusion.xxx, 1.0f);
 }
\ No newline at end of file
@@ -0,0 +1,25 @@
+// --- Text SDF Shader Interface ---
+
+#include <common/interface_model.hlsl>
+
+struct V2P {
+    float4 position : SV_Position;
+    float2 texcoord : TEXCOORD0;
+    float3 position_world : POSITION;
+    float3 normal_world : NORMAL;
+    float4 depth : TEXCOORD1;
+};
+
+struct MaterialProperties {
+    float4 color;
+};
+
+cbuffer cbMaterialProperties : register(b3)
+{
+    MaterialProperties materialProperties;
+};
+
+// The signed distance to the outline, 0.5 on it and rising inward.
+Texture2D texSdf : register(t0);
+
+SamplerState sampler_texSdf : register(s0);
@@ -0,0 +1,36 @@
+#include "interface.hlsl"
+
+
+ struct PSOut {
+    float4 color : SV_TARGET0;
+    float4 normal : SV_TARGET1;
+    float4 depth : SV_TARGET3;
+ };
+
+PSOut PSMain(V2P input) : SV_Target {
+    PSOut output;
+
+    float4 color = materialProperties.color;
+
+    if (textureConfig.texHasFlag & 0x01) {
+        float distance = texSdf.Sample(sampler_texSdf, input.texcoord).r;
+
+        // Antialias over about one screen pixel, whatever the scale of the text is.
+        float width = max(fwidth(distance) * 0.7f, 1e-4f);
+        color.a *= smoothstep(0.5f - width, 0.5f + width, distance);
+    }
+
+    if (color.a < 0.01f) {
+        discard;
+    }
+
+    output.color = color;
+    
+    float3 normal_world = normalize(input.normal_world);
+    output.normal = float4(normal_world, 1);
+
+    float depth = input.depth.z / input.depth.w;
+    output.depth = float4(depth.xxxx);
+
+    return output;
+}
\ No newline at end of file
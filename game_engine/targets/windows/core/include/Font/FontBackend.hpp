@@ -1,9 +1,12 @@
 #pragma once
 
 #include "FontFace.hpp"
+#include "SdfFont.hpp"
+#include "SdfFontTexture.hpp"
 
 #include <nodec_rendering/resources/font.hpp>
 
+#include <memory>
 #include <string>
 
 class FontBackend : public nodec_rendering::resources::Font {
@@ -12,10 +15,38 @@ public:
         : mFace{library.GetLibrary(), path} {
     }
 
+    /**
+     * @param data The font file in memory, kept alive by @p dataOwner while the font lives.
+     */
+    FontBackend(FontLibrary &library, std::shared_ptr<const void> dataOwner, const void *data, std::size_t size, const std::string &path)
+        : mData{std::move(dataOwner)}, mFace{library.GetLibrary(), data, size, path} {
+    }
+
     FT_Face GetFace() {
         return mFace.GetFace();
     }
 
+    /**
+     * @brief Attaches the SDF atlas baked offline for this font.
+     */
+    void SetSdf(std::shared_ptr<const SdfFont> sdfFont, std::unique_ptr<SdfFontTexture> sdfTexture) {
+        mSdfFont = std::move(sdfFont);
+        mSdfTexture = std::move(sdfTexture);
+    }
+
+    //! The baked SDF atlas, or nullptr if the font has none.
+    const SdfFont *GetSdfFont() const {
+        return mSdfFont.get();
+    }
+
+    SdfFontTexture *GetSdfTexture() const {
+        return mSdfTexture.get();
+    }
+
 private:
+    // Declared before the face, which reads it until destroyed.
+    std::shared_ptr<const void> mData;
     FontFace mFace;
+    std::shared_ptr<const SdfFont> mSdfFont;
+    std::unique_ptr<SdfFontTexture> mSdfTexture;
 };
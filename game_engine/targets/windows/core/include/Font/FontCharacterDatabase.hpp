@@ -1,7 +1,8 @@
 #pragma once
 
 #include "FontFace.hpp"
-#include "FontTexture.hpp"
+#include "GlyphAtlas.hpp"
+#include "GlyphAtlasTexture.hpp"
 
 #include <nodec/containers/sparse_table.hpp>
 #include <nodec/vector2.hpp>
@@ -31,39 +32,46 @@ struct FontCharacter {
     //! from the origin to the origin of the next glyph.
     std::uint16_t advance;
 
-    std::shared_ptr<FontTexture> pFontTexture;
+    //! False for the void character like space. It has no glyph in the atlas.
+    bool has_bitmap{false};
 };
 
+/**
+ * @brief Caches the glyph metrics, and the glyph bitmaps in one shared atlas.
+ *
+ * The metrics are kept for good, while the bitmaps are evicted from the atlas when it is full
+ * and rendered again on the next use.
+ */
 class FontCharacterDatabase {
     struct FaceBlock {
+        std::uint32_t id;
         std::uint16_t pixelSize;
         nodec::containers::SparseTable<FontCharacter> characters;
     };
 
 public:
+    static constexpr std::uint16_t ATLAS_SIZE = 1024;
+
     FontCharacterDatabase(Graphics *pGfx)
-        : mpGfx{pGfx} {}
+        : mpGfx{pGfx}, mAtlas(ATLAS_SIZE, ATLAS_SIZE), mAtlasTexture(pGfx, mAtlas) {}
 
     const FontCharacter &Get(FT_Face face, std::uint16_t pixelSize, std::uint32_t chCode) {
-        auto &faceBlock = mFaces[{face, pixelSize}];
+        auto &faceBlock = GetFaceBlock(face, pixelSize);
         auto &character = faceBlock.characters[chCode];
 
         if (character.initialized) return character;
 
-        FT_Set_Pixel_Sizes(face, 0, pixelSize);
-
-        if (FT_Load_Char(face, chCode, FT_LOAD_RENDER)) {
-            // TODO: return dummy character with no throw.
-            throw std::runtime_error("Failed to load Glyph");
-        }
+        LoadGlyph(face, pixelSize, chCode);
 
         character.advance = static_cast<std::uint16_t>(face->glyph->advance.x);
         character.size.set(face->glyph->bitmap.width, face->glyph->bitmap.rows);
         character.bearing.set(face->glyph->bitmap_left, face->glyph->bitmap_top);
 
         // The buffer will be null when the character is void character like space.
-        if (face->glyph->bitmap.buffer != nullptr) {
-            character.pFontTexture.reset(new FontTexture(mpGfx, face));
+        character.has_bitmap = face->glyph->bitmap.buffer != nullptr;
+        if (character.has_bitmap) {
+            // The glyph is rendered already, so put it in the atlas while here.
+            InsertGlyph(GlyphKey(faceBlock, chCode), face);
         }
 
         character.initialized = true;
@@ -71,7 +79,83 @@ public:
         return character;
     }
 
+    /**
+     * @brief Starts a new batch of glyphs.
+     *
+     * The glyphs returned by GetAtlasRect() stay in place in the atlas until the next call.
+     */
+    void BeginBatch() {
+        mAtlas.begin_batch();
+    }
+
+    /**
+     * @brief Returns the rectangle of the glyph in the atlas, rendering it again if it has been evicted.
+     *
+     * @return nullptr if the character has no bitmap, or the atlas is full of the glyphs of the current batch.
+     */
+    const GlyphAtlas::Rect *GetAtlasRect(FT_Face face, std::uint16_t pixelSize, std::uint32_t chCode) {
+        const auto &character = Get(face, pixelSize, chCode);
+        if (!character.has_bitmap) return nullptr;
+
+        const auto key = GlyphKey(GetFaceBlock(face, pixelSize), chCode);
+        if (auto *rect = mAtlas.find(key)) return rect;
+
+        LoadGlyph(face, pixelSize, chCode);
+        return InsertGlyph(key, face);
+    }
+
+    /**
+     * @brief Uploads the glyphs added since the last upload.
+     *
+     * @return The number of bytes uploaded.
+     */
+    std::size_t UploadAtlas() {
+        return mAtlasTexture.upload(mAtlas);
+    }
+
+    GlyphAtlasTexture &AtlasTexture() {
+        return mAtlasTexture;
+    }
+
+    const GlyphAtlas &Atlas() const {
+        return mAtlas;
+    }
+
+private:
+    FaceBlock &GetFaceBlock(FT_Face face, std::uint16_t pixelSize) {
+        auto result = mFaces.try_emplace({face, pixelSize});
+        auto &faceBlock = result.first->second;
+        if (result.second) {
+            faceBlock.id = mNextFaceBlockId++;
+            faceBlock.pixelSize = pixelSize;
+        }
+        return faceBlock;
+    }
+
+    static std::uint64_t GlyphKey(const FaceBlock &faceBlock, std::uint32_t chCode) {
+        return (static_cast<std::uint64_t>(faceBlock.id) << 32) | chCode;
+    }
+
+    static void LoadGlyph(FT_Face face, std::uint16_t pixelSize, std::uint32_t chCode) {
+        FT_Set_Pixel_Sizes(face, 0, pixelSize);
+
+        if (FT_Load_Char(face, chCode, FT_LOAD_RENDER)) {
+            // TODO: return dummy character with no throw.
+            throw std::runtime_error("Failed to load Glyph");
+        }
+    }
+
+    const GlyphAtlas::Rect *InsertGlyph(std::uint64_t key, FT_Face face) {
+        const auto &bitmap = face->glyph->bitmap;
+        return mAtlas.insert(key, static_cast<std::uint16_t>(bitmap.width), static_cast<std::uint16_t>(bitmap.rows),
+                             bitmap.buffer, bitmap.pitch);
+    }
+
 private:
     Graphics *mpGfx;
     std::unordered_map<std::pair<FT_Face, std::uint16_t>, FaceBlock> mFaces;
+    std::uint32_t mNextFaceBlockId{0};
+
+    GlyphAtlas mAtlas;
+    GlyphAtlasTexture mAtlasTexture;
 };
\ No newline at end of file
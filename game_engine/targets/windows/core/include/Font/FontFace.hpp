@@ -13,6 +13,16 @@ public:
         
     }
 
+    /**
+     * @brief The face over the font file in memory. The memory must outlive the face.
+     */
+    FontFace(FT_Library library, const void* data, std::size_t size, const std::string& path) {
+        if (FT_New_Memory_Face(library, static_cast<const FT_Byte*>(data), static_cast<FT_Long>(size), 0, &mFace)) {
+            throw std::runtime_error(nodec::ErrorFormatter<std::runtime_error>(__FILE__, __LINE__)
+                                     << "Failed to load font. path: " << path);
+        }
+    }
+
     ~FontFace() {
         FT_Done_Face(mFace);
     }
@@ -0,0 +1,186 @@
+#ifndef NODEC_GAME_ENGINE__FONT__GLYPH_ATLAS_HPP_
+#define NODEC_GAME_ENGINE__FONT__GLYPH_ATLAS_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "GlyphAtlasPacker.hpp"
+
+/**
+ * @brief CPU side of the glyph atlas. It holds the 8-bit coverage of the glyphs in one image.
+ *
+ * The glyphs are kept in the least recently used order.
+ * When a new glyph does not fit, the coldest glyphs are evicted until it fits.
+ * The glyphs used since the last begin_batch() are never evicted, since the batch being built refers them.
+ *
+ * The changed pixels are tracked by one dirty rectangle, which the texture uploads and clears.
+ */
+class GlyphAtlas {
+public:
+    using Rect = GlyphAtlasPacker::Rect;
+
+    // The empty border around each glyph, so that the bilinear filter does not fetch the neighbours.
+    static constexpr std::uint16_t GLYPH_PADDING = 1;
+
+    GlyphAtlas(std::uint16_t width, std::uint16_t height)
+        : packer_(width, height), pixels_(static_cast<std::size_t>(width) * height, 0) {}
+
+    /**
+     * @brief Starts a new batch. The glyphs used in the previous batches become evictable.
+     */
+    void begin_batch() {
+        ++batch_;
+    }
+
+    /**
+     * @brief Returns the rectangle of the glyph in the atlas, or nullptr if it is not resident.
+     */
+    const Rect *find(std::uint64_t key) {
+        auto iter = lookup_.find(key);
+        if (iter == lookup_.end()) return nullptr;
+
+        touch(iter->second);
+        return &iter->second->glyph_rect;
+    }
+
+    /**
+     * @brief Copies the glyph into the atlas.
+     *
+     * @param pixels The 8-bit coverage, @p pitch bytes per row.
+     * @return The rectangle of the glyph, or nullptr if it does not fit even after the eviction.
+     */
+    const Rect *insert(std::uint64_t key, std::uint16_t width, std::uint16_t height,
+                       const std::uint8_t *pixels, int pitch) {
+        const auto padded_width = static_cast<std::uint16_t>(width + GLYPH_PADDING * 2);
+        const auto padded_height = static_cast<std::uint16_t>(height + GLYPH_PADDING * 2);
+
+        auto allocation = packer_.allocate(padded_width, padded_height);
+        while (!allocation && evict_coldest()) {
+            allocation = packer_.allocate(padded_width, padded_height);
+        }
+        if (!allocation) return nullptr;
+
+        const Rect glyph_rect{static_cast<std::uint16_t>(allocation->x + GLYPH_PADDING),
+                              static_cast<std::uint16_t>(allocation->y + GLYPH_PADDING),
+                              width, height};
+
+        // Clear the border too, the evicted glyph may remain there.
+        for (std::uint16_t y = 0; y < allocation->height; ++y) {
+            std::memset(&pixels_[index(allocation->x, allocation->y + y)], 0, allocation->width);
+        }
+        for (std::uint16_t y = 0; y < height; ++y) {
+            std::memcpy(&pixels_[index(glyph_rect.x, glyph_rect.y + y)], pixels + static_cast<std::ptrdiff_t>(y) * pitch, width);
+        }
+        mark_dirty(*allocation);
+
+        entries_.push_front({key, *allocation, glyph_rect, batch_});
+        lookup_[key] = entries_.begin();
+        return &entries_.front().glyph_rect;
+    }
+
+    void clear() {
+        entries_.clear();
+        lookup_.clear();
+        packer_.clear();
+        dirty_ = false;
+        dirty_rect_ = {};
+    }
+
+    std::uint16_t width() const noexcept {
+        return packer_.width();
+    }
+
+    std::uint16_t height() const noexcept {
+        return packer_.height();
+    }
+
+    const std::vector<std::uint8_t> &pixels() const noexcept {
+        return pixels_;
+    }
+
+    bool is_dirty() const noexcept {
+        return dirty_;
+    }
+
+    const Rect &dirty_rect() const noexcept {
+        return dirty_rect_;
+    }
+
+    void clear_dirty() noexcept {
+        dirty_ = false;
+    }
+
+    std::size_t glyph_count() const noexcept {
+        return entries_.size();
+    }
+
+    std::size_t eviction_count() const noexcept {
+        return eviction_count_;
+    }
+
+private:
+    struct Entry {
+        std::uint64_t key;
+        Rect allocation;
+        Rect glyph_rect;
+        std::uint64_t last_batch;
+    };
+
+    using EntryIterator = std::list<Entry>::iterator;
+
+    std::size_t index(std::uint32_t x, std::uint32_t y) const {
+        return static_cast<std::size_t>(y) * packer_.width() + x;
+    }
+
+    void touch(EntryIterator iter) {
+        iter->last_batch = batch_;
+        entries_.splice(entries_.begin(), entries_, iter);
+    }
+
+    bool evict_coldest() {
+        if (entries_.empty()) return false;
+
+        auto &coldest = entries_.back();
+        if (coldest.last_batch == batch_) return false;
+
+        packer_.release(coldest.allocation);
+        lookup_.erase(coldest.key);
+        entries_.pop_back();
+        ++eviction_count_;
+        return true;
+    }
+
+    void mark_dirty(const Rect &rect) {
+        if (!dirty_) {
+            dirty_rect_ = rect;
+            dirty_ = true;
+            return;
+        }
+
+        const auto left = (std::min)(dirty_rect_.x, rect.x);
+        const auto top = (std::min)(dirty_rect_.y, rect.y);
+        const auto right = (std::max)(dirty_rect_.x + dirty_rect_.width, rect.x + rect.width);
+        const auto bottom = (std::max)(dirty_rect_.y + dirty_rect_.height, rect.y + rect.height);
+        dirty_rect_ = {left, top, static_cast<std::uint16_t>(right - left), static_cast<std::uint16_t>(bottom - top)};
+    }
+
+private:
+    GlyphAtlasPacker packer_;
+    std::vector<std::uint8_t> pixels_;
+
+    // The most recently used first.
+    std::list<Entry> entries_;
+    std::unordered_map<std::uint64_t, EntryIterator> lookup_;
+
+    std::uint64_t batch_{0};
+    std::size_t eviction_count_{0};
+
+    bool dirty_{false};
+    Rect dirty_rect_{};
+};
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef NODEC_GAME_ENGINE__FONT__GLYPH_ATLAS_PACKER_HPP_
+#define NODEC_GAME_ENGINE__FONT__GLYPH_ATLAS_PACKER_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <nodec/optional.hpp>
+
+/**
+ * @brief Shelf packer of the rectangles in the glyph atlas.
+ *
+ * The atlas is split into horizontal shelves from the top.
+ * A rectangle is placed in the free span of the shelf whose height fits it best.
+ * The released spans are merged back, and the shelves which become empty are merged with
+ * the empty neighbours, so that the space can be reused by the glyphs of another height.
+ *
+ * It only manages the space. The pixels are up to the owner.
+ */
+class GlyphAtlasPacker {
+public:
+    struct Rect {
+        std::uint16_t x;
+        std::uint16_t y;
+        std::uint16_t width;
+        std::uint16_t height;
+    };
+
+    GlyphAtlasPacker(std::uint16_t width, std::uint16_t height)
+        : width_(width), height_(height) {}
+
+    nodec::optional<Rect> allocate(std::uint16_t width, std::uint16_t height) {
+        if (width == 0 || height == 0 || width > width_ || height > height_) return nodec::nullopt;
+
+        const auto shelf_height = round_up_shelf_height(height);
+
+        // Best fit in the shelves in use.
+        // The shelves twice as tall as the rectangle are skipped not to waste them.
+        std::size_t best_shelf = NO_SHELF;
+        std::size_t best_span = 0;
+        for (std::size_t i = 0; i < shelves_.size(); ++i) {
+            const auto &shelf = shelves_[i];
+            if (shelf.allocation_count == 0) continue;
+            if (shelf.height < height || shelf.height >= shelf_height * 2) continue;
+            if (best_shelf != NO_SHELF && shelves_[best_shelf].height <= shelf.height) continue;
+
+            const auto span = find_span(shelf, width);
+            if (span == NO_SPAN) continue;
+            best_shelf = i;
+            best_span = span;
+        }
+
+        // Then the first empty shelf tall enough. The rest of it is left as another empty shelf.
+        if (best_shelf == NO_SHELF) {
+            for (std::size_t i = 0; i < shelves_.size(); ++i) {
+                auto &shelf = shelves_[i];
+                if (shelf.allocation_count != 0 || shelf.height < height) continue;
+
+                const auto used_height = (std::min)(shelf.height, shelf_height);
+                if (shelf.height > used_height) {
+                    const auto rest_y = static_cast<std::uint16_t>(shelf.y + used_height);
+                    const auto rest_height = static_cast<std::uint16_t>(shelf.height - used_height);
+                    shelf.height = used_height;
+                    shelves_.insert(shelves_.begin() + i + 1, make_empty_shelf(rest_y, rest_height));
+                }
+                best_shelf = i;
+                best_span = 0;
+                break;
+            }
+        }
+
+        // Then a new shelf on the unused space at the bottom.
+        if (best_shelf == NO_SHELF) {
+            if (static_cast<std::uint32_t>(next_y_) + shelf_height > height_) return nodec::nullopt;
+            shelves_.push_back(make_empty_shelf(next_y_, shelf_height));
+            next_y_ = static_cast<std::uint16_t>(next_y_ + shelf_height);
+            best_shelf = shelves_.size() - 1;
+            best_span = 0;
+        }
+
+        auto &shelf = shelves_[best_shelf];
+        auto &span = shelf.free_spans[best_span];
+        const Rect rect{span.x, shelf.y, width, height};
+
+        span.x = static_cast<std::uint16_t>(span.x + width);
+        span.width = static_cast<std::uint16_t>(span.width - width);
+        if (span.width == 0) {
+            shelf.free_spans.erase(shelf.free_spans.begin() + best_span);
+        }
+        ++shelf.allocation_count;
+        return rect;
+    }
+
+    /**
+     * @brief Returns the rectangle given by allocate() to the free space.
+     */
+    void release(const Rect &rect) {
+        const auto shelf_index = find_shelf(rect.y);
+        if (shelf_index == NO_SHELF) return;
+        auto &shelf = shelves_[shelf_index];
+
+        // Insert the span keeping the order of x, and merge it with the adjacent ones.
+        auto &spans = shelf.free_spans;
+        std::size_t i = 0;
+        while (i < spans.size() && spans[i].x < rect.x) ++i;
+        spans.insert(spans.begin() + i, Span{rect.x, rect.width});
+
+        if (i + 1 < spans.size() && spans[i].x + spans[i].width == spans[i + 1].x) {
+            spans[i].width = static_cast<std::uint16_t>(spans[i].width + spans[i + 1].width);
+            spans.erase(spans.begin() + i + 1);
+        }
+        if (i > 0 && spans[i - 1].x + spans[i - 1].width == spans[i].x) {
+            spans[i - 1].width = static_cast<std::uint16_t>(spans[i - 1].width + spans[i].width);
+            spans.erase(spans.begin() + i);
+        }
+
+        if (--shelf.allocation_count == 0) {
+            merge_empty_shelves(shelf_index);
+        }
+    }
+
+    void clear() {
+        shelves_.clear();
+        next_y_ = 0;
+    }
+
+    std::uint16_t width() const noexcept {
+        return width_;
+    }
+
+    std::uint16_t height() const noexcept {
+        return height_;
+    }
+
+    std::size_t shelf_count() const noexcept {
+        return shelves_.size();
+    }
+
+private:
+    struct Span {
+        std::uint16_t x;
+        std::uint16_t width;
+    };
+
+    struct Shelf {
+        std::uint16_t y;
+        std::uint16_t height;
+        std::uint32_t allocation_count;
+
+        // Sorted by x.
+        std::vector<Span> free_spans;
+    };
+
+    static constexpr std::size_t NO_SHELF = static_cast<std::size_t>(-1);
+    static constexpr std::size_t NO_SPAN = static_cast<std::size_t>(-1);
+
+    // The heights are rounded up, so that the glyphs of the similar heights share the shelves.
+    static constexpr std::uint16_t SHELF_HEIGHT_GRANULARITY = 4;
+
+    std::uint16_t round_up_shelf_height(std::uint16_t height) const {
+        const std::uint32_t rounded = (height + SHELF_HEIGHT_GRANULARITY - 1) / SHELF_HEIGHT_GRANULARITY * SHELF_HEIGHT_GRANULARITY;
+        return static_cast<std::uint16_t>((std::min<std::uint32_t>)(rounded, height_));
+    }
+
+    Shelf make_empty_shelf(std::uint16_t y, std::uint16_t height) const {
+        return {y, height, 0, {Span{0, width_}}};
+    }
+
+    static std::size_t find_span(const Shelf &shelf, std::uint16_t width) {
+        for (std::size_t i = 0; i < shelf.free_spans.size(); ++i) {
+            if (shelf.free_spans[i].width >= width) return i;
+        }
+        return NO_SPAN;
+    }
+
+    std::size_t find_shelf(std::uint16_t y) const {
+        for (std::size_t i = 0; i < shelves_.size(); ++i) {
+            if (shelves_[i].y == y) return i;
+        }
+        return NO_SHELF;
+    }
+
+    void merge_empty_shelves(std::size_t index) {
+        if (index + 1 < shelves_.size() && shelves_[index + 1].allocation_count == 0) {
+            shelves_[index].height = static_cast<std::uint16_t>(shelves_[index].height + shelves_[index + 1].height);
+            shelves_.erase(shelves_.begin() + index + 1);
+        }
+        if (index > 0 && shelves_[index - 1].allocation_count == 0) {
+            shelves_[index - 1].height = static_cast<std::uint16_t>(shelves_[index - 1].height + shelves_[index].height);
+            shelves_.erase(shelves_.begin() + index);
+            --index;
+        }
+
+        // The empty shelf at the bottom goes back to the unused space.
+        if (index + 1 == shelves_.size()) {
+            next_y_ = shelves_[index].y;
+            shelves_.pop_back();
+        }
+    }
+
+private:
+    std::uint16_t width_;
+    std::uint16_t height_;
+    std::uint16_t next_y_{0};
+    std::vector<Shelf> shelves_;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef NODEC_GAME_ENGINE__FONT__GLYPH_ATLAS_TEXTURE_HPP_
+#define NODEC_GAME_ENGINE__FONT__GLYPH_ATLAS_TEXTURE_HPP_
+
+#include "../rendering/texture_backend.hpp"
+
+#include "GlyphAtlas.hpp"
+
+/**
+ * @brief The device copy of the glyph atlas.
+ */
+class GlyphAtlasTexture : public TextureBackend {
+public:
+    GlyphAtlasTexture(Graphics *gfx, const GlyphAtlas &atlas)
+        : gfx_(gfx) {
+        D3D11_TEXTURE2D_DESC texture_desc{};
+        texture_desc.Format = DXGI_FORMAT_R8_UNORM;
+        texture_desc.Width = atlas.width();
+        texture_desc.Height = atlas.height();
+        texture_desc.SampleDesc.Count = 1;
+        texture_desc.ArraySize = 1;
+        texture_desc.MipLevels = 1;
+        texture_desc.Usage = D3D11_USAGE_DEFAULT;
+        texture_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+        D3D11_SUBRESOURCE_DATA init_data{};
+        init_data.pSysMem = atlas.pixels().data();
+        init_data.SysMemPitch = atlas.width();
+        init_data.SysMemSlicePitch = 0;
+
+        ThrowIfFailedGfx(
+            gfx->device().CreateTexture2D(&texture_desc, &init_data, &texture_),
+            gfx, __FILE__, __LINE__);
+
+        {
+            D3D11_SHADER_RESOURCE_VIEW_DESC desc{};
+            desc.Format = texture_desc.Format;
+            desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+            desc.Texture2D.MipLevels = texture_desc.MipLevels;
+            desc.Texture2D.MostDetailedMip = 0;
+            ThrowIfFailedGfx(
+                gfx->device().CreateShaderResourceView(texture_.Get(), &desc, &shader_resource_view_),
+                gfx, __FILE__, __LINE__);
+        }
+
+        initialize(shader_resource_view_.Get(), atlas.width(), atlas.height());
+    }
+
+    /**
+     * @brief Uploads the dirty rectangle of the atlas, then clears it.
+     *
+     * @return The number of bytes uploaded.
+     */
+    std::size_t upload(GlyphAtlas &atlas) {
+        if (!atlas.is_dirty()) return 0;
+
+        const auto &rect = atlas.dirty_rect();
+        D3D11_BOX box{};
+        box.left = rect.x;
+        box.top = rect.y;
+        box.front = 0;
+        box.right = rect.x + rect.width;
+        box.bottom = rect.y + rect.height;
+        box.back = 1;
+
+        const auto *source = atlas.pixels().data() + static_cast<std::size_t>(rect.y) * atlas.width() + rect.x;
+        gfx_->context().UpdateSubresource(texture_.Get(), 0, &box, source, atlas.width(), 0);
+
+        atlas.clear_dirty();
+        return static_cast<std::size_t>(rect.width) * rect.height;
+    }
+
+private:
+    Graphics *gfx_;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> texture_;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_view_;
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef NODEC_GAME_ENGINE__FONT__SDF_FONT_HPP_
+#define NODEC_GAME_ENGINE__FONT__SDF_FONT_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Signed distance field atlas of a font, baked offline at one pixel size.
+ *
+ * The atlas stores 0.5 on the outline, rising inward. A texel value of 0 or 1 is @p spread pixels
+ * away from the outline at the baked size. So one atlas serves all the pixel sizes by scaling the quads.
+ *
+ * The file is the header, the glyph records, then the 8-bit atlas pixels row by row.
+ * All the values are little endian.
+ */
+struct SdfFont {
+    struct Glyph {
+        // The rectangle in the atlas, including the spread border on every side.
+        std::uint16_t x;
+        std::uint16_t y;
+        std::uint16_t width;
+        std::uint16_t height;
+
+        // The metrics at the baked size, in pixels. The size excludes the border.
+        std::int16_t bearing_x;
+        std::int16_t bearing_y;
+        std::uint16_t bitmap_width;
+        std::uint16_t bitmap_height;
+
+        //! The horizontal advance in 1/64th pixels.
+        std::uint16_t advance;
+    };
+
+    static constexpr std::uint32_t MAGIC = 0x46445344; // "DSDF"
+    static constexpr std::uint32_t VERSION = 1;
+
+    std::uint16_t pixel_size{0};
+    std::uint16_t spread{0};
+    std::uint16_t atlas_width{0};
+    std::uint16_t atlas_height{0};
+
+    std::unordered_map<std::uint32_t, Glyph> glyphs;
+    std::vector<std::uint8_t> pixels;
+
+    const Glyph *find(std::uint32_t code) const {
+        auto iter = glyphs.find(code);
+        if (iter == glyphs.end()) return nullptr;
+        return &iter->second;
+    }
+};
+
+namespace sdf_font_io {
+
+struct Header {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint16_t pixel_size;
+    std::uint16_t spread;
+    std::uint16_t atlas_width;
+    std::uint16_t atlas_height;
+    std::uint32_t glyph_count;
+};
+
+struct GlyphRecord {
+    std::uint32_t code;
+    SdfFont::Glyph glyph;
+};
+
+} // namespace sdf_font_io
+
+inline void write_sdf_font(std::ostream &out, const SdfFont &font) {
+    using namespace sdf_font_io;
+
+    const Header header{SdfFont::MAGIC, SdfFont::VERSION, font.pixel_size, font.spread,
+                        font.atlas_width, font.atlas_height, static_cast<std::uint32_t>(font.glyphs.size())};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    // Write in the code order and zero the padding, so that the same font bakes to the same bytes.
+    std::vector<std::uint32_t> codes;
+    codes.reserve(font.glyphs.size());
+    for (const auto &pair : font.glyphs) {
+        codes.push_back(pair.first);
+    }
+    std::sort(codes.begin(), codes.end());
+
+    for (const auto code : codes) {
+        GlyphRecord record{};
+        record.code = code;
+        record.glyph = font.glyphs.at(code);
+        out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    }
+    out.write(reinterpret_cast<const char *>(font.pixels.data()), font.pixels.size());
+
+    if (!out) {
+        throw std::runtime_error("Failed to write the SDF font.");
+    }
+}
+
+inline SdfFont read_sdf_font(std::istream &in) {
+    using namespace sdf_font_io;
+
+    Header header;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))
+        || header.magic != SdfFont::MAGIC || header.version != SdfFont::VERSION) {
+        throw std::runtime_error("Not a SDF font, or the version is not supported.");
+    }
+
+    SdfFont font;
+    font.pixel_size = header.pixel_size;
+    font.spread = header.spread;
+    font.atlas_width = header.atlas_width;
+    font.atlas_height = header.atlas_height;
+
+    font.glyphs.reserve(header.glyph_count);
+    for (std::uint32_t i = 0; i < header.glyph_count; ++i) {
+        GlyphRecord record;
+        if (!in.read(reinterpret_cast<char *>(&record), sizeof(record))) {
+            throw std::runtime_error("The SDF font is truncated.");
+        }
+
+        const auto &glyph = record.glyph;
+        if (glyph.x + glyph.width > font.atlas_width || glyph.y + glyph.height > font.atlas_height) {
+            throw std::runtime_error("The SDF glyph is out of the atlas.");
+        }
+        font.glyphs.emplace(record.code, glyph);
+    }
+
+    font.pixels.resize(static_cast<std::size_t>(font.atlas_width) * font.atlas_height);
+    if (!in.read(reinterpret_cast<char *>(font.pixels.data()), font.pixels.size())) {
+        throw std::runtime_error("The SDF font is truncated.");
+    }
+    return font;
+}
+
+#endif
@@ -1,30 +1,29 @@
-#ifndef NODEC_GAME_ENGINE__FONT__FONT_TEXTURE_HPP_
-#define NODEC_GAME_ENGINE__FONT__FONT_TEXTURE_HPP_
-
-#include <cassert>
+#ifndef NODEC_GAME_ENGINE__FONT__SDF_FONT_TEXTURE_HPP_
+#define NODEC_GAME_ENGINE__FONT__SDF_FONT_TEXTURE_HPP_
 
 #include "../rendering/texture_backend.hpp"
 
-#include "FontFace.hpp"
+#include "SdfFont.hpp"
 
-class FontTexture : public TextureBackend {
+/**
+ * @brief The device copy of the baked SDF atlas. It never changes after the load.
+ */
+class SdfFontTexture : public TextureBackend {
 public:
-    FontTexture(Graphics *gfx, FT_Face face) {
-        assert(face->glyph->bitmap.buffer != nullptr);
-
+    SdfFontTexture(Graphics *gfx, const SdfFont &font) {
         D3D11_TEXTURE2D_DESC texture_desc{};
         texture_desc.Format = DXGI_FORMAT_R8_UNORM;
-        texture_desc.Width = face->glyph->bitmap.width;
-        texture_desc.Height = face->glyph->bitmap.rows;
+        texture_desc.Width = font.atlas_width;
+        texture_desc.Height = font.atlas_height;
         texture_desc.SampleDesc.Count = 1;
-        texture_desc.ArraySize = 1; // We are making one texture.
+        texture_desc.ArraySize = 1;
         texture_desc.MipLevels = 1;
-        texture_desc.Usage = D3D11_USAGE_DEFAULT;
+        texture_desc.Usage = D3D11_USAGE_IMMUTABLE;
         texture_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 
         D3D11_SUBRESOURCE_DATA init_data{};
-        init_data.pSysMem = face->glyph->bitmap.buffer;
-        init_data.SysMemPitch = face->glyph->bitmap.pitch;
+        init_data.pSysMem = font.pixels.data();
+        init_data.SysMemPitch = font.atlas_width;
         init_data.SysMemSlicePitch = 0;
 
         ThrowIfFailedGfx(
@@ -42,7 +41,7 @@ public:
                 gfx, __FILE__, __LINE__);
         }
 
-        initialize(shader_resource_view_.Get(), face->glyph->bitmap.width, face->glyph->bitmap.rows);
+        initialize(shader_resource_view_.Get(), font.atlas_width, font.atlas_height);
     }
 
 private:
@@ -50,4 +49,4 @@ private:
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_view_;
 };
 
-#endif
\ No newline at end of file
+#endif
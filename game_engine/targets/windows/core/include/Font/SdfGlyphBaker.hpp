@@ -0,0 +1,208 @@
+#ifndef NODEC_GAME_ENGINE__FONT__SDF_GLYPH_BAKER_HPP_
+#define NODEC_GAME_ENGINE__FONT__SDF_GLYPH_BAKER_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "GlyphAtlasPacker.hpp"
+#include "SdfFont.hpp"
+
+/**
+ * @brief Bakes the signed distance field atlas of a font on the CPU.
+ *
+ * Each glyph is rendered OVERSAMPLING times larger than the baked size.
+ * The exact euclidean distance to the outline is computed on that bitmap,
+ * then sampled at the texel centers of the baked size.
+ *
+ * It only depends on FreeType, so the asset pipeline can run it without the device.
+ */
+class SdfGlyphBaker {
+public:
+    static constexpr int OVERSAMPLING = 4;
+
+    SdfGlyphBaker(FT_Face face, std::uint16_t pixel_size, std::uint16_t spread)
+        : face_(face), pixel_size_(pixel_size), spread_(spread) {}
+
+    /**
+     * @brief Bakes the glyphs of the codes. The codes the font does not have are skipped.
+     *
+     * @throw std::runtime_error if the glyphs do not fit in the atlas.
+     */
+    SdfFont bake(const std::vector<std::uint32_t> &codes, std::uint16_t atlas_width, std::uint16_t atlas_height) {
+        struct BakedGlyph {
+            std::uint32_t code;
+            SdfFont::Glyph glyph;
+            std::vector<std::uint8_t> field;
+        };
+
+        std::vector<BakedGlyph> baked_glyphs;
+        baked_glyphs.reserve(codes.size());
+
+        FT_Set_Pixel_Sizes(face_, 0, pixel_size_ * OVERSAMPLING);
+        for (const auto code : codes) {
+            if (FT_Get_Char_Index(face_, code) == 0) continue;
+            if (FT_Load_Char(face_, code, FT_LOAD_RENDER)) continue;
+
+            BakedGlyph baked{code, {}, {}};
+            const auto &bitmap = face_->glyph->bitmap;
+            auto &glyph = baked.glyph;
+            glyph.advance = static_cast<std::uint16_t>(face_->glyph->advance.x / OVERSAMPLING);
+
+            // The void character like space only has the advance.
+            if (bitmap.buffer != nullptr && bitmap.width > 0 && bitmap.rows > 0) {
+                glyph.bitmap_width = static_cast<std::uint16_t>((bitmap.width + OVERSAMPLING - 1) / OVERSAMPLING);
+                glyph.bitmap_height = static_cast<std::uint16_t>((bitmap.rows + OVERSAMPLING - 1) / OVERSAMPLING);
+                glyph.bearing_x = static_cast<std::int16_t>(std::floor(static_cast<float>(face_->glyph->bitmap_left) / OVERSAMPLING));
+                glyph.bearing_y = static_cast<std::int16_t>(std::ceil(static_cast<float>(face_->glyph->bitmap_top) / OVERSAMPLING));
+                glyph.width = static_cast<std::uint16_t>(glyph.bitmap_width + spread_ * 2);
+                glyph.height = static_cast<std::uint16_t>(glyph.bitmap_height + spread_ * 2);
+
+                make_distance_field(bitmap.buffer, bitmap.width, bitmap.rows, bitmap.pitch,
+                                    glyph.width, glyph.height, baked.field);
+            }
+            baked_glyphs.push_back(std::move(baked));
+        }
+
+        // The tall glyphs first, so that the shelves are filled evenly.
+        std::sort(baked_glyphs.begin(), baked_glyphs.end(), [](const BakedGlyph &a, const BakedGlyph &b) {
+            if (a.glyph.height != b.glyph.height) return a.glyph.height > b.glyph.height;
+            return a.code < b.code;
+        });
+
+        SdfFont font;
+        font.pixel_size = pixel_size_;
+        font.spread = spread_;
+        font.atlas_width = atlas_width;
+        font.atlas_height = atlas_height;
+        font.pixels.assign(static_cast<std::size_t>(atlas_width) * atlas_height, 0);
+
+        GlyphAtlasPacker packer(atlas_width, atlas_height);
+        for (auto &baked : baked_glyphs) {
+            auto &glyph = baked.glyph;
+            if (!baked.field.empty()) {
+                auto rect = packer.allocate(glyph.width, glyph.height);
+                if (!rect) {
+                    throw std::runtime_error("The SDF glyphs do not fit in the atlas.");
+                }
+                glyph.x = rect->x;
+                glyph.y = rect->y;
+
+                for (std::uint16_t y = 0; y < glyph.height; ++y) {
+                    std::copy_n(&baked.field[static_cast<std::size_t>(y) * glyph.width], glyph.width,
+                                &font.pixels[static_cast<std::size_t>(glyph.y + y) * atlas_width + glyph.x]);
+                }
+            }
+            font.glyphs.emplace(baked.code, glyph);
+        }
+        return font;
+    }
+
+    /**
+     * @brief Makes the distance field of the oversampled coverage bitmap.
+     *
+     * The field is @p field_width x @p field_height texels at the baked size, with the spread border on every side.
+     */
+    void make_distance_field(const std::uint8_t *coverage, int width, int height, int pitch,
+                             int field_width, int field_height, std::vector<std::uint8_t> &field) const {
+        // The oversampled grid covering the field.
+        const int border = spread_ * OVERSAMPLING;
+        const int grid_width = field_width * OVERSAMPLING;
+        const int grid_height = field_height * OVERSAMPLING;
+
+        std::vector<bool> inside(static_cast<std::size_t>(grid_width) * grid_height, false);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                inside[static_cast<std::size_t>(y + border) * grid_width + x + border] = coverage[y * pitch + x] >= 128;
+            }
+        }
+
+        const auto distance_to_inside = squared_distance_transform(inside, grid_width, grid_height, true);
+        const auto distance_to_outside = squared_distance_transform(inside, grid_width, grid_height, false);
+
+        field.resize(static_cast<std::size_t>(field_width) * field_height);
+        const float scale = 1.0f / (OVERSAMPLING * spread_ * 2.0f);
+        for (int y = 0; y < field_height; ++y) {
+            for (int x = 0; x < field_width; ++x) {
+                const auto index = static_cast<std::size_t>(y * OVERSAMPLING + OVERSAMPLING / 2) * grid_width
+                                   + x * OVERSAMPLING + OVERSAMPLING / 2;
+
+                // The distances are between the pixel centers, so the outline is half a pixel away from them.
+                const float signed_distance = inside[index]
+                                                  ? std::sqrt(distance_to_outside[index]) - 0.5f
+                                                  : 0.5f - std::sqrt(distance_to_inside[index]);
+                const float value = (std::min)((std::max)(0.5f + signed_distance * scale, 0.0f), 1.0f);
+                field[static_cast<std::size_t>(y) * field_width + x] = static_cast<std::uint8_t>(value * 255.0f + 0.5f);
+            }
+        }
+    }
+
+private:
+    /**
+     * @brief Squared distance from each pixel to the nearest pixel whose inside flag equals @p feature.
+     *
+     * Felzenszwalb and Huttenlocher, "Distance Transforms of Sampled Functions", run on the columns then the rows.
+     */
+    static std::vector<float> squared_distance_transform(const std::vector<bool> &inside, int width, int height, bool feature) {
+        const float INF = 1e20f;
+
+        std::vector<float> distance(inside.size());
+        for (std::size_t i = 0; i < inside.size(); ++i) {
+            distance[i] = inside[i] == feature ? 0.0f : INF;
+        }
+
+        const int length = (std::max)(width, height);
+        std::vector<float> f(length);
+        std::vector<float> d(length);
+        std::vector<int> v(length);
+        std::vector<float> z(length + 1);
+
+        const auto transform_1d = [&](int n) {
+            int k = 0;
+            v[0] = 0;
+            z[0] = -INF;
+            z[1] = INF;
+            for (int q = 1; q < n; ++q) {
+                float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+                while (s <= z[k]) {
+                    --k;
+                    s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+                }
+                ++k;
+                v[k] = q;
+                z[k] = s;
+                z[k + 1] = INF;
+            }
+
+            k = 0;
+            for (int q = 0; q < n; ++q) {
+                while (z[k + 1] < q) ++k;
+                d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+            }
+        };
+
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < height; ++y) f[y] = distance[static_cast<std::size_t>(y) * width + x];
+            transform_1d(height);
+            for (int y = 0; y < height; ++y) distance[static_cast<std::size_t>(y) * width + x] = d[y];
+        }
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) f[x] = distance[static_cast<std::size_t>(y) * width + x];
+            transform_1d(width);
+            for (int x = 0; x < width; ++x) distance[static_cast<std::size_t>(y) * width + x] = d[x];
+        }
+        return distance;
+    }
+
+private:
+    FT_Face face_;
+    std::uint16_t pixel_size_;
+    std::uint16_t spread_;
+};
+
+#endif
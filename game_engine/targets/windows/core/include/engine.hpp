@@ -8,6 +8,7 @@
 #include "input/mouse_device_system.hpp"
 #include "physics/physics_system_backend.hpp"
 #include "rendering/scene_renderer.hpp"
+#include "rendering/scene_spatial_index.hpp"
 #include "resources/resources_backend.hpp"
 #include "scene_audio/scene_audio_system.hpp"
 #include "scene_serialization/scene_serialization_backend.hpp"
@@ -41,6 +42,15 @@ public:
 
     void frame_begin();
 
+    /**
+     * @brief Updates the transforms and the spatial index, then captures the scene snapshot all the views of the frame share.
+     *
+     * frame_end() calls it unless it was already called in the frame.
+     * The views rendered before frame_end(), like the editor scene view, call it first.
+     * The registry must not change between this and frame_end().
+     */
+    void update_scene();
+
     void frame_end();
 
     nodec_screen::Screen &screen() {
@@ -55,6 +65,10 @@ public:
         return *resources_;
     }
 
+    ResourceResidency &resource_residency() {
+        return resources_->residency();
+    }
+
     nodec_scene_serialization::SceneSerialization &scene_serialization() {
         return *scene_serialization_;
     }
@@ -70,6 +84,10 @@ public:
         return *scene_renderer_;
     }
 
+    SceneSpatialIndex &scene_spatial_index() {
+        return *scene_spatial_index_;
+    }
+
     SceneRenderingContext &scene_rendering_context() {
         return *scene_rendering_context_;
     }
@@ -106,6 +124,7 @@ private:
     std::unique_ptr<SceneRenderer> scene_renderer_;
 
     std::unique_ptr<nodec_rendering::systems::VisibilitySystem> visibility_system_;
+    std::unique_ptr<SceneSpatialIndex> scene_spatial_index_;
 
     std::unique_ptr<SceneAudioSystem> scene_audio_system_;
 
@@ -116,6 +135,8 @@ private:
 
     std::shared_ptr<nodec_animation::ComponentRegistry> animation_component_registry_;
     std::unique_ptr<nodec_animation::systems::AnimatorSystem> animator_system_;
+
+    bool scene_updated_{false};
 };
 
 #if CEREAL_THREAD_SAFE != 1
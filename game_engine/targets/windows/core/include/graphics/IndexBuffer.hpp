@@ -5,14 +5,20 @@
 class IndexBuffer
 {
 public:
-    IndexBuffer(Graphics* pGraphics, UINT size, const void* pSysMem) {
+    /**
+     * @param format DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT.
+     */
+    IndexBuffer(Graphics* pGraphics, UINT size, const void* pSysMem, DXGI_FORMAT format = DXGI_FORMAT_R16_UINT)
+        : mFormat(format) {
+        const UINT stride = format == DXGI_FORMAT_R32_UINT ? sizeof(uint32_t) : sizeof(uint16_t);
+
         D3D11_BUFFER_DESC ibd = {};
         ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
         ibd.Usage = D3D11_USAGE_DEFAULT;
         ibd.CPUAccessFlags = 0u;
         ibd.MiscFlags = 0u;
-        ibd.ByteWidth = size * sizeof(uint16_t);
-        ibd.StructureByteStride = sizeof(uint16_t);
+        ibd.ByteWidth = size * stride;
+        ibd.StructureByteStride = stride;
         D3D11_SUBRESOURCE_DATA isd = {};
         isd.pSysMem = pSysMem;
 
@@ -23,7 +29,7 @@ public:
     }
 
     void Bind(Graphics* pGraphics) {
-        pGraphics->context().IASetIndexBuffer(pIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0u);
+        pGraphics->context().IASetIndexBuffer(pIndexBuffer.Get(), mFormat, 0u);
 
         // NOTE: The following code is too heavy to run for each model.
         // const auto logs = pGraphics->info_logger().Dump();
@@ -36,6 +42,7 @@ public:
 
 private:
     Microsoft::WRL::ComPtr<ID3D11Buffer> pIndexBuffer;
+    DXGI_FORMAT mFormat;
 
 private:
     NODEC_DISABLE_COPY(IndexBuffer)
@@ -0,0 +1,76 @@
+#ifndef NODEC_GAME_ENGINE__GRAPHICS__INSTANCE_BUFFER_HPP_
+#define NODEC_GAME_ENGINE__GRAPHICS__INSTANCE_BUFFER_HPP_
+
+#include <cstring>
+
+#include "graphics.hpp"
+
+/**
+ * @brief Dynamic vertex buffer holding the per-instance data, or the vertices generated on the CPU.
+ *
+ * The buffer is rewritten from the CPU every frame.
+ * It grows to the largest size requested so far and is never shrunk.
+ */
+class InstanceBuffer {
+public:
+    InstanceBuffer(Graphics &gfx, UINT stride_bytes)
+        : gfx_(gfx), stride_bytes_(stride_bytes) {}
+
+    /**
+     * @brief Uploads @p count elements with discarding the previous contents.
+     */
+    void update(const void *sys_mem_ptr, UINT count) {
+        if (count == 0) return;
+
+        if (count > capacity_) {
+            reserve(count);
+        }
+
+        D3D11_MAPPED_SUBRESOURCE msr;
+        ThrowIfFailedGfx(
+            gfx_.context().Map(buffer_.Get(), 0u, D3D11_MAP_WRITE_DISCARD, 0u, &msr),
+            &gfx_, __FILE__, __LINE__);
+        std::memcpy(msr.pData, sys_mem_ptr, static_cast<std::size_t>(count) * stride_bytes_);
+        gfx_.context().Unmap(buffer_.Get(), 0u);
+    }
+
+    void bind(UINT slot) {
+        const UINT offset = 0u;
+        gfx_.context().IASetVertexBuffers(slot, 1u, buffer_.GetAddressOf(), &stride_bytes_, &offset);
+    }
+
+    UINT capacity() const noexcept {
+        return capacity_;
+    }
+
+private:
+    void reserve(UINT count) {
+        UINT new_capacity = capacity_ > 0 ? capacity_ : 256u;
+        while (new_capacity < count) new_capacity *= 2;
+
+        D3D11_BUFFER_DESC bd = {};
+        bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        bd.Usage = D3D11_USAGE_DYNAMIC;
+        bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        bd.MiscFlags = 0u;
+        bd.ByteWidth = new_capacity * stride_bytes_;
+        bd.StructureByteStride = stride_bytes_;
+
+        buffer_.Reset();
+        ThrowIfFailedGfx(
+            gfx_.device().CreateBuffer(&bd, nullptr, &buffer_),
+            &gfx_, __FILE__, __LINE__);
+        capacity_ = new_capacity;
+    }
+
+private:
+    Graphics &gfx_;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> buffer_;
+    UINT stride_bytes_;
+    UINT capacity_{0};
+
+private:
+    NODEC_DISABLE_COPY(InstanceBuffer)
+};
+
+#endif
@@ -24,6 +24,13 @@ public:
             &gfx, __FILE__, __LINE__);
     }
 
+    PixelShader(Graphics &gfx, const void *bytecode, std::size_t size)
+        : gfx_(gfx) {
+        ThrowIfFailedGfx(
+            gfx.device().CreatePixelShader(bytecode, size, nullptr, &pixel_shader_),
+            &gfx, __FILE__, __LINE__);
+    }
+
     void bind() {
         gfx_.context().PSSetShader(pixel_shader_.Get(), nullptr, 0u);
     }
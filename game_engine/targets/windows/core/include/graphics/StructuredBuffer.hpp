@@ -0,0 +1,90 @@
+#ifndef NODEC_GAME_ENGINE__GRAPHICS__STRUCTURED_BUFFER_HPP_
+#define NODEC_GAME_ENGINE__GRAPHICS__STRUCTURED_BUFFER_HPP_
+
+#include <cstring>
+
+#include "graphics.hpp"
+
+/**
+ * @brief Dynamic structured buffer read by the shaders through a shader resource view.
+ *
+ * The buffer is rewritten from the CPU every frame.
+ * It grows to the largest size requested so far and is never shrunk.
+ */
+class StructuredBuffer {
+public:
+    StructuredBuffer(Graphics &gfx, UINT stride_bytes)
+        : gfx_(gfx), stride_bytes_(stride_bytes) {}
+
+    /**
+     * @brief Uploads @p count elements with discarding the previous contents.
+     */
+    void update(const void *sys_mem_ptr, UINT count) {
+        if (count == 0) return;
+
+        if (count > capacity_) {
+            reserve(count);
+        }
+
+        D3D11_MAPPED_SUBRESOURCE msr;
+        ThrowIfFailedGfx(
+            gfx_.context().Map(buffer_.Get(), 0u, D3D11_MAP_WRITE_DISCARD, 0u, &msr),
+            &gfx_, __FILE__, __LINE__);
+        std::memcpy(msr.pData, sys_mem_ptr, static_cast<std::size_t>(count) * stride_bytes_);
+        gfx_.context().Unmap(buffer_.Get(), 0u);
+    }
+
+    /**
+     * @brief Binds the view to the pixel shader. Nothing is bound before the first update.
+     */
+    void bind_ps(UINT slot) {
+        gfx_.context().PSSetShaderResources(slot, 1u, shader_resource_view_.GetAddressOf());
+    }
+
+    UINT capacity() const noexcept {
+        return capacity_;
+    }
+
+private:
+    void reserve(UINT count) {
+        UINT new_capacity = capacity_ > 0 ? capacity_ : 256u;
+        while (new_capacity < count) new_capacity *= 2;
+
+        D3D11_BUFFER_DESC bd = {};
+        bd.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        bd.Usage = D3D11_USAGE_DYNAMIC;
+        bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        bd.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+        bd.ByteWidth = new_capacity * stride_bytes_;
+        bd.StructureByteStride = stride_bytes_;
+
+        shader_resource_view_.Reset();
+        buffer_.Reset();
+        ThrowIfFailedGfx(
+            gfx_.device().CreateBuffer(&bd, nullptr, &buffer_),
+            &gfx_, __FILE__, __LINE__);
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC desc = {};
+        desc.Format = DXGI_FORMAT_UNKNOWN;
+        desc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+        desc.Buffer.FirstElement = 0u;
+        desc.Buffer.NumElements = new_capacity;
+
+        ThrowIfFailedGfx(
+            gfx_.device().CreateShaderResourceView(buffer_.Get(), &desc, &shader_resource_view_),
+            &gfx_, __FILE__, __LINE__);
+        capacity_ = new_capacity;
+    }
+
+private:
+    Graphics &gfx_;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> buffer_;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_view_;
+    UINT stride_bytes_;
+    UINT capacity_{0};
+
+private:
+    NODEC_DISABLE_COPY(StructuredBuffer)
+};
+
+#endif
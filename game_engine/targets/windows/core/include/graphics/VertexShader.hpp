@@ -3,6 +3,8 @@
 
 #include <d3dcompiler.h>
 
+#include <cstring>
+
 #include <nodec/unicode.hpp>
 
 #include "graphics.hpp"
@@ -22,6 +24,21 @@ public:
             &gfx, __FILE__, __LINE__);
     }
 
+    /**
+     * @brief Creates the shader from the compiled bytecode in memory. The bytecode is copied for the input layouts.
+     */
+    VertexShader(Graphics &gfx, const void *bytecode, std::size_t size)
+        : gfx_(gfx) {
+        ThrowIfFailedGfx(D3DCreateBlob(size, &bytecode_blob_), &gfx, __FILE__, __LINE__);
+        std::memcpy(bytecode_blob_->GetBufferPointer(), bytecode, size);
+
+        ThrowIfFailedGfx(
+            gfx.device().CreateVertexShader(
+                bytecode_blob_->GetBufferPointer(), bytecode_blob_->GetBufferSize(),
+                nullptr, &vertex_shader_),
+            &gfx, __FILE__, __LINE__);
+    }
+
     void bind() {
         gfx_.context().VSSetShader(vertex_shader_.Get(), nullptr, 0u);
     }
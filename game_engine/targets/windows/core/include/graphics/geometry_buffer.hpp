@@ -5,15 +5,15 @@
 
 class GeometryBuffer {
 public:
-    GeometryBuffer(Graphics *gfx, UINT width, UINT height)
-        : width_{width}, height_{height} {
+    GeometryBuffer(Graphics *gfx, UINT width, UINT height, DXGI_FORMAT format = DXGI_FORMAT_R32G32B32A32_FLOAT)
+        : width_{width}, height_{height}, format_{format} {
         // Generate the render target textures.
         D3D11_TEXTURE2D_DESC textureDesc{};
         textureDesc.Width = width;
         textureDesc.Height = height;
         textureDesc.MipLevels = 1;
         textureDesc.ArraySize = 1;
-        textureDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        textureDesc.Format = format;
         textureDesc.SampleDesc.Count = 1;
         textureDesc.Usage = D3D11_USAGE_DEFAULT;
         textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
@@ -62,9 +62,14 @@ public:
         return height_;
     }
 
+    DXGI_FORMAT format() const noexcept {
+        return format_;
+    }
+
 private:
     UINT width_;
     UINT height_;
+    DXGI_FORMAT format_;
     Microsoft::WRL::ComPtr<ID3D11Texture2D> texture_;
     Microsoft::WRL::ComPtr<ID3D11RenderTargetView> render_target_view_;
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_view_;
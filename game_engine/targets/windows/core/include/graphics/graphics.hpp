@@ -25,6 +25,8 @@ public:
 
     void DrawIndexed(UINT count);
 
+    void DrawIndexedInstanced(UINT count, UINT instance_count, UINT start_instance);
+
     ID3D11Device &device() noexcept {
         return *device_.Get();
     }
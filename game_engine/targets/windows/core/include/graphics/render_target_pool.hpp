@@ -0,0 +1,172 @@
+#ifndef NODEC_GAME_ENGINE__GRAPHICS__RENDER_TARGET_POOL_HPP_
+#define NODEC_GAME_ENGINE__GRAPHICS__RENDER_TARGET_POOL_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <nodec/macros.hpp>
+#include <nodec/optional.hpp>
+
+#include "geometry_buffer.hpp"
+#include "graphics.hpp"
+
+/**
+ * @brief The format and the size of a named render target, declared by the sub-shader meta.
+ */
+struct RenderTargetDesc {
+    DXGI_FORMAT format{DXGI_FORMAT_R32G32B32A32_FLOAT};
+
+    //! The size relative to the rendering target.
+    float scale{1.0f};
+};
+
+/**
+ * @brief Parses the format name used in the sub-shader meta, like "R11G11B10_FLOAT".
+ */
+inline nodec::optional<DXGI_FORMAT> parse_render_target_format(const std::string &name) {
+    struct Entry {
+        const char *name;
+        DXGI_FORMAT format;
+    };
+    static const Entry entries[] = {
+        {"R32G32B32A32_FLOAT", DXGI_FORMAT_R32G32B32A32_FLOAT},
+        {"R16G16B16A16_FLOAT", DXGI_FORMAT_R16G16B16A16_FLOAT},
+        {"R11G11B10_FLOAT", DXGI_FORMAT_R11G11B10_FLOAT},
+        {"R10G10B10A2_UNORM", DXGI_FORMAT_R10G10B10A2_UNORM},
+        {"R8G8B8A8_UNORM", DXGI_FORMAT_R8G8B8A8_UNORM},
+        {"R16G16_FLOAT", DXGI_FORMAT_R16G16_FLOAT},
+        {"R32_FLOAT", DXGI_FORMAT_R32_FLOAT},
+        {"R16_FLOAT", DXGI_FORMAT_R16_FLOAT},
+        {"R8_UNORM", DXGI_FORMAT_R8_UNORM}};
+
+    for (const auto &entry : entries) {
+        if (name == entry.name) return entry.format;
+    }
+    return nodec::nullopt;
+}
+
+/**
+ * @brief The bytes per pixel of the formats accepted by parse_render_target_format().
+ */
+inline std::uint32_t render_target_format_size(DXGI_FORMAT format) noexcept {
+    switch (format) {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        return 16;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        return 8;
+    case DXGI_FORMAT_R16_FLOAT:
+        return 2;
+    case DXGI_FORMAT_R8_UNORM:
+        return 1;
+    default:
+        return 4;
+    }
+}
+
+/**
+ * @brief The size of a render target scaled from the rendering target size. It is rounded up and at least one.
+ */
+inline UINT scaled_render_target_size(std::uint32_t size, float scale) noexcept {
+    return (std::max)(static_cast<UINT>(std::ceil(size * scale)), 1u);
+}
+
+/**
+ * @brief Owns the render target textures and lends them by the format and the size.
+ *
+ * A texture released by one render target is lent to the next one of the same format and size,
+ * so the render targets whose lifetimes do not overlap share the memory.
+ * The textures not lent for MAX_UNUSED_FRAMES frames are destroyed.
+ *
+ * @tparam Buffer The texture, made from the device, the size and the format like GeometryBuffer.
+ *   The tests lend the textures of no device through it.
+ */
+template<typename Buffer, typename Device>
+class BasicRenderTargetPool {
+public:
+    static constexpr std::uint64_t MAX_UNUSED_FRAMES = 120;
+
+    BasicRenderTargetPool(Device &device)
+        : device_(device) {}
+
+    Buffer &acquire(DXGI_FORMAT format, UINT width, UINT height) {
+        for (auto &entry : entries_) {
+            auto &buffer = *entry.buffer;
+            if (entry.in_use || buffer.format() != format || buffer.width() != width || buffer.height() != height) continue;
+
+            entry.in_use = true;
+            entry.last_used_frame = frame_;
+            return buffer;
+        }
+
+        entries_.push_back({std::make_unique<Buffer>(&device_, width, height, format), true, frame_});
+        allocated_bytes_ += bytes_of(*entries_.back().buffer);
+        return *entries_.back().buffer;
+    }
+
+    void release(Buffer &buffer) noexcept {
+        for (auto &entry : entries_) {
+            if (entry.buffer.get() != &buffer) continue;
+            entry.in_use = false;
+            return;
+        }
+    }
+
+    /**
+     * @brief Advances the frame, and destroys the textures left unused for long.
+     *
+     * @param on_destroy Called with each texture just before it is destroyed.
+     */
+    template<typename OnDestroy>
+    void end_frame(OnDestroy &&on_destroy) {
+        ++frame_;
+        for (std::size_t i = 0; i < entries_.size();) {
+            auto &entry = entries_[i];
+            if (entry.in_use || entry.last_used_frame + MAX_UNUSED_FRAMES >= frame_) {
+                ++i;
+                continue;
+            }
+            on_destroy(*entry.buffer);
+            allocated_bytes_ -= bytes_of(*entry.buffer);
+            entries_[i] = std::move(entries_.back());
+            entries_.pop_back();
+        }
+    }
+
+    std::size_t texture_count() const noexcept {
+        return entries_.size();
+    }
+
+    /**
+     * @brief The bytes of the textures the pool owns.
+     */
+    std::uint64_t allocated_bytes() const noexcept {
+        return allocated_bytes_;
+    }
+
+    static std::uint64_t bytes_of(const Buffer &buffer) noexcept {
+        return static_cast<std::uint64_t>(buffer.width()) * buffer.height() * render_target_format_size(buffer.format());
+    }
+
+private:
+    struct Entry {
+        std::unique_ptr<Buffer> buffer;
+        bool in_use;
+        std::uint64_t last_used_frame;
+    };
+
+    Device &device_;
+    std::vector<Entry> entries_;
+    std::uint64_t frame_{0};
+    std::uint64_t allocated_bytes_{0};
+
+private:
+    NODEC_DISABLE_COPY(BasicRenderTargetPool)
+};
+
+using RenderTargetPool = BasicRenderTargetPool<GeometryBuffer, Graphics>;
+
+#endif
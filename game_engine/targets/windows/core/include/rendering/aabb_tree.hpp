@@ -0,0 +1,205 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__AABB_TREE_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__AABB_TREE_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "frustum_culling.hpp"
+
+/**
+ * @brief Dynamic bounding volume hierarchy of axis-aligned boxes.
+ *
+ * The leaves store enlarged ("fat") boxes, so the proxies moving within their margin
+ * do not touch the tree. The tree is kept balanced by the AVL-like rotations on insertion.
+ * See Erin Catto's b2DynamicTree for the original design.
+ *
+ * @note The queries share the traversal stacks of the tree, so a tree must not be queried from two threads at once.
+ */
+class AabbTree {
+public:
+    static constexpr int NULL_NODE = -1;
+
+    struct Box {
+        DirectX::XMFLOAT3 min;
+        DirectX::XMFLOAT3 max;
+
+        bool contains(const Box &other) const noexcept {
+            return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+                   && other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+        }
+    };
+
+    AabbTree() = default;
+
+    /**
+     * @brief Inserts a proxy and returns its id.
+     */
+    int create_proxy(const Box &box, std::uint32_t user_data);
+
+    void destroy_proxy(int proxy_id);
+
+    /**
+     * @brief Updates the box of the proxy.
+     *
+     * @return true if the proxy left its fat box and was reinserted.
+     */
+    bool move_proxy(int proxy_id, const Box &box);
+
+    std::uint32_t user_data(int proxy_id) const noexcept {
+        return nodes_[proxy_id].user_data;
+    }
+
+    const Box &fat_box(int proxy_id) const noexcept {
+        return nodes_[proxy_id].box;
+    }
+
+    std::size_t proxy_count() const noexcept {
+        return proxy_count_;
+    }
+
+    int height() const noexcept {
+        return root_ == NULL_NODE ? 0 : nodes_[root_].height;
+    }
+
+    /**
+     * @brief Calls callback(user_data, is_inside) for each proxy whose fat box is not outside the planes.
+     *
+     * When a whole subtree is inside the frustum, its leaves are reported without further tests.
+     */
+    template<typename Callback>
+    void query_frustum(const CullingPlanes &planes, Callback &&callback) const {
+        if (root_ == NULL_NODE) return;
+
+        auto &stack = query_stack_;
+        stack.clear();
+        stack.push_back(root_);
+
+        while (!stack.empty()) {
+            const auto node_id = stack.back();
+            stack.pop_back();
+            const auto &node = nodes_[node_id];
+
+            const auto result = classify(planes, node.box);
+            if (result == Classification::Outside) continue;
+
+            if (result == Classification::Inside) {
+                report_leaves(node_id, callback);
+                continue;
+            }
+
+            if (node.is_leaf()) {
+                callback(node.user_data, false);
+                continue;
+            }
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+
+    /**
+     * @brief Casts a ray against the fat boxes.
+     *
+     * The callback is called as callback(user_data, distance) for each proxy whose box the ray enters
+     * before @p max_distance. It returns the new max distance, so a closest-hit query can clip the ray.
+     *
+     * @param direction Need not be normalized. The distances are in units of its length.
+     */
+    template<typename Callback>
+    void raycast(const DirectX::XMFLOAT3 &origin, const DirectX::XMFLOAT3 &direction, float max_distance,
+                 Callback &&callback) const {
+        if (root_ == NULL_NODE) return;
+
+        auto &stack = query_stack_;
+        stack.clear();
+        stack.push_back(root_);
+
+        while (!stack.empty()) {
+            const auto node_id = stack.back();
+            stack.pop_back();
+            const auto &node = nodes_[node_id];
+
+            float distance;
+            if (!intersect_ray(node.box, origin, direction, max_distance, distance)) continue;
+
+            if (node.is_leaf()) {
+                max_distance = callback(node.user_data, distance);
+                continue;
+            }
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+
+    /**
+     * @brief Tests the ray against the box by the slab method.
+     *
+     * @param distance The entry distance, or zero if the origin is inside the box.
+     */
+    static bool intersect_ray(const Box &box, const DirectX::XMFLOAT3 &origin, const DirectX::XMFLOAT3 &direction,
+                              float max_distance, float &distance) noexcept;
+
+private:
+    enum class Classification {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    struct Node {
+        Box box;
+        std::uint32_t user_data;
+        int parent;
+        int child1;
+        int child2;
+
+        // The leaf is 0. The free node is -1.
+        int height;
+
+        bool is_leaf() const noexcept {
+            return child1 == NULL_NODE;
+        }
+    };
+
+    static Box merge(const Box &a, const Box &b) noexcept;
+    static float surface_area(const Box &box) noexcept;
+    static Classification classify(const CullingPlanes &planes, const Box &box) noexcept;
+
+    static Box fatten(const Box &box) noexcept;
+
+    template<typename Callback>
+    void report_leaves(int node_id, Callback &callback) const {
+        auto &stack = leaf_stack_;
+        stack.clear();
+        stack.push_back(node_id);
+        while (!stack.empty()) {
+            const auto &node = nodes_[stack.back()];
+            stack.pop_back();
+            if (node.is_leaf()) {
+                callback(node.user_data, true);
+                continue;
+            }
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+
+    int allocate_node();
+    void free_node(int node_id);
+
+    void insert_leaf(int leaf);
+    void remove_leaf(int leaf);
+    int balance(int node_id);
+
+private:
+    std::vector<Node> nodes_;
+    int root_{NULL_NODE};
+    int free_list_{NULL_NODE};
+    std::size_t proxy_count_{0};
+
+    mutable std::vector<int> query_stack_;
+    mutable std::vector<int> leaf_stack_;
+};
+
+#endif
@@ -9,6 +9,8 @@
 #include <nodec/gfx/gfx.hpp>
 #include <nodec_rendering/components/camera.hpp>
 
+#include "frustum_culling.hpp"
+
 class CameraState {
 public:
     CameraState()
@@ -41,6 +43,8 @@ public:
         matrix_p_inverse_ = XMMatrixInverse(nullptr, matrix_p_);
 
         aspect_ = aspect;
+
+        culling_planes_ = CullingPlanes::from_view_projection(matrix_v_ * matrix_p_);
     }
 
     void update_transform(const nodec::Matrix4x4f &camera_local_to_world) {
@@ -49,6 +53,8 @@ public:
         matrix_v_inverse_ = XMMATRIX(camera_local_to_world.m);
         matrix_v_ = XMMatrixInverse(nullptr, matrix_v_inverse_);
 
+        culling_planes_ = CullingPlanes::from_view_projection(matrix_v_ * matrix_p_);
+
         nodec::gfx::TRSComponents trs;
         nodec::gfx::decompose_trs(camera_local_to_world, trs);
 
@@ -86,10 +92,25 @@ public:
         return matrix_v_inverse_;
     }
 
+    float near_clip() const {
+        return camera_.near_clip_plane;
+    }
+
+    float far_clip() const {
+        return camera_.far_clip_plane;
+    }
+
     const nodec::gfx::Frustum &frustum() const {
         return frustum_;
     }
 
+    /**
+     * @brief The frustum planes for the batch culling, extracted from the view-projection matrix.
+     */
+    const CullingPlanes &culling_planes() const {
+        return culling_planes_;
+    }
+
     // btCollisionObject *frustum_object() const {
     //     return frustum_object_.get();
     // }
@@ -97,6 +118,7 @@ public:
 private:
     float aspect_;
     nodec::gfx::Frustum frustum_;
+    CullingPlanes culling_planes_{};
     nodec_rendering::components::Camera camera_;
     DirectX::XMMATRIX matrix_p_;
     DirectX::XMMATRIX matrix_p_inverse_;
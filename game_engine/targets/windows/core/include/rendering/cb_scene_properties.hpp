@@ -21,19 +21,24 @@ public:
         std::uint32_t padding[3];
     };
 
-    struct PointLight {
-        nodec::Vector3f position;
-        float range;
-        nodec::Vector3f color;
-        float intensity;
-    };
-
+    /**
+     * @brief The point lights themselves are in PointLightBuffer, uploaded apart from these per-view constants.
+     */
     struct SceneLighting {
         nodec::Vector4f ambient_color;
         std::uint32_t num_of_point_lights;
         std::uint32_t padding[3];
         DirectionalLight directional;
-        PointLight point_lights[1024];
+    };
+
+    /**
+     * @brief The layout of the light cluster grid. See LightClusterGrid.
+     */
+    struct LightClusters {
+        std::uint32_t cluster_count[3];
+        float z_slice_scale;
+        float z_slice_bias;
+        std::uint32_t padding[3];
     };
 
     struct SceneProperties {
@@ -42,6 +47,7 @@ public:
         DirectX::XMFLOAT4X4 matrix_p_inverse;
         DirectX::XMFLOAT4X4 matrix_v;
         DirectX::XMFLOAT4X4 matrix_v_inverse;
+        LightClusters clusters;
         SceneLighting lights;
     };
 
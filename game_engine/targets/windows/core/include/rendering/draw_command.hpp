@@ -0,0 +1,92 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__DRAW_COMMAND_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__DRAW_COMMAND_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include <nodec/vector4.hpp>
+#include <nodec_rendering/components/text_renderer.hpp>
+
+class MeshBackend;
+class MaterialBackend;
+class TextureBackend;
+struct TextLayout;
+
+/**
+ * @brief Plain draw record submitted by the scene renderer.
+ *
+ * The record holds only raw pointers. The pointees are owned by the scene components
+ * and are alive while the frame which submitted the record is rendered.
+ */
+struct DrawCommand {
+    enum class Type : std::uint8_t {
+        Mesh,
+        Image,
+        Text
+    };
+
+    DirectX::XMMATRIX matrix_m;
+    Type type;
+    MeshBackend *mesh;
+    MaterialBackend *material;
+    TextureBackend *image;
+    const nodec_rendering::components::TextRenderer *text_renderer;
+    TextLayout *text_layout;
+    nodec::Vector4f color;
+
+    static DrawCommand make_mesh(const DirectX::XMMATRIX &matrix_m, MeshBackend *mesh, MaterialBackend *material) {
+        return {matrix_m, Type::Mesh, mesh, material, nullptr, nullptr, nullptr, {}};
+    }
+
+    static DrawCommand make_image(const DirectX::XMMATRIX &matrix_m, TextureBackend *image, MaterialBackend *material,
+                                  const nodec::Vector4f &color) {
+        return {matrix_m, Type::Image, nullptr, material, image, nullptr, nullptr, color};
+    }
+
+    static DrawCommand make_text(const DirectX::XMMATRIX &matrix_m, MaterialBackend *material,
+                                 const nodec_rendering::components::TextRenderer &text_renderer, TextLayout &text_layout) {
+        return {matrix_m, Type::Text, nullptr, material, nullptr, &text_renderer, &text_layout, {}};
+    }
+};
+
+/**
+ * @brief Frame-scoped linear storage of the draw commands.
+ *
+ * The commands are referred by index. The storage keeps its capacity over the frames,
+ * so pushing commands does not allocate once the scene reaches its steady state.
+ */
+class DrawCommandBuffer {
+public:
+    using Index = std::uint32_t;
+
+    Index push(const DrawCommand &command) {
+        commands_.push_back(command);
+        return static_cast<Index>(commands_.size() - 1);
+    }
+
+    DrawCommand &operator[](Index index) noexcept {
+        return commands_[index];
+    }
+
+    const DrawCommand &operator[](Index index) const noexcept {
+        return commands_[index];
+    }
+
+    std::size_t size() const noexcept {
+        return commands_.size();
+    }
+
+    /**
+     * @brief Discards all commands in O(1). The allocated memory is retained.
+     */
+    void reset() noexcept {
+        commands_.clear();
+    }
+
+private:
+    std::vector<DrawCommand> commands_;
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__DRAW_QUEUE_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__DRAW_QUEUE_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "draw_command.hpp"
+
+/**
+ * @brief Packs the draw order of a command into 64 bits.
+ *
+ * Layout (from the most significant bit):
+ *   [63]     transparent flag (opaque first)
+ *   [62..47] shader rendering priority (biased)
+ *   [46..35] shader id
+ *   [34..0]  opaque:      material id (15 bits) | mesh id (10 bits) | coarse depth front-to-back (10 bits)
+ *            transparent: depth back-to-front (20 bits) | material id (15 bits)
+ *
+ * The opaque draws of the same mesh and material end up adjacent, so they can be instanced.
+ *
+ * The shader ids are unique among the live shaders and fit in their field, so the draws of a shader
+ * are contiguous within each priority and transparency. The renderer builds the passes of a shader per run,
+ * and a split run would execute the passes of a multi-pass shader twice.
+ *
+ * The material and mesh ids are masked into their fields. A collision there only costs extra state changes,
+ * because the renderer compares the actual pointers when it batches the draws.
+ */
+struct DrawSortKey {
+    static constexpr int DEPTH_BITS = 20;
+    static constexpr int MATERIAL_BITS = 15;
+    static constexpr int OPAQUE_MESH_BITS = 10;
+    static constexpr int OPAQUE_DEPTH_BITS = DEPTH_BITS - OPAQUE_MESH_BITS;
+    static constexpr int SHADER_BITS = 12;
+    static constexpr int PRIORITY_BITS = 16;
+
+    static constexpr int SHADER_SHIFT = DEPTH_BITS + MATERIAL_BITS;
+    static constexpr int PRIORITY_SHIFT = SHADER_SHIFT + SHADER_BITS;
+    static constexpr int TRANSPARENT_SHIFT = PRIORITY_SHIFT + PRIORITY_BITS;
+
+    static std::uint64_t make_opaque(int priority, std::uint32_t shader_id, std::uint32_t material_id,
+                                     std::uint32_t mesh_id, float depth) noexcept {
+        return header(false, priority, shader_id)
+               | (field(material_id, MATERIAL_BITS) << DEPTH_BITS)
+               | (field(mesh_id, OPAQUE_MESH_BITS) << OPAQUE_DEPTH_BITS)
+               | quantize_depth(depth, OPAQUE_DEPTH_BITS);
+    }
+
+    static std::uint64_t make_transparent(int priority, std::uint32_t shader_id, std::uint32_t material_id, float depth) noexcept {
+        const auto far_first = field(~quantize_depth(depth, DEPTH_BITS), DEPTH_BITS);
+        return header(true, priority, shader_id)
+               | (far_first << MATERIAL_BITS)
+               | field(material_id, MATERIAL_BITS);
+    }
+
+    static bool is_transparent(std::uint64_t key) noexcept {
+        return (key >> TRANSPARENT_SHIFT) != 0;
+    }
+
+    /**
+     * @brief Maps the view depth to an integer which keeps the order of the non-negative floats.
+     *
+     * The bit pattern of a positive IEEE-754 float increases monotonically with its value,
+     * so the top bits below the sign are a cheap quantization.
+     */
+    static std::uint64_t quantize_depth(float depth, int bits) noexcept {
+        if (!(depth > 0.0f)) return 0;
+        std::uint32_t depth_bits;
+        std::memcpy(&depth_bits, &depth, sizeof(depth_bits));
+        return depth_bits >> (31 - bits);
+    }
+
+private:
+    static std::uint64_t field(std::uint64_t value, int bits) noexcept {
+        return value & ((std::uint64_t{1} << bits) - 1);
+    }
+
+    static std::uint64_t header(bool is_transparent, int priority, std::uint32_t shader_id) noexcept {
+        const auto clamped = (std::max)(static_cast<int>((std::numeric_limits<std::int16_t>::min)()),
+                                        (std::min)(priority, static_cast<int>((std::numeric_limits<std::int16_t>::max)())));
+        const auto biased = static_cast<std::uint64_t>(clamped + 0x8000);
+        return (static_cast<std::uint64_t>(is_transparent) << TRANSPARENT_SHIFT)
+               | (biased << PRIORITY_SHIFT)
+               | (field(shader_id, SHADER_BITS) << SHADER_SHIFT);
+    }
+};
+
+/**
+ * @brief Flat list of (sort key, command index) pairs for one camera pass.
+ */
+class DrawQueue {
+public:
+    struct Item {
+        std::uint64_t key;
+        DrawCommandBuffer::Index command;
+    };
+
+    void push(std::uint64_t key, DrawCommandBuffer::Index command) {
+        items_.push_back({key, command});
+    }
+
+    /**
+     * @brief Sorts the items by key with a stable LSD radix sort.
+     *
+     * The items with the same key keep the submission order, so the result is deterministic.
+     * The byte passes in which all keys share the same digit are skipped.
+     */
+    void sort() {
+        constexpr int RADIX_BITS = 8;
+        constexpr std::size_t BUCKET_COUNT = 1 << RADIX_BITS;
+        constexpr int PASS_COUNT = 64 / RADIX_BITS;
+
+        if (items_.size() < 2) return;
+
+        scratch_.resize(items_.size());
+
+        std::size_t histograms[PASS_COUNT][BUCKET_COUNT]{};
+        for (const auto &item : items_) {
+            for (int pass = 0; pass < PASS_COUNT; ++pass) {
+                ++histograms[pass][(item.key >> (pass * RADIX_BITS)) & (BUCKET_COUNT - 1)];
+            }
+        }
+
+        auto *src = &items_;
+        auto *dst = &scratch_;
+        for (int pass = 0; pass < PASS_COUNT; ++pass) {
+            auto &histogram = histograms[pass];
+            const auto shift = pass * RADIX_BITS;
+
+            const auto first_digit = (src->front().key >> shift) & (BUCKET_COUNT - 1);
+            if (histogram[first_digit] == src->size()) continue;
+
+            std::size_t offset = 0;
+            for (auto &count : histogram) {
+                const auto next = offset + count;
+                count = offset;
+                offset = next;
+            }
+
+            for (const auto &item : *src) {
+                (*dst)[histogram[(item.key >> shift) & (BUCKET_COUNT - 1)]++] = item;
+            }
+            std::swap(src, dst);
+        }
+
+        if (src != &items_) {
+            items_.swap(scratch_);
+        }
+    }
+
+    void clear() noexcept {
+        items_.clear();
+    }
+
+    std::size_t size() const noexcept {
+        return items_.size();
+    }
+
+    const Item &operator[](std::size_t index) const noexcept {
+        return items_[index];
+    }
+
+    decltype(auto) begin() const noexcept {
+        return items_.begin();
+    }
+
+    decltype(auto) end() const noexcept {
+        return items_.end();
+    }
+
+private:
+    std::vector<Item> items_;
+    std::vector<Item> scratch_;
+};
+
+#endif
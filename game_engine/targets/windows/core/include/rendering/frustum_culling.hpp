@@ -0,0 +1,180 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__FRUSTUM_CULLING_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__FRUSTUM_CULLING_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include <nodec/gfx/bouding_box.hpp>
+
+/**
+ * @brief The six frustum planes in the structure-of-arrays layout.
+ *
+ * A point p is inside the plane i when nx[i] * p.x + ny[i] * p.y + nz[i] * p.z + d[i] >= 0.
+ * The planes are not normalized. The box test compares two values scaled by the same factor, so it does not need it.
+ */
+struct CullingPlanes {
+    static constexpr int PLANE_COUNT = 6;
+
+    float nx[PLANE_COUNT];
+    float ny[PLANE_COUNT];
+    float nz[PLANE_COUNT];
+    float d[PLANE_COUNT];
+
+    /**
+     * @brief Extracts the planes from the view-projection matrix (row-vector convention, z in [0, 1]).
+     */
+    static CullingPlanes from_view_projection(const DirectX::XMMATRIX &matrix_vp);
+};
+
+/**
+ * @brief World-space axis-aligned boxes in the structure-of-arrays layout.
+ *
+ * The arrays are padded to a multiple of four, so the kernel can always load four boxes at once.
+ */
+class WorldBoundsArray {
+public:
+    void resize(std::size_t size) {
+        size_ = size;
+        const auto padded = (size + 3) & ~std::size_t{3};
+        center_x_.resize(padded);
+        center_y_.resize(padded);
+        center_z_.resize(padded);
+        extents_x_.resize(padded);
+        extents_y_.resize(padded);
+        extents_z_.resize(padded);
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+    /**
+     * @brief Stores the box enclosing the local bounds transformed by the model matrix.
+     */
+    void set(std::size_t index, const nodec::gfx::BoundingBox &local_bounds, const DirectX::XMMATRIX &matrix_m);
+
+    /**
+     * @brief Stores the box at @p other_index of @p other.
+     */
+    void copy(std::size_t index, const WorldBoundsArray &other, std::size_t other_index);
+
+    /**
+     * @brief Grows the box at @p index to enclose the box at @p other_index of @p other.
+     */
+    void merge(std::size_t index, const WorldBoundsArray &other, std::size_t other_index);
+
+    const float *center_x() const noexcept {
+        return center_x_.data();
+    }
+    const float *center_y() const noexcept {
+        return center_y_.data();
+    }
+    const float *center_z() const noexcept {
+        return center_z_.data();
+    }
+    const float *extents_x() const noexcept {
+        return extents_x_.data();
+    }
+    const float *extents_y() const noexcept {
+        return extents_y_.data();
+    }
+    const float *extents_z() const noexcept {
+        return extents_z_.data();
+    }
+
+private:
+    std::size_t size_{0};
+    std::vector<float> center_x_;
+    std::vector<float> center_y_;
+    std::vector<float> center_z_;
+    std::vector<float> extents_x_;
+    std::vector<float> extents_y_;
+    std::vector<float> extents_z_;
+};
+
+/**
+ * @brief Tests the boxes [begin, end) against the planes.
+ *
+ * The bit i of @p visible_bits is set if the box i intersects or is inside the frustum.
+ * If @p inside_bits is not null, its bit i is set if the box i is entirely inside the frustum.
+ * The words covering [begin, end) are overwritten.
+ *
+ * @note @p begin must be a multiple of 64, so that the concurrent calls on the disjoint ranges never share a word.
+ */
+void cull_world_bounds(const CullingPlanes &planes, const WorldBoundsArray &bounds,
+                       std::size_t begin, std::size_t end,
+                       std::uint64_t *visible_bits, std::uint64_t *inside_bits = nullptr);
+
+/**
+ * @brief Tests one box against the planes. Returns true if the box intersects or is inside the frustum.
+ */
+bool test_world_bounds(const CullingPlanes &planes, const WorldBoundsArray &bounds, std::size_t index);
+
+/**
+ * @brief The counters of cull_submeshes, named like the ones of SceneRendererStats.
+ */
+struct SubmeshCullingStats {
+    std::uint64_t entity_bounds_tests{0};
+    std::uint64_t submesh_bounds_tests{0};
+    std::uint64_t submesh_bounds_tests_saved{0};
+};
+
+inline std::size_t visibility_word_count(std::size_t bit_count) noexcept {
+    return (bit_count + 63) / 64;
+}
+
+inline bool test_visibility_bit(const std::uint64_t *bits, std::size_t index) noexcept {
+    return (bits[index / 64] >> (index % 64)) & 1u;
+}
+
+/**
+ * @brief Culls the entities [begin, end) by their combined bounds, then the submeshes of the entities straddling a plane.
+ *
+ * If @p is_entity_tested, the entity bounds are tested here and the words of the bits covering [begin, end) are overwritten.
+ * Otherwise the bits are the ones the caller set (from the spatial index), and the entities left out are not counted.
+ *
+ * @param submeshes submeshes(entity) returns the pair of the first index in @p submesh_bounds and the submesh count.
+ * @param visit visit(entity, submesh) is called for each visible submesh, in the index order.
+ *
+ * @note @p begin must be a multiple of 64, like for cull_world_bounds.
+ */
+template<typename Submeshes, typename Visit>
+void cull_submeshes(const CullingPlanes &planes,
+                    const WorldBoundsArray &entity_bounds, const WorldBoundsArray &submesh_bounds,
+                    std::size_t begin, std::size_t end, bool is_entity_tested,
+                    std::uint64_t *visible_bits, std::uint64_t *inside_bits,
+                    Submeshes &&submeshes, Visit &&visit, SubmeshCullingStats &stats) {
+    if (is_entity_tested) {
+        cull_world_bounds(planes, entity_bounds, begin, end, visible_bits, inside_bits);
+        stats.entity_bounds_tests += end - begin;
+    }
+
+    for (auto entity = begin; entity < end; ++entity) {
+        const auto range = submeshes(entity);
+        const std::size_t first = range.first;
+        const std::size_t count = range.second;
+
+        if (!test_visibility_bit(visible_bits, entity)) {
+            // The entities the query does not report are never tested.
+            if (is_entity_tested) stats.submesh_bounds_tests_saved += count;
+            continue;
+        }
+
+        // A single submesh has the same bounds as the entity, so the entity test decides it.
+        const bool is_inside = count == 1 || test_visibility_bit(inside_bits, entity);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            if (is_inside) {
+                ++stats.submesh_bounds_tests_saved;
+            } else {
+                ++stats.submesh_bounds_tests;
+                if (!test_world_bounds(planes, submesh_bounds, first + i)) continue;
+            }
+            visit(entity, i);
+        }
+    }
+}
+
+#endif
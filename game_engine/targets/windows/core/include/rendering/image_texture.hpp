@@ -9,34 +9,16 @@
 
 class ImageTexture : public TextureBackend {
 public:
-    ImageTexture(Graphics *gfx, const std::string &path) {
+    /**
+     * @param upload_now If false, the image is kept in memory until upload(), which may run on another thread.
+     */
+    ImageTexture(Graphics *gfx, const std::string &path, bool upload_now = true) {
         using namespace DirectX;
 
-        enum class ImageType {
-            TGA,
-            WIC,
-            HDR
-        };
-
-        ImageType image_type = ImageType::WIC;
-
-        auto extention_pos = path.find_last_of('.');
-        if (extention_pos != std::string::npos) {
-            auto extention = path.substr(extention_pos);
-
-            if (extention == ".tga" || extention == ".TGA") {
-                image_type = ImageType::TGA;
-            }
-
-            if (extention == ".hdr") {
-                image_type = ImageType::HDR;
-            }
-        }
-
         std::wstring path_wide = nodec::unicode::utf8to16<std::wstring>(path);
 
-        ScratchImage image;
-        switch (image_type) {
+        auto &image = image_;
+        switch (image_type(path)) {
         case ImageType::TGA:
             ThrowIfFailedGfx(
                 LoadFromTGAFile(path_wide.c_str(), &metadata_, image),
@@ -55,16 +37,82 @@ public:
             break;
         }
 
+        if (upload_now) upload(gfx);
+    }
+
+    /**
+     * @brief Decodes the image file read in memory, like the one in the resource archive.
+     *
+     * @param path Picks the decoder by the extension.
+     */
+    ImageTexture(Graphics *gfx, const std::string &path, const void *data, std::size_t size, bool upload_now = true) {
+        using namespace DirectX;
+
+        auto &image = image_;
+        switch (image_type(path)) {
+        case ImageType::TGA:
+            ThrowIfFailedGfx(
+                LoadFromTGAMemory(data, size, &metadata_, image),
+                gfx, __FILE__, __LINE__);
+            break;
+        case ImageType::HDR:
+            ThrowIfFailedGfx(
+                LoadFromHDRMemory(data, size, &metadata_, image),
+                gfx, __FILE__, __LINE__);
+            break;
+        default:
+        case ImageType::WIC:
+            ThrowIfFailedGfx(
+                LoadFromWICMemory(data, size, WIC_FLAGS::WIC_FLAGS_NONE, &metadata_, image),
+                gfx, __FILE__, __LINE__);
+            break;
+        }
+
+        if (upload_now) upload(gfx);
+    }
+
+    /**
+     * @brief Creates the texture from the image read by the constructor, then releases the image.
+     */
+    void upload(Graphics *gfx) {
+        using namespace DirectX;
+
         // create the resource view on the texture
         ThrowIfFailedGfx(
-            CreateShaderResourceView(&gfx->device(), image.GetImages(), image.GetImageCount(), metadata_, &shader_resource_view_),
+            CreateShaderResourceView(&gfx->device(), image_.GetImages(), image_.GetImageCount(), metadata_, &shader_resource_view_),
             gfx, __FILE__, __LINE__);
 
         initialize(shader_resource_view_.Get(), metadata_.width, metadata_.height);
+        image_.Release();
+    }
+
+    /**
+     * @brief The bytes of the image waiting for upload().
+     */
+    std::size_t staged_bytes() const noexcept {
+        return image_.GetPixelsSize();
+    }
+
+private:
+    enum class ImageType {
+        TGA,
+        WIC,
+        HDR
+    };
+
+    static ImageType image_type(const std::string &path) {
+        auto extention_pos = path.find_last_of('.');
+        if (extention_pos == std::string::npos) return ImageType::WIC;
+
+        auto extention = path.substr(extention_pos);
+        if (extention == ".tga" || extention == ".TGA") return ImageType::TGA;
+        if (extention == ".hdr") return ImageType::HDR;
+        return ImageType::WIC;
     }
 
 private:
     DirectX::TexMetadata metadata_;
+    DirectX::ScratchImage image_;
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_view_;
 };
 
@@ -0,0 +1,121 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__INSTANCE_BATCHER_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__INSTANCE_BATCHER_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "draw_command.hpp"
+#include "draw_queue.hpp"
+
+/**
+ * @brief Per-instance data streamed to the instanced vertex shaders.
+ *
+ * The layout must match the INSTANCE_MATRIX_M and INSTANCE_MATRIX_M_INVERSE elements
+ * of the instanced input layout (see shaders/common/interface_instance.hlsl).
+ */
+struct InstanceData {
+    DirectX::XMFLOAT4X4 matrix_m;
+    DirectX::XMFLOAT4X4 matrix_m_inverse;
+};
+
+/**
+ * @brief Finds the runs of the sorted draw queue which can be drawn as one instanced draw call,
+ * and packs their per-instance data into one array.
+ *
+ * The batcher touches no GPU object, so the batching can be checked without a device.
+ */
+class InstanceBatcher {
+public:
+    /**
+     * @brief The shortest run worth an instanced draw call.
+     */
+    static constexpr std::size_t MIN_INSTANCE_COUNT = 2;
+
+    /**
+     * @brief Range [begin, end) of the draw queue drawn as one instanced draw call.
+     */
+    struct Batch {
+        std::size_t begin;
+        std::size_t end;
+        std::uint32_t first_instance;
+
+        std::uint32_t instance_count() const noexcept {
+            return static_cast<std::uint32_t>(end - begin);
+        }
+    };
+
+    /**
+     * @brief Rebuilds the batches from the sorted queue.
+     *
+     * Only the opaque mesh commands are batched. The transparent ones must keep their back-to-front order.
+     *
+     * @param can_instance Tells whether the material of the given command has the instanced shader variant.
+     */
+    template<typename CanInstance>
+    void build(const DrawQueue &queue, const DrawCommandBuffer &commands, CanInstance &&can_instance) {
+        clear();
+
+        for (std::size_t begin = 0; begin < queue.size();) {
+            const auto &first = commands[queue[begin].command];
+
+            if (first.type != DrawCommand::Type::Mesh
+                || DrawSortKey::is_transparent(queue[begin].key)
+                || !can_instance(first)) {
+                ++begin;
+                continue;
+            }
+
+            auto end = begin + 1;
+            for (; end < queue.size(); ++end) {
+                const auto &command = commands[queue[end].command];
+                if (command.type != DrawCommand::Type::Mesh
+                    || command.mesh != first.mesh
+                    || command.material != first.material
+                    || DrawSortKey::is_transparent(queue[end].key)) {
+                    break;
+                }
+            }
+
+            if (end - begin >= MIN_INSTANCE_COUNT) {
+                batches_.push_back({begin, end, static_cast<std::uint32_t>(instances_.size())});
+                for (auto i = begin; i < end; ++i) {
+                    pack(commands[queue[i].command].matrix_m);
+                }
+            }
+            begin = end;
+        }
+    }
+
+    void clear() noexcept {
+        batches_.clear();
+        instances_.clear();
+    }
+
+    /**
+     * @brief The batches in the queue order.
+     */
+    const std::vector<Batch> &batches() const noexcept {
+        return batches_;
+    }
+
+    const std::vector<InstanceData> &instances() const noexcept {
+        return instances_;
+    }
+
+private:
+    void pack(const DirectX::XMMATRIX &matrix_m) {
+        using namespace DirectX;
+        instances_.emplace_back();
+        auto &instance = instances_.back();
+        XMStoreFloat4x4(&instance.matrix_m, matrix_m);
+        XMStoreFloat4x4(&instance.matrix_m_inverse, XMMatrixInverse(nullptr, matrix_m));
+    }
+
+private:
+    std::vector<Batch> batches_;
+    std::vector<InstanceData> instances_;
+};
+
+#endif
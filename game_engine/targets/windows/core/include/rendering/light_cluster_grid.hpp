@@ -0,0 +1,102 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__LIGHT_CLUSTER_GRID_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__LIGHT_CLUSTER_GRID_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include <nodec/concurrent/thread_pool_executor.hpp>
+
+#include "frustum_culling.hpp"
+
+/**
+ * @brief Assigns the point lights to the froxels (the clusters) of the view frustum.
+ *
+ * The screen is split into CLUSTER_COUNT_X x CLUSTER_COUNT_Y tiles, and the depth between the near and far planes
+ * into CLUSTER_COUNT_Z slices growing exponentially.
+ * Each cluster refers a contiguous range of light_indices(), which holds the indices into the input lights.
+ * The lighting shader finds the cluster of a pixel and only loops over its lights.
+ *
+ * The cluster index is (z * CLUSTER_COUNT_Y + y) * CLUSTER_COUNT_X + x, where y is counted from the top of the screen.
+ */
+class LightClusterGrid {
+public:
+    static constexpr std::uint32_t CLUSTER_COUNT_X = 16;
+    static constexpr std::uint32_t CLUSTER_COUNT_Y = 9;
+    static constexpr std::uint32_t CLUSTER_COUNT_Z = 24;
+    static constexpr std::uint32_t CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+
+    struct PointLight {
+        DirectX::XMFLOAT3 position;
+        float range;
+    };
+
+    struct ClusterRange {
+        std::uint32_t offset;
+        std::uint32_t count;
+    };
+
+    LightClusterGrid();
+
+    /**
+     * @brief Rebuilds the clusters for the view.
+     *
+     * The lights outside of the planes are dropped first.
+     *
+     * @param lights The world-space lights.
+     * @param planes The world-space frustum planes.
+     */
+    void build(const std::vector<PointLight> &lights, const CullingPlanes &planes,
+               const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
+               float near_clip, float far_clip,
+               nodec::concurrent::ThreadPoolExecutor &executor);
+
+    const std::vector<ClusterRange> &cluster_ranges() const noexcept {
+        return cluster_ranges_;
+    }
+
+    const std::vector<std::uint32_t> &light_indices() const noexcept {
+        return light_indices_;
+    }
+
+    std::size_t visible_light_count() const noexcept {
+        return visible_lights_.size();
+    }
+
+    /**
+     * @brief The slice of the view-space depth z is floor(log(z) * z_slice_scale() + z_slice_bias()).
+     */
+    float z_slice_scale() const noexcept {
+        return z_slice_scale_;
+    }
+
+    float z_slice_bias() const noexcept {
+        return z_slice_bias_;
+    }
+
+private:
+    // The light and the inclusive cluster range it touches.
+    struct LightBounds {
+        std::uint32_t light;
+        std::uint8_t min_x, max_x;
+        std::uint8_t min_y, max_y;
+        std::uint8_t min_z, max_z;
+    };
+
+    struct Chunk {
+        std::vector<LightBounds> visible_lights;
+        std::vector<std::uint32_t> light_indices;
+    };
+
+private:
+    std::vector<ClusterRange> cluster_ranges_;
+    std::vector<std::uint32_t> light_indices_;
+    std::vector<LightBounds> visible_lights_;
+    std::vector<Chunk> chunks_;
+
+    float z_slice_scale_{0.0f};
+    float z_slice_bias_{0.0f};
+};
+
+#endif
@@ -1,10 +1,12 @@
 #ifndef NODEC_GAME_ENGINE__RENDERING__MATERIAL_BACKEND_HPP_
 #define NODEC_GAME_ENGINE__RENDERING__MATERIAL_BACKEND_HPP_
 
+#include <cstring>
 #include <memory>
 
 #include <nodec_rendering/resources/material.hpp>
 
+#include "material_property_block.hpp"
 #include "shader_backend.hpp"
 #include <graphics/ConstantBuffer.hpp>
 #include <graphics/graphics.hpp>
@@ -74,6 +76,29 @@ public:
         return true;
     }
 
+public:
+    float get_float_property(MaterialPropertyId id) const {
+        return shader_backend_assured()->get_float_property(property_memory_, id);
+    }
+
+    void set_float_property(MaterialPropertyId id, const float &value) {
+        shader_backend_assured()->set_float_property(property_memory_, id, value);
+        dirty_ = true;
+    }
+
+    nodec::optional<nodec::Vector4f> get_vector4_property(MaterialPropertyId id) const {
+        return shader_backend_assured()->get_vector4_property(property_memory_, id);
+    }
+
+    bool set_vector4_property(MaterialPropertyId id, const nodec::Vector4f &value) {
+        if (!shader_backend_assured()->set_vector4_property(property_memory_, id, value)) {
+            return false;
+        }
+
+        dirty_ = true;
+        return true;
+    }
+
 public:
     void bind_constant_buffer(Graphics *gfx, UINT slot) {
         update_device_memory();
@@ -84,22 +109,68 @@ public:
         }
     }
 
+    /**
+     * @brief Binds the constants with the vector overrides of the block applied.
+     *
+     * The overridden constants are written to a separate buffer, which is uploaded only when they change.
+     * So the draws sharing the same overrides, like the glyphs of a text, upload them once.
+     */
+    void bind_constant_buffer(Graphics *gfx, UINT slot, const MaterialPropertyBlock &block) {
+        if (block.vector4_overrides().empty() || !constant_buffer_) {
+            bind_constant_buffer(gfx, slot);
+            return;
+        }
+
+        block_staging_memory_ = property_memory_;
+        shader_backend_->property_layout().apply_vector4_overrides(block_staging_memory_, block);
+
+        if (!block_constant_buffer_) {
+            block_constant_buffer_.reset(new ConstantBuffer(*gfx_, block_staging_memory_.size(), block_staging_memory_.data()));
+            block_property_memory_.swap(block_staging_memory_);
+        } else if (std::memcmp(block_staging_memory_.data(), block_property_memory_.data(), block_property_memory_.size()) != 0) {
+            block_constant_buffer_->update(block_staging_memory_.data());
+            block_property_memory_.swap(block_staging_memory_);
+        }
+
+        block_constant_buffer_->bind_vs(slot);
+        block_constant_buffer_->bind_ps(slot);
+    }
+
     ConstantBuffer *constant_buffer() {
         return constant_buffer_.get();
     }
 
+    /**
+     * @brief Returns the shader backend without touching the reference count.
+     *
+     * The pointer is valid while this material holds the shader.
+     */
+    ShaderBackend *shader_backend() const noexcept {
+        return shader_backend_;
+    }
+
     const auto &texture_entries() const {
         return texture_entries_;
     }
 
+    /**
+     * @brief Compact id of this material used in the draw sort key.
+     */
+    std::uint32_t sort_id() const noexcept {
+        return sort_id_.value();
+    }
+
 protected:
     void on_shader_changed() override {
         constant_buffer_.reset();
+        block_constant_buffer_.reset();
         property_memory_.clear();
+        block_property_memory_.clear();
         texture_entries_.clear();
 
         auto shader_locked = shader();
         auto *shader_backend = static_cast<ShaderBackend *>(shader_locked.get());
+        shader_backend_ = shader_backend;
         if (!shader_backend) {
             return;
         }
@@ -120,11 +191,19 @@ protected:
 
 private:
     Graphics *gfx_;
+    ShaderBackend *shader_backend_{nullptr};
 
     std::unique_ptr<ConstantBuffer> constant_buffer_;
     std::vector<uint8_t> property_memory_;
     std::vector<TextureEntry> texture_entries_;
     bool dirty_{true};
+
+    // The constants with the overrides of the last property block.
+    std::unique_ptr<ConstantBuffer> block_constant_buffer_;
+    std::vector<uint8_t> block_property_memory_;
+    std::vector<uint8_t> block_staging_memory_;
+
+    RenderSortId<MaterialBackend> sort_id_;
 };
 
 #endif
\ No newline at end of file
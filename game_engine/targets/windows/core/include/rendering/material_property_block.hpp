@@ -0,0 +1,75 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__MATERIAL_PROPERTY_BLOCK_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__MATERIAL_PROPERTY_BLOCK_HPP_
+
+#include <vector>
+
+#include <nodec/vector4.hpp>
+#include <nodec_rendering/sampler.hpp>
+
+#include "material_property_id.hpp"
+#include "texture_backend.hpp"
+
+/**
+ * @brief Per-draw overrides of the material properties.
+ *
+ * The block is applied on top of the material at the bind, so the shared material is never modified.
+ * The overrides whose property is not in the shader of the material are ignored.
+ *
+ * The block only holds a few overrides, so they are kept in small lists.
+ * Reuse the block over the draws to keep their storage.
+ */
+class MaterialPropertyBlock {
+public:
+    struct Vector4Override {
+        MaterialPropertyId id;
+        nodec::Vector4f value;
+    };
+
+    struct TextureOverride {
+        MaterialPropertyId id;
+
+        // The texture is not owned. It must be alive until the draw.
+        TextureBackend *texture;
+        nodec_rendering::Sampler sampler;
+    };
+
+    void clear() {
+        vector4_overrides_.clear();
+        texture_overrides_.clear();
+    }
+
+    void set_vector4(MaterialPropertyId id, const nodec::Vector4f &value) {
+        for (auto &entry : vector4_overrides_) {
+            if (entry.id == id) {
+                entry.value = value;
+                return;
+            }
+        }
+        vector4_overrides_.push_back({id, value});
+    }
+
+    void set_texture(MaterialPropertyId id, TextureBackend *texture, const nodec_rendering::Sampler &sampler) {
+        for (auto &entry : texture_overrides_) {
+            if (entry.id == id) {
+                entry.texture = texture;
+                entry.sampler = sampler;
+                return;
+            }
+        }
+        texture_overrides_.push_back({id, texture, sampler});
+    }
+
+    const std::vector<Vector4Override> &vector4_overrides() const noexcept {
+        return vector4_overrides_;
+    }
+
+    const std::vector<TextureOverride> &texture_overrides() const noexcept {
+        return texture_overrides_;
+    }
+
+private:
+    std::vector<Vector4Override> vector4_overrides_;
+    std::vector<TextureOverride> texture_overrides_;
+};
+
+#endif
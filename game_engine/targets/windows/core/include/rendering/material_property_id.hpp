@@ -0,0 +1,82 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__MATERIAL_PROPERTY_ID_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__MATERIAL_PROPERTY_ID_HPP_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <nodec/optional.hpp>
+
+/**
+ * @brief Interned id of a material property name.
+ *
+ * The same name always maps to the same id, in all shaders.
+ * Resolve the id once with intern(), then the shaders look up the property by indexing with the id.
+ * The shaders may be loaded on the loader threads, so the name table is guarded by a mutex.
+ */
+class MaterialPropertyId {
+    class Registry {
+    public:
+        std::uint32_t intern(const std::string &name) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto result = ids_.emplace(name, static_cast<std::uint32_t>(ids_.size()));
+            return result.first->second;
+        }
+
+        nodec::optional<std::uint32_t> find(const std::string &name) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto iter = ids_.find(name);
+            if (iter == ids_.end()) return nodec::nullopt;
+            return iter->second;
+        }
+
+    private:
+        std::mutex mutex_;
+        std::unordered_map<std::string, std::uint32_t> ids_;
+    };
+
+    static Registry &registry() {
+        static Registry registry;
+        return registry;
+    }
+
+    explicit MaterialPropertyId(std::uint32_t value)
+        : value_(value) {}
+
+public:
+    /**
+     * @brief Returns the id of the name, registering it at the first call.
+     */
+    static MaterialPropertyId intern(const std::string &name) {
+        return MaterialPropertyId(registry().intern(name));
+    }
+
+    /**
+     * @brief Returns the id of the name if it has been registered.
+     *
+     * The name never registered is not a property of any shader.
+     */
+    static nodec::optional<MaterialPropertyId> find(const std::string &name) {
+        auto value = registry().find(name);
+        if (!value) return nodec::nullopt;
+        return MaterialPropertyId(*value);
+    }
+
+    std::uint32_t value() const noexcept {
+        return value_;
+    }
+
+    bool operator==(const MaterialPropertyId &other) const noexcept {
+        return value_ == other.value_;
+    }
+
+    bool operator!=(const MaterialPropertyId &other) const noexcept {
+        return value_ != other.value_;
+    }
+
+private:
+    std::uint32_t value_;
+};
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__MATERIAL_PROPERTY_LAYOUT_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__MATERIAL_PROPERTY_LAYOUT_HPP_
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <nodec/optional.hpp>
+#include <nodec/vector4.hpp>
+
+#include "material_property_block.hpp"
+#include "material_property_id.hpp"
+
+/**
+ * @brief Where the material properties of a shader are, looked up by MaterialPropertyId.
+ *
+ * The float properties come first in the constants, then the vector4 properties, each group padded to 16 bytes.
+ * The textures take the slots in their order. The layout has no device object, so ShaderBackend keeps one
+ * and the materials apply their property blocks through it.
+ */
+class MaterialPropertyLayout {
+public:
+    MaterialPropertyLayout() = default;
+
+    /**
+     * @param float_properties The properties with the name and the float default_value.
+     * @param vector4_properties The properties with the name and the vector4 default_value.
+     * @param texture_entries The entries with the name.
+     */
+    template<typename FloatProperties, typename Vector4Properties, typename TextureEntries>
+    MaterialPropertyLayout(const FloatProperties &float_properties, const Vector4Properties &vector4_properties,
+                           const TextureEntries &texture_entries) {
+        for (auto &property : float_properties) {
+            register_property(float_property_offsets_, property.name, property_memory_prototype_.size());
+            append_property(property_memory_prototype_, property.default_value);
+        }
+        align_memory(property_memory_prototype_);
+
+        for (auto &property : vector4_properties) {
+            register_property(vector4_property_offsets_, property.name, property_memory_prototype_.size());
+            append_property(property_memory_prototype_, property.default_value);
+        }
+        align_memory(property_memory_prototype_);
+
+        std::size_t slot = 0;
+        for (auto &entry : texture_entries) {
+            register_property(texture_entry_slots_, entry.name, slot++);
+        }
+    }
+
+    std::vector<uint8_t> create_property_memory() const {
+        return property_memory_prototype_;
+    }
+
+    /**
+     * @brief Returns the offset of the float property in the property memory.
+     */
+    nodec::optional<std::size_t> float_property_offset(MaterialPropertyId id) const noexcept {
+        return find_property(float_property_offsets_, id);
+    }
+
+    /**
+     * @brief Returns the offset of the vector4 property in the property memory.
+     */
+    nodec::optional<std::size_t> vector4_property_offset(MaterialPropertyId id) const noexcept {
+        return find_property(vector4_property_offsets_, id);
+    }
+
+    nodec::optional<std::size_t> texture_slot(MaterialPropertyId id) const noexcept {
+        return find_property(texture_entry_slots_, id);
+    }
+
+    float get_float_property(const std::vector<uint8_t> &property_memory, MaterialPropertyId id) const {
+        auto offset = float_property_offset(id);
+        if (!offset) throw std::out_of_range("No float property.");
+        return *get_property_ptr<float>(property_memory, *offset);
+    }
+
+    void set_float_property(std::vector<uint8_t> &property_memory, MaterialPropertyId id, const float &value) const {
+        auto offset = float_property_offset(id);
+        if (!offset) throw std::out_of_range("No float property.");
+        *get_property_ptr<float>(property_memory, *offset) = value;
+    }
+
+    nodec::optional<nodec::Vector4f> get_vector4_property(const std::vector<uint8_t> &property_memory, MaterialPropertyId id) const {
+        auto offset = vector4_property_offset(id);
+        if (!offset) return nodec::nullopt;
+        return *get_property_ptr<nodec::Vector4f>(property_memory, *offset);
+    }
+
+    bool set_vector4_property(std::vector<uint8_t> &property_memory, MaterialPropertyId id, const nodec::Vector4f &value) const {
+        auto offset = vector4_property_offset(id);
+        if (!offset) return false;
+        *get_property_ptr<nodec::Vector4f>(property_memory, *offset) = value;
+        return true;
+    }
+
+    /**
+     * @brief Writes the vector4 overrides of the block into the property memory. The ones not in the layout are ignored.
+     */
+    void apply_vector4_overrides(std::vector<uint8_t> &property_memory, const MaterialPropertyBlock &block) const {
+        for (const auto &entry : block.vector4_overrides()) {
+            set_vector4_property(property_memory, entry.id, entry.value);
+        }
+    }
+
+    /**
+     * @brief Returns the texture override of the block which goes to the slot, or nullptr.
+     */
+    const MaterialPropertyBlock::TextureOverride *find_texture_override(const MaterialPropertyBlock &block, std::size_t slot) const noexcept {
+        for (const auto &entry : block.texture_overrides()) {
+            auto override_slot = texture_slot(entry.id);
+            if (override_slot && *override_slot == slot) return &entry;
+        }
+        return nullptr;
+    }
+
+private:
+    static constexpr std::size_t NO_PROPERTY = static_cast<std::size_t>(-1);
+
+    static void register_property(std::vector<std::size_t> &table, const std::string &name, std::size_t value) {
+        const auto id = MaterialPropertyId::intern(name).value();
+        if (table.size() <= id) {
+            table.resize(id + 1, NO_PROPERTY);
+        }
+        table[id] = value;
+    }
+
+    static nodec::optional<std::size_t> find_property(const std::vector<std::size_t> &table, MaterialPropertyId id) noexcept {
+        if (id.value() >= table.size() || table[id.value()] == NO_PROPERTY) return nodec::nullopt;
+        return table[id.value()];
+    }
+
+    template<typename T>
+    static void append_property(std::vector<uint8_t> &memory, const T &value) {
+        // <https://stackoverrun.com/ja/q/3787586>
+        const uint8_t *p = reinterpret_cast<const uint8_t *>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            memory.push_back(p[i]);
+        }
+    }
+
+    template<typename T>
+    static T *get_property_ptr(std::vector<uint8_t> &memory, const std::size_t offset) {
+        // <http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2015/p0007r0.html>
+        return const_cast<T *>(get_property_ptr<T>(
+            const_cast<std::add_const_t<std::remove_reference_t<decltype(memory)>> &>(memory),
+            offset));
+    }
+
+    template<typename T>
+    static const T *get_property_ptr(const std::vector<uint8_t> &memory, const std::size_t offset) {
+        auto end = offset + sizeof(T);
+        if (end > memory.size()) {
+            throw std::out_of_range("Exceed property memory boundary.");
+        }
+
+        return reinterpret_cast<const T *>(&memory[offset]);
+    }
+
+    static void align_memory(std::vector<uint8_t> &memory) {
+        // Packing Rules for Constant Variables
+        // <https://docs.microsoft.com/en-us/windows/win32/direct3dhlsl/dx-graphics-hlsl-packing-rules>
+        constexpr size_t alignment_size = 16;
+        size_t aligned = (memory.size() + (alignment_size - 1)) & ~(alignment_size - 1);
+
+        // add padding so that size will be a multiple of 16.
+        while (memory.size() < aligned) {
+            memory.push_back(0x00);
+        }
+    }
+
+private:
+    // The offsets and the slots are indexed by MaterialPropertyId::value().
+    // The ids not used by this layout hold NO_PROPERTY.
+    std::vector<std::size_t> float_property_offsets_;
+    std::vector<std::size_t> vector4_property_offsets_;
+    std::vector<std::size_t> texture_entry_slots_;
+
+    std::vector<uint8_t> property_memory_prototype_;
+};
+
+#endif
@@ -9,6 +9,9 @@
 #include <graphics/IndexBuffer.hpp>
 #include <graphics/VertexBuffer.hpp>
 
+#include "render_sort_id.hpp"
+#include "vertex_format.hpp"
+
 class MeshBackend : public nodec_rendering::resources::Mesh {
 public:
     struct Vertex {
@@ -19,25 +22,80 @@ public:
     };
 
     std::vector<Vertex> vertices;
-    std::vector<uint16_t> triangles;
+    std::vector<std::uint32_t> triangles;
     nodec::gfx::BoundingBox bounds;
 
+    //! The format the vertices are uploaded in.
+    VertexFormat vertex_format{VertexFormat::Float32};
+
+    /**
+     * @brief Uploads the vertices in the vertex_format, and the triangles.
+     *
+     * The indices are uploaded in 16 bits when they can refer all the vertices.
+     */
     void update_device_memory(Graphics *graphics) {
+        std::vector<CompactVertex> compact_vertices;
+        const void *vertex_data = vertices.data();
+        if (vertex_format == VertexFormat::Compact) {
+            compact_vertices.reserve(vertices.size());
+            for (const auto &vertex : vertices) {
+                compact_vertices.push_back(pack_compact_vertex(vertex.position, vertex.normal, vertex.uv, vertex.tangent));
+            }
+            vertex_data = compact_vertices.data();
+        }
+
+        const bool wide_indices = vertices.size() > 0x10000;
+        std::vector<std::uint16_t> narrow_triangles;
+        const void *index_data = triangles.data();
+        if (!wide_indices) {
+            narrow_triangles.assign(triangles.begin(), triangles.end());
+            index_data = narrow_triangles.data();
+        }
+
+        update_device_memory(graphics, vertex_format, vertex_data, vertices.size(),
+                             index_data, triangles.size(), wide_indices);
+    }
+
+    /**
+     * @brief Uploads the packed vertices and indices as they are, like the ones mapped from a mesh file.
+     *
+     * The vertices and the triangles on the CPU side are left untouched.
+     */
+    void update_device_memory(Graphics *graphics, VertexFormat format,
+                              const void *vertex_data, std::size_t vertex_count,
+                              const void *index_data, std::size_t index_count, bool wide_indices) {
         vertex_buffer_.reset();
         index_buffer_.reset();
 
+        vertex_format = format;
+        const auto stride = vertex_stride(format);
         vertex_buffer_.reset(
             new VertexBuffer(
                 graphics,
-                vertices.size() * sizeof(Vertex),
-                sizeof(Vertex),
-                vertices.data()));
+                static_cast<UINT>(vertex_count * stride),
+                stride,
+                vertex_data));
 
         index_buffer_.reset(
             new IndexBuffer(
                 graphics,
-                triangles.size(),
-                triangles.data()));
+                static_cast<UINT>(index_count),
+                index_data,
+                wide_indices ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT));
+
+        index_count_ = static_cast<UINT>(index_count);
+        device_memory_bytes_ = vertex_count * stride + index_count * (wide_indices ? 4 : 2);
+    }
+
+    UINT index_count() const noexcept {
+        return index_count_;
+    }
+
+    /**
+     * @brief The bytes of the vertex and the index buffers.
+     */
+    std::size_t device_memory_bytes() const noexcept {
+        return device_memory_bytes_;
     }
 
     VertexBuffer *vertex_buffer() {
@@ -58,9 +116,20 @@ public:
         }
     }
 
+    /**
+     * @brief Compact id of this mesh used in the draw sort key.
+     */
+    std::uint32_t sort_id() const noexcept {
+        return sort_id_.value();
+    }
+
 private:
     std::unique_ptr<VertexBuffer> vertex_buffer_;
     std::unique_ptr<IndexBuffer> index_buffer_;
+    UINT index_count_{0};
+    std::size_t device_memory_bytes_{0};
+
+    RenderSortId<MeshBackend> sort_id_;
 };
 
 #endif
\ No newline at end of file
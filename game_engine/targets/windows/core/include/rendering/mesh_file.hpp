@@ -0,0 +1,152 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__MESH_FILE_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__MESH_FILE_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include <nodec/gfx/bouding_box.hpp>
+
+#include "vertex_format.hpp"
+
+/**
+ * @brief The binary mesh container, laid out to be mapped and uploaded without parsing.
+ *
+ * The file is the header, the packed vertices at vertex_offset, then the indices at index_offset.
+ * The offsets are aligned to 16 bytes. All the values are little endian.
+ */
+namespace mesh_file {
+
+constexpr std::uint32_t MAGIC = 0x4853454d; // "MESH"
+constexpr std::uint32_t VERSION = 1;
+constexpr std::uint64_t ALIGNMENT = 16;
+
+struct Header {
+    std::uint32_t magic;
+    std::uint32_t version;
+
+    //! The VertexFormat of the vertices.
+    std::uint8_t vertex_format;
+
+    //! The bytes of an index, 2 or 4.
+    std::uint8_t index_size;
+    std::uint16_t reserved0;
+
+    std::uint32_t vertex_count;
+    std::uint32_t index_count;
+
+    // The bounds of the positions, so the loader does not visit the vertices.
+    float bounds_center[3];
+    float bounds_extents[3];
+    std::uint32_t reserved1;
+
+    std::uint64_t vertex_offset;
+    std::uint64_t index_offset;
+};
+
+/**
+ * @brief The sections of a mesh file in memory.
+ */
+struct View {
+    const Header *header;
+    const void *vertices;
+    const void *indices;
+};
+
+inline std::uint64_t align(std::uint64_t offset) {
+    return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+/**
+ * @brief Tells whether the data starts with the mesh file magic. The older meshes are the cereal archives.
+ */
+inline bool is_mesh_file(const void *data, std::size_t size) {
+    std::uint32_t magic;
+    if (size < sizeof(magic)) return false;
+    std::memcpy(&magic, data, sizeof(magic));
+    return magic == MAGIC;
+}
+
+/**
+ * @brief Validates the header and points the sections. Nothing is copied.
+ *
+ * @param data The start of the file, aligned to 16 bytes like the mapped views are.
+ */
+inline View parse_mesh_file(const void *data, std::size_t size) {
+    if (size < sizeof(Header)) {
+        throw std::runtime_error("The mesh file is truncated.");
+    }
+
+    const auto *header = static_cast<const Header *>(data);
+    if (header->magic != MAGIC || header->version != VERSION) {
+        throw std::runtime_error("Not a mesh file, or the version is not supported.");
+    }
+    if (header->vertex_format >= VERTEX_FORMAT_COUNT || (header->index_size != 2 && header->index_size != 4)) {
+        throw std::runtime_error("The mesh file has an unknown vertex format or index size.");
+    }
+
+    const auto vertex_bytes = static_cast<std::uint64_t>(header->vertex_count)
+                              * vertex_stride(static_cast<VertexFormat>(header->vertex_format));
+    const auto index_bytes = static_cast<std::uint64_t>(header->index_count) * header->index_size;
+    // Compared without adding to the offsets, which may overflow.
+    if (header->vertex_offset % ALIGNMENT != 0 || header->index_offset % ALIGNMENT != 0
+        || header->vertex_offset > size || vertex_bytes > size - header->vertex_offset
+        || header->index_offset > size || index_bytes > size - header->index_offset) {
+        throw std::runtime_error("The mesh file sections are out of the file.");
+    }
+
+    const auto *bytes = static_cast<const std::uint8_t *>(data);
+    return {header, bytes + header->vertex_offset, bytes + header->index_offset};
+}
+
+/**
+ * @brief Writes the packed vertices and the indices.
+ *
+ * The indices are written in 16 bits when they can refer all the vertices.
+ */
+inline void write_mesh_file(std::ostream &out, VertexFormat format,
+                            const void *vertices, std::uint32_t vertex_count,
+                            const std::uint32_t *indices, std::uint32_t index_count,
+                            const nodec::gfx::BoundingBox &bounds) {
+    const bool wide_indices = vertex_count > 0x10000;
+    const auto vertex_bytes = static_cast<std::uint64_t>(vertex_count) * vertex_stride(format);
+
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.vertex_format = static_cast<std::uint8_t>(format);
+    header.index_size = wide_indices ? 4 : 2;
+    header.vertex_count = vertex_count;
+    header.index_count = index_count;
+    header.bounds_center[0] = bounds.center.x;
+    header.bounds_center[1] = bounds.center.y;
+    header.bounds_center[2] = bounds.center.z;
+    header.bounds_extents[0] = bounds.extents.x;
+    header.bounds_extents[1] = bounds.extents.y;
+    header.bounds_extents[2] = bounds.extents.z;
+    header.vertex_offset = align(sizeof(Header));
+    header.index_offset = align(header.vertex_offset + vertex_bytes);
+
+    const char padding[ALIGNMENT]{};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(padding, header.vertex_offset - sizeof(header));
+    out.write(static_cast<const char *>(vertices), vertex_bytes);
+    out.write(padding, header.index_offset - header.vertex_offset - vertex_bytes);
+
+    if (wide_indices) {
+        out.write(reinterpret_cast<const char *>(indices), static_cast<std::streamsize>(index_count) * sizeof(std::uint32_t));
+    } else {
+        const std::vector<std::uint16_t> narrow_indices(indices, indices + index_count);
+        out.write(reinterpret_cast<const char *>(narrow_indices.data()), static_cast<std::streamsize>(index_count) * sizeof(std::uint16_t));
+    }
+
+    if (!out) {
+        throw std::runtime_error("Failed to write the mesh file.");
+    }
+}
+
+} // namespace mesh_file
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__PARALLEL_CHUNKS_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__PARALLEL_CHUNKS_HPP_
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Splits [0, count) into at most one chunk per hardware thread.
+ * The chunk boundaries except the last end are multiples of min_chunk_size.
+ */
+class ChunkPartition {
+public:
+    /**
+     * @param max_chunk_count The limit of the chunks. 0 takes the number of the hardware threads.
+     */
+    ChunkPartition(std::size_t count, std::size_t min_chunk_size, std::size_t max_chunk_count = 0)
+        : count_(count), unit_size_(min_chunk_size), unit_count_((count + min_chunk_size - 1) / min_chunk_size) {
+        if (max_chunk_count == 0) max_chunk_count = (std::max)(1u, std::thread::hardware_concurrency());
+        chunk_count_ = (std::max<std::size_t>)(1, (std::min)(unit_count_, max_chunk_count));
+    }
+
+    std::size_t chunk_count() const noexcept {
+        return chunk_count_;
+    }
+
+    std::size_t begin(std::size_t chunk_index) const noexcept {
+        return (std::min)(count_, unit_count_ * chunk_index / chunk_count_ * unit_size_);
+    }
+
+    std::size_t end(std::size_t chunk_index) const noexcept {
+        return begin(chunk_index + 1);
+    }
+
+private:
+    std::size_t count_;
+    std::size_t unit_size_;
+    std::size_t unit_count_;
+    std::size_t chunk_count_;
+};
+
+/**
+ * @brief Calls function(chunk_index, begin, end) for each chunk on the executor and waits for all of them.
+ * The calling thread takes the first chunk itself.
+ *
+ * The chunks reference the partition and the function, so all of them are waited for
+ * even if one throws. The first exception is rethrown after that.
+ */
+template<typename Executor, typename Function>
+void run_chunks(Executor &executor, const ChunkPartition &partition, Function &&function) {
+    std::vector<decltype(executor.submit(std::function<void()>()))> futures;
+    std::exception_ptr exception;
+    try {
+        for (std::size_t chunk_index = 1; chunk_index < partition.chunk_count(); ++chunk_index) {
+            futures.push_back(executor.submit(std::function<void()>([&, chunk_index]() {
+                function(chunk_index, partition.begin(chunk_index), partition.end(chunk_index));
+            })));
+        }
+        function(0, partition.begin(0), partition.end(0));
+    } catch (...) {
+        exception = std::current_exception();
+    }
+
+    for (auto &future : futures) {
+        try {
+            future.get();
+        } catch (...) {
+            if (!exception) exception = std::current_exception();
+        }
+    }
+    if (exception) std::rethrow_exception(exception);
+}
+
+/**
+ * @brief Runs collect(output, begin, end) for each chunk into the output of the chunk, then merge(output) in the chunk order.
+ *
+ * If collect appends in the index order, the merged result equals collecting [0, count) at once,
+ * whatever the chunk count and the thread timing. The outputs are kept by the caller, so they keep their capacity.
+ */
+template<typename Executor, typename Output, typename Collect, typename Merge>
+void collect_chunks(Executor &executor, const ChunkPartition &partition, std::vector<Output> &outputs,
+                    Collect &&collect, Merge &&merge) {
+    if (outputs.size() < partition.chunk_count()) {
+        outputs.resize(partition.chunk_count());
+    }
+
+    run_chunks(executor, partition, [&](std::size_t chunk_index, std::size_t begin, std::size_t end) {
+        collect(outputs[chunk_index], begin, end);
+    });
+
+    for (std::size_t chunk_index = 0; chunk_index < partition.chunk_count(); ++chunk_index) {
+        merge(outputs[chunk_index]);
+    }
+}
+
+#endif
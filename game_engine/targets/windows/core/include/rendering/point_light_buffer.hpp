@@ -0,0 +1,89 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__POINT_LIGHT_BUFFER_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__POINT_LIGHT_BUFFER_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <nodec/vector3.hpp>
+
+#include "../graphics/StructuredBuffer.hpp"
+
+/**
+ * @brief The point lights of the scene in a structured buffer, versioned apart from the per-view constants.
+ *
+ * The lights are staged every frame, but the buffer is uploaded only when the staged lights differ
+ * from the uploaded ones, and only for the active count.
+ */
+class PointLightBuffer {
+public:
+    struct PointLight {
+        nodec::Vector3f position;
+        float range;
+        nodec::Vector3f color;
+        float intensity;
+    };
+
+    PointLightBuffer(Graphics &gfx)
+        : buffer_(gfx, sizeof(PointLight)) {}
+
+    /**
+     * @brief Clears the staging lights. The lights pushed after it replace the previous ones.
+     */
+    void begin_staging() {
+        staging_.clear();
+    }
+
+    void push(const PointLight &light) {
+        staging_.push_back(light);
+    }
+
+    /**
+     * @brief Bumps the version if the staged lights differ from the current ones.
+     */
+    void end_staging() {
+        if (staging_.size() == lights_.size()
+            && (lights_.empty() || std::memcmp(staging_.data(), lights_.data(), lights_.size() * sizeof(PointLight)) == 0)) {
+            return;
+        }
+        lights_.swap(staging_);
+        ++version_;
+    }
+
+    /**
+     * @brief Uploads the lights if their version has changed since the last upload.
+     *
+     * @return The number of bytes uploaded.
+     */
+    std::size_t upload() {
+        if (uploaded_version_ == version_) return 0;
+        uploaded_version_ = version_;
+
+        buffer_.update(lights_.data(), static_cast<UINT>(lights_.size()));
+        return lights_.size() * sizeof(PointLight);
+    }
+
+    void bind_ps(UINT slot) {
+        buffer_.bind_ps(slot);
+    }
+
+    const std::vector<PointLight> &lights() const noexcept {
+        return lights_;
+    }
+
+    std::uint64_t version() const noexcept {
+        return version_;
+    }
+
+private:
+    std::vector<PointLight> lights_;
+    std::vector<PointLight> staging_;
+    std::uint64_t version_{0};
+    std::uint64_t uploaded_version_{0};
+    StructuredBuffer buffer_;
+
+private:
+    NODEC_DISABLE_COPY(PointLightBuffer)
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__QUAD_INDEX_BUFFER_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__QUAD_INDEX_BUFFER_HPP_
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <graphics/IndexBuffer.hpp>
+
+/**
+ * @brief Shared indices of the quad lists, where each quad is four vertices from the bottom left in the clockwise order.
+ *
+ * The indices only depend on the quad count, so they are built once for the largest count so far.
+ * The indices are 16-bit, so a longer list is drawn in chunks of MAX_QUAD_COUNT with the base vertex offset.
+ */
+class QuadIndexBuffer {
+public:
+    static constexpr std::size_t MAX_QUAD_COUNT = 65536 / 4;
+
+    QuadIndexBuffer(Graphics &gfx)
+        : gfx_(gfx) {}
+
+    /**
+     * @brief Binds the indices and draws @p quad_count quads of the bound vertex buffer, from the quad @p first_quad.
+     */
+    void draw(std::size_t quad_count, std::size_t first_quad = 0) {
+        if (quad_count == 0) return;
+
+        const auto chunk_quad_count = (std::min)(quad_count, MAX_QUAD_COUNT);
+        if (chunk_quad_count > quad_capacity_) {
+            reserve(chunk_quad_count);
+        }
+        index_buffer_->Bind(&gfx_);
+
+        for (std::size_t drawn = 0; drawn < quad_count; drawn += MAX_QUAD_COUNT) {
+            const auto count = (std::min)(quad_count - drawn, MAX_QUAD_COUNT);
+            gfx_.context().DrawIndexed(static_cast<UINT>(count * 6), 0u, static_cast<INT>((first_quad + drawn) * 4));
+        }
+    }
+
+private:
+    void reserve(std::size_t count) {
+        std::size_t capacity = quad_capacity_ > 0 ? quad_capacity_ : 64;
+        while (capacity < count) capacity *= 2;
+        capacity = (std::min)(capacity, MAX_QUAD_COUNT);
+
+        std::vector<std::uint16_t> indices(capacity * 6);
+        for (std::size_t quad = 0; quad < capacity; ++quad) {
+            const auto base = static_cast<std::uint16_t>(quad * 4);
+            auto *index = &indices[quad * 6];
+            index[0] = base;
+            index[1] = base + 1;
+            index[2] = base + 2;
+            index[3] = base;
+            index[4] = base + 2;
+            index[5] = base + 3;
+        }
+        index_buffer_.reset(new IndexBuffer(&gfx_, static_cast<UINT>(indices.size()), indices.data()));
+        quad_capacity_ = capacity;
+    }
+
+private:
+    Graphics &gfx_;
+    std::unique_ptr<IndexBuffer> index_buffer_;
+    std::size_t quad_capacity_{0};
+
+private:
+    NODEC_DISABLE_COPY(QuadIndexBuffer)
+};
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__RENDER_GRAPH_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__RENDER_GRAPH_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CompiledRenderGraph;
+
+/**
+ * @brief Describes the passes of a view by the resources they read and write.
+ *
+ * The passes run in the order they are added; the graph never reorders them.
+ * The compilation culls the passes whose writes are never read, finds the first and the last use of each resource,
+ * and tells which resources must be cleared before their first use.
+ *
+ * The graph knows nothing about the device. The executor keeps its own table of the work indexed by the pass id,
+ * and binds the resources by their names.
+ */
+class RenderGraph {
+public:
+    using ResourceId = std::uint32_t;
+    using PassId = std::uint32_t;
+
+    enum class WriteMode : std::uint8_t {
+        //! The pass may leave some texels untouched, so the previous contents are kept.
+        Partial,
+
+        //! The pass writes every texel, like a full screen pass without discard.
+        Overwrite
+    };
+
+    struct Resource {
+        std::string name;
+
+        //! Owned outside of the graph, like the back buffer. Its contents after the last pass are the outputs.
+        bool imported;
+
+        //! The imported contents are defined before the first pass, so they are never cleared.
+        bool preserve_contents;
+    };
+
+    struct Write {
+        ResourceId resource;
+        WriteMode mode;
+    };
+
+    /**
+     * @brief The accesses of a pass are the ranges of reads() and writes(), in the declaration order.
+     */
+    struct Pass {
+        std::string name;
+        std::uint32_t first_read;
+        std::uint32_t read_count;
+        std::uint32_t first_write;
+        std::uint32_t write_count;
+        bool has_side_effects;
+    };
+
+    /**
+     * @brief Removes all the passes and the resources. The capacity is kept.
+     */
+    void clear() noexcept {
+        resources_.clear();
+        passes_.clear();
+        reads_.clear();
+        writes_.clear();
+    }
+
+    /**
+     * @brief Returns the resource of the name, adding it as transient if the graph does not have it.
+     */
+    ResourceId resource(const std::string &name);
+
+    /**
+     * @brief Adds the resource owned outside of the graph, or marks the existing one as imported.
+     */
+    ResourceId import_resource(const std::string &name, bool preserve_contents);
+
+    /**
+     * @brief Adds a pass. The following read() and write() calls declare its accesses.
+     */
+    PassId add_pass(const std::string &name);
+
+    void read(ResourceId resource);
+
+    /**
+     * @brief Declares a write of the last pass.
+     *
+     * The writes of a pass are its render target slots, so the same resource may not be declared twice.
+     */
+    void write(ResourceId resource, WriteMode mode);
+
+    /**
+     * @brief Keeps the last pass even if nothing reads its writes.
+     */
+    void set_side_effects() {
+        passes_.back().has_side_effects = true;
+    }
+
+    const std::vector<Resource> &resources() const noexcept {
+        return resources_;
+    }
+
+    const std::vector<Pass> &passes() const noexcept {
+        return passes_;
+    }
+
+    const std::vector<ResourceId> &reads() const noexcept {
+        return reads_;
+    }
+
+    const std::vector<Write> &writes() const noexcept {
+        return writes_;
+    }
+
+    /**
+     * @brief Writes the topology of the graph as the tokens.
+     *
+     * Two graphs with the same tokens compile to the same result. The names are not included,
+     * since the compiled graph refers the passes and the resources by their ids.
+     */
+    void write_signature(std::vector<std::uint32_t> &signature) const;
+
+    CompiledRenderGraph compile() const;
+
+private:
+    std::vector<Resource> resources_;
+    std::vector<Pass> passes_;
+    std::vector<ResourceId> reads_;
+    std::vector<Write> writes_;
+};
+
+/**
+ * @brief The execution order of a render graph, with the resource lifetimes.
+ *
+ * It is valid for any graph with the same signature, so it is reused while the topology stays.
+ */
+class CompiledRenderGraph {
+public:
+    /**
+     * @brief A pass to run. The resources are acquired before the pass, and released after it.
+     *
+     * The ranges refer acquires() and releases().
+     */
+    struct Step {
+        RenderGraph::PassId pass;
+        std::uint32_t first_acquire;
+        std::uint32_t acquire_count;
+        std::uint32_t first_release;
+        std::uint32_t release_count;
+    };
+
+    struct Acquire {
+        RenderGraph::ResourceId resource;
+
+        //! The first use does not overwrite every texel, so the resource must be cleared first.
+        bool clear;
+    };
+
+    const std::vector<Step> &steps() const noexcept {
+        return steps_;
+    }
+
+    /**
+     * @brief The first uses. The imported resources are listed too, to tell whether they are cleared.
+     *
+     * The transient resources no live pass writes are not listed. Their reads are bound to no resource.
+     */
+    const std::vector<Acquire> &acquires() const noexcept {
+        return acquires_;
+    }
+
+    /**
+     * @brief The last uses of the transient resources.
+     */
+    const std::vector<RenderGraph::ResourceId> &releases() const noexcept {
+        return releases_;
+    }
+
+    /**
+     * @brief Tells whether the write, indexed like RenderGraph::writes(), is read later or is an output.
+     *
+     * The dead writes of a live pass can be bound to no target.
+     */
+    bool is_write_live(std::size_t write_index) const noexcept {
+        return live_writes_[write_index] != 0;
+    }
+
+    std::size_t culled_pass_count() const noexcept {
+        return culled_pass_count_;
+    }
+
+private:
+    friend class RenderGraph;
+
+    std::vector<Step> steps_;
+    std::vector<Acquire> acquires_;
+    std::vector<RenderGraph::ResourceId> releases_;
+    std::vector<std::uint8_t> live_writes_;
+    std::size_t culled_pass_count_{0};
+};
+
+/**
+ * @brief Keeps the compiled graphs of the recent topologies.
+ *
+ * The graph is described again every frame, but compiled only when its signature is new.
+ */
+class RenderGraphCache {
+public:
+    static constexpr std::size_t CAPACITY = 8;
+
+    /**
+     * @brief Returns the compiled graph of the topology. It is valid until the next call.
+     */
+    const CompiledRenderGraph &compile(const RenderGraph &graph);
+
+    /**
+     * @brief The number of the compilations, that is the cache misses.
+     */
+    std::uint64_t compile_count() const noexcept {
+        return compile_count_;
+    }
+
+private:
+    struct Entry {
+        std::vector<std::uint32_t> signature;
+        CompiledRenderGraph compiled;
+        std::uint64_t last_used;
+    };
+
+    std::vector<Entry> entries_;
+    std::vector<std::uint32_t> signature_;
+    std::uint64_t use_count_{0};
+    std::uint64_t compile_count_{0};
+};
+
+#endif
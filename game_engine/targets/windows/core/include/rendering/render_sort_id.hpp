@@ -0,0 +1,76 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__RENDER_SORT_ID_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__RENDER_SORT_ID_HPP_
+
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <nodec/macros.hpp>
+
+/**
+ * @brief Small integer id used to pack a resource into a draw sort key.
+ *
+ * The ids are recycled when the owner is destroyed, so the live ids stay compact.
+ * The resources may be created on the loader threads, so the pool is guarded by a mutex.
+ *
+ * @tparam Tag The owner type. Each owner type has its own id space.
+ * @tparam Bits The width of the field the id is packed into. The ids never exceed it,
+ *   so the live owners never share an id. Acquiring throws std::runtime_error when all are in use.
+ */
+template<typename Tag, int Bits = 32>
+class RenderSortId {
+    static_assert(0 < Bits && Bits <= 32, "The id must fit in 32 bits.");
+
+    static constexpr std::uint64_t CAPACITY = std::uint64_t{1} << Bits;
+
+    class Pool {
+    public:
+        std::uint32_t acquire() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_ids_.empty()) {
+                auto id = free_ids_.back();
+                free_ids_.pop_back();
+                return id;
+            }
+            if (next_id_ >= CAPACITY) {
+                throw std::runtime_error("The render sort ids are exhausted.");
+            }
+            return static_cast<std::uint32_t>(next_id_++);
+        }
+
+        void release(std::uint32_t id) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_ids_.push_back(id);
+        }
+
+    private:
+        std::mutex mutex_;
+        std::vector<std::uint32_t> free_ids_;
+        std::uint64_t next_id_{0};
+    };
+
+    static Pool &pool() {
+        static Pool pool;
+        return pool;
+    }
+
+public:
+    RenderSortId()
+        : value_(pool().acquire()) {}
+
+    ~RenderSortId() {
+        pool().release(value_);
+    }
+
+    std::uint32_t value() const noexcept {
+        return value_;
+    }
+
+private:
+    std::uint32_t value_;
+
+    NODEC_DISABLE_COPY(RenderSortId)
+};
+
+#endif
@@ -8,7 +8,9 @@
 
 #include <DirectXMath.h>
 
+#include <nodec/concurrent/thread_pool_executor.hpp>
 #include <nodec/logging/logging.hpp>
+#include <nodec/optional.hpp>
 #include <nodec/resource_management/resource_registry.hpp>
 #include <nodec/vector4.hpp>
 #include <nodec_rendering/components/camera.hpp>
@@ -21,142 +23,271 @@
 #include <nodec_rendering/components/scene_lighting.hpp>
 #include <nodec_rendering/components/text_renderer.hpp>
 #include <nodec_rendering/sampler.hpp>
+#include <nodec_scene/components/local_to_world.hpp>
 #include <nodec_scene/components/local_transform.hpp>
 #include <nodec_scene/scene.hpp>
 
 #include "../graphics/ConstantBuffer.hpp"
+#include "../graphics/InstanceBuffer.hpp"
 #include "../graphics/RasterizerState.hpp"
 #include "../graphics/SamplerState.hpp"
+#include "../graphics/StructuredBuffer.hpp"
 #include "../graphics/geometry_buffer.hpp"
 #include "../graphics/graphics.hpp"
 #include "material_backend.hpp"
 #include "mesh_backend.hpp"
+#include "point_light_buffer.hpp"
+#include "render_graph.hpp"
 #include "camera_state.hpp"
+#include "draw_command.hpp"
+#include "draw_queue.hpp"
+#include "instance_batcher.hpp"
+#include "light_cluster_grid.hpp"
 #include "scene_renderer_context.hpp"
 #include "scene_rendering_context.hpp"
+#include "scene_snapshot.hpp"
+#include "scene_spatial_index.hpp"
 #include "shader_backend.hpp"
+#include "sprite_batcher.hpp"
 #include "texture_backend.hpp"
 
-class DrawCommand {
-public:
-    virtual ~DrawCommand() {}
-    virtual void draw(const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
-                      SceneRendererContext &, Graphics &) = 0;
-};
+/**
+ * @brief Issues the draw call of the given command.
+ */
+void execute_draw_command(const DrawCommand &command,
+                          const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
+                          SceneRendererContext &context, Graphics &gfx);
 
-class DrawGroup {
-public:
-    std::weak_ptr<ShaderBackend> shader;
+/**
+ * @brief Counters accumulated over the render calls since the last reset.
+ */
+struct SceneRendererStats {
+    //! The number of the mesh renderer bounds tested as a whole.
+    std::uint64_t entity_bounds_tests{0};
 
-    virtual ~DrawGroup() {}
+    //! The number of the submesh bounds tested individually.
+    std::uint64_t submesh_bounds_tests{0};
 
-    virtual void draw_all(const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
-                          SceneRendererContext &context, Graphics &gfx) = 0;
+    //! The number of the submesh tests decided by the entity test (entity entirely inside or outside).
+    std::uint64_t submesh_bounds_tests_saved{0};
 
-    virtual void clear_draw_commands() = 0;
-};
+    //! The number of the draw commands submitted.
+    std::uint64_t draw_commands{0};
 
-class OpaqueDrawGroup : public DrawGroup {
-public:
-    std::unordered_map<std::intptr_t, std::vector<std::unique_ptr<DrawCommand>>> draw_commands;
-
-    void draw_all(const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
-                  SceneRendererContext &context, Graphics &gfx) override {
-        for (auto &material_group : draw_commands) {
-            for (auto &command : material_group.second) {
-                command->draw(matrix_v, matrix_p, context, gfx);
-            }
-        }
-        // for (auto iter = draw_commands.begin(); iter != draw_commands.end(); ++iter) {
-        //     iter->second->draw(matrix_v, matrix_p, context, gfx);
-        // }
-        // for (auto &command : draw_commands) {
-        //     command.second->draw(matrix_v, matrix_p, context, gfx);
-        // }
-    }
+    //! The number of the image draws merged into the sprite batches.
+    std::uint64_t batched_sprites{0};
 
-    void append_draw_command(const std::shared_ptr<MaterialBackend> &material_backend, std::unique_ptr<DrawCommand> command) {
-        auto material_id = reinterpret_cast<std::intptr_t>(material_backend.get());
-        auto &material_group = draw_commands[material_id];
-        material_group.push_back(std::move(command));
-    }
+    //! The number of the sprite batches drawn.
+    std::uint64_t sprite_batches{0};
 
-    void clear_draw_commands() override {
-        // draw_commands.clear();
-        for (auto &material_group : draw_commands) {
-            material_group.second.clear();
-        }
-    }
-};
+    //! The number of the point lights left by the frustum culling and assigned to the clusters.
+    std::uint64_t visible_point_lights{0};
 
-class TransparentDrawGroup : public DrawGroup {
-public:
-    std::multimap<float, std::unique_ptr<DrawCommand>> draw_commands;
-    void draw_all(const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
-                  SceneRendererContext &context, Graphics &gfx) override {
-        for (auto iter = draw_commands.rbegin(); iter != draw_commands.rend(); ++iter) {
-            iter->second->draw(matrix_v, matrix_p, context, gfx);
-        }
-    }
+    //! The number of the render graphs compiled because their topology was new.
+    std::uint64_t render_graph_compiles{0};
 
-    void clear_draw_commands() override {
-        draw_commands.clear();
-    }
-};
+    //! The number of the passes skipped because nothing reads their results.
+    std::uint64_t culled_passes{0};
 
-struct DrawGroupPriorityKey {
-    DrawGroupPriorityKey(std::shared_ptr<ShaderBackend> &shader, bool is_transparent = false)
-        : is_transparent_(is_transparent) {
-        assert(shader);
-        shader_id_ = reinterpret_cast<std::intptr_t>(shader.get());
-        priority_ = shader->rendering_priority();
-    }
+    //! The number of the render targets cleared. A render target is cleared only before a pass which may leave texels untouched.
+    std::uint64_t clears{0};
 
-    bool operator==(const DrawGroupPriorityKey &other) const {
-        return shader_id_ == other.shader_id_ && is_transparent_ == other.is_transparent_;
-    }
+    //! The bytes of the render targets cleared.
+    std::uint64_t cleared_bytes{0};
 
-    bool operator<(const DrawGroupPriorityKey &other) const {
-        if (is_transparent_ == other.is_transparent_) {
-            return priority_ < other.priority_;
-        }
-        return !is_transparent_;
-    }
+    //! The bytes uploaded for the scene constants, the point lights, the light clusters, the instances and the sprites.
+    std::uint64_t uploaded_bytes{0};
 
-private:
-    std::intptr_t shader_id_;
-    int priority_;
-    bool is_transparent_;
+    //! The number of the scene snapshots captured. The views rendered between two invalidations share one.
+    std::uint64_t snapshot_captures{0};
+
+    //! The time spent in the snapshot captures, in microseconds.
+    std::uint64_t snapshot_microseconds{0};
+
+    //! The number of the views rendered.
+    std::uint64_t views{0};
+
+    //! The time spent in the views, culling to the last pass, in microseconds.
+    std::uint64_t view_microseconds{0};
 };
 
 class SceneRenderer {
 public:
-    SceneRenderer(nodec_scene::Scene &, Graphics &, nodec::resource_management::ResourceRegistry &);
+    /**
+     * @param spatial_index If not null, the mesh renderers are collected by its frustum query
+     * instead of iterating all of them.
+     */
+    SceneRenderer(nodec_scene::Scene &, Graphics &, nodec::resource_management::ResourceRegistry &,
+                  const SceneSpatialIndex *spatial_index = nullptr);
 
     void render(nodec_scene::Scene &scene, ID3D11RenderTargetView &render_target, SceneRenderingContext &context);
 
     void render(nodec_scene::Scene &scene, const CameraState &camera_state, ID3D11RenderTargetView *render_target, SceneRenderingContext &context);
 
+    const SceneRendererStats &stats() const noexcept {
+        return stats_;
+    }
+
+    void reset_stats() noexcept {
+        stats_ = {};
+    }
+
+    /**
+     * @brief Tells that the registry may have changed, so the next render captures the scene again.
+     *
+     * Until then, all the views rendered share the renderables and the lights extracted by the first one.
+     * Call it at least once per frame, and after any change of the registry made between the renders.
+     */
+    void invalidate_snapshot() noexcept {
+        snapshot_scene_ = nullptr;
+    }
+
+    /**
+     * @brief Captures the scene now. The views rendered until the next invalidate_snapshot() share this capture.
+     *
+     * The registry must not change until those renders end, since the snapshot points into its components.
+     */
+    void capture_snapshot(nodec_scene::Scene &scene) {
+        invalidate_snapshot();
+        prepare_snapshot(scene);
+    }
+
 private:
+    /**
+     * @brief Captures the snapshot and sets up the lights, unless the views of the scene already share one.
+     */
+    void prepare_snapshot(nodec_scene::Scene &scene);
+
     void setup_scene_lighting(nodec_scene::Scene &scene);
 
-    void render_internal(nodec_scene::Scene &scene,
-                         const CameraState &camera_state,
-                         ID3D11RenderTargetView *target, SceneRenderingContext &context);
+    /**
+     * @brief Renders the view of the camera with the active_effects_ into the output.
+     */
+    void render_camera(nodec_scene::Scene &scene,
+                       const CameraState &camera_state,
+                       ID3D11RenderTargetView &output, SceneRenderingContext &context);
+
+    /**
+     * @brief Describes the skybox, the shader runs of the sorted queue and the effects as the render graph.
+     */
+    void build_render_graph(nodec_scene::Scene &scene);
+
+    /**
+     * @brief Runs the live passes. The render targets are bound at their first use and released after their last use.
+     */
+    void execute_render_graph(const CompiledRenderGraph &compiled_graph,
+                              const CameraState &camera_state,
+                              ID3D11RenderTargetView &output, SceneRenderingContext &context);
+
+    void push_draw_command(const DrawCommand &command,
+                           const DirectX::XMMATRIX &matrix_v_inverse);
 
-    void push_draw_command(std::shared_ptr<ShaderBackend> shader, bool is_transparent,
-                           const std::shared_ptr<MaterialBackend> &material_backend,
-                           std::unique_ptr<DrawCommand> command,
-                           const DirectX::XMMATRIX &matrix_m, const DirectX::XMMATRIX &matrix_v_inverse);
+    /**
+     * @brief Culls the mesh renderers of the snapshot against the camera frustum and pushes their draw commands.
+     *
+     * With the spatial index, only the renderers reported by its frustum query are tested.
+     * Otherwise, the combined bounds of all the renderers are tested in batches.
+     * The submeshes are tested individually only when the renderer straddles the frustum.
+     * The renderers are split into chunks processed on the thread pool.
+     * The chunk outputs are merged in the collection order, so the result does not depend on the thread timing.
+     */
+    void push_mesh_draw_commands(nodec_scene::Scene &scene, const CameraState &camera_state);
+
+    /**
+     * @brief Builds the clusters of the staged point lights for the camera and binds them.
+     */
+    void build_light_clusters(const CameraState &camera_state);
 
 private:
     std::shared_ptr<nodec::logging::Logger> logger_;
     nodec_scene::Scene &scene_;
     Graphics &gfx_;
+    const SceneSpatialIndex *spatial_index_;
 
     SceneRendererContext renderer_context_;
 
-    std::map<DrawGroupPriorityKey, std::unique_ptr<DrawGroup>> draw_groups_;
+    struct DrawCommandChunk {
+        std::vector<DrawCommand> commands;
+        std::vector<std::uint64_t> keys;
+        SubmeshCullingStats stats;
+    };
+
+    DrawCommandBuffer draw_commands_;
+    DrawQueue draw_queue_;
+
+    SceneSnapshot snapshot_;
+
+    //! The scene the snapshot was captured from, or nullptr if it is invalidated.
+    const nodec_scene::Scene *snapshot_scene_{nullptr};
+
+    // Per-view culling state, indexed like the mesh sources of the snapshot.
+    std::vector<std::uint64_t> entity_visibility_bits_;
+    std::vector<std::uint64_t> entity_inside_bits_;
+    std::vector<DrawCommandChunk> draw_command_chunks_;
+    nodec::concurrent::ThreadPoolExecutor executor_;
+
+    InstanceBatcher instance_batcher_;
+    InstanceBuffer instance_buffer_;
+
+    SpriteBatcher sprite_batcher_;
+    InstanceBuffer sprite_vertex_buffer_;
+
+    std::vector<LightClusterGrid::PointLight> cluster_lights_;
+    LightClusterGrid light_cluster_grid_;
+    StructuredBuffer cluster_range_buffer_;
+    StructuredBuffer cluster_light_index_buffer_;
+    PointLightBuffer point_light_buffer_;
+
+    /**
+     * @brief The work of a render graph pass, indexed by the pass id.
+     */
+    struct RenderPassWork {
+        enum class Type {
+            Skybox,
+            Shader,
+            Upsample,
+            Effect
+        };
+
+        Type type;
+
+        //! The index into shader_runs_ or active_effects_.
+        std::uint32_t index;
+        int pass_num;
+    };
+
+    /**
+     * @brief A range of the sorted draw queue which shares the shader and the transparency.
+     */
+    struct ShaderRun {
+        std::size_t begin;
+        std::size_t end;
+        ShaderBackend *shader;
+    };
+
+    struct BoundTarget {
+        ID3D11RenderTargetView *render_target_view;
+        ID3D11ShaderResourceView *shader_resource_view;
+        FLOAT width;
+        FLOAT height;
+    };
+
+    std::vector<const nodec_rendering::components::PostProcessing::Effect *> active_effects_;
+    MaterialBackend *skybox_material_{nullptr};
+    std::vector<ShaderRun> shader_runs_;
+
+    RenderGraph render_graph_;
+    RenderGraphCache render_graph_cache_;
+    std::vector<RenderPassWork> render_passes_;
+
+    // Indexed by the resource id. The render targets written by a shader pass have the desc of the shader.
+    std::vector<nodec::optional<RenderTargetDesc>> render_target_descs_;
+    std::vector<BoundTarget> bound_targets_;
+
+    // The upsample targets read as their sources, while the upsample shader is missing.
+    std::vector<std::pair<std::string, RenderGraph::ResourceId>> upsample_aliases_;
+
+    SceneRendererStats stats_;
 };
 
 #endif
\ No newline at end of file
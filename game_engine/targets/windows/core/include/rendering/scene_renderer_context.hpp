@@ -9,9 +9,12 @@
 #include "../graphics/blend_state.hpp"
 #include "../graphics/graphics.hpp"
 #include "../rendering/material_backend.hpp"
+#include "../rendering/material_property_block.hpp"
 #include "cb_model_properties.hpp"
 #include "cb_scene_properties.hpp"
 #include "cb_texture_config.hpp"
+#include "quad_index_buffer.hpp"
+#include "text_layout_cache.hpp"
 #include "mesh_backend.hpp"
 #include "texture_backend.hpp"
 
@@ -20,6 +23,11 @@ struct SceneRenderingConstants {
     static constexpr UINT TEXTURE_CONFIG_CB_SLOT = 1;
     static constexpr UINT MODEL_PROPERTIES_CB_SLOT = 2;
     static constexpr UINT MATERIAL_PROPERTIES_CB_SLOT = 3;
+
+    // Above the slots of the material textures and the geometry buffers.
+    static constexpr UINT LIGHT_CLUSTER_RANGES_SRV_SLOT = 16;
+    static constexpr UINT LIGHT_CLUSTER_INDICES_SRV_SLOT = 17;
+    static constexpr UINT POINT_LIGHTS_SRV_SLOT = 18;
 };
 
 class SceneRendererContext {
@@ -63,37 +71,24 @@ public:
         return *state;
     }
 
+    /**
+     * @brief Binds the material textures from the slot 0.
+     *
+     * When the block is given, its texture overrides replace the entries of the same slot.
+     */
     UINT bind_texture_entries(const std::vector<nodec_rendering::resources::Material::TextureEntry> &texture_entries,
-                              uint32_t &tex_has_flag) {
+                              uint32_t &tex_has_flag,
+                              const MaterialPropertyBlock *block = nullptr, const ShaderBackend *shader = nullptr) {
         cb_texture_config_.data().tex_has_flag = 0;
         UINT slot = 0;
 
         for (auto &entry : texture_entries) {
-            if (!entry.texture) {
-                // texture not setted.
-                // skip bind texture,
-                // but bind sampler because the The Pixel Shader unit expects a Sampler to be set at Slot 0.
-                auto &defaultSamplerState = sampler_state({});
-                defaultSamplerState.BindPS(&gfx_, slot);
-                defaultSamplerState.BindVS(&gfx_, slot);
-
-                ++slot;
-                continue;
+            const auto *texture_override = block ? shader->property_layout().find_texture_override(*block, slot) : nullptr;
+            if (texture_override) {
+                bind_texture(slot, texture_override->texture, texture_override->sampler, tex_has_flag);
+            } else {
+                bind_texture(slot, static_cast<TextureBackend *>(entry.texture.get()), entry.sampler, tex_has_flag);
             }
-
-            auto *textureBackend = static_cast<TextureBackend *>(entry.texture.get());
-            {
-                auto *view = &textureBackend->shader_resource_view();
-                gfx_.context().VSSetShaderResources(slot, 1u, &view);
-                gfx_.context().PSSetShaderResources(slot, 1u, &view);
-            }
-
-            auto &samplerState = sampler_state(entry.sampler);
-            samplerState.BindVS(&gfx_, slot);
-            samplerState.BindPS(&gfx_, slot);
-
-            tex_has_flag |= 0x01 << slot;
-
             ++slot;
         }
         return slot;
@@ -138,6 +133,29 @@ public:
         cb_texture_config_.apply();
     }
 
+    /**
+     * @brief Binds the material with the per-draw overrides of the block.
+     *
+     * The material itself is left untouched, so it can be shared with the other draws.
+     */
+    void bind_material(MaterialBackend *material, const MaterialPropertyBlock &block) {
+        // The bound state differs from the plain material, so the next bind_material() must rebind it.
+        last_bound_material_id_ = 0x00;
+
+        if (!material) {
+            return;
+        }
+
+        set_cull_mode(material->cull_mode());
+
+        material->bind_constant_buffer(&gfx_, SceneRenderingConstants::MATERIAL_PROPERTIES_CB_SLOT, block);
+
+        cb_texture_config_.data().tex_has_flag = 0;
+        bind_texture_entries(material->texture_entries(), cb_texture_config_.data().tex_has_flag,
+                             &block, material->shader_backend());
+        cb_texture_config_.apply();
+    }
+
     /**
      * @brief 0.5 x 0.5 quad.
      */
@@ -159,6 +177,14 @@ public:
         return *screen_quad_mesh_;
     }
 
+    /**
+     * @brief The shader filling a full size target from a low resolution one (see ShaderBackend::BilateralUpsample).
+     * Null if the resource is not installed.
+     */
+    ShaderBackend *bilateral_upsample_shader() {
+        return bilateral_upsample_shader_.get();
+    }
+
     BlendState &bs_default() {
         return bs_default_;
     }
@@ -171,12 +197,57 @@ public:
         return font_character_database_;
     }
 
+    TextLayoutCache &text_layout_cache() {
+        return text_layout_cache_;
+    }
+
+    QuadIndexBuffer &quad_index_buffer() {
+        return quad_index_buffer_;
+    }
+
+    /**
+     * @brief Scratch block for the per-draw overrides. Clear it before use.
+     */
+    MaterialPropertyBlock &property_block() {
+        return property_block_;
+    }
+
+private:
+    void bind_texture(UINT slot, TextureBackend *texture, const nodec_rendering::Sampler &sampler, uint32_t &tex_has_flag) {
+        if (!texture) {
+            // texture not setted.
+            // skip bind texture,
+            // but bind sampler because the The Pixel Shader unit expects a Sampler to be set at Slot 0.
+            auto &defaultSamplerState = sampler_state({});
+            defaultSamplerState.BindPS(&gfx_, slot);
+            defaultSamplerState.BindVS(&gfx_, slot);
+            return;
+        }
+
+        {
+            auto *view = &texture->shader_resource_view();
+            gfx_.context().VSSetShaderResources(slot, 1u, &view);
+            gfx_.context().PSSetShaderResources(slot, 1u, &view);
+        }
+
+        auto &samplerState = sampler_state(sampler);
+        samplerState.BindVS(&gfx_, slot);
+        samplerState.BindPS(&gfx_, slot);
+
+        tex_has_flag |= 0x01 << slot;
+    }
+
 private:
     std::shared_ptr<nodec::logging::Logger> logger_;
 
     Graphics &gfx_;
 
     FontCharacterDatabase font_character_database_;
+    FontBackendGlyphSource glyph_source_;
+    TextLayoutCache text_layout_cache_;
+    QuadIndexBuffer quad_index_buffer_;
+
+    MaterialPropertyBlock property_block_;
 
     // slot 0
     CBSceneProperties cb_scene_properties_;
@@ -196,6 +267,7 @@ private:
     std::shared_ptr<MeshBackend> quad_mesh_;
     std::unique_ptr<MeshBackend> screen_quad_mesh_;
     std::shared_ptr<MeshBackend> norm_cube_mesh_;
+    std::shared_ptr<ShaderBackend> bilateral_upsample_shader_;
 
     BlendState bs_default_;
     BlendState bs_alpha_blend_;
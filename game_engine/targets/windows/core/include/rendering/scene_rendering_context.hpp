@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <d3d11.h>
 #include <wrl.h>
@@ -14,27 +15,105 @@
 #include "../graphics/RasterizerState.hpp"
 #include "../graphics/geometry_buffer.hpp"
 #include "../graphics/graphics.hpp"
+#include "../graphics/render_target_pool.hpp"
 
+/**
+ * @brief The render target memory used in the frame.
+ */
+struct RenderTargetStats {
+    //! The number of the textures in the pool.
+    std::size_t texture_count{0};
+
+    //! The bytes of the textures in the pool.
+    std::uint64_t allocated_bytes{0};
+
+    //! The bytes the render targets used in the frame would take if each had its own texture.
+    std::uint64_t requested_bytes{0};
+
+    std::uint64_t saved_bytes() const noexcept {
+        return requested_bytes > allocated_bytes ? requested_bytes - allocated_bytes : 0;
+    }
+};
+
+/**
+ * @brief The render targets and the depth stencil of a rendering target.
+ *
+ * The named render targets are transient. A name is bound to a texture of the pool at its first use,
+ * and kept until it is released. The renderer releases each name after its last use in the frame,
+ * so the later render targets of the same format and size reuse the texture.
+ * The texture may hold the contents of another name, so the caller clears it unless it is fully overwritten
+ * (see CompiledRenderGraph::Acquire).
+ */
 class SceneRenderingContext {
 public:
     SceneRenderingContext(std::uint32_t target_width, std::uint32_t target_height, Graphics &gfx);
 
+    /**
+     * @brief Returns the render target bound to the name, binding it with the desc declared last for the name.
+     */
     GeometryBuffer &geometry_buffer(const std::string &name) {
-        return geometry_buffer(name, target_width_, target_height_);
+        auto iter = live_buffers_.find(name);
+        if (iter != live_buffers_.end()) return *iter->second;
+
+        auto desc_iter = render_target_descs_.find(name);
+        return bind_geometry_buffer(name, desc_iter != render_target_descs_.end() ? desc_iter->second : RenderTargetDesc{});
+    }
+
+    /**
+     * @brief Declares the format and the size of the name, then returns the render target bound to it.
+     *
+     * The desc takes effect at the next binding if the name is already bound.
+     */
+    GeometryBuffer &geometry_buffer(const std::string &name, const RenderTargetDesc &desc) {
+        render_target_descs_[name] = desc;
+        return geometry_buffer(name);
+    }
+
+    bool is_geometry_buffer_bound(const std::string &name) const {
+        return live_buffers_.find(name) != live_buffers_.end();
+    }
+
+    /**
+     * @brief Returns the texture of the name to the pool.
+     *
+     * The contents are lost once the texture is lent to another name.
+     */
+    void release_geometry_buffer(const std::string &name) {
+        auto iter = live_buffers_.find(name);
+        if (iter == live_buffers_.end()) return;
+        pool_.release(*iter->second);
+        live_buffers_.erase(iter);
     }
 
-    GeometryBuffer &geometry_buffer(const std::string &name, std::uint32_t width, std::uint32_t height) {
-        auto &buffer = geometry_buffers_[name];
-        if (!buffer) {
-            buffer.reset(new GeometryBuffer(&gfx_, width, height));
-            shader_resource_views_[name] = &buffer->shader_resource_view();
+    /**
+     * @brief Releases the names for which @p pred returns true.
+     */
+    template<typename Pred>
+    void release_geometry_buffers_if(Pred &&pred) {
+        for (auto iter = live_buffers_.begin(); iter != live_buffers_.end();) {
+            if (!pred(iter->first)) {
+                ++iter;
+                continue;
+            }
+            pool_.release(*iter->second);
+            iter = live_buffers_.erase(iter);
         }
-        return *buffer;
     }
 
-    void swap_geometry_buffers(const std::string &lhs, const std::string &rhs) {
-        std::swap(geometry_buffers_[lhs], geometry_buffers_[rhs]);
-        std::swap(shader_resource_views_[lhs], shader_resource_views_[rhs]);
+    void release_geometry_buffers() {
+        release_geometry_buffers_if([](const std::string &) { return true; });
+    }
+
+    /**
+     * @brief Starts a new frame. All the names are released, and the textures unused for long are destroyed.
+     */
+    void begin_frame();
+
+    /**
+     * @brief The memory of the render targets used since begin_frame().
+     */
+    RenderTargetStats render_target_stats() const noexcept {
+        return {pool_.texture_count(), pool_.allocated_bytes(), frame_requested_bytes_};
     }
 
     /**
@@ -63,16 +142,11 @@ public:
         return *depth_stencil_view_.Get();
     }
 
+    /**
+     * @brief The number of the names bound to a render target now.
+     */
     std::size_t geometry_buffer_count() const noexcept {
-        return geometry_buffers_.size();
-    }
-
-    decltype(auto) geometry_buffer_begin() const noexcept {
-        return geometry_buffers_.begin();
-    }
-
-    decltype(auto) geometry_buffer_end() const noexcept {
-        return geometry_buffers_.end();
+        return live_buffers_.size();
     }
 
     std::size_t shader_resource_view_count() const noexcept {
@@ -87,11 +161,21 @@ public:
         return shader_resource_views_.end();
     }
 
+private:
+    GeometryBuffer &bind_geometry_buffer(const std::string &name, const RenderTargetDesc &desc);
+
 private:
     std::uint32_t target_width_;
     std::uint32_t target_height_;
     Graphics &gfx_;
-    std::unordered_map<std::string, std::unique_ptr<GeometryBuffer>> geometry_buffers_;
+
+    RenderTargetPool pool_;
+    std::unordered_map<std::string, GeometryBuffer *> live_buffers_;
+    std::unordered_map<std::string, RenderTargetDesc> render_target_descs_;
+
+    // The names bound since begin_frame(), for the stats.
+    std::unordered_set<std::string> frame_names_;
+    std::uint64_t frame_requested_bytes_{0};
 
     Microsoft::WRL::ComPtr<ID3D11Texture2D> depth_stencil_texture_;
     Microsoft::WRL::ComPtr<ID3D11DepthStencilView> depth_stencil_view_;
@@ -0,0 +1,132 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__SCENE_SNAPSHOT_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__SCENE_SNAPSHOT_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <nodec/concurrent/thread_pool_executor.hpp>
+#include <nodec/macros.hpp>
+#include <nodec/matrix4x4.hpp>
+#include <nodec_rendering/components/image_renderer.hpp>
+#include <nodec_rendering/components/mesh_renderer.hpp>
+#include <nodec_rendering/components/text_renderer.hpp>
+#include <nodec_scene/components/local_to_world.hpp>
+#include <nodec_scene/scene.hpp>
+
+#include "frustum_culling.hpp"
+#include "material_backend.hpp"
+#include "mesh_backend.hpp"
+#include "text_layout_cache.hpp"
+#include "texture_backend.hpp"
+
+/**
+ * @brief The renderables of the scene extracted once per frame, shared by all the views of the frame.
+ *
+ * The capture walks the registries, refreshes the world bounds of the moved mesh renderers and lays out the texts.
+ * Each view then only culls and sorts against the compact arrays.
+ *
+ * The sources refer the components by pointer, so the snapshot is valid only until the registry changes.
+ */
+class SceneSnapshot {
+public:
+    struct MeshSource {
+        nodec_scene::SceneEntity entity;
+        const nodec_rendering::components::MeshRenderer *renderer;
+        const nodec_scene::components::LocalToWorld *local_to_world;
+
+        //! The index of the first submesh into submesh_world_bounds().
+        std::uint32_t first_bounds;
+    };
+
+    struct ImageSource {
+        const nodec_rendering::components::ImageRenderer *renderer;
+        const nodec_scene::components::LocalToWorld *local_to_world;
+        TextureBackend *image;
+        MaterialBackend *material;
+
+        // The size of the image in the world units.
+        float width;
+        float height;
+    };
+
+    struct TextSource {
+        const nodec_rendering::components::TextRenderer *renderer;
+        const nodec_scene::components::LocalToWorld *local_to_world;
+        TextLayout *layout;
+    };
+
+    SceneSnapshot() = default;
+
+    /**
+     * @brief Extracts the renderables of the scene.
+     *
+     * @param indexed If true, the mesh sources can be found by their entities with find_mesh_source().
+     */
+    void capture(nodec_scene::Scene &scene, TextLayoutCache &text_layout_cache,
+                 nodec::concurrent::ThreadPoolExecutor &executor, bool indexed);
+
+    /**
+     * @brief Returns the index of the mesh source of the entity, or -1 if it was not captured.
+     */
+    std::int64_t find_mesh_source(nodec_scene::SceneRegistry &scene_registry, nodec_scene::SceneEntity entity) const;
+
+    const std::vector<MeshSource> &mesh_sources() const noexcept {
+        return mesh_sources_;
+    }
+
+    /**
+     * @brief The bounds combining the submeshes of each renderer, indexed like mesh_sources().
+     */
+    const WorldBoundsArray &mesh_world_bounds() const noexcept {
+        return entity_world_bounds_;
+    }
+
+    /**
+     * @brief The bounds of each submesh, indexed by MeshSource::first_bounds + submesh index.
+     */
+    const WorldBoundsArray &submesh_world_bounds() const noexcept {
+        return submesh_world_bounds_;
+    }
+
+    const std::vector<ImageSource> &image_sources() const noexcept {
+        return image_sources_;
+    }
+
+    const std::vector<TextSource> &text_sources() const noexcept {
+        return text_sources_;
+    }
+
+    /**
+     * @brief The number of the captures since the construction.
+     */
+    std::uint64_t capture_count() const noexcept {
+        return capture_count_;
+    }
+
+private:
+    /**
+     * @brief The inputs of the cached world bounds.
+     * The world bounds are recomputed only when one of them changes.
+     */
+    struct MeshBoundsKey {
+        const MeshBackend *mesh;
+        nodec::Matrix4x4f matrix_m;
+    };
+
+    std::vector<MeshSource> mesh_sources_;
+    WorldBoundsArray entity_world_bounds_;
+
+    // Per-submesh state, indexed by MeshSource::first_bounds + submesh index.
+    std::vector<MeshBoundsKey> mesh_bounds_keys_;
+    WorldBoundsArray submesh_world_bounds_;
+
+    std::vector<ImageSource> image_sources_;
+    std::vector<TextSource> text_sources_;
+
+    std::uint64_t capture_count_{0};
+
+private:
+    NODEC_DISABLE_COPY(SceneSnapshot)
+};
+
+#endif
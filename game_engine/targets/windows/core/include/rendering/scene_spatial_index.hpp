@@ -0,0 +1,77 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__SCENE_SPATIAL_INDEX_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__SCENE_SPATIAL_INDEX_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include <nodec/macros.hpp>
+#include <nodec_scene/scene_registry.hpp>
+
+#include "aabb_tree.hpp"
+#include "frustum_culling.hpp"
+
+/**
+ * @brief Keeps the world bounds of the mesh renderers in a dynamic AABB tree.
+ *
+ * The entities which do not move keep their proxies untouched, so the cameras and the picking
+ * only visit the subtrees near them instead of all the mesh renderers.
+ * The index is synchronized with the registry once per frame by update().
+ */
+class SceneSpatialIndex {
+public:
+    SceneSpatialIndex() = default;
+
+    /**
+     * @brief Adds, moves and removes the proxies to match the mesh renderers in the registry.
+     *
+     * Call it after the transforms have been updated.
+     */
+    void update(nodec_scene::SceneRegistry &scene_registry);
+
+    /**
+     * @brief Calls callback(entity, is_inside) for each indexed entity whose bounds may intersect the frustum.
+     *
+     * The reported entities may have been destroyed or changed since the last update().
+     */
+    template<typename Callback>
+    void query_frustum(const CullingPlanes &planes, Callback &&callback) const {
+        tree_.query_frustum(planes, [&](std::uint32_t slot, bool is_inside) {
+            callback(entries_[slot].entity, is_inside);
+        });
+    }
+
+    /**
+     * @brief Finds the closest entity whose world bounds are hit by the ray.
+     *
+     * @param direction Need not be normalized. The distance is in units of its length.
+     * @return true if an entity is hit.
+     */
+    bool raycast(const DirectX::XMFLOAT3 &origin, const DirectX::XMFLOAT3 &direction, float max_distance,
+                 nodec_scene::SceneEntity &hit_entity, float &hit_distance) const;
+
+    std::size_t entity_count() const noexcept {
+        return tree_.proxy_count();
+    }
+
+private:
+    struct Entry {
+        nodec_scene::SceneEntity entity;
+        int proxy;
+
+        // The tight bounds. The tree keeps the enlarged one.
+        AabbTree::Box box;
+    };
+
+    std::uint32_t allocate_entry();
+
+private:
+    AabbTree tree_;
+    std::vector<Entry> entries_;
+    std::vector<std::uint32_t> free_entries_;
+
+    NODEC_DISABLE_COPY(SceneSpatialIndex)
+};
+
+#endif
@@ -4,6 +4,8 @@
 #include <graphics/InputLayout.hpp>
 #include <graphics/PixelShader.hpp>
 #include <graphics/VertexShader.hpp>
+#include <graphics/render_target_pool.hpp>
+#include <resources/resource_file_system.hpp>
 
 #include <nodec_rendering/resources/shader.hpp>
 
@@ -12,8 +14,15 @@
 
 #include <cassert>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "draw_queue.hpp"
+#include "material_property_id.hpp"
+#include "material_property_layout.hpp"
+#include "vertex_format.hpp"
+#include "render_sort_id.hpp"
+
 class ShaderBackend : public nodec_rendering::resources::Shader {
     using ShaderMetaInfo = nodec_rendering::resources::ShaderMetaInfo;
     using SubShaderMetaInfo = nodec_rendering::resources::SubShaderMetaInfo;
@@ -21,16 +30,33 @@ class ShaderBackend : public nodec_rendering::resources::Shader {
     using Vector4Property = typename ShaderMetaInfo::Vector4Property;
     using TextureEntry = typename ShaderMetaInfo::TextureEntry;
 
+public:
+    /**
+     * @brief Fills the full size @p target from the low resolution @p source before the pass,
+     * weighting the source texels by their depth difference so that the edges do not bleed.
+     */
+    struct BilateralUpsample {
+        std::string source;
+        std::string target;
+    };
+
+private:
     struct SubShader {
         std::string name;
         std::vector<std::string> render_targets;
         std::vector<std::string> texture_resources;
+        std::unordered_map<std::string, RenderTargetDesc> render_target_descs;
+        float resolution_scale{1.0f};
+        std::vector<BilateralUpsample> bilateral_upsamples;
         std::unique_ptr<VertexShader> vertex_shader;
         std::unique_ptr<PixelShader> pixel_shader;
     };
 
 public:
-    ShaderBackend(Graphics *gfx, const std::string &path, const ShaderMetaInfo &meta_info,
+    /**
+     * @param files The archive and the loose files the compiled shaders are read from.
+     */
+    ShaderBackend(Graphics *gfx, const ResourceFileSystem &files, const std::string &path, const ShaderMetaInfo &meta_info,
                   const std::vector<SubShaderMetaInfo> &sub_shader_meta_infos) {
         using namespace nodec;
 
@@ -39,11 +65,16 @@ public:
         texture_entries_ = meta_info.texture_entries;
         rendering_priority_ = meta_info.rendering_priority;
 
+        std::string instanced_vertex_shader_path;
+        std::string sprite_vertex_shader_path;
+
         if (sub_shader_meta_infos.size() == 0) {
             // no sub shader, only one shader set (vertex, pixel).
             sub_shaders_.resize(1);
-            sub_shaders_[0].vertex_shader.reset(new VertexShader(*gfx, Formatter() << path << "/vertex.cso"));
-            sub_shaders_[0].pixel_shader.reset(new PixelShader(*gfx, Formatter() << path << "/pixel.cso"));
+            sub_shaders_[0].vertex_shader = load_shader<VertexShader>(*gfx, files, Formatter() << path << "/vertex.cso");
+            sub_shaders_[0].pixel_shader = load_shader<PixelShader>(*gfx, files, Formatter() << path << "/pixel.cso");
+            instanced_vertex_shader_path = Formatter() << path << "/vertex_instanced.cso";
+            sprite_vertex_shader_path = Formatter() << path << "/vertex_sprite.cso";
         } else {
             if (meta_info.pass.size() != sub_shader_meta_infos.size()) {
                 throw std::runtime_error(ErrorFormatter<std::runtime_error>(__FILE__, __LINE__)
@@ -56,45 +87,70 @@ public:
                 sub_shaders_[i].name = name;
                 sub_shaders_[i].render_targets = info.render_targets;
                 sub_shaders_[i].texture_resources = info.texture_resources;
-                sub_shaders_[i].vertex_shader.reset(new VertexShader(*gfx, Formatter() << path << "/" << name << "_vs.cso"));
-                sub_shaders_[i].pixel_shader.reset(new PixelShader(*gfx, Formatter() << path << "/" << name << "_ps.cso"));
+                sub_shaders_[i].vertex_shader = load_shader<VertexShader>(*gfx, files, Formatter() << path << "/" << name << "_vs.cso");
+                sub_shaders_[i].pixel_shader = load_shader<PixelShader>(*gfx, files, Formatter() << path << "/" << name << "_ps.cso");
             }
+            instanced_vertex_shader_path = Formatter() << path << "/" << meta_info.pass[0] << "_vs_instanced.cso";
+            sprite_vertex_shader_path = Formatter() << path << "/" << meta_info.pass[0] << "_vs_sprite.cso";
         }
         assert(sub_shaders_.size() != 0 && "Sub shaders must include at least one shader");
 
-        // Make the input layout.
-        {
-            const D3D11_INPUT_ELEMENT_DESC ied[] = {
-                {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-                {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-                {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
-                {"TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0}};
+        // Make the input layout of each vertex format.
+        for (std::size_t format = 0; format < VERTEX_FORMAT_COUNT; ++format) {
+            const auto ied = vertex_input_elements(static_cast<VertexFormat>(format));
 
-            input_layout_.reset(new InputLayout(
-                *gfx, ied, static_cast<UINT>(std::size(ied)),
+            input_layouts_[format].reset(new InputLayout(
+                *gfx, ied.data(), static_cast<UINT>(ied.size()),
                 sub_shaders_[0].vertex_shader->bytecode().GetBufferPointer(),
                 sub_shaders_[0].vertex_shader->bytecode().GetBufferSize()));
         }
 
-        // Make the prototype for material constants.
-        {
-            for (auto &property : float_properties_) {
-                float_property_offsets_[property.name] = property_memory_prototype.size();
-                append_property(property_memory_prototype, property.default_value);
-            }
-            align_memory(property_memory_prototype);
-
-            for (auto &property : vector4_properties_) {
-                vector4_property_offsets_[property.name] = property_memory_prototype.size();
-                append_property(property_memory_prototype, property.default_value);
+        // The instanced variant of the first pass is optional.
+        // The per-instance model matrices are streamed from the slot 1 (see InstanceData).
+        if (files.exists(instanced_vertex_shader_path)) {
+            instanced_vertex_shader_ = load_shader<VertexShader>(*gfx, files, instanced_vertex_shader_path);
+
+            const D3D11_INPUT_ELEMENT_DESC instance_ied[] = {
+                {"INSTANCE_MATRIX_M", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                {"INSTANCE_MATRIX_M", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                {"INSTANCE_MATRIX_M", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                {"INSTANCE_MATRIX_M", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                {"INSTANCE_MATRIX_M_INVERSE", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                {"INSTANCE_MATRIX_M_INVERSE", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                {"INSTANCE_MATRIX_M_INVERSE", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                {"INSTANCE_MATRIX_M_INVERSE", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1}};
+
+            for (std::size_t format = 0; format < VERTEX_FORMAT_COUNT; ++format) {
+                const auto vertex_ied = vertex_input_elements(static_cast<VertexFormat>(format));
+
+                std::vector<D3D11_INPUT_ELEMENT_DESC> ied(vertex_ied.begin(), vertex_ied.end());
+                ied.insert(ied.end(), std::begin(instance_ied), std::end(instance_ied));
+
+                instanced_input_layouts_[format].reset(new InputLayout(
+                    *gfx, ied.data(), static_cast<UINT>(ied.size()),
+                    instanced_vertex_shader_->bytecode().GetBufferPointer(),
+                    instanced_vertex_shader_->bytecode().GetBufferSize()));
             }
-            align_memory(property_memory_prototype);
         }
 
-        for (int slot = 0; slot < texture_entries_.size(); ++slot) {
-            auto &entry = texture_entries_[slot];
-            texture_entry_slots_[entry.name] = slot;
+        // The sprite variant of the first pass is optional too.
+        // The world space quads of the sprite batch are streamed from the slot 0 (see SpriteVertex).
+        if (files.exists(sprite_vertex_shader_path)) {
+            sprite_vertex_shader_ = load_shader<VertexShader>(*gfx, files, sprite_vertex_shader_path);
+
+            const D3D11_INPUT_ELEMENT_DESC ied[] = {
+                {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+                {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+                {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+                {"COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0}};
+
+            sprite_input_layout_.reset(new InputLayout(
+                *gfx, ied, static_cast<UINT>(std::size(ied)),
+                sprite_vertex_shader_->bytecode().GetBufferPointer(),
+                sprite_vertex_shader_->bytecode().GetBufferSize()));
         }
+
+        property_layout_ = MaterialPropertyLayout(float_properties_, vector4_properties_, texture_entries_);
     }
 
 public:
@@ -122,47 +178,87 @@ public:
 
 public:
     std::vector<uint8_t> create_property_memory() const {
-        return property_memory_prototype;
+        return property_layout_.create_property_memory();
     }
 
     float get_float_property(const std::vector<uint8_t> &property_memory, const std::string &name) const {
-        auto offset = float_property_offsets_.at(name);
-        return *get_property_ptr<float>(property_memory, offset);
+        return get_float_property(property_memory, float_property_id_assured(name));
+    }
+
+    float get_float_property(const std::vector<uint8_t> &property_memory, MaterialPropertyId id) const {
+        return property_layout_.get_float_property(property_memory, id);
     }
 
     void set_float_property(std::vector<uint8_t> &property_memory, const std::string &name, const float &value) const {
-        auto offset = float_property_offsets_.at(name);
-        auto *v = get_property_ptr<float>(property_memory, offset);
-        *v = value;
+        set_float_property(property_memory, float_property_id_assured(name), value);
+    }
+
+    void set_float_property(std::vector<uint8_t> &property_memory, MaterialPropertyId id, const float &value) const {
+        property_layout_.set_float_property(property_memory, id, value);
     }
 
     nodec::optional<nodec::Vector4f> get_vector4_property(const std::vector<uint8_t> &property_memory, const std::string &name) const {
-        using namespace nodec;
-        auto iter = vector4_property_offsets_.find(name);
-        if (iter == vector4_property_offsets_.end()) return nodec::nullopt;
-        return *get_property_ptr<Vector4f>(property_memory, iter->second);
+        auto id = MaterialPropertyId::find(name);
+        if (!id) return nodec::nullopt;
+        return get_vector4_property(property_memory, *id);
+    }
+
+    nodec::optional<nodec::Vector4f> get_vector4_property(const std::vector<uint8_t> &property_memory, MaterialPropertyId id) const {
+        return property_layout_.get_vector4_property(property_memory, id);
     }
 
     bool set_vector4_property(std::vector<uint8_t> &property_memory, const std::string &name, const nodec::Vector4f &value) const {
-        using namespace nodec;
-        auto iter = vector4_property_offsets_.find(name);
-        if (iter == vector4_property_offsets_.end()) return false;
+        auto id = MaterialPropertyId::find(name);
+        if (!id) return false;
+        return set_vector4_property(property_memory, *id, value);
+    }
 
-        auto *v = get_property_ptr<Vector4f>(property_memory, iter->second);
-        *v = value;
-        return true;
+    bool set_vector4_property(std::vector<uint8_t> &property_memory, MaterialPropertyId id, const nodec::Vector4f &value) const {
+        return property_layout_.set_vector4_property(property_memory, id, value);
     }
 
     nodec::optional<std::size_t> get_texture_slot(const std::string &name) const noexcept {
-        auto iter = texture_entry_slots_.find(name);
-        if (iter == texture_entry_slots_.end()) return nodec::nullopt;
-        return iter->second;
+        auto id = MaterialPropertyId::find(name);
+        if (!id) return nodec::nullopt;
+        return get_texture_slot(*id);
+    }
+
+    nodec::optional<std::size_t> get_texture_slot(MaterialPropertyId id) const noexcept {
+        return property_layout_.texture_slot(id);
+    }
+
+    /**
+     * @brief Returns the offset of the float property in the property memory.
+     */
+    nodec::optional<std::size_t> float_property_offset(MaterialPropertyId id) const noexcept {
+        return property_layout_.float_property_offset(id);
+    }
+
+    /**
+     * @brief Returns the offset of the vector4 property in the property memory.
+     */
+    nodec::optional<std::size_t> vector4_property_offset(MaterialPropertyId id) const noexcept {
+        return property_layout_.vector4_property_offset(id);
+    }
+
+    /**
+     * @brief The layout the materials apply their property blocks through.
+     */
+    const MaterialPropertyLayout &property_layout() const noexcept {
+        return property_layout_;
     }
 
     std::size_t pass_count() const noexcept {
         return sub_shaders_.size();
     }
 
+    /**
+     * @brief The sub-shader name of the pass. It is empty for the shader without the passes.
+     */
+    const std::string &pass_name(std::size_t pass_num) const {
+        return sub_shaders_.at(pass_num).name;
+    }
+
     const std::vector<std::string> &render_targets(std::size_t pass_num) const {
         return sub_shaders_.at(pass_num).render_targets;
     }
@@ -170,6 +266,46 @@ public:
         return sub_shaders_.at(pass_num).texture_resources;
     }
 
+    /**
+     * @brief The format and the size of the render target written by the pass.
+     * The render target without the declaration is R32G32B32A32_FLOAT at the resolution scale of the pass.
+     */
+    RenderTargetDesc render_target_desc(std::size_t pass_num, const std::string &name) const {
+        const auto &sub_shader = sub_shaders_.at(pass_num);
+        auto iter = sub_shader.render_target_descs.find(name);
+        if (iter != sub_shader.render_target_descs.end()) return iter->second;
+
+        RenderTargetDesc desc;
+        desc.scale = sub_shader.resolution_scale;
+        return desc;
+    }
+
+    void set_render_target_desc(std::size_t pass_num, const std::string &name, const RenderTargetDesc &desc) {
+        sub_shaders_.at(pass_num).render_target_descs[name] = desc;
+    }
+
+    /**
+     * @brief The size of the render targets of the pass relative to the rendering target.
+     */
+    float resolution_scale(std::size_t pass_num) const {
+        return sub_shaders_.at(pass_num).resolution_scale;
+    }
+
+    void set_resolution_scale(std::size_t pass_num, float scale) {
+        sub_shaders_.at(pass_num).resolution_scale = scale;
+    }
+
+    /**
+     * @brief The upsamples run before the pass. The pass reads their targets.
+     */
+    const std::vector<BilateralUpsample> &bilateral_upsamples(std::size_t pass_num) const {
+        return sub_shaders_.at(pass_num).bilateral_upsamples;
+    }
+
+    void add_bilateral_upsample(std::size_t pass_num, const BilateralUpsample &upsample) {
+        sub_shaders_.at(pass_num).bilateral_upsamples.push_back(upsample);
+    }
+
     const auto &float_properties() const {
         return float_properties_;
     }
@@ -182,79 +318,117 @@ public:
         return texture_entries_;
     }
 
-    InputLayout &input_layout() noexcept {
-        return *input_layout_.get();
+    InputLayout &input_layout(VertexFormat format = VertexFormat::Float32) noexcept {
+        return *input_layouts_[static_cast<std::size_t>(format)].get();
     }
 
+    /**
+     * @brief Binds the pass with the input layout of the Float32 vertices.
+     */
     void bind(std::size_t pass_num = 0) {
         assert(pass_num < sub_shaders_.size());
 
-        input_layout_->bind();
+        input_layouts_[static_cast<std::size_t>(VertexFormat::Float32)]->bind();
 
         sub_shaders_[pass_num].vertex_shader->bind();
         sub_shaders_[pass_num].pixel_shader->bind();
     }
 
-    int rendering_priority() const noexcept {
-        return rendering_priority_;
+    /**
+     * @brief Whether the first pass has the instanced vertex shader.
+     */
+    bool supports_instancing() const noexcept {
+        return static_cast<bool>(instanced_vertex_shader_);
     }
 
-private:
-    template<typename T>
-    static void append_property(std::vector<uint8_t> &memory, const T &value) {
-        // <https://stackoverrun.com/ja/q/3787586>
-        const uint8_t *p = reinterpret_cast<const uint8_t *>(&value);
-        for (size_t i = 0; i < sizeof(T); ++i) {
-            memory.push_back(p[i]);
-        }
+    /**
+     * @brief Binds the first pass with the instanced vertex shader.
+     */
+    void bind_instanced() {
+        assert(supports_instancing());
+
+        instanced_input_layouts_[static_cast<std::size_t>(VertexFormat::Float32)]->bind();
+
+        instanced_vertex_shader_->bind();
+        sub_shaders_[0].pixel_shader->bind();
     }
 
-    template<typename T>
-    static T *get_property_ptr(std::vector<uint8_t> &memory, const std::size_t offset) {
-        // <http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2015/p0007r0.html>
-        return const_cast<T *>(get_property_ptr<T>(
-            const_cast<std::add_const_t<std::remove_reference_t<decltype(memory)>> &>(memory),
-            offset));
+    /**
+     * @brief Switches the input layout of the bound pass to the vertex format of the mesh drawn next.
+     */
+    void bind_input_layout(VertexFormat format, bool instanced = false) {
+        auto &layouts = instanced ? instanced_input_layouts_ : input_layouts_;
+        layouts[static_cast<std::size_t>(format)]->bind();
     }
 
-    template<typename T>
-    static const T *get_property_ptr(const std::vector<uint8_t> &memory, const std::size_t offset) {
-        auto end = offset + sizeof(T);
-        if (end > memory.size()) {
-            throw std::out_of_range("Exceed property memory boundary.");
-        }
+    /**
+     * @brief Whether the first pass has the sprite vertex shader.
+     */
+    bool supports_sprite_batching() const noexcept {
+        return static_cast<bool>(sprite_vertex_shader_);
+    }
+
+    /**
+     * @brief Binds the first pass with the sprite vertex shader.
+     */
+    void bind_sprite() {
+        assert(supports_sprite_batching());
+
+        sprite_input_layout_->bind();
+
+        sprite_vertex_shader_->bind();
+        sub_shaders_[0].pixel_shader->bind();
+    }
+
+    int rendering_priority() const noexcept {
+        return rendering_priority_;
+    }
 
-        return reinterpret_cast<const T *>(&memory[offset]);
+    /**
+     * @brief Compact id of this shader used in the draw sort key. Unique among the live shaders.
+     */
+    std::uint32_t sort_id() const noexcept {
+        return sort_id_.value();
     }
 
-    static void align_memory(std::vector<uint8_t> &memory) {
-        // Packing Rules for Constant Variables
-        // <https://docs.microsoft.com/en-us/windows/win32/direct3dhlsl/dx-graphics-hlsl-packing-rules>
-        constexpr size_t alignment_size = 16;
-        size_t aligned = (memory.size() + (alignment_size - 1)) & ~(alignment_size - 1);
+private:
+    static MaterialPropertyId float_property_id_assured(const std::string &name) {
+        auto id = MaterialPropertyId::find(name);
+        if (!id) throw std::out_of_range("No float property.");
+        return *id;
+    }
 
-        // add padding so that size will be a multiple of 16.
-        while (memory.size() < aligned) {
-            memory.push_back(0x00);
+    template<typename ShaderStage>
+    static std::unique_ptr<ShaderStage> load_shader(Graphics &gfx, const ResourceFileSystem &files, const std::string &path) {
+        auto file = files.read(path);
+        if (!file) {
+            throw std::runtime_error(nodec::ErrorFormatter<std::runtime_error>(__FILE__, __LINE__)
+                                     << "Failed to open the compiled shader. path: " << path);
         }
+        return std::unique_ptr<ShaderStage>(new ShaderStage(gfx, file->data(), file->size()));
     }
 
 private:
     std::vector<FloatProperty> float_properties_;
-    std::unordered_map<std::string, std::size_t> float_property_offsets_;
-
     std::vector<Vector4Property> vector4_properties_;
-    std::unordered_map<std::string, std::size_t> vector4_property_offsets_;
-
     std::vector<TextureEntry> texture_entries_;
-    std::unordered_map<std::string, std::size_t> texture_entry_slots_;
 
-    std::vector<uint8_t> property_memory_prototype;
+    MaterialPropertyLayout property_layout_;
 
-    std::unique_ptr<InputLayout> input_layout_;
+    // Indexed by the vertex format.
+    std::unique_ptr<InputLayout> input_layouts_[VERTEX_FORMAT_COUNT];
     std::vector<SubShader> sub_shaders_;
 
+    std::unique_ptr<InputLayout> instanced_input_layouts_[VERTEX_FORMAT_COUNT];
+    std::unique_ptr<VertexShader> instanced_vertex_shader_;
+
+    std::unique_ptr<InputLayout> sprite_input_layout_;
+    std::unique_ptr<VertexShader> sprite_vertex_shader_;
+
     int rendering_priority_{0};
+
+    // The renderer splits the sorted queue by shader, so the shaders must not share a key field.
+    RenderSortId<ShaderBackend, DrawSortKey::SHADER_BITS> sort_id_;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,336 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__SHADER_DESCRIPTOR_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__SHADER_DESCRIPTOR_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The shader.meta and the pass metas of a shader compiled into one binary file.
+ *
+ * The JSON metas stay the authoring format. The descriptor is written next to them as shader.meta.bin
+ * by the shader-meta-compiler tool. It keeps the hash of the metas it was compiled from,
+ * and the loader reads it instead of them only while the hash matches the metas on the disk.
+ *
+ * The file is the header, then the sections in the order of the counts, each string prefixed with its 32 bits length.
+ * All the values are little endian.
+ */
+namespace shader_descriptor {
+
+constexpr std::uint32_t MAGIC = 0x44485353; // "SSHD"
+constexpr std::uint32_t VERSION = 2;
+
+//! The file name in the shader directory.
+constexpr const char *FILE_NAME = "shader.meta.bin";
+
+struct FloatProperty {
+    std::string name;
+    float default_value;
+};
+
+struct Vector4Property {
+    std::string name;
+    float default_value[4];
+};
+
+struct RenderTargetDesc {
+    std::string name;
+
+    //! The name of the format, like "R16G16B16A16_FLOAT".
+    std::string format;
+
+    //! Zero takes the resolution scale of the pass.
+    float scale;
+};
+
+struct BilateralUpsample {
+    std::string source;
+    std::string target;
+};
+
+struct Pass {
+    std::string name;
+    std::vector<std::string> render_targets;
+    std::vector<std::string> texture_resources;
+    std::vector<RenderTargetDesc> render_target_descs;
+    float resolution_scale{1.0f};
+    std::vector<BilateralUpsample> bilateral_upsamples;
+};
+
+/**
+ * @brief Everything the loader reads from the JSON metas of a shader.
+ *
+ * The material constants are laid out in the order of the properties, so the order is kept.
+ */
+struct ShaderDescriptor {
+    std::vector<FloatProperty> float_properties;
+    std::vector<Vector4Property> vector4_properties;
+    std::vector<std::string> texture_entries;
+    std::int32_t rendering_priority{0};
+
+    //! Empty for the shader of one vertex and one pixel shader without the pass metas.
+    std::vector<Pass> passes;
+
+    //! The hash of the metas it was compiled from. See shader_meta::hash_shader_metas().
+    std::uint64_t source_hash{0};
+};
+
+struct Header {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::int32_t rendering_priority;
+    std::uint32_t float_property_count;
+    std::uint32_t vector4_property_count;
+    std::uint32_t texture_entry_count;
+    std::uint32_t pass_count;
+    std::uint32_t reserved;
+    std::uint64_t source_hash;
+};
+
+constexpr std::uint64_t SOURCE_HASH_SEED = 0xcbf29ce484222325ull;
+
+/**
+ * @brief Adds the bytes to the FNV-1a hash of the source metas.
+ */
+inline std::uint64_t hash_source(std::uint64_t hash, const void *data, std::size_t size) noexcept {
+    const auto *bytes = static_cast<const std::uint8_t *>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+namespace details {
+
+class Writer {
+public:
+    explicit Writer(std::ostream &out)
+        : out_(out) {}
+
+    template<typename T>
+    void value(const T &value) {
+        out_.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void string(const std::string &value) {
+        this->value(static_cast<std::uint32_t>(value.size()));
+        out_.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+
+    void strings(const std::vector<std::string> &values) {
+        value(static_cast<std::uint32_t>(values.size()));
+        for (const auto &value : values) string(value);
+    }
+
+private:
+    std::ostream &out_;
+};
+
+class Reader {
+public:
+    Reader(const void *data, std::size_t size)
+        : data_(static_cast<const char *>(data)), size_(size) {}
+
+    template<typename T>
+    T value() {
+        T value;
+        std::memcpy(&value, take(sizeof(value)), sizeof(value));
+        return value;
+    }
+
+    std::string string() {
+        const auto size = value<std::uint32_t>();
+        const auto *data = take(size);
+        return std::string(data, size);
+    }
+
+    std::vector<std::string> strings() {
+        std::vector<std::string> values(count(sizeof(std::uint32_t)));
+        for (auto &value : values) value = string();
+        return values;
+    }
+
+    /**
+     * @brief Reads a count, rejecting the ones the rest of the file cannot hold.
+     */
+    std::uint32_t count(std::size_t min_item_size) {
+        return checked_count(value<std::uint32_t>(), min_item_size);
+    }
+
+    std::uint32_t checked_count(std::uint32_t count, std::size_t min_item_size) const {
+        if (static_cast<std::uint64_t>(count) * min_item_size > size_ - position_) {
+            throw std::runtime_error("The shader descriptor is truncated.");
+        }
+        return count;
+    }
+
+    bool at_end() const noexcept {
+        return position_ == size_;
+    }
+
+private:
+    const char *take(std::size_t size) {
+        if (size > size_ - position_) {
+            throw std::runtime_error("The shader descriptor is truncated.");
+        }
+        const auto *data = data_ + position_;
+        position_ += size;
+        return data;
+    }
+
+    const char *data_;
+    std::size_t size_;
+    std::size_t position_{0};
+};
+
+} // namespace details
+
+inline void write_shader_descriptor(std::ostream &out, const ShaderDescriptor &descriptor) {
+    Header header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.rendering_priority = descriptor.rendering_priority;
+    header.float_property_count = static_cast<std::uint32_t>(descriptor.float_properties.size());
+    header.vector4_property_count = static_cast<std::uint32_t>(descriptor.vector4_properties.size());
+    header.texture_entry_count = static_cast<std::uint32_t>(descriptor.texture_entries.size());
+    header.pass_count = static_cast<std::uint32_t>(descriptor.passes.size());
+    header.source_hash = descriptor.source_hash;
+
+    details::Writer writer(out);
+    writer.value(header);
+
+    for (const auto &property : descriptor.float_properties) {
+        writer.string(property.name);
+        writer.value(property.default_value);
+    }
+    for (const auto &property : descriptor.vector4_properties) {
+        writer.string(property.name);
+        writer.value(property.default_value);
+    }
+    for (const auto &entry : descriptor.texture_entries) {
+        writer.string(entry);
+    }
+
+    for (const auto &pass : descriptor.passes) {
+        writer.string(pass.name);
+        writer.strings(pass.render_targets);
+        writer.strings(pass.texture_resources);
+
+        writer.value(static_cast<std::uint32_t>(pass.render_target_descs.size()));
+        for (const auto &desc : pass.render_target_descs) {
+            writer.string(desc.name);
+            writer.string(desc.format);
+            writer.value(desc.scale);
+        }
+
+        writer.value(pass.resolution_scale);
+
+        writer.value(static_cast<std::uint32_t>(pass.bilateral_upsamples.size()));
+        for (const auto &upsample : pass.bilateral_upsamples) {
+            writer.string(upsample.source);
+            writer.string(upsample.target);
+        }
+    }
+
+    if (!out) {
+        throw std::runtime_error("Failed to write the shader descriptor.");
+    }
+}
+
+/**
+ * @brief Reads the descriptor in memory. Throws std::runtime_error on the broken one.
+ */
+inline ShaderDescriptor read_shader_descriptor(const void *data, std::size_t size) {
+    details::Reader reader(data, size);
+
+    const auto header = reader.value<Header>();
+    if (header.magic != MAGIC || header.version != VERSION) {
+        throw std::runtime_error("Not a shader descriptor, or the version is not supported.");
+    }
+
+    // The smallest items are the empty strings with their lengths.
+    constexpr auto length_size = sizeof(std::uint32_t);
+
+    ShaderDescriptor descriptor;
+    descriptor.rendering_priority = header.rendering_priority;
+    descriptor.source_hash = header.source_hash;
+
+    descriptor.float_properties.resize(reader.checked_count(header.float_property_count, length_size + sizeof(float)));
+    for (auto &property : descriptor.float_properties) {
+        property.name = reader.string();
+        property.default_value = reader.value<float>();
+    }
+
+    descriptor.vector4_properties.resize(reader.checked_count(header.vector4_property_count, length_size + sizeof(float) * 4));
+    for (auto &property : descriptor.vector4_properties) {
+        property.name = reader.string();
+        for (auto &component : property.default_value) component = reader.value<float>();
+    }
+
+    descriptor.texture_entries.resize(reader.checked_count(header.texture_entry_count, length_size));
+    for (auto &entry : descriptor.texture_entries) {
+        entry = reader.string();
+    }
+
+    descriptor.passes.resize(reader.checked_count(header.pass_count, length_size * 5 + sizeof(float)));
+    for (auto &pass : descriptor.passes) {
+        pass.name = reader.string();
+        pass.render_targets = reader.strings();
+        pass.texture_resources = reader.strings();
+
+        pass.render_target_descs.resize(reader.count(length_size * 2 + sizeof(float)));
+        for (auto &desc : pass.render_target_descs) {
+            desc.name = reader.string();
+            desc.format = reader.string();
+            desc.scale = reader.value<float>();
+        }
+
+        pass.resolution_scale = reader.value<float>();
+
+        pass.bilateral_upsamples.resize(reader.count(length_size * 2));
+        for (auto &upsample : pass.bilateral_upsamples) {
+            upsample.source = reader.string();
+            upsample.target = reader.string();
+        }
+    }
+
+    if (!reader.at_end()) {
+        throw std::runtime_error("The shader descriptor has trailing bytes.");
+    }
+    return descriptor;
+}
+
+/**
+ * @brief Drops the passes from the first one whose compiled shaders are missing.
+ *
+ * The shader then runs the passes built before, like the single pass of the shader before it was split.
+ * The last pass left draws to the screen at the full resolution.
+ * Nothing is dropped when the first pass is missing, so the load still fails on it.
+ *
+ * @param is_pass_built Tells if the vertex and the pixel shader of the pass name are compiled.
+ * @return The name of the first dropped pass, or empty if every pass is built.
+ */
+template<typename IsPassBuilt>
+std::string drop_unbuilt_passes(ShaderDescriptor &descriptor, IsPassBuilt &&is_pass_built) {
+    for (std::size_t i = 1; i < descriptor.passes.size(); ++i) {
+        if (is_pass_built(descriptor.passes[i].name)) continue;
+
+        auto missing = descriptor.passes[i].name;
+        descriptor.passes.resize(i);
+
+        auto &last = descriptor.passes.back();
+        last.render_targets.clear();
+        last.render_target_descs.clear();
+        last.resolution_scale = 1.0f;
+        return missing;
+    }
+    return {};
+}
+
+} // namespace shader_descriptor
+
+#endif
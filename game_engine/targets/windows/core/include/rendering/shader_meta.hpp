@@ -0,0 +1,188 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__SHADER_META_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__SHADER_META_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cereal/archives/json.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <nodec_rendering/serialization/resources/shader.hpp>
+
+#include "shader_descriptor.hpp"
+
+/**
+ * @brief The JSON metas of a shader, compiled into the shader descriptor.
+ */
+namespace shader_meta {
+
+struct RenderTargetDescMeta {
+    std::string name;
+    std::string format{"R32G32B32A32_FLOAT"};
+
+    //! Zero takes the resolution scale of the pass.
+    float scale{0.0f};
+
+    template<class Archive>
+    void serialize(Archive &archive) {
+        archive(cereal::make_nvp("name", name),
+                cereal::make_nvp("format", format));
+        try {
+            archive(cereal::make_nvp("scale", scale));
+        } catch (cereal::Exception &) {
+            scale = 0.0f;
+        }
+    }
+};
+
+struct BilateralUpsampleMeta {
+    std::string source;
+    std::string target;
+
+    template<class Archive>
+    void serialize(Archive &archive) {
+        archive(cereal::make_nvp("source", source),
+                cereal::make_nvp("target", target));
+    }
+};
+
+/**
+ * @brief The part of the sub-shader meta the nodec_rendering one does not know.
+ */
+struct SubShaderTargetMeta {
+    std::vector<RenderTargetDescMeta> render_target_descs;
+    float resolution_scale{1.0f};
+    std::vector<BilateralUpsampleMeta> bilateral_upsamples;
+
+    template<class Archive>
+    void serialize(Archive &archive) {
+        // They are optional. The render targets not declared are the full size R32G32B32A32_FLOAT.
+        try {
+            archive(cereal::make_nvp("render_target_descs", render_target_descs));
+        } catch (cereal::Exception &) {
+            render_target_descs.clear();
+        }
+        try {
+            archive(cereal::make_nvp("resolution_scale", resolution_scale));
+        } catch (cereal::Exception &) {
+            resolution_scale = 1.0f;
+        }
+        try {
+            archive(cereal::make_nvp("bilateral_upsamples", bilateral_upsamples));
+        } catch (cereal::Exception &) {
+            bilateral_upsamples.clear();
+        }
+    }
+};
+
+/**
+ * @brief Opens the meta of the name in the shader directory, like "shader.meta". Null if it is missing.
+ */
+using OpenMeta = std::function<std::unique_ptr<std::istream>(const std::string &name)>;
+
+/**
+ * @brief The hash of shader.meta and the metas of the passes of the descriptor, in this order.
+ *
+ * Any edit of the metas changes it, adding or removing a pass too since shader.meta lists them.
+ * Throws std::runtime_error if a meta is missing.
+ */
+inline std::uint64_t hash_shader_metas(const shader_descriptor::ShaderDescriptor &descriptor, const OpenMeta &open) {
+    auto hash = shader_descriptor::SOURCE_HASH_SEED;
+    const auto add = [&](const std::string &name) {
+        auto file = open(name);
+        if (!file) throw std::runtime_error("Failed to open the shader meta. name: " + name);
+
+        const std::string data(std::istreambuf_iterator<char>(*file), {});
+        const auto size = static_cast<std::uint64_t>(data.size());
+        hash = shader_descriptor::hash_source(hash, data.data(), data.size());
+        hash = shader_descriptor::hash_source(hash, &size, sizeof(size));
+    };
+
+    add("shader.meta");
+    for (const auto &pass : descriptor.passes) {
+        add(pass.name + ".meta");
+    }
+    return hash;
+}
+
+/**
+ * @brief Parses shader.meta and the meta of each pass. Throws on the missing or malformed one.
+ */
+inline shader_descriptor::ShaderDescriptor compile_shader_meta(const OpenMeta &open) {
+    using namespace nodec_rendering::resources;
+
+    auto open_assured = [&](const std::string &name) {
+        auto file = open(name);
+        if (!file) throw std::runtime_error("Failed to open the shader meta. name: " + name);
+        return file;
+    };
+
+    ShaderMetaInfo meta_info;
+    {
+        auto file = open_assured("shader.meta");
+        cereal::JSONInputArchive archive(*file);
+        archive(meta_info);
+    }
+
+    shader_descriptor::ShaderDescriptor descriptor;
+    descriptor.rendering_priority = meta_info.rendering_priority;
+
+    for (const auto &property : meta_info.float_properties) {
+        descriptor.float_properties.push_back({property.name, property.default_value});
+    }
+    for (const auto &property : meta_info.vector4_properties) {
+        const auto &value = property.default_value;
+        descriptor.vector4_properties.push_back({property.name, {value.x, value.y, value.z, value.w}});
+    }
+    for (const auto &entry : meta_info.texture_entries) {
+        descriptor.texture_entries.push_back(entry.name);
+    }
+
+    for (const auto &pass_name : meta_info.pass) {
+        auto file = open_assured(pass_name + ".meta");
+
+        shader_descriptor::Pass pass;
+        pass.name = pass_name;
+
+        SubShaderMetaInfo info;
+        {
+            cereal::JSONInputArchive archive(*file);
+            archive(info);
+        }
+        pass.render_targets = info.render_targets;
+        pass.texture_resources = info.texture_resources;
+
+        // The same file again, for the fields nodec_rendering does not know.
+        file->clear();
+        file->seekg(0);
+
+        SubShaderTargetMeta target_meta;
+        {
+            cereal::JSONInputArchive archive(*file);
+            archive(cereal::make_nvp("meta", target_meta));
+        }
+        for (const auto &desc : target_meta.render_target_descs) {
+            pass.render_target_descs.push_back({desc.name, desc.format, desc.scale});
+        }
+        pass.resolution_scale = target_meta.resolution_scale;
+        for (const auto &upsample : target_meta.bilateral_upsamples) {
+            pass.bilateral_upsamples.push_back({upsample.source, upsample.target});
+        }
+
+        descriptor.passes.push_back(std::move(pass));
+    }
+
+    descriptor.source_hash = hash_shader_metas(descriptor, open);
+    return descriptor;
+}
+
+} // namespace shader_meta
+
+#endif
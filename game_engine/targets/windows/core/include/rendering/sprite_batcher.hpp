@@ -0,0 +1,151 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__SPRITE_BATCHER_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__SPRITE_BATCHER_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "draw_command.hpp"
+#include "draw_queue.hpp"
+
+/**
+ * @brief Per-vertex data of the batched sprites.
+ *
+ * The layout must match the input layout of the sprite vertex shaders (see ShaderBackend::bind_sprite()).
+ * The positions and the normals are in the world space, so the batch is drawn without the model matrix.
+ */
+struct SpriteVertex {
+    DirectX::XMFLOAT3 position;
+    DirectX::XMFLOAT3 normal;
+    DirectX::XMFLOAT2 texcoord;
+    DirectX::XMFLOAT4 color;
+};
+
+/**
+ * @brief Finds the runs of the sorted draw queue which can be drawn as one sprite batch,
+ * and expands their quads into one vertex array.
+ *
+ * The quads are emitted in the queue order, so the transparent sprites keep their back-to-front order in a batch.
+ * The batcher touches no GPU object, so the batching and the vertex generation can be checked without a device.
+ */
+class SpriteBatcher {
+public:
+    /**
+     * @brief The shortest run worth a sprite batch.
+     */
+    static constexpr std::size_t MIN_SPRITE_COUNT = 2;
+
+    /**
+     * @brief Range [begin, end) of the draw queue drawn as one sprite batch.
+     */
+    struct Batch {
+        std::size_t begin;
+        std::size_t end;
+        std::uint32_t first_quad;
+
+        std::uint32_t quad_count() const noexcept {
+            return static_cast<std::uint32_t>(end - begin);
+        }
+    };
+
+    /**
+     * @brief Rebuilds the batches from the sorted queue.
+     *
+     * The adjacent image commands are merged while they share the material and the image.
+     * All the images are drawn with the alpha blending, so the blend state never splits a batch.
+     *
+     * @param can_batch Tells whether the material of the given command has the sprite shader variant.
+     */
+    template<typename CanBatch>
+    void build(const DrawQueue &queue, const DrawCommandBuffer &commands, CanBatch &&can_batch) {
+        clear();
+
+        for (std::size_t begin = 0; begin < queue.size();) {
+            const auto &first = commands[queue[begin].command];
+
+            if (first.type != DrawCommand::Type::Image || !can_batch(first)) {
+                ++begin;
+                continue;
+            }
+
+            auto end = begin + 1;
+            for (; end < queue.size(); ++end) {
+                const auto &command = commands[queue[end].command];
+                if (command.type != DrawCommand::Type::Image
+                    || command.material != first.material
+                    || command.image != first.image) {
+                    break;
+                }
+            }
+
+            if (end - begin >= MIN_SPRITE_COUNT) {
+                batches_.push_back({begin, end, static_cast<std::uint32_t>(vertices_.size() / 4)});
+                for (auto i = begin; i < end; ++i) {
+                    pack(commands[queue[i].command]);
+                }
+            }
+            begin = end;
+        }
+    }
+
+    void clear() noexcept {
+        batches_.clear();
+        vertices_.clear();
+    }
+
+    /**
+     * @brief The batches in the queue order.
+     */
+    const std::vector<Batch> &batches() const noexcept {
+        return batches_;
+    }
+
+    /**
+     * @brief Four vertices per quad, from the bottom left in the clockwise order (see QuadIndexBuffer).
+     */
+    const std::vector<SpriteVertex> &vertices() const noexcept {
+        return vertices_;
+    }
+
+private:
+    void pack(const DrawCommand &command) {
+        using namespace DirectX;
+
+        // The corners of the unit quad mesh, centered at the origin.
+        const auto &m = command.matrix_m;
+        const auto bottom_left = XMVector3Transform(XMVectorSet(-0.5f, -0.5f, 0.0f, 1.0f), m);
+        const auto top_left = XMVector3Transform(XMVectorSet(-0.5f, 0.5f, 0.0f, 1.0f), m);
+        const auto top_right = XMVector3Transform(XMVectorSet(0.5f, 0.5f, 0.0f, 1.0f), m);
+        const auto bottom_right = XMVector3Transform(XMVectorSet(0.5f, -0.5f, 0.0f, 1.0f), m);
+
+        // The quad faces -Z in the local space. The shader turns it toward the camera anyway.
+        auto normal = XMVector3Cross(XMVectorSubtract(top_left, bottom_left), XMVectorSubtract(bottom_right, bottom_left));
+        normal = XMVectorGetX(XMVector3LengthSq(normal)) > 0.0f
+                     ? XMVector3Normalize(normal)
+                     : XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f);
+
+        XMFLOAT3 normal_value;
+        XMStoreFloat3(&normal_value, normal);
+        const XMFLOAT4 color{command.color.x, command.color.y, command.color.z, command.color.w};
+
+        const auto push = [&](FXMVECTOR position, float u, float v) {
+            vertices_.emplace_back();
+            auto &vertex = vertices_.back();
+            XMStoreFloat3(&vertex.position, position);
+            vertex.normal = normal_value;
+            vertex.texcoord = {u, v};
+            vertex.color = color;
+        };
+        push(bottom_left, 0.0f, 1.0f);
+        push(top_left, 0.0f, 0.0f);
+        push(top_right, 1.0f, 0.0f);
+        push(bottom_right, 1.0f, 1.0f);
+    }
+
+private:
+    std::vector<Batch> batches_;
+    std::vector<SpriteVertex> vertices_;
+};
+
+#endif
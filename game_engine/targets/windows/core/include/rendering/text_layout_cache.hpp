@@ -0,0 +1,165 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__TEXT_LAYOUT_CACHE_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__TEXT_LAYOUT_CACHE_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <nodec/macros.hpp>
+#include <nodec_rendering/components/text_renderer.hpp>
+#include <nodec_scene/scene_registry.hpp>
+
+#include "../Font/FontCharacterDatabase.hpp"
+#include "../Font/SdfFont.hpp"
+#include "../graphics/VertexBuffer.hpp"
+#include "mesh_backend.hpp"
+#include "texture_backend.hpp"
+
+/**
+ * @brief The glyph quads of a text renderer.
+ */
+struct TextLayout {
+    struct Glyph {
+        std::uint32_t code;
+
+        // The quad in the local space of the text.
+        float x;
+        float y;
+        float width;
+        float height;
+
+        GlyphAtlas::Rect atlas_rect;
+    };
+
+    nodec_scene::SceneEntity entity{nodec::entities::null_entity};
+    std::size_t source_hash{0};
+    std::vector<Glyph> glyphs;
+
+    //! The baked SDF atlas the glyphs refer to, or nullptr if they refer to the shared glyph atlas.
+    TextureBackend *sdf_texture{nullptr};
+
+    // The atlas state the vertices were built with.
+    bool resolved{false};
+    std::size_t atlas_eviction_count{0};
+    std::unique_ptr<VertexBuffer> vertex_buffer;
+
+    std::size_t quad_count() const noexcept {
+        return glyphs.size();
+    }
+};
+
+/**
+ * @brief The glyphs of the fonts which the layouts are built from.
+ */
+class TextGlyphSource {
+public:
+    virtual ~TextGlyphSource() = default;
+
+    //! The metrics of the character, loading them on the first use.
+    virtual const FontCharacter &character(nodec_rendering::resources::Font &font, std::uint16_t pixel_size, std::uint32_t code) = 0;
+
+    //! The rectangle of the glyph in atlas(), or nullptr if it has no bitmap or does not fit.
+    virtual const GlyphAtlas::Rect *atlas_rect(nodec_rendering::resources::Font &font, std::uint16_t pixel_size, std::uint32_t code) = 0;
+
+    virtual const GlyphAtlas &atlas() const = 0;
+
+    //! The baked SDF atlas of the font, or nullptr if it has none.
+    virtual const SdfFont *sdf_font(nodec_rendering::resources::Font &font) = 0;
+
+    virtual TextureBackend *sdf_texture(nodec_rendering::resources::Font &font) = 0;
+};
+
+/**
+ * @brief The glyphs of the FontBackend fonts, rendered by FreeType into the shared atlas of the database.
+ */
+class FontBackendGlyphSource : public TextGlyphSource {
+public:
+    FontBackendGlyphSource(FontCharacterDatabase &font_character_database)
+        : font_character_database_(font_character_database) {}
+
+    const FontCharacter &character(nodec_rendering::resources::Font &font, std::uint16_t pixel_size, std::uint32_t code) override;
+
+    const GlyphAtlas::Rect *atlas_rect(nodec_rendering::resources::Font &font, std::uint16_t pixel_size, std::uint32_t code) override;
+
+    const GlyphAtlas &atlas() const override {
+        return font_character_database_.Atlas();
+    }
+
+    const SdfFont *sdf_font(nodec_rendering::resources::Font &font) override;
+
+    TextureBackend *sdf_texture(nodec_rendering::resources::Font &font) override;
+
+private:
+    FontCharacterDatabase &font_character_database_;
+};
+
+/**
+ * @brief Keeps the glyph quads of the text renderers, so that the static texts are not laid out every frame.
+ *
+ * A layout is rebuilt only when the text, the font, the pixel size or the pixels per unit change.
+ * The atlas coordinates of its glyphs are resolved again only when the atlas has evicted some glyph since then.
+ *
+ * When the font has a baked SDF atlas and the material samples the "sdf" texture, the glyphs are taken
+ * from the baked atlas instead, scaled to the pixel size. Such layouts never go back to FreeType
+ * except for the characters missing in the baked set.
+ * Each layout has its own vertex buffer, which is drawn by one call with the shared quad indices.
+ */
+class TextLayoutCache {
+public:
+    /**
+     * @param gfx The device of the vertex buffers, which are made by resolve() only.
+     */
+    TextLayoutCache(Graphics *gfx, TextGlyphSource &glyph_source)
+        : gfx_(gfx), glyph_source_(glyph_source) {}
+
+    /**
+     * @brief Adds, rebuilds and removes the layouts to match the text renderers in the registry.
+     *
+     * The layouts are referred by pointer until the next update().
+     */
+    void update(nodec_scene::SceneRegistry &scene_registry);
+
+    /**
+     * @brief Returns the layout of the entity, or nullptr if it has no text renderer.
+     */
+    TextLayout *find(nodec_scene::SceneRegistry &scene_registry, nodec_scene::SceneEntity entity);
+
+    /**
+     * @brief Makes the atlas coordinates and the vertex buffer of the layout up to date.
+     *
+     * Call it in the glyph batch of the draw, since it touches the glyphs in the atlas.
+     */
+    void resolve(TextLayout &layout, const nodec_rendering::components::TextRenderer &renderer);
+
+    std::size_t layout_count() const noexcept {
+        return entries_.size() - free_entries_.size();
+    }
+
+    /**
+     * @brief The number of the layouts rebuilt since the construction.
+     */
+    std::size_t rebuild_count() const noexcept {
+        return rebuild_count_;
+    }
+
+private:
+    std::uint32_t allocate_entry();
+
+    void rebuild(TextLayout &layout, const nodec_rendering::components::TextRenderer &renderer, std::size_t source_hash);
+
+    void build_vertices(TextLayout &layout, int atlas_width, int atlas_height);
+
+private:
+    Graphics *gfx_;
+    TextGlyphSource &glyph_source_;
+
+    std::vector<TextLayout> entries_;
+    std::vector<std::uint32_t> free_entries_;
+    std::vector<MeshBackend::Vertex> vertices_;
+    std::size_t rebuild_count_{0};
+
+private:
+    NODEC_DISABLE_COPY(TextLayoutCache)
+};
+
+#endif
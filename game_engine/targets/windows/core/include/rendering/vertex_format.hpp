@@ -0,0 +1,116 @@
+#ifndef NODEC_GAME_ENGINE__RENDERING__VERTEX_FORMAT_HPP_
+#define NODEC_GAME_ENGINE__RENDERING__VERTEX_FORMAT_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <nodec/vector2.hpp>
+#include <nodec/vector3.hpp>
+
+#include "../graphics/graphics.hpp"
+
+/**
+ * @brief The layout of the mesh vertices in the vertex buffer.
+ *
+ * All the formats feed the same POSITION, NORMAL, TEXCOORD and TANGENT inputs.
+ * The input assembler expands the normalized integers and the half floats to floats,
+ * so the vertex shaders do not know the format.
+ */
+enum class VertexFormat : std::uint8_t {
+    //! The float3 position, normal and tangent, and the float2 uv. 44 bytes.
+    Float32 = 0,
+
+    //! The float3 position, the snorm8x4 normal and tangent, and the half2 uv. 24 bytes.
+    Compact = 1
+};
+
+constexpr std::size_t VERTEX_FORMAT_COUNT = 2;
+
+struct CompactVertex {
+    nodec::Vector3f position;
+    std::int8_t normal[4];
+    std::uint16_t uv[2];
+    std::int8_t tangent[4];
+};
+
+inline UINT vertex_stride(VertexFormat format) {
+    switch (format) {
+    case VertexFormat::Compact:
+        return sizeof(CompactVertex);
+    default:
+        return sizeof(float) * 11;
+    }
+}
+
+/**
+ * @brief The input elements of the vertices at the slot 0.
+ */
+inline std::array<D3D11_INPUT_ELEMENT_DESC, 4> vertex_input_elements(VertexFormat format) {
+    const bool compact = format == VertexFormat::Compact;
+    const auto direction_format = compact ? DXGI_FORMAT_R8G8B8A8_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+    const auto uv_format = compact ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R32G32_FLOAT;
+
+    return {{{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+             {"NORMAL", 0, direction_format, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+             {"TEXCOORD", 0, uv_format, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+             {"TANGENT", 0, direction_format, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0}}};
+}
+
+inline std::int8_t pack_snorm8(float value) {
+    return static_cast<std::int8_t>(std::lround((std::max)(-1.0f, (std::min)(1.0f, value)) * 127.0f));
+}
+
+/**
+ * @brief Converts to the IEEE 754 half, rounding to the nearest even.
+ */
+inline std::uint16_t pack_half(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const std::uint32_t sign = (bits >> 16) & 0x8000u;
+    const std::uint32_t magnitude = bits & 0x7fffffffu;
+
+    // Infinity and NaN.
+    if (magnitude >= 0x7f800000u) {
+        return static_cast<std::uint16_t>(sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x0200u : 0u));
+    }
+
+    // 65520 and above round to the infinity.
+    if (magnitude >= 0x477ff000u) {
+        return static_cast<std::uint16_t>(sign | 0x7c00u);
+    }
+
+    // Below 2^-14, the half is subnormal in the units of 2^-24.
+    if (magnitude < 0x38800000u) {
+        float abs_value;
+        std::memcpy(&abs_value, &magnitude, sizeof(abs_value));
+        return static_cast<std::uint16_t>(sign | static_cast<std::uint32_t>(std::nearbyint(abs_value * 16777216.0f)));
+    }
+
+    // Rebias the exponent from 127 to 15, and round the 13 dropped bits.
+    std::uint32_t half = (magnitude - 0x38000000u) >> 13;
+    const std::uint32_t rest = magnitude & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) ++half;
+    return static_cast<std::uint16_t>(sign | half);
+}
+
+inline CompactVertex pack_compact_vertex(const nodec::Vector3f &position, const nodec::Vector3f &normal,
+                                         const nodec::Vector2f &uv, const nodec::Vector3f &tangent) {
+    CompactVertex vertex;
+    vertex.position = position;
+    vertex.normal[0] = pack_snorm8(normal.x);
+    vertex.normal[1] = pack_snorm8(normal.y);
+    vertex.normal[2] = pack_snorm8(normal.z);
+    vertex.normal[3] = 0;
+    vertex.uv[0] = pack_half(uv.x);
+    vertex.uv[1] = pack_half(uv.y);
+    vertex.tangent[0] = pack_snorm8(tangent.x);
+    vertex.tangent[1] = pack_snorm8(tangent.y);
+    vertex.tangent[2] = pack_snorm8(tangent.z);
+    vertex.tangent[3] = 0;
+    return vertex;
+}
+
+#endif
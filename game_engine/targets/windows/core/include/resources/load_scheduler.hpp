@@ -0,0 +1,259 @@
+#ifndef NODEC_GAME_ENGINE__RESOURCES__LOAD_SCHEDULER_HPP_
+#define NODEC_GAME_ENGINE__RESOURCES__LOAD_SCHEDULER_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include <nodec/macros.hpp>
+
+/**
+ * @brief The class of a load request. The workers take the requests of the higher class first.
+ */
+enum class LoadPriority : std::uint8_t {
+    //! Needed to show the current frame, like the UI.
+    Critical = 0,
+    High = 1,
+    Normal = 2,
+
+    //! Prefetches. They run only while nothing else waits.
+    Background = 3
+};
+
+constexpr std::size_t LOAD_PRIORITY_COUNT = 4;
+
+/**
+ * @brief Lets the requester give up a load request.
+ *
+ * The copies share the state. The default constructed token is never cancelled.
+ */
+class CancellationToken {
+public:
+    CancellationToken() = default;
+
+    static CancellationToken create() {
+        CancellationToken token;
+        token.cancelled_ = std::make_shared<std::atomic<bool>>(false);
+        return token;
+    }
+
+    void cancel() noexcept {
+        if (cancelled_) cancelled_->store(true, std::memory_order_relaxed);
+    }
+
+    bool is_cancelled() const noexcept {
+        return cancelled_ && cancelled_->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+/**
+ * @brief Counts the durations in the power of two buckets of microseconds.
+ *
+ * The bucket i holds [2^i, 2^(i+1)) us. The bucket 0 also holds below 1 us, and the last bucket holds all above.
+ */
+class LatencyHistogram {
+public:
+    static constexpr std::size_t BUCKET_COUNT = 24;
+
+    void record(std::uint64_t microseconds) noexcept {
+        std::size_t bucket = 0;
+        while (bucket + 1 < BUCKET_COUNT && (microseconds >> (bucket + 1)) != 0) ++bucket;
+
+        ++buckets_[bucket];
+        ++count_;
+        total_microseconds_ += microseconds;
+        if (microseconds > max_microseconds_) max_microseconds_ = microseconds;
+    }
+
+    /**
+     * @brief Returns the upper bound of the bucket the given fraction of the records falls in.
+     */
+    std::uint64_t percentile(double fraction) const noexcept {
+        if (count_ == 0) return 0;
+
+        const auto target = static_cast<std::uint64_t>(fraction * static_cast<double>(count_ - 1)) + 1;
+        std::uint64_t accumulated = 0;
+        for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+            accumulated += buckets_[i];
+            if (accumulated >= target) {
+                return i + 1 < BUCKET_COUNT ? (std::uint64_t{1} << (i + 1)) : max_microseconds_;
+            }
+        }
+        return max_microseconds_;
+    }
+
+    const std::array<std::uint64_t, BUCKET_COUNT> &buckets() const noexcept {
+        return buckets_;
+    }
+
+    std::uint64_t count() const noexcept {
+        return count_;
+    }
+
+    std::uint64_t mean_microseconds() const noexcept {
+        return count_ == 0 ? 0 : total_microseconds_ / count_;
+    }
+
+    std::uint64_t max_microseconds() const noexcept {
+        return max_microseconds_;
+    }
+
+private:
+    std::array<std::uint64_t, BUCKET_COUNT> buckets_{};
+    std::uint64_t count_{0};
+    std::uint64_t total_microseconds_{0};
+    std::uint64_t max_microseconds_{0};
+};
+
+/**
+ * @brief Counters accumulated since the construction of the scheduler.
+ */
+struct LoadSchedulerStats {
+    //! The number of the requests scheduled.
+    std::uint64_t requests{0};
+
+    //! The number of the requests joined to the in-flight request for the same resource.
+    std::uint64_t deduplicated{0};
+
+    //! The number of the loads run by the workers.
+    std::uint64_t loads{0};
+
+    //! The number of the loads skipped because all their requesters cancelled.
+    std::uint64_t cancelled{0};
+
+    //! The time from the request to the start of the load, per priority.
+    std::array<LatencyHistogram, LOAD_PRIORITY_COUNT> queue_latency;
+};
+
+/**
+ * @brief Runs the load requests on the worker threads, in the priority order.
+ *
+ * The requests for the same resource while one is queued or running share the one load.
+ * A cancelled request completes with null. The load itself is skipped if all the requests sharing it are cancelled
+ * before it starts.
+ *
+ * The scheduler only calls the given functions, so it works with any loader.
+ */
+class LoadScheduler {
+public:
+    using Completion = std::function<void(const std::shared_ptr<void> &)>;
+
+    /**
+     * @brief Runs on a worker. Calls finish once with the result, there or later on any thread.
+     *
+     * The request is in flight until finish, so a load handing its last stage to another thread is still shared.
+     * Every load must finish before the scheduler is destroyed.
+     */
+    using Load = std::function<void(const Completion &finish)>;
+
+    /**
+     * @param worker_count The number of the worker threads. 0 leaves one hardware thread to the main thread.
+     * @param on_worker_begin Called on each worker thread before the first load.
+     * @param on_worker_end Called on each worker thread after the last load.
+     */
+    explicit LoadScheduler(std::size_t worker_count = 0,
+                           std::function<void()> on_worker_begin = {},
+                           std::function<void()> on_worker_end = {});
+
+    /**
+     * @brief Stops the workers after their current loads. The requests not started yet complete with null.
+     */
+    ~LoadScheduler();
+
+    /**
+     * @brief Queues the load, or joins the in-flight load of the same key and type.
+     *
+     * The completion is called on a worker thread. It is called on the calling thread if the token is already cancelled.
+     */
+    void schedule(const std::type_info &type, const std::string &key, LoadPriority priority,
+                  const CancellationToken &token, Load load, Completion completion);
+
+    template<typename T>
+    std::future<std::shared_ptr<T>> schedule(const std::string &key, LoadPriority priority, const CancellationToken &token,
+                                             std::function<std::shared_ptr<T>()> load,
+                                             std::function<void(const std::shared_ptr<T> &)> on_completed = {}) {
+        auto promise = std::make_shared<std::promise<std::shared_ptr<T>>>();
+        auto future = promise->get_future();
+
+        schedule(
+            typeid(T), key, priority, token,
+            [load](const Completion &finish) {
+                finish(load());
+            },
+            [promise, on_completed](const std::shared_ptr<void> &result) {
+                auto resource = std::static_pointer_cast<T>(result);
+                if (on_completed) on_completed(resource);
+                promise->set_value(resource);
+            });
+
+        return future;
+    }
+
+    std::size_t worker_count() const noexcept {
+        return workers_.size();
+    }
+
+    LoadSchedulerStats stats() const;
+
+private:
+    struct Waiter {
+        CancellationToken token;
+        Completion completion;
+    };
+
+    struct Request {
+        std::string key;
+        Load load;
+        std::vector<Waiter> waiters;
+
+        //! The highest priority of the waiters.
+        LoadPriority priority;
+        std::chrono::steady_clock::time_point scheduled_at;
+        bool started{false};
+    };
+
+    void run_worker();
+
+    /**
+     * @brief Pops the next request to load, or null when stopping. Called with the lock held.
+     */
+    std::shared_ptr<Request> pop_request(std::unique_lock<std::mutex> &lock);
+
+    /**
+     * @brief Ends the request and completes its waiters.
+     */
+    void finish_request(const std::shared_ptr<Request> &request, const std::shared_ptr<void> &result);
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stopping_{false};
+
+    // A request upgraded to the higher priority is also left in the lower queue. It is skipped there once started.
+    std::array<std::deque<std::shared_ptr<Request>>, LOAD_PRIORITY_COUNT> queues_;
+    std::unordered_map<std::string, std::shared_ptr<Request>> in_flight_;
+    LoadSchedulerStats stats_;
+
+    std::function<void()> on_worker_begin_;
+    std::function<void()> on_worker_end_;
+    std::vector<std::thread> workers_;
+
+private:
+    NODEC_DISABLE_COPY(LoadScheduler)
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef NODEC_GAME_ENGINE__RESOURCES__LZ4_BLOCK_HPP_
+#define NODEC_GAME_ENGINE__RESOURCES__LZ4_BLOCK_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief The LZ4 block format, without the frame. The blocks are compatible with LZ4_decompress_safe().
+ *
+ * The compressor is the greedy single probe one, fast enough for the offline packing.
+ */
+namespace lz4_block {
+
+namespace details {
+
+constexpr std::size_t MIN_MATCH = 4;
+
+// The last 5 bytes are always literals, and the last match starts 12 bytes before the end at the latest.
+constexpr std::size_t LAST_LITERALS = 5;
+constexpr std::size_t MF_LIMIT = 12;
+constexpr std::size_t MAX_OFFSET = 0xffff;
+constexpr int HASH_BITS = 16;
+
+inline std::uint32_t read32(const std::uint8_t *p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline void write_length(std::vector<std::uint8_t> &out, std::size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<std::uint8_t>(length));
+}
+
+inline void write_sequence(std::vector<std::uint8_t> &out, const std::uint8_t *literals, std::size_t literal_length,
+                           std::size_t offset, std::size_t match_length) {
+    const auto match_code = match_length - MIN_MATCH;
+    out.push_back(static_cast<std::uint8_t>(((literal_length < 15 ? literal_length : 15) << 4)
+                                            | (match_code < 15 ? match_code : 15)));
+    if (literal_length >= 15) write_length(out, literal_length - 15);
+    out.insert(out.end(), literals, literals + literal_length);
+
+    out.push_back(static_cast<std::uint8_t>(offset & 0xff));
+    out.push_back(static_cast<std::uint8_t>(offset >> 8));
+    if (match_code >= 15) write_length(out, match_code - 15);
+}
+
+inline void write_last_literals(std::vector<std::uint8_t> &out, const std::uint8_t *literals, std::size_t literal_length) {
+    out.push_back(static_cast<std::uint8_t>((literal_length < 15 ? literal_length : 15) << 4));
+    if (literal_length >= 15) write_length(out, literal_length - 15);
+    out.insert(out.end(), literals, literals + literal_length);
+}
+
+} // namespace details
+
+inline std::vector<std::uint8_t> compress(const void *source, std::size_t size) {
+    using namespace details;
+
+    const auto *src = static_cast<const std::uint8_t *>(source);
+    std::vector<std::uint8_t> out;
+    out.reserve(size + size / 255 + 16);
+
+    std::size_t anchor = 0;
+    if (size > MF_LIMIT) {
+        constexpr auto NONE = ~std::size_t{0};
+        std::vector<std::size_t> table(std::size_t{1} << HASH_BITS, NONE);
+
+        const auto match_start_limit = size - MF_LIMIT;
+        const auto match_end_limit = size - LAST_LITERALS;
+
+        std::size_t pos = 0;
+        while (pos < match_start_limit) {
+            const auto sequence = read32(src + pos);
+            auto &slot = table[(sequence * 2654435761u) >> (32 - HASH_BITS)];
+            const auto candidate = slot;
+            slot = pos;
+
+            if (candidate == NONE || pos - candidate > MAX_OFFSET || read32(src + candidate) != sequence) {
+                ++pos;
+                continue;
+            }
+
+            auto length = MIN_MATCH;
+            while (pos + length < match_end_limit && src[candidate + length] == src[pos + length]) ++length;
+
+            write_sequence(out, src + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+        }
+    }
+
+    write_last_literals(out, src + anchor, size - anchor);
+    return out;
+}
+
+/**
+ * @brief Decompresses the block of exactly @p size bytes. Throws std::runtime_error on the malformed block.
+ */
+inline void decompress(const void *source, std::size_t source_size, void *destination, std::size_t size) {
+    const auto *src = static_cast<const std::uint8_t *>(source);
+    auto *dst = static_cast<std::uint8_t *>(destination);
+
+    std::size_t ip = 0;
+    std::size_t op = 0;
+
+    auto read_length = [&](std::size_t length) {
+        std::uint8_t byte;
+        do {
+            if (ip >= source_size) throw std::runtime_error("The LZ4 block is truncated.");
+            byte = src[ip++];
+            length += byte;
+        } while (byte == 255);
+        return length;
+    };
+
+    while (true) {
+        if (ip >= source_size) throw std::runtime_error("The LZ4 block is truncated.");
+        const auto token = src[ip++];
+
+        std::size_t literal_length = token >> 4;
+        if (literal_length == 15) literal_length = read_length(literal_length);
+        if (literal_length > source_size - ip || literal_length > size - op) {
+            throw std::runtime_error("The LZ4 literals run out of the block.");
+        }
+        if (literal_length > 0) std::memcpy(dst + op, src + ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        // The last sequence has no match.
+        if (ip == source_size) break;
+
+        if (source_size - ip < 2) throw std::runtime_error("The LZ4 block is truncated.");
+        const std::size_t offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) throw std::runtime_error("The LZ4 match refers before the block.");
+
+        std::size_t match_length = token & 15;
+        if (match_length == 15) match_length = read_length(match_length);
+        match_length += details::MIN_MATCH;
+        if (match_length > size - op) throw std::runtime_error("The LZ4 match runs out of the block.");
+
+        // The match may overlap the bytes it writes.
+        for (std::size_t i = 0; i < match_length; ++i) {
+            dst[op + i] = dst[op - offset + i];
+        }
+        op += match_length;
+    }
+
+    if (op != size) throw std::runtime_error("The LZ4 block is shorter than its size.");
+}
+
+} // namespace lz4_block
+
+#endif
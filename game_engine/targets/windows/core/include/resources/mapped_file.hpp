@@ -0,0 +1,75 @@
+#ifndef NODEC_GAME_ENGINE__RESOURCES__MAPPED_FILE_HPP_
+#define NODEC_GAME_ENGINE__RESOURCES__MAPPED_FILE_HPP_
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include <Windows.h>
+
+#include <nodec/macros.hpp>
+
+/**
+ * @brief Maps the whole file read-only. The pages are read from the file cache on the first touch.
+ *
+ * The view starts at the allocation granularity, so the data is aligned at least to 64 KiB.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path) {
+        file_ = CreateFileW(std::filesystem::u8path(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Failed to open the file. path: " + path);
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) {
+            close();
+            throw std::runtime_error("Failed to map the empty file. path: " + path);
+        }
+        size_ = static_cast<std::size_t>(size.QuadPart);
+
+        mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_) {
+            data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        }
+        if (!data_) {
+            close();
+            throw std::runtime_error("Failed to map the file. path: " + path);
+        }
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    const void *data() const noexcept {
+        return data_;
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+private:
+    void close() noexcept {
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        data_ = nullptr;
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+    }
+
+private:
+    HANDLE file_{INVALID_HANDLE_VALUE};
+    HANDLE mapping_{nullptr};
+    const void *data_{nullptr};
+    std::size_t size_{0};
+
+private:
+    NODEC_DISABLE_COPY(MappedFile)
+};
+
+#endif
@@ -0,0 +1,250 @@
+#ifndef NODEC_GAME_ENGINE__RESOURCES__RESOURCE_ARCHIVE_HPP_
+#define NODEC_GAME_ENGINE__RESOURCES__RESOURCE_ARCHIVE_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "lz4_block.hpp"
+
+/**
+ * @brief The resource directory packed into one file, read by mapping it.
+ *
+ * The file is the header, the entry data each aligned to 16 bytes, the index sorted by the name hash,
+ * then the names. The names are the paths relative to the resource directory with the forward slashes.
+ * All the values are little endian.
+ */
+namespace resource_archive {
+
+constexpr std::uint32_t MAGIC = 0x4b41504e; // "NPAK"
+constexpr std::uint32_t VERSION = 1;
+constexpr std::uint64_t ALIGNMENT = 16;
+
+enum class Compression : std::uint8_t {
+    None = 0,
+
+    //! One LZ4 block (see lz4_block).
+    Lz4 = 1
+};
+
+struct Header {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t entry_count;
+    std::uint32_t reserved;
+    std::uint64_t index_offset;
+    std::uint64_t names_offset;
+    std::uint64_t names_size;
+};
+
+struct IndexEntry {
+    std::uint64_t hash;
+    std::uint64_t offset;
+
+    //! The bytes in the archive.
+    std::uint64_t stored_size;
+
+    //! The bytes after the decompression.
+    std::uint64_t size;
+
+    //! The name in the names section, not terminated.
+    std::uint32_t name_offset;
+    std::uint32_t name_size;
+
+    std::uint8_t compression;
+    std::uint8_t reserved[7];
+};
+
+/**
+ * @brief The FNV-1a hash of the name.
+ */
+inline std::uint64_t hash_name(const char *name, std::size_t size) {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<std::uint8_t>(name[i]);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+inline std::uint64_t align(std::uint64_t offset) {
+    return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+/**
+ * @brief The sections of an archive in memory.
+ */
+struct View {
+    const std::uint8_t *data;
+    const Header *header;
+    const IndexEntry *entries;
+    const char *names;
+};
+
+/**
+ * @brief Validates the header and the index. Nothing is copied.
+ */
+inline View parse_archive(const void *data, std::size_t size) {
+    if (size < sizeof(Header)) {
+        throw std::runtime_error("The resource archive is truncated.");
+    }
+
+    const auto *bytes = static_cast<const std::uint8_t *>(data);
+    const auto *header = static_cast<const Header *>(data);
+    if (header->magic != MAGIC || header->version != VERSION) {
+        throw std::runtime_error("Not a resource archive, or the version is not supported.");
+    }
+
+    const auto index_size = static_cast<std::uint64_t>(header->entry_count) * sizeof(IndexEntry);
+    if (header->index_offset % alignof(IndexEntry) != 0
+        || header->index_offset > size || index_size > size - header->index_offset
+        || header->names_offset > size || header->names_size > size - header->names_offset) {
+        throw std::runtime_error("The resource archive sections are out of the file.");
+    }
+
+    const auto *entries = reinterpret_cast<const IndexEntry *>(bytes + header->index_offset);
+    for (std::uint32_t i = 0; i < header->entry_count; ++i) {
+        const auto &entry = entries[i];
+
+        // The stored entries are read in place, and the size of an LZ4 block expands at most 255 times.
+        // The reader allocates the size, so a forged one must not pass.
+        // The stored size is within the file, so the bound does not overflow.
+        const bool size_valid = entry.compression == static_cast<std::uint8_t>(Compression::None)
+                                    ? entry.size == entry.stored_size
+                                    : entry.size <= entry.stored_size * 255 + 16;
+
+        if (entry.offset > size || entry.stored_size > size - entry.offset
+            || entry.name_offset > header->names_size || entry.name_size > header->names_size - entry.name_offset
+            || entry.compression > static_cast<std::uint8_t>(Compression::Lz4) || !size_valid
+            || (i > 0 && entries[i - 1].hash > entry.hash)) {
+            throw std::runtime_error("The resource archive index is broken.");
+        }
+    }
+
+    return {bytes, header, entries, reinterpret_cast<const char *>(bytes + header->names_offset)};
+}
+
+/**
+ * @brief Returns the entry of the name, or null.
+ */
+inline const IndexEntry *find_entry(const View &view, const std::string &name) {
+    const auto hash = hash_name(name.data(), name.size());
+    const auto *begin = view.entries;
+    const auto *end = view.entries + view.header->entry_count;
+
+    auto *entry = std::lower_bound(begin, end, hash, [](const IndexEntry &entry, std::uint64_t hash) {
+        return entry.hash < hash;
+    });
+    for (; entry != end && entry->hash == hash; ++entry) {
+        if (entry->name_size == name.size() && std::memcmp(view.names + entry->name_offset, name.data(), name.size()) == 0) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Writes an archive, streaming the entry data as they are added.
+ *
+ * The stream must be seekable, since the header is completed by finish().
+ */
+class ArchiveWriter {
+public:
+    explicit ArchiveWriter(std::ostream &out)
+        : out_(out) {
+        const Header header{};
+        out_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        offset_ = sizeof(header);
+    }
+
+    /**
+     * @param compress If true, the data is stored compressed when it saves more than @p min_saving of the size.
+     * @return The bytes stored.
+     */
+    std::uint64_t add(const std::string &name, const void *data, std::size_t size,
+                      bool compress = false, double min_saving = 0.1) {
+        IndexEntry entry{};
+        entry.hash = hash_name(name.data(), name.size());
+        entry.size = size;
+        entry.name_offset = static_cast<std::uint32_t>(names_.size());
+        entry.name_size = static_cast<std::uint32_t>(name.size());
+        names_ += name;
+
+        const void *stored = data;
+        std::uint64_t stored_size = size;
+        std::vector<std::uint8_t> compressed;
+        if (compress && size > 0) {
+            compressed = lz4_block::compress(data, size);
+            if (static_cast<double>(compressed.size()) < static_cast<double>(size) * (1.0 - min_saving)) {
+                stored = compressed.data();
+                stored_size = compressed.size();
+                entry.compression = static_cast<std::uint8_t>(Compression::Lz4);
+            }
+        }
+
+        pad_to(align(offset_));
+        entry.offset = offset_;
+        entry.stored_size = stored_size;
+        out_.write(static_cast<const char *>(stored), static_cast<std::streamsize>(stored_size));
+        offset_ += stored_size;
+
+        entries_.push_back(entry);
+        return stored_size;
+    }
+
+    /**
+     * @brief Writes the index and the names, then the header. Throws std::runtime_error on failure.
+     */
+    void finish() {
+        std::stable_sort(entries_.begin(), entries_.end(), [](const IndexEntry &lhs, const IndexEntry &rhs) {
+            return lhs.hash < rhs.hash;
+        });
+
+        Header header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.entry_count = static_cast<std::uint32_t>(entries_.size());
+
+        pad_to(align(offset_));
+        header.index_offset = offset_;
+        out_.write(reinterpret_cast<const char *>(entries_.data()), static_cast<std::streamsize>(entries_.size() * sizeof(IndexEntry)));
+        offset_ += entries_.size() * sizeof(IndexEntry);
+
+        header.names_offset = offset_;
+        header.names_size = names_.size();
+        out_.write(names_.data(), static_cast<std::streamsize>(names_.size()));
+        offset_ += names_.size();
+
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out_.seekp(0, std::ios::end);
+
+        if (!out_) {
+            throw std::runtime_error("Failed to write the resource archive.");
+        }
+    }
+
+    std::size_t entry_count() const noexcept {
+        return entries_.size();
+    }
+
+private:
+    void pad_to(std::uint64_t offset) {
+        const char padding[ALIGNMENT]{};
+        out_.write(padding, static_cast<std::streamsize>(offset - offset_));
+        offset_ = offset;
+    }
+
+    std::ostream &out_;
+    std::uint64_t offset_{0};
+    std::vector<IndexEntry> entries_;
+    std::string names_;
+};
+
+} // namespace resource_archive
+
+#endif
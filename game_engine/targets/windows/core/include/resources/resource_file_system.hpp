@@ -0,0 +1,115 @@
+#ifndef NODEC_GAME_ENGINE__RESOURCES__RESOURCE_FILE_SYSTEM_HPP_
+#define NODEC_GAME_ENGINE__RESOURCES__RESOURCE_FILE_SYSTEM_HPP_
+
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <nodec/macros.hpp>
+
+#include "resource_archive.hpp"
+
+class MappedFile;
+
+/**
+ * @brief The whole content of a resource file, kept alive by the owner.
+ */
+class ResourceFile {
+public:
+    ResourceFile(std::shared_ptr<const void> owner, const void *data, std::size_t size)
+        : owner_(std::move(owner)), data_(data), size_(size) {}
+
+    const void *data() const noexcept {
+        return data_;
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+    /**
+     * @brief Keeps the data alive. The mapping of the archive, the loose file or the decompressed copy.
+     */
+    const std::shared_ptr<const void> &owner() const noexcept {
+        return owner_;
+    }
+
+private:
+    std::shared_ptr<const void> owner_;
+    const void *data_;
+    std::size_t size_;
+};
+
+/**
+ * @brief The seekable stream over the file, for the readers taking one. The stream keeps the file alive.
+ */
+std::unique_ptr<std::istream> open_stream(std::shared_ptr<const ResourceFile> file);
+
+/**
+ * @brief Reads the resource files from the mounted archive, or the loose files next to it.
+ *
+ * The archive is packed from the resource directory by the resource-packer tool.
+ * A loose file on the disk is read first, so the files edited or added after the packing are never shadowed
+ * by a stale archive. The paths under the mounted root with no loose file are looked up in the archive index,
+ * so a build shipping only the archive needs no file open.
+ *
+ * Thread safe, the loader threads read concurrently.
+ */
+class ResourceFileSystem {
+public:
+    ResourceFileSystem();
+    ~ResourceFileSystem();
+
+    /**
+     * @brief Mounts the archive for the paths under @p root. Replaces the mounted one.
+     *
+     * Throws std::runtime_error if the archive cannot be read.
+     */
+    void mount(const std::string &root, const std::string &archive_path);
+
+    void unmount();
+
+    /**
+     * @brief Reads the whole file, the loose one if it exists. The stored entries of the archive are not copied.
+     *
+     * @return null if the file is neither on the disk nor in the archive.
+     * Throws std::runtime_error if the archive entry is broken.
+     */
+    std::shared_ptr<const ResourceFile> read(const std::string &path) const;
+
+    /**
+     * @brief Opens the file as a seekable stream, for the readers taking one.
+     *
+     * @return null if the file is neither on the disk nor in the archive.
+     */
+    std::unique_ptr<std::istream> open(const std::string &path) const;
+
+    bool exists(const std::string &path) const;
+
+    /**
+     * @brief The number of the entries in the mounted archive. 0 if none.
+     */
+    std::size_t archive_entry_count() const;
+
+private:
+    struct Archive {
+        std::string root;
+        std::shared_ptr<MappedFile> file;
+        resource_archive::View view;
+    };
+
+    /**
+     * @brief The mounted archive and the entry of the path, or null ones.
+     */
+    std::pair<std::shared_ptr<const Archive>, const resource_archive::IndexEntry *> find(const std::string &path) const;
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<const Archive> archive_;
+
+private:
+    NODEC_DISABLE_COPY(ResourceFileSystem)
+};
+
+#endif
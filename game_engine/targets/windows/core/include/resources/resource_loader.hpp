@@ -1,7 +1,6 @@
 #ifndef NODEC_GAME_ENGINE__RESOURCES__RESOURCE_LOADER_HPP_
 #define NODEC_GAME_ENGINE__RESOURCES__RESOURCE_LOADER_HPP_
 
-#include <nodec/concurrent/thread_pool_executor.hpp>
 #include <nodec/logging/logging.hpp>
 #include <nodec/resource_management/resource_registry.hpp>
 #include <nodec_scene_serialization/scene_serialization.hpp>
@@ -9,6 +8,31 @@
 #include <Font/FontBackend.hpp>
 #include <Font/FontLibrary.hpp>
 #include <graphics/graphics.hpp>
+#include <rendering/mesh_backend.hpp>
+#include <rendering/texture_backend.hpp>
+#include <scene_audio/audio_clip_backend.hpp>
+
+#include "load_scheduler.hpp"
+#include "resource_file_system.hpp"
+#include "resource_residency.hpp"
+#include "upload_queue.hpp"
+
+/**
+ * @brief A resource decoded on a loader thread, with the device objects not created yet.
+ */
+template<typename ResourceBackend>
+struct StagedResource {
+    std::shared_ptr<ResourceBackend> resource;
+
+    //! Creates the device objects of the resource. Empty if it has none. Returns false on failure.
+    std::function<bool()> upload;
+
+    //! The size of the data the upload copies to the device.
+    std::uint64_t upload_bytes{0};
+
+    //! The memory the loaded resource keeps on the CPU and the device, for the residency accounting.
+    std::uint64_t memory_bytes{0};
+};
 
 class ResourceLoader {
     using ResourceRegistry = nodec::resource_management::ResourceRegistry;
@@ -19,6 +43,12 @@ class ResourceLoader {
     template<typename T>
     using ResourcePtr = std::shared_ptr<T>;
 
+    template<typename ResourceBackend>
+    static std::shared_ptr<ResourceBackend> upload_now(StagedResource<ResourceBackend> staged) {
+        if (staged.upload && !staged.upload()) return {};
+        return staged.resource;
+    }
+
     void HandleException(const std::string &identifier) const {
         using namespace nodec;
 
@@ -38,51 +68,181 @@ class ResourceLoader {
             << details;
     }
 
+    /**
+     * @brief Reads the resource file from the archive or the disk. Null if it is missing or broken.
+     */
+    std::shared_ptr<const ResourceFile> read_file(const std::string &path) const noexcept {
+        try {
+            return files_.read(path);
+        } catch (...) {
+            HandleException(path);
+            return nullptr;
+        }
+    }
+
+    std::unique_ptr<std::istream> open_file(const std::string &path) const noexcept {
+        try {
+            return files_.open(path);
+        } catch (...) {
+            HandleException(path);
+            return nullptr;
+        }
+    }
+
 public:
+    /**
+     * @param files The archive and the loose files the resources are read from.
+     * @param worker_count The number of the loader threads. 0 picks one from the hardware threads.
+     * @param upload_capacity_bytes The decoded data the upload queue holds before the loader threads wait.
+     */
     ResourceLoader(Graphics &gfx, ResourceRegistry &registry,
                    FontLibrary &font_library,
-                   nodec_scene_serialization::SceneSerialization &scene_serialization)
+                   nodec_scene_serialization::SceneSerialization &scene_serialization,
+                   ResourceResidency &residency, const ResourceFileSystem &files,
+                   std::size_t worker_count = 0, std::uint64_t upload_capacity_bytes = 256ull << 20)
         : logger_(nodec::logging::get_logger("engine.resources.resource-loader")),
-          gfx_{gfx}, registry_{registry}, font_library_{font_library}, scene_serialization_{scene_serialization} {
+          gfx_{gfx}, registry_{registry}, font_library_{font_library}, scene_serialization_{scene_serialization},
+          residency_{residency}, files_{files},
+          upload_queue_(upload_capacity_bytes),
+          scheduler_(
+              worker_count,
+              [=]() {
+                  // <https://github.com/microsoft/DirectXTex/issues/163>
+                  HRESULT hr = CoInitializeEx(nullptr, COINITBASE_MULTITHREADED);
+                  if (FAILED(hr)) {
+                      logger_->warn(__FILE__, __LINE__) << "CoInitializeEx failed.";
+                  }
+              },
+              []() {
+                  CoUninitialize();
+              }) {
+    }
+
+    ~ResourceLoader() {
+        // The loads waiting for the upload finish with null, and the ones decoding fail their push.
+        upload_queue_.close();
     }
 
-    // For resource registry
+    /**
+     * @brief Loads the resource with its device objects on the calling thread. For the resource registry.
+     *
+     * @param type_name The name the residency lists the resource under, like "Mesh".
+     */
     template<typename Resource, typename ResourceBackend>
-    ResourcePtr<Resource> load_direct(const std::string &path) {
-        std::shared_ptr<Resource> resource = load_backend<ResourceBackend>(path);
+    ResourcePtr<Resource> load_direct(const std::string &type_name, const std::string &path) {
+        auto staged = decode_backend<ResourceBackend>(path);
+        const auto memory_bytes = staged.memory_bytes;
+        std::shared_ptr<Resource> resource = upload_now(std::move(staged));
+        if (resource) residency_.track(type_name, path, resource, memory_bytes);
         return resource;
     }
 
+    /**
+     * @brief Queues the load on the scheduler.
+     *
+     * A loader thread decodes the resource, then its device objects are created by the next drains of upload_queue().
+     * The requests for the same path while it is loading share the one load.
+     * If the token is cancelled, the notifyer and the future receive null like a failed load.
+     *
+     * @param type_name The name the residency lists the resource under, like "Mesh".
+     */
     template<typename Resource, typename ResourceBackend>
-    ResourceFuture<Resource> load_async(const std::string &name, const std::string &path, ResourceRegistry::LoadNotifyer<Resource> notifyer) {
-        using namespace nodec;
-
-        return executor_.submit(
-            [=]() {
-                // <https://github.com/microsoft/DirectXTex/issues/163>
-                HRESULT hr = CoInitializeEx(nullptr, COINITBASE_MULTITHREADED);
-                if (FAILED(hr)) {
-                    logger_->warn(__FILE__, __LINE__) << "CoInitializeEx failed.";
+    ResourceFuture<Resource> load_async(const std::string &type_name, const std::string &name, const std::string &path, ResourceRegistry::LoadNotifyer<Resource> notifyer,
+                                        LoadPriority priority = LoadPriority::Normal, const CancellationToken &token = {}) {
+        auto promise = std::make_shared<std::promise<std::shared_ptr<Resource>>>();
+        auto future = promise->get_future();
+
+        scheduler_.schedule(
+            typeid(Resource), path, priority, token,
+            [=](const LoadScheduler::Completion &finish) {
+                auto staged = decode_backend<ResourceBackend>(path);
+                std::shared_ptr<Resource> resource = staged.resource;
+                const auto memory_bytes = staged.memory_bytes;
+                if (!resource) {
+                    finish(nullptr);
+                    return;
+                }
+                if (!staged.upload) {
+                    residency_.track(type_name, path, resource, memory_bytes);
+                    finish(resource);
+                    return;
                 }
 
-                std::shared_ptr<Resource> resource = load_backend<ResourceBackend>(path);
+                auto upload = std::move(staged.upload);
+                const bool queued = upload_queue_.push(
+                    staged.upload_bytes,
+                    [=]() {
+                        if (!upload()) {
+                            finish(nullptr);
+                            return;
+                        }
+                        residency_.track(type_name, path, resource, memory_bytes);
+                        finish(resource);
+                    },
+                    [=]() {
+                        finish(nullptr);
+                    });
+                if (!queued) finish(nullptr);
+            },
+            [=](const std::shared_ptr<void> &result) mutable {
+                auto resource = std::static_pointer_cast<Resource>(result);
                 notifyer.on_loaded(name, resource);
-
-                CoUninitialize();
-                return resource;
+                promise->set_value(resource);
             });
+
+        return future;
     }
 
+    LoadScheduler &scheduler() noexcept {
+        return scheduler_;
+    }
+
+    /**
+     * @brief The queue the render thread drains to finish the async loads.
+     */
+    UploadQueue &upload_queue() noexcept {
+        return upload_queue_;
+    }
+
+    /**
+     * @brief Loads the resource with its device objects on the calling thread.
+     */
     template<typename ResourceBackend>
     std::shared_ptr<ResourceBackend> load_backend(const std::string &path) const noexcept;
 
+    /**
+     * @brief Loads the resource without creating its device objects. The resources with none are loaded whole.
+     */
+    template<typename ResourceBackend>
+    StagedResource<ResourceBackend> decode_backend(const std::string &path) const noexcept {
+        return {load_backend<ResourceBackend>(path), {}, 0, 0};
+    }
+
 private:
     Graphics &gfx_;
     ResourceRegistry &registry_;
     FontLibrary &font_library_;
     nodec_scene_serialization::SceneSerialization &scene_serialization_;
     std::shared_ptr<nodec::logging::Logger> logger_;
-    nodec::concurrent::ThreadPoolExecutor executor_;
+    ResourceResidency &residency_;
+    const ResourceFileSystem &files_;
+
+    UploadQueue upload_queue_;
+
+    // Destroyed first, so the loads in progress finish before the members they use.
+    LoadScheduler scheduler_;
 };
 
+template<>
+StagedResource<MeshBackend> ResourceLoader::decode_backend<MeshBackend>(const std::string &path) const noexcept;
+
+template<>
+StagedResource<TextureBackend> ResourceLoader::decode_backend<TextureBackend>(const std::string &path) const noexcept;
+
+template<>
+StagedResource<FontBackend> ResourceLoader::decode_backend<FontBackend>(const std::string &path) const noexcept;
+
+template<>
+StagedResource<AudioClipBackend> ResourceLoader::decode_backend<AudioClipBackend>(const std::string &path) const noexcept;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,133 @@
+#ifndef NODEC_GAME_ENGINE__RESOURCES__RESOURCE_RESIDENCY_HPP_
+#define NODEC_GAME_ENGINE__RESOURCES__RESOURCE_RESIDENCY_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nodec/macros.hpp>
+
+/**
+ * @brief Accounts the memory of the loaded resources, and keeps the unreferenced ones cached within a budget.
+ *
+ * The tracker holds a reference to each resource, so a resource nobody else refers stays loaded and the registry
+ * hands it out again. Each update() marks the resources referenced elsewhere as used in that frame.
+ * While the total is over the budget, the unreferenced resources are released in the least recently used order.
+ * The referenced ones are never released, so the total may stay over the budget.
+ *
+ * The resources of 0 bytes, like the materials and the shaders, do not count against the budget.
+ * They are released once unreferenced for the idle frames instead, so the cached ones do not pin the textures they refer.
+ *
+ * The budget 0 releases every unreferenced resource at the next update(), like without the tracker.
+ */
+class ResourceResidency {
+public:
+    struct Entry {
+        //! The type of the resource, like "Mesh" or "Texture".
+        std::string type;
+        std::string path;
+        std::uint64_t bytes;
+
+        //! The frame the resource was last referenced outside the tracker.
+        std::uint64_t last_used_frame;
+        bool referenced;
+    };
+
+    struct TypeUsage {
+        std::string type;
+        std::size_t count;
+        std::uint64_t bytes;
+    };
+
+    //! The frames an unreferenced resource of 0 bytes stays cached by default.
+    static constexpr std::uint64_t DEFAULT_UNSIZED_IDLE_FRAMES = 300;
+
+    explicit ResourceResidency(std::uint64_t budget_bytes = 0)
+        : budget_bytes_(budget_bytes) {}
+
+    /**
+     * @brief Starts tracking the loaded resource. Tracking the same type and path again replaces the entry.
+     *
+     * Thread safe.
+     */
+    void track(const std::string &type, const std::string &path, std::shared_ptr<void> resource, std::uint64_t bytes);
+
+    /**
+     * @brief Advances the frame, refreshes the references and releases the resources over the budget.
+     *
+     * Releasing a resource may leave the ones it referred unreferenced, so they are considered again in the same update.
+     *
+     * @return The number of the resources released.
+     */
+    std::size_t update();
+
+    void set_unsized_idle_frames(std::uint64_t frames) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unsized_idle_frames_ = frames;
+    }
+
+    void set_budget(std::uint64_t budget_bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        budget_bytes_ = budget_bytes;
+    }
+
+    std::uint64_t budget() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return budget_bytes_;
+    }
+
+    std::uint64_t total_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return total_bytes_;
+    }
+
+    std::size_t count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return resources_.size();
+    }
+
+    /**
+     * @brief The number of the resources released since the construction.
+     */
+    std::uint64_t evicted_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return evicted_count_;
+    }
+
+    /**
+     * @brief The count and the bytes per type, the largest first.
+     */
+    std::vector<TypeUsage> bytes_by_type() const;
+
+    /**
+     * @brief The n largest resources, the largest first.
+     */
+    std::vector<Entry> largest(std::size_t n) const;
+
+private:
+    struct Resident {
+        Entry entry;
+        std::shared_ptr<void> resource;
+    };
+
+    /**
+     * @brief Refreshes the references and takes the resources to release. They are destroyed by the caller, out of the lock.
+     */
+    std::vector<std::shared_ptr<void>> take_unused();
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Resident> resources_;
+    std::uint64_t budget_bytes_;
+    std::uint64_t unsized_idle_frames_{DEFAULT_UNSIZED_IDLE_FRAMES};
+    std::uint64_t total_bytes_{0};
+    std::uint64_t frame_{0};
+    std::uint64_t evicted_count_{0};
+
+private:
+    NODEC_DISABLE_COPY(ResourceResidency)
+};
+
+#endif
@@ -6,10 +6,16 @@
 #include <nodec_scene_audio/resources/audio_clip.hpp>
 
 #include "../scene_audio/audio_clip_backend.hpp"
+#include "resource_file_system.hpp"
 #include "resource_loader.hpp"
 
+#include <filesystem>
+
 class ResourcesBackend : public nodec_resources::impl::ResourcesImpl {
 public:
+    //! Appended to the resource directory for the path of its archive.
+    static constexpr const char *ARCHIVE_EXTENSION = ".nodecpack";
+
     void setup_on_boot() {
         resource_path_changed_connection_ = resource_path_changed().connect(
             [](ResourcesImpl &resources, const std::string &path) {
@@ -25,79 +31,147 @@ public:
 
         resource_path_changed_connection_.disconnect();
 
-        resource_loader_.reset(new ResourceLoader(graphics, registry(), font_library, scene_serialization));
+        // The archive packed by the resource-packer tool is placed next to the resource directory.
+        // The loose files still in the directory take precedence over it.
+        {
+            const std::string archive_path = Formatter() << resource_path() << ARCHIVE_EXTENSION;
+            std::error_code error;
+            if (std::filesystem::is_regular_file(std::filesystem::u8path(archive_path), error)) {
+                try {
+                    files_.mount(resource_path(), archive_path);
+                } catch (std::exception &e) {
+                    logging::get_logger("engine.resources")->warn(__FILE__, __LINE__)
+                        << "Failed to mount the resource archive. The loose files are read.\n"
+                        << "path: " << archive_path << "\n"
+                        << "details: " << e.what();
+                }
+            }
+        }
+
+        resource_loader_.reset(new ResourceLoader(graphics, registry(), font_library, scene_serialization, residency_, files_, loader_worker_count_));
+
+        // The shaders, materials, fonts and textures are small and the others wait for them,
+        // so they go before the meshes and the scenes queued at the same time.
 
         registry().register_resource_loader<Mesh>(
             [=](auto &name) {
-                return resource_loader_->load_direct<Mesh, MeshBackend>(Formatter() << resource_path() << "/" << name);
+                return resource_loader_->load_direct<Mesh, MeshBackend>("Mesh", Formatter() << resource_path() << "/" << name);
             },
             [=](auto &name, auto notifyer) {
-                return resource_loader_->load_async<Mesh, MeshBackend>(name, Formatter() << resource_path() << "/" << name, notifyer);
+                return resource_loader_->load_async<Mesh, MeshBackend>("Mesh", name, Formatter() << resource_path() << "/" << name, notifyer);
             });
 
         registry().register_resource_loader<Shader>(
             [=](auto &name) {
-                return resource_loader_->load_direct<Shader, ShaderBackend>(Formatter() << resource_path() << "/" << name);
+                return resource_loader_->load_direct<Shader, ShaderBackend>("Shader", Formatter() << resource_path() << "/" << name);
             },
             [=](auto &name, auto notifyer) {
-                return resource_loader_->load_async<Shader, ShaderBackend>(name, Formatter() << resource_path() << "/" << name, notifyer);
+                return resource_loader_->load_async<Shader, ShaderBackend>("Shader", name, Formatter() << resource_path() << "/" << name, notifyer, LoadPriority::High);
             });
 
         registry().register_resource_loader<Texture>(
             [=](auto &name) {
-                return resource_loader_->load_direct<Texture, TextureBackend>(Formatter() << resource_path() << "/" << name);
+                return resource_loader_->load_direct<Texture, TextureBackend>("Texture", Formatter() << resource_path() << "/" << name);
             },
             [=](auto &name, auto notifyer) {
-                return resource_loader_->load_async<Texture, TextureBackend>(name, Formatter() << resource_path() << "/" << name, notifyer);
+                return resource_loader_->load_async<Texture, TextureBackend>("Texture", name, Formatter() << resource_path() << "/" << name, notifyer, LoadPriority::High);
             });
 
         registry().register_resource_loader<Material>(
             [=](auto &name) {
-                return resource_loader_->load_direct<Material, MaterialBackend>(Formatter() << resource_path() << "/" << name);
+                return resource_loader_->load_direct<Material, MaterialBackend>("Material", Formatter() << resource_path() << "/" << name);
             },
             [=](auto &name, auto notifyer) {
-                return resource_loader_->load_async<Material, MaterialBackend>(name, Formatter() << resource_path() << "/" << name, notifyer);
+                return resource_loader_->load_async<Material, MaterialBackend>("Material", name, Formatter() << resource_path() << "/" << name, notifyer, LoadPriority::High);
             });
 
         registry().register_resource_loader<SerializableEntity>(
             [=](auto &name) {
-                return resource_loader_->load_direct<SerializableEntity, SerializableEntity>(Formatter() << resource_path() << "/" << name);
+                return resource_loader_->load_direct<SerializableEntity, SerializableEntity>("SerializableEntity", Formatter() << resource_path() << "/" << name);
             },
             [=](auto &name, auto notifyer) {
-                return resource_loader_->load_async<SerializableEntity, SerializableEntity>(name, Formatter() << resource_path() << "/" << name, notifyer);
+                return resource_loader_->load_async<SerializableEntity, SerializableEntity>("SerializableEntity", name, Formatter() << resource_path() << "/" << name, notifyer);
             });
 
         registry().register_resource_loader<AudioClip>(
             [=](auto &name) {
-                return resource_loader_->load_direct<AudioClip, AudioClipBackend>(Formatter() << resource_path() << "/" << name);
+                return resource_loader_->load_direct<AudioClip, AudioClipBackend>("AudioClip", Formatter() << resource_path() << "/" << name);
             },
             [=](auto &name, auto notifyer) {
-                return resource_loader_->load_async<AudioClip, AudioClipBackend>(name, Formatter() << resource_path() << "/" << name, notifyer);
+                return resource_loader_->load_async<AudioClip, AudioClipBackend>("AudioClip", name, Formatter() << resource_path() << "/" << name, notifyer);
             });
 
         registry().register_resource_loader<Font>(
             [=](auto &name) {
-                return resource_loader_->load_direct<Font, FontBackend>(Formatter() << resource_path() << "/" << name);
+                return resource_loader_->load_direct<Font, FontBackend>("Font", Formatter() << resource_path() << "/" << name);
             },
             [=](auto &name, auto notifyer) {
-                return resource_loader_->load_async<Font, FontBackend>(name, Formatter() << resource_path() << "/" << name, notifyer);
+                return resource_loader_->load_async<Font, FontBackend>("Font", name, Formatter() << resource_path() << "/" << name, notifyer, LoadPriority::High);
             });
 
         {
             using namespace nodec_animation::resources;
             registry().register_resource_loader<AnimationClip>(
                 [=](auto &name) {
-                    return resource_loader_->load_direct<AnimationClip, AnimationClip>(Formatter() << resource_path() << "/" << name);
+                    return resource_loader_->load_direct<AnimationClip, AnimationClip>("AnimationClip", Formatter() << resource_path() << "/" << name);
                 },
                 [=](auto &name, auto notifyer) {
-                    return resource_loader_->load_async<AnimationClip, AnimationClip>(name, Formatter() << resource_path() << "/" << name, notifyer);
+                    return resource_loader_->load_async<AnimationClip, AnimationClip>("AnimationClip", name, Formatter() << resource_path() << "/" << name, notifyer);
                 });
         }
     }
 
+    /**
+     * @brief Sets the number of the loader threads. Takes effect at setup_on_runtime(). 0 picks one from the hardware threads.
+     */
+    void set_loader_worker_count(std::size_t count) noexcept {
+        loader_worker_count_ = count;
+    }
+
+    /**
+     * @brief Creates the device objects of the resources decoded since the last call, within the budget.
+     * Call once per frame on the render thread.
+     */
+    void drain_uploads() {
+        if (!resource_loader_) return;
+        resource_loader_->upload_queue().drain(upload_budget_);
+    }
+
+    void set_upload_budget(const UploadBudget &budget) noexcept {
+        upload_budget_ = budget;
+    }
+
+    /**
+     * @brief The memory of the loaded resources, and the cache of the unreferenced ones.
+     * Call update() on it once per frame.
+     */
+    ResourceResidency &residency() noexcept {
+        return residency_;
+    }
+
+    /**
+     * @brief The files the resources are read from.
+     */
+    const ResourceFileSystem &files() const noexcept {
+        return files_;
+    }
+
+    /**
+     * @brief The loader, for the requests with a priority or a cancellation token. Null until setup_on_runtime().
+     */
+    ResourceLoader *resource_loader() noexcept {
+        return resource_loader_.get();
+    }
+
 private:
     nodec::signals::Connection resource_path_changed_connection_;
+
+    // Outlive the loader, which tracks into and reads from them until its workers stop.
+    ResourceResidency residency_;
+    ResourceFileSystem files_;
     std::unique_ptr<ResourceLoader> resource_loader_;
+    std::size_t loader_worker_count_{0};
+    UploadBudget upload_budget_;
 };
 
 #endif
\ No newline at end of file
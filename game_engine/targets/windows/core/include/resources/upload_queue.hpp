@@ -0,0 +1,123 @@
+#ifndef NODEC_GAME_ENGINE__RESOURCES__UPLOAD_QUEUE_HPP_
+#define NODEC_GAME_ENGINE__RESOURCES__UPLOAD_QUEUE_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include <nodec/macros.hpp>
+
+#include "load_scheduler.hpp"
+
+/**
+ * @brief The work one drain may do.
+ *
+ * The drain stops before the upload that would go past either limit. It always runs at least one upload,
+ * so an upload larger than the budget still goes through.
+ */
+struct UploadBudget {
+    std::uint64_t microseconds{2000};
+    std::uint64_t bytes{32ull << 20};
+};
+
+/**
+ * @brief Counters accumulated since the construction of the queue.
+ */
+struct UploadQueueStats {
+    std::uint64_t uploads{0};
+    std::uint64_t bytes{0};
+    std::uint64_t drains{0};
+
+    //! The number of the drains that stopped on the budget with the uploads left.
+    std::uint64_t budget_exhausted{0};
+
+    //! The number of the uploads discarded by close().
+    std::uint64_t discarded{0};
+
+    //! The time from the push to the upload.
+    LatencyHistogram wait_latency;
+};
+
+/**
+ * @brief Hands the device object creation of the decoded resources from the loader threads to the render thread.
+ *
+ * The loader threads push; the render thread drains once per frame under a budget.
+ * The queue holds at most capacity bytes, and the pushers wait while it is full, so the decode does not run
+ * far ahead of the uploads.
+ *
+ * The thread draining must not wait for the loads pushing here, or they wait for each other.
+ */
+class UploadQueue {
+public:
+    //! Creates the device objects. Runs on the draining thread.
+    using Upload = std::function<void()>;
+
+    //! Releases the upload not run. Runs on the thread calling close().
+    using Discard = std::function<void()>;
+
+    explicit UploadQueue(std::uint64_t capacity_bytes = 256ull << 20)
+        : capacity_bytes_(capacity_bytes) {}
+
+    ~UploadQueue() {
+        close();
+    }
+
+    /**
+     * @brief Queues the upload, waiting while the queue is full. An empty queue takes any size.
+     *
+     * @return False if the queue is closed. Neither function is called then.
+     */
+    bool push(std::uint64_t bytes, Upload upload, Discard discard);
+
+    /**
+     * @brief Runs the queued uploads in the order they were pushed, within the budget.
+     *
+     * @return The number of the uploads run.
+     */
+    std::size_t drain(const UploadBudget &budget);
+
+    /**
+     * @brief Discards the queued uploads and refuses the later pushes.
+     */
+    void close();
+
+    std::size_t pending_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    std::uint64_t pending_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pending_bytes_;
+    }
+
+    UploadQueueStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    struct Entry {
+        std::uint64_t bytes;
+        Upload upload;
+        Discard discard;
+        std::chrono::steady_clock::time_point pushed_at;
+    };
+
+    const std::uint64_t capacity_bytes_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::deque<Entry> entries_;
+    std::uint64_t pending_bytes_{0};
+    bool closed_{false};
+    UploadQueueStats stats_;
+
+private:
+    NODEC_DISABLE_COPY(UploadQueue)
+};
+
+#endif
@@ -7,22 +7,19 @@
 #include <nodec/formatter.hpp>
 #include <nodec/riff.hpp>
 
-#include <fstream>
+#include <istream>
 
 class AudioClipBackend : public nodec_scene_audio::resources::AudioClip {
 public:
-    AudioClipBackend(const std::string &path) {
+    /**
+     * @param audio_file The seekable stream of the WAVE file.
+     * @param path For the error messages.
+     */
+    AudioClipBackend(std::istream &audio_file, const std::string &path) {
         using namespace nodec::riff;
         using namespace nodec::audio::wave_format;
         using namespace nodec;
 
-        std::ifstream audio_file;
-        audio_file.open(path, std::ios::binary);
-        if (!audio_file) {
-            throw std::runtime_error(ErrorFormatter<std::runtime_error>(__FILE__, __LINE__)
-                                     << "Open file failed. path: " << path);
-        }
-
         RIFFChunk riff_chunk;
         bool found;
         RIFFChunk chunk;
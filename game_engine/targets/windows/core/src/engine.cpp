@@ -44,6 +44,7 @@ Engine::Engine(nodec_application::impl::ApplicationImpl &app)
     physics_system_.reset(new PhysicsSystemBackend(*world_));
 
     visibility_system_.reset(new nodec_rendering::systems::VisibilitySystem(world_->scene()));
+    scene_spatial_index_.reset(new SceneSpatialIndex());
     prefab_load_system_.reset(new nodec_scene_serialization::systems::PrefabLoadSystem(world_->scene(), *entity_loader_));
 
     animation_component_registry_.reset(new nodec_animation::ComponentRegistry());
@@ -87,7 +88,8 @@ void Engine::setup() {
 
     resources_->setup_on_runtime(window_->graphics(), *font_library_, *scene_serialization_);
 
-    scene_renderer_.reset(new SceneRenderer(world_->scene(), window_->graphics(), resources_->registry()));
+    scene_renderer_.reset(new SceneRenderer(world_->scene(), window_->graphics(), resources_->registry(),
+                                            scene_spatial_index_.get()));
 
     audio_platform_.reset(new AudioPlatform());
 
@@ -103,9 +105,18 @@ void Engine::on_stepped(nodec_world::World &world) {
 
 void Engine::frame_begin() {
     window_->graphics().begin_frame();
+    scene_renderer_->reset_stats();
+
+    // The resources finishing here are seen by the whole frame.
+    resources_->drain_uploads();
+    resources_->residency().update();
+
+    // The snapshot of the last frame refers the components the step may destroy.
+    scene_renderer_->invalidate_snapshot();
+    scene_updated_ = false;
 }
 
-void Engine::frame_end() {
+void Engine::update_scene() {
     using namespace nodec::entities;
     using namespace nodec_scene::components;
 
@@ -122,6 +133,18 @@ void Engine::frame_end() {
         }
     }
 
+    scene_spatial_index_->update(world_->scene().registry());
+
+    // The views of the frame share one snapshot taken after the updates.
+    scene_renderer_->capture_snapshot(world_->scene());
+    scene_updated_ = true;
+}
+
+void Engine::frame_end() {
+    if (!scene_updated_) {
+        update_scene();
+    }
+
     scene_renderer_->render(world_->scene(),
                             window_->graphics().render_target_view(),
                             *scene_rendering_context_);
@@ -188,3 +188,7 @@ void Graphics::DrawIndexed(UINT count) {
     //        << logs;
     //}
 }
+
+void Graphics::DrawIndexedInstanced(UINT count, UINT instance_count, UINT start_instance) {
+    context_->DrawIndexedInstanced(count, instance_count, 0u, 0, start_instance);
+}
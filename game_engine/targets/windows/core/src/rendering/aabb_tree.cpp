@@ -0,0 +1,311 @@
+#include <rendering/aabb_tree.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// The fat box margin is relative to the box size with a floor for the tiny objects.
+constexpr float FAT_MARGIN_RATIO = 0.1f;
+constexpr float MIN_FAT_MARGIN = 0.05f;
+
+} // namespace
+
+AabbTree::Box AabbTree::merge(const Box &a, const Box &b) noexcept {
+    return {{(std::min)(a.min.x, b.min.x), (std::min)(a.min.y, b.min.y), (std::min)(a.min.z, b.min.z)},
+            {(std::max)(a.max.x, b.max.x), (std::max)(a.max.y, b.max.y), (std::max)(a.max.z, b.max.z)}};
+}
+
+float AabbTree::surface_area(const Box &box) noexcept {
+    const float dx = box.max.x - box.min.x;
+    const float dy = box.max.y - box.min.y;
+    const float dz = box.max.z - box.min.z;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+AabbTree::Box AabbTree::fatten(const Box &box) noexcept {
+    const auto margin = [](float min, float max) {
+        return (std::max)(MIN_FAT_MARGIN, (max - min) * FAT_MARGIN_RATIO);
+    };
+    const float mx = margin(box.min.x, box.max.x);
+    const float my = margin(box.min.y, box.max.y);
+    const float mz = margin(box.min.z, box.max.z);
+    return {{box.min.x - mx, box.min.y - my, box.min.z - mz},
+            {box.max.x + mx, box.max.y + my, box.max.z + mz}};
+}
+
+AabbTree::Classification AabbTree::classify(const CullingPlanes &planes, const Box &box) noexcept {
+    const float cx = (box.min.x + box.max.x) * 0.5f;
+    const float cy = (box.min.y + box.max.y) * 0.5f;
+    const float cz = (box.min.z + box.max.z) * 0.5f;
+    const float ex = (box.max.x - box.min.x) * 0.5f;
+    const float ey = (box.max.y - box.min.y) * 0.5f;
+    const float ez = (box.max.z - box.min.z) * 0.5f;
+
+    auto result = Classification::Inside;
+    for (int p = 0; p < CullingPlanes::PLANE_COUNT; ++p) {
+        const float s = planes.nx[p] * cx + planes.ny[p] * cy + planes.nz[p] * cz + planes.d[p];
+        const float r = std::abs(planes.nx[p]) * ex + std::abs(planes.ny[p]) * ey + std::abs(planes.nz[p]) * ez;
+        if (s < -r) return Classification::Outside;
+        if (s < r) result = Classification::Intersecting;
+    }
+    return result;
+}
+
+bool AabbTree::intersect_ray(const Box &box, const DirectX::XMFLOAT3 &origin, const DirectX::XMFLOAT3 &direction,
+                             float max_distance, float &distance) noexcept {
+    // Slab test.
+    float t_min = 0.0f;
+    float t_max = max_distance;
+
+    const float origins[3] = {origin.x, origin.y, origin.z};
+    const float directions[3] = {direction.x, direction.y, direction.z};
+    const float mins[3] = {box.min.x, box.min.y, box.min.z};
+    const float maxs[3] = {box.max.x, box.max.y, box.max.z};
+
+    for (int axis = 0; axis < 3; ++axis) {
+        if (std::abs(directions[axis]) < std::numeric_limits<float>::epsilon()) {
+            if (origins[axis] < mins[axis] || maxs[axis] < origins[axis]) return false;
+            continue;
+        }
+        const float inv = 1.0f / directions[axis];
+        float t1 = (mins[axis] - origins[axis]) * inv;
+        float t2 = (maxs[axis] - origins[axis]) * inv;
+        if (t1 > t2) std::swap(t1, t2);
+        t_min = (std::max)(t_min, t1);
+        t_max = (std::min)(t_max, t2);
+        if (t_min > t_max) return false;
+    }
+    distance = t_min;
+    return true;
+}
+
+int AabbTree::allocate_node() {
+    if (free_list_ == NULL_NODE) {
+        nodes_.push_back({});
+        free_list_ = static_cast<int>(nodes_.size() - 1);
+        nodes_[free_list_].parent = NULL_NODE;
+        nodes_[free_list_].height = -1;
+    }
+
+    const auto node_id = free_list_;
+    auto &node = nodes_[node_id];
+    free_list_ = node.parent;
+    node.parent = NULL_NODE;
+    node.child1 = NULL_NODE;
+    node.child2 = NULL_NODE;
+    node.height = 0;
+    node.user_data = 0;
+    return node_id;
+}
+
+void AabbTree::free_node(int node_id) {
+    // The free list is linked through the parent field.
+    nodes_[node_id].parent = free_list_;
+    nodes_[node_id].height = -1;
+    free_list_ = node_id;
+}
+
+int AabbTree::create_proxy(const Box &box, std::uint32_t user_data) {
+    const auto proxy_id = allocate_node();
+    nodes_[proxy_id].box = fatten(box);
+    nodes_[proxy_id].user_data = user_data;
+    insert_leaf(proxy_id);
+    ++proxy_count_;
+    return proxy_id;
+}
+
+void AabbTree::destroy_proxy(int proxy_id) {
+    assert(0 <= proxy_id && proxy_id < static_cast<int>(nodes_.size()));
+    assert(nodes_[proxy_id].is_leaf());
+
+    remove_leaf(proxy_id);
+    free_node(proxy_id);
+    --proxy_count_;
+}
+
+bool AabbTree::move_proxy(int proxy_id, const Box &box) {
+    assert(nodes_[proxy_id].is_leaf());
+
+    if (nodes_[proxy_id].box.contains(box)) return false;
+
+    // The ancestors are refitted while the leaf is removed and reinserted.
+    remove_leaf(proxy_id);
+    nodes_[proxy_id].box = fatten(box);
+    insert_leaf(proxy_id);
+    return true;
+}
+
+void AabbTree::insert_leaf(int leaf) {
+    if (root_ == NULL_NODE) {
+        root_ = leaf;
+        nodes_[root_].parent = NULL_NODE;
+        return;
+    }
+
+    // Find the best sibling by the surface area heuristic.
+    const auto leaf_box = nodes_[leaf].box;
+    int index = root_;
+    while (!nodes_[index].is_leaf()) {
+        const auto &node = nodes_[index];
+        const int child1 = node.child1;
+        const int child2 = node.child2;
+
+        const float area = surface_area(node.box);
+        const float combined_area = surface_area(merge(node.box, leaf_box));
+
+        // Cost of creating a new parent for this node and the new leaf.
+        const float cost = 2.0f * combined_area;
+
+        // Minimum cost of pushing the leaf further down the tree.
+        const float inheritance_cost = 2.0f * (combined_area - area);
+
+        const auto child_cost = [&](int child) {
+            const auto &child_node = nodes_[child];
+            const float new_area = surface_area(merge(leaf_box, child_node.box));
+            if (child_node.is_leaf()) return new_area + inheritance_cost;
+            return new_area - surface_area(child_node.box) + inheritance_cost;
+        };
+        const float cost1 = child_cost(child1);
+        const float cost2 = child_cost(child2);
+
+        if (cost < cost1 && cost < cost2) break;
+
+        index = cost1 < cost2 ? child1 : child2;
+    }
+
+    const int sibling = index;
+
+    // Create a new parent.
+    const int old_parent = nodes_[sibling].parent;
+    const int new_parent = allocate_node();
+    nodes_[new_parent].parent = old_parent;
+    nodes_[new_parent].box = merge(leaf_box, nodes_[sibling].box);
+    nodes_[new_parent].height = nodes_[sibling].height + 1;
+    nodes_[new_parent].child1 = sibling;
+    nodes_[new_parent].child2 = leaf;
+    nodes_[sibling].parent = new_parent;
+    nodes_[leaf].parent = new_parent;
+
+    if (old_parent != NULL_NODE) {
+        if (nodes_[old_parent].child1 == sibling) {
+            nodes_[old_parent].child1 = new_parent;
+        } else {
+            nodes_[old_parent].child2 = new_parent;
+        }
+    } else {
+        root_ = new_parent;
+    }
+
+    // Walk back up the tree fixing heights and boxes.
+    index = nodes_[leaf].parent;
+    while (index != NULL_NODE) {
+        index = balance(index);
+
+        const int child1 = nodes_[index].child1;
+        const int child2 = nodes_[index].child2;
+        nodes_[index].height = 1 + (std::max)(nodes_[child1].height, nodes_[child2].height);
+        nodes_[index].box = merge(nodes_[child1].box, nodes_[child2].box);
+
+        index = nodes_[index].parent;
+    }
+}
+
+void AabbTree::remove_leaf(int leaf) {
+    if (leaf == root_) {
+        root_ = NULL_NODE;
+        return;
+    }
+
+    const int parent = nodes_[leaf].parent;
+    const int grand_parent = nodes_[parent].parent;
+    const int sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+
+    if (grand_parent == NULL_NODE) {
+        root_ = sibling;
+        nodes_[sibling].parent = NULL_NODE;
+        free_node(parent);
+        return;
+    }
+
+    // Destroy the parent and connect the sibling to the grand parent.
+    if (nodes_[grand_parent].child1 == parent) {
+        nodes_[grand_parent].child1 = sibling;
+    } else {
+        nodes_[grand_parent].child2 = sibling;
+    }
+    nodes_[sibling].parent = grand_parent;
+    free_node(parent);
+
+    // Adjust the ancestor bounds.
+    int index = grand_parent;
+    while (index != NULL_NODE) {
+        index = balance(index);
+
+        const int child1 = nodes_[index].child1;
+        const int child2 = nodes_[index].child2;
+        nodes_[index].box = merge(nodes_[child1].box, nodes_[child2].box);
+        nodes_[index].height = 1 + (std::max)(nodes_[child1].height, nodes_[child2].height);
+
+        index = nodes_[index].parent;
+    }
+}
+
+int AabbTree::balance(int a_id) {
+    // Perform a left or right rotation if the node A is imbalanced.
+    // Returns the new root index of the subtree.
+    auto &a = nodes_[a_id];
+    if (a.is_leaf() || a.height < 2) return a_id;
+
+    const int b_id = a.child1;
+    const int c_id = a.child2;
+    const int balance_factor = nodes_[c_id].height - nodes_[b_id].height;
+
+    // Rotate the child (c or b) up.
+    const auto rotate = [&](int up_id, int other_id, bool up_is_child2) {
+        auto &up = nodes_[up_id];
+        const int f_id = up.child1;
+        const int g_id = up.child2;
+
+        // Swap A and the child.
+        up.child1 = a_id;
+        up.parent = a.parent;
+        a.parent = up_id;
+
+        if (up.parent != NULL_NODE) {
+            if (nodes_[up.parent].child1 == a_id) {
+                nodes_[up.parent].child1 = up_id;
+            } else {
+                nodes_[up.parent].child2 = up_id;
+            }
+        } else {
+            root_ = up_id;
+        }
+
+        // Rotate the taller grand child up with the child, and hand the other one to A.
+        const bool f_taller = nodes_[f_id].height > nodes_[g_id].height;
+        const int keep_id = f_taller ? f_id : g_id;
+        const int give_id = f_taller ? g_id : f_id;
+
+        up.child2 = keep_id;
+        if (up_is_child2) {
+            a.child2 = give_id;
+        } else {
+            a.child1 = give_id;
+        }
+        nodes_[give_id].parent = a_id;
+
+        a.box = merge(nodes_[other_id].box, nodes_[give_id].box);
+        up.box = merge(a.box, nodes_[keep_id].box);
+
+        a.height = 1 + (std::max)(nodes_[other_id].height, nodes_[give_id].height);
+        up.height = 1 + (std::max)(a.height, nodes_[keep_id].height);
+        return up_id;
+    };
+
+    if (balance_factor > 1) return rotate(c_id, b_id, true);
+    if (balance_factor < -1) return rotate(b_id, c_id, false);
+    return a_id;
+}
@@ -0,0 +1,213 @@
+#include <rendering/frustum_culling.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    include <emmintrin.h>
+#    define NODEC_GAME_ENGINE_CULLING_SSE2
+#endif
+
+namespace {
+
+#ifndef NODEC_GAME_ENGINE_CULLING_SSE2
+// Returns the 4-bit masks of the boxes [index, index + 4).
+// Bit j of *visible is set if the box (index + j) is not outside of any plane.
+// Bit j of *inside is set if the box (index + j) is entirely inside of all planes.
+void cull_four_scalar(const CullingPlanes &planes, const WorldBoundsArray &bounds, std::size_t index,
+                      unsigned &visible, unsigned &inside) {
+    visible = 0;
+    inside = 0;
+    for (int j = 0; j < 4; ++j) {
+        const auto i = index + j;
+        bool is_outside = false;
+        bool is_inside = true;
+        for (int p = 0; p < CullingPlanes::PLANE_COUNT; ++p) {
+            const float s = planes.nx[p] * bounds.center_x()[i]
+                            + planes.ny[p] * bounds.center_y()[i]
+                            + planes.nz[p] * bounds.center_z()[i]
+                            + planes.d[p];
+            const float r = std::abs(planes.nx[p]) * bounds.extents_x()[i]
+                            + std::abs(planes.ny[p]) * bounds.extents_y()[i]
+                            + std::abs(planes.nz[p]) * bounds.extents_z()[i];
+            if (s < -r) {
+                is_outside = true;
+                break;
+            }
+            if (s < r) is_inside = false;
+        }
+        if (!is_outside) visible |= 1u << j;
+        if (!is_outside && is_inside) inside |= 1u << j;
+    }
+}
+#endif
+
+#ifdef NODEC_GAME_ENGINE_CULLING_SSE2
+// Same as cull_four_scalar() with four boxes per lane.
+void cull_four_sse2(const CullingPlanes &planes, const WorldBoundsArray &bounds, std::size_t index,
+                    unsigned &visible, unsigned &inside) {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+    const __m128 cx = _mm_loadu_ps(bounds.center_x() + index);
+    const __m128 cy = _mm_loadu_ps(bounds.center_y() + index);
+    const __m128 cz = _mm_loadu_ps(bounds.center_z() + index);
+    const __m128 ex = _mm_loadu_ps(bounds.extents_x() + index);
+    const __m128 ey = _mm_loadu_ps(bounds.extents_y() + index);
+    const __m128 ez = _mm_loadu_ps(bounds.extents_z() + index);
+
+    __m128 outside = _mm_setzero_ps();
+    __m128 partial = _mm_setzero_ps();
+
+    for (int p = 0; p < CullingPlanes::PLANE_COUNT; ++p) {
+        const __m128 nx = _mm_set1_ps(planes.nx[p]);
+        const __m128 ny = _mm_set1_ps(planes.ny[p]);
+        const __m128 nz = _mm_set1_ps(planes.nz[p]);
+
+        const __m128 s = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+            _mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(planes.d[p])));
+        const __m128 r = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign_mask, nx), ex), _mm_mul_ps(_mm_andnot_ps(sign_mask, ny), ey)),
+            _mm_mul_ps(_mm_andnot_ps(sign_mask, nz), ez));
+
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(s, _mm_xor_ps(r, sign_mask)));
+        partial = _mm_or_ps(partial, _mm_cmplt_ps(s, r));
+    }
+
+    const unsigned outside_bits = static_cast<unsigned>(_mm_movemask_ps(outside));
+    const unsigned partial_bits = static_cast<unsigned>(_mm_movemask_ps(partial));
+    visible = ~outside_bits & 0xFu;
+    inside = ~partial_bits & 0xFu;
+}
+#endif
+
+} // namespace
+
+CullingPlanes CullingPlanes::from_view_projection(const DirectX::XMMATRIX &matrix_vp) {
+    using namespace DirectX;
+
+    // Gribb & Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix".
+    // For the row-vector convention the planes are built from the columns of the matrix.
+    XMFLOAT4X4 m;
+    XMStoreFloat4x4(&m, matrix_vp);
+
+    const auto column = [&](int j) {
+        return XMFLOAT4(m.m[0][j], m.m[1][j], m.m[2][j], m.m[3][j]);
+    };
+    const auto c0 = column(0);
+    const auto c1 = column(1);
+    const auto c2 = column(2);
+    const auto c3 = column(3);
+
+    const XMFLOAT4 source[PLANE_COUNT] = {
+        {c3.x + c0.x, c3.y + c0.y, c3.z + c0.z, c3.w + c0.w}, // left
+        {c3.x - c0.x, c3.y - c0.y, c3.z - c0.z, c3.w - c0.w}, // right
+        {c3.x + c1.x, c3.y + c1.y, c3.z + c1.z, c3.w + c1.w}, // bottom
+        {c3.x - c1.x, c3.y - c1.y, c3.z - c1.z, c3.w - c1.w}, // top
+        {c2.x, c2.y, c2.z, c2.w},                             // near (z >= 0)
+        {c3.x - c2.x, c3.y - c2.y, c3.z - c2.z, c3.w - c2.w}, // far
+    };
+
+    CullingPlanes planes;
+    for (int i = 0; i < PLANE_COUNT; ++i) {
+        planes.nx[i] = source[i].x;
+        planes.ny[i] = source[i].y;
+        planes.nz[i] = source[i].z;
+        planes.d[i] = source[i].w;
+    }
+    return planes;
+}
+
+void WorldBoundsArray::set(std::size_t index, const nodec::gfx::BoundingBox &local_bounds, const DirectX::XMMATRIX &matrix_m) {
+    using namespace DirectX;
+
+    const auto center = XMVector3Transform(
+        XMVectorSet(local_bounds.center.x, local_bounds.center.y, local_bounds.center.z, 1.0f), matrix_m);
+
+    // The extents of the transformed box are the absolute rows weighted by the local extents.
+    const auto extents = XMVectorAdd(
+        XMVectorAdd(XMVectorScale(XMVectorAbs(matrix_m.r[0]), local_bounds.extents.x),
+                    XMVectorScale(XMVectorAbs(matrix_m.r[1]), local_bounds.extents.y)),
+        XMVectorScale(XMVectorAbs(matrix_m.r[2]), local_bounds.extents.z));
+
+    center_x_[index] = XMVectorGetX(center);
+    center_y_[index] = XMVectorGetY(center);
+    center_z_[index] = XMVectorGetZ(center);
+    extents_x_[index] = XMVectorGetX(extents);
+    extents_y_[index] = XMVectorGetY(extents);
+    extents_z_[index] = XMVectorGetZ(extents);
+}
+
+void WorldBoundsArray::copy(std::size_t index, const WorldBoundsArray &other, std::size_t other_index) {
+    center_x_[index] = other.center_x_[other_index];
+    center_y_[index] = other.center_y_[other_index];
+    center_z_[index] = other.center_z_[other_index];
+    extents_x_[index] = other.extents_x_[other_index];
+    extents_y_[index] = other.extents_y_[other_index];
+    extents_z_[index] = other.extents_z_[other_index];
+}
+
+void WorldBoundsArray::merge(std::size_t index, const WorldBoundsArray &other, std::size_t other_index) {
+    const auto merge_axis = [&](std::vector<float> &center, std::vector<float> &extents,
+                                const std::vector<float> &other_center, const std::vector<float> &other_extents) {
+        const float min = (std::min)(center[index] - extents[index], other_center[other_index] - other_extents[other_index]);
+        const float max = (std::max)(center[index] + extents[index], other_center[other_index] + other_extents[other_index]);
+        center[index] = (min + max) * 0.5f;
+        extents[index] = (max - min) * 0.5f;
+    };
+    merge_axis(center_x_, extents_x_, other.center_x_, other.extents_x_);
+    merge_axis(center_y_, extents_y_, other.center_y_, other.extents_y_);
+    merge_axis(center_z_, extents_z_, other.center_z_, other.extents_z_);
+}
+
+bool test_world_bounds(const CullingPlanes &planes, const WorldBoundsArray &bounds, std::size_t index) {
+    for (int p = 0; p < CullingPlanes::PLANE_COUNT; ++p) {
+        const float s = planes.nx[p] * bounds.center_x()[index]
+                        + planes.ny[p] * bounds.center_y()[index]
+                        + planes.nz[p] * bounds.center_z()[index]
+                        + planes.d[p];
+        const float r = std::abs(planes.nx[p]) * bounds.extents_x()[index]
+                        + std::abs(planes.ny[p]) * bounds.extents_y()[index]
+                        + std::abs(planes.nz[p]) * bounds.extents_z()[index];
+        if (s < -r) return false;
+    }
+    return true;
+}
+
+void cull_world_bounds(const CullingPlanes &planes, const WorldBoundsArray &bounds,
+                       std::size_t begin, std::size_t end,
+                       std::uint64_t *visible_bits, std::uint64_t *inside_bits) {
+    assert(begin % 64 == 0);
+    assert(end <= bounds.size());
+
+    if (begin >= end) return;
+
+    std::fill(visible_bits + begin / 64, visible_bits + visibility_word_count(end), 0);
+    if (inside_bits) {
+        std::fill(inside_bits + begin / 64, inside_bits + visibility_word_count(end), 0);
+    }
+
+    // The padding of the arrays allows to read four boxes past the end.
+    // The bits of the padding boxes are masked out below.
+    for (std::size_t index = begin; index < end; index += 4) {
+        unsigned visible;
+        unsigned inside;
+#ifdef NODEC_GAME_ENGINE_CULLING_SSE2
+        cull_four_sse2(planes, bounds, index, visible, inside);
+#else
+        cull_four_scalar(planes, bounds, index, visible, inside);
+#endif
+        if (end - index < 4) {
+            const unsigned valid = (1u << (end - index)) - 1u;
+            visible &= valid;
+            inside &= valid;
+        }
+
+        const auto shift = index % 64;
+        visible_bits[index / 64] |= static_cast<std::uint64_t>(visible) << shift;
+        if (inside_bits) {
+            inside_bits[index / 64] |= static_cast<std::uint64_t>(inside) << shift;
+        }
+    }
+}
@@ -0,0 +1,176 @@
+#include <rendering/light_cluster_grid.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <rendering/parallel_chunks.hpp>
+
+namespace {
+
+std::uint8_t to_cluster(float value, std::uint32_t count) {
+    const auto index = static_cast<int>(std::floor(value * count));
+    return static_cast<std::uint8_t>((std::min)((std::max)(index, 0), static_cast<int>(count) - 1));
+}
+
+bool is_sphere_visible(const CullingPlanes &planes, const DirectX::XMFLOAT3 &center, float radius) {
+    for (int p = 0; p < CullingPlanes::PLANE_COUNT; ++p) {
+        // The planes are not normalized, so scale the radius by the normal length instead.
+        const float s = planes.nx[p] * center.x + planes.ny[p] * center.y + planes.nz[p] * center.z + planes.d[p];
+        const float length = std::sqrt(planes.nx[p] * planes.nx[p] + planes.ny[p] * planes.ny[p] + planes.nz[p] * planes.nz[p]);
+        if (s < -radius * length) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+LightClusterGrid::LightClusterGrid()
+    : cluster_ranges_(CLUSTER_COUNT) {
+}
+
+void LightClusterGrid::build(const std::vector<PointLight> &lights, const CullingPlanes &planes,
+                             const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
+                             float near_clip, float far_clip,
+                             nodec::concurrent::ThreadPoolExecutor &executor) {
+    using namespace DirectX;
+
+    // The lights are cheap to bound, so a chunk must have many of them.
+    constexpr std::size_t MIN_LIGHT_CHUNK_SIZE = 256;
+
+    near_clip = (std::max)(near_clip, 1e-4f);
+    far_clip = (std::max)(far_clip, near_clip * 1.001f);
+
+    const float log_depth_ratio = std::log(far_clip / near_clip);
+    z_slice_scale_ = static_cast<float>(CLUSTER_COUNT_Z) / log_depth_ratio;
+    z_slice_bias_ = -z_slice_scale_ * std::log(near_clip);
+
+    const auto z_slice = [&](float depth) {
+        return to_cluster((std::log(depth) - std::log(near_clip)) / log_depth_ratio, CLUSTER_COUNT_Z);
+    };
+
+    // --- Cull the lights and find the clusters each light touches. ---
+    const ChunkPartition light_partition(lights.size(), MIN_LIGHT_CHUNK_SIZE);
+    if (chunks_.size() < light_partition.chunk_count()) {
+        chunks_.resize(light_partition.chunk_count());
+    }
+
+    run_chunks(executor, light_partition, [&](std::size_t chunk_index, std::size_t begin, std::size_t end) {
+        auto &visible_lights = chunks_[chunk_index].visible_lights;
+        visible_lights.clear();
+
+        for (auto i = begin; i < end; ++i) {
+            const auto &light = lights[i];
+            if (light.range <= 0.0f) continue;
+            if (!is_sphere_visible(planes, light.position, light.range)) continue;
+
+            XMFLOAT3 center;
+            XMStoreFloat3(&center, XMVector3TransformCoord(XMLoadFloat3(&light.position), matrix_v));
+
+            const float min_depth = (std::max)(center.z - light.range, near_clip);
+            const float max_depth = (std::min)(center.z + light.range, far_clip);
+            if (min_depth > max_depth) continue;
+
+            // Project the corners of the view-space box around the sphere.
+            // The projected x and y are monotonic in each coordinate, so the corners bound the whole box.
+            float min_ndc_x = 1.0f;
+            float max_ndc_x = -1.0f;
+            float min_ndc_y = 1.0f;
+            float max_ndc_y = -1.0f;
+            for (int corner = 0; corner < 8; ++corner) {
+                const auto position = XMVectorSet(
+                    center.x + (corner & 1 ? light.range : -light.range),
+                    center.y + (corner & 2 ? light.range : -light.range),
+                    corner & 4 ? max_depth : min_depth, 1.0f);
+                XMFLOAT3 ndc;
+                XMStoreFloat3(&ndc, XMVector3TransformCoord(position, matrix_p));
+                min_ndc_x = (std::min)(min_ndc_x, ndc.x);
+                max_ndc_x = (std::max)(max_ndc_x, ndc.x);
+                min_ndc_y = (std::min)(min_ndc_y, ndc.y);
+                max_ndc_y = (std::max)(max_ndc_y, ndc.y);
+            }
+
+            LightBounds bounds;
+            bounds.light = static_cast<std::uint32_t>(i);
+            bounds.min_x = to_cluster(min_ndc_x * 0.5f + 0.5f, CLUSTER_COUNT_X);
+            bounds.max_x = to_cluster(max_ndc_x * 0.5f + 0.5f, CLUSTER_COUNT_X);
+            bounds.min_y = to_cluster(0.5f - max_ndc_y * 0.5f, CLUSTER_COUNT_Y);
+            bounds.max_y = to_cluster(0.5f - min_ndc_y * 0.5f, CLUSTER_COUNT_Y);
+            bounds.min_z = z_slice(min_depth);
+            bounds.max_z = z_slice(max_depth);
+            visible_lights.push_back(bounds);
+        }
+    });
+
+    visible_lights_.clear();
+    for (std::size_t chunk_index = 0; chunk_index < light_partition.chunk_count(); ++chunk_index) {
+        const auto &visible_lights = chunks_[chunk_index].visible_lights;
+        visible_lights_.insert(visible_lights_.end(), visible_lights.begin(), visible_lights.end());
+    }
+
+    // --- Fill the light lists, one chunk per range of depth slices. ---
+    // Each chunk owns the clusters of its slices, so the chunks never write the same range.
+    constexpr std::uint32_t SLICE_CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y;
+    const ChunkPartition slice_partition(CLUSTER_COUNT_Z, 1);
+    if (chunks_.size() < slice_partition.chunk_count()) {
+        chunks_.resize(slice_partition.chunk_count());
+    }
+
+    run_chunks(executor, slice_partition, [&](std::size_t chunk_index, std::size_t begin, std::size_t end) {
+        auto &light_indices = chunks_[chunk_index].light_indices;
+        const auto first_cluster = static_cast<std::uint32_t>(begin) * SLICE_CLUSTER_COUNT;
+        const auto last_cluster = static_cast<std::uint32_t>(end) * SLICE_CLUSTER_COUNT;
+
+        for (auto cluster = first_cluster; cluster < last_cluster; ++cluster) {
+            cluster_ranges_[cluster] = {0, 0};
+        }
+
+        // Calls function(cluster) for each cluster of this chunk which the light touches.
+        const auto for_each_cluster = [&](const LightBounds &bounds, auto &&function) {
+            const std::uint32_t min_z = (std::max<std::uint32_t>)(bounds.min_z, static_cast<std::uint32_t>(begin));
+            const std::uint32_t max_z = (std::min<std::uint32_t>)(bounds.max_z, static_cast<std::uint32_t>(end) - 1);
+            for (auto z = min_z; z <= max_z; ++z) {
+                for (std::uint32_t y = bounds.min_y; y <= bounds.max_y; ++y) {
+                    for (std::uint32_t x = bounds.min_x; x <= bounds.max_x; ++x) {
+                        function((z * CLUSTER_COUNT_Y + y) * CLUSTER_COUNT_X + x);
+                    }
+                }
+            }
+        };
+
+        // Count, then place by the prefix sums, so that each list keeps the input order of the lights.
+        for (const auto &bounds : visible_lights_) {
+            for_each_cluster(bounds, [&](std::uint32_t cluster) {
+                ++cluster_ranges_[cluster].count;
+            });
+        }
+
+        std::uint32_t offset = 0;
+        for (auto cluster = first_cluster; cluster < last_cluster; ++cluster) {
+            cluster_ranges_[cluster].offset = offset;
+            offset += cluster_ranges_[cluster].count;
+            cluster_ranges_[cluster].count = 0;
+        }
+        light_indices.resize(offset);
+
+        for (const auto &bounds : visible_lights_) {
+            for_each_cluster(bounds, [&](std::uint32_t cluster) {
+                auto &range = cluster_ranges_[cluster];
+                light_indices[range.offset + range.count++] = bounds.light;
+            });
+        }
+    });
+
+    // --- Concatenate the chunk lists and rebase their ranges. ---
+    light_indices_.clear();
+    for (std::size_t chunk_index = 0; chunk_index < slice_partition.chunk_count(); ++chunk_index) {
+        const auto base = static_cast<std::uint32_t>(light_indices_.size());
+        const auto first_cluster = static_cast<std::uint32_t>(slice_partition.begin(chunk_index)) * SLICE_CLUSTER_COUNT;
+        const auto last_cluster = static_cast<std::uint32_t>(slice_partition.end(chunk_index)) * SLICE_CLUSTER_COUNT;
+        for (auto cluster = first_cluster; cluster < last_cluster; ++cluster) {
+            cluster_ranges_[cluster].offset += base;
+        }
+
+        const auto &light_indices = chunks_[chunk_index].light_indices;
+        light_indices_.insert(light_indices_.end(), light_indices.begin(), light_indices.end());
+    }
+}
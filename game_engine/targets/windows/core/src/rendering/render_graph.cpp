@@ -0,0 +1,197 @@
+#include <rendering/render_graph.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+RenderGraph::ResourceId RenderGraph::resource(const std::string &name) {
+    // The graphs of a view have a few dozen resources at most.
+    for (std::size_t i = 0; i < resources_.size(); ++i) {
+        if (resources_[i].name == name) return static_cast<ResourceId>(i);
+    }
+    resources_.push_back({name, false, false});
+    return static_cast<ResourceId>(resources_.size() - 1);
+}
+
+RenderGraph::ResourceId RenderGraph::import_resource(const std::string &name, bool preserve_contents) {
+    const auto id = resource(name);
+    resources_[id].imported = true;
+    resources_[id].preserve_contents = preserve_contents;
+    return id;
+}
+
+RenderGraph::PassId RenderGraph::add_pass(const std::string &name) {
+    passes_.push_back({name,
+                       static_cast<std::uint32_t>(reads_.size()), 0,
+                       static_cast<std::uint32_t>(writes_.size()), 0,
+                       false});
+    return static_cast<PassId>(passes_.size() - 1);
+}
+
+void RenderGraph::read(ResourceId resource) {
+    assert(!passes_.empty());
+    reads_.push_back(resource);
+    ++passes_.back().read_count;
+}
+
+void RenderGraph::write(ResourceId resource, WriteMode mode) {
+    assert(!passes_.empty());
+    writes_.push_back({resource, mode});
+    ++passes_.back().write_count;
+}
+
+void RenderGraph::write_signature(std::vector<std::uint32_t> &signature) const {
+    signature.clear();
+    signature.push_back(static_cast<std::uint32_t>(resources_.size()));
+    for (const auto &resource : resources_) {
+        signature.push_back((resource.imported ? 1u : 0u) | (resource.preserve_contents ? 2u : 0u));
+    }
+
+    signature.push_back(static_cast<std::uint32_t>(passes_.size()));
+    for (const auto &pass : passes_) {
+        signature.push_back(pass.has_side_effects ? 1u : 0u);
+        signature.push_back(pass.read_count);
+        for (std::uint32_t i = 0; i < pass.read_count; ++i) {
+            signature.push_back(reads_[pass.first_read + i]);
+        }
+        signature.push_back(pass.write_count);
+        for (std::uint32_t i = 0; i < pass.write_count; ++i) {
+            const auto &write = writes_[pass.first_write + i];
+            signature.push_back(write.resource << 1 | (write.mode == WriteMode::Overwrite ? 1u : 0u));
+        }
+    }
+}
+
+CompiledRenderGraph RenderGraph::compile() const {
+    constexpr auto UNUSED = (std::numeric_limits<std::uint32_t>::max)();
+
+    CompiledRenderGraph compiled;
+    compiled.live_writes_.assign(writes_.size(), 0);
+
+    // --- Cull backward from the outputs. ---
+    // A resource is needed if a later live pass reads its current contents, or it is an output.
+    std::vector<std::uint8_t> needed(resources_.size(), 0);
+    for (std::size_t i = 0; i < resources_.size(); ++i) {
+        needed[i] = resources_[i].imported ? 1 : 0;
+    }
+
+    std::vector<std::uint8_t> live_passes(passes_.size(), 0);
+    for (auto pass_id = passes_.size(); pass_id-- > 0;) {
+        const auto &pass = passes_[pass_id];
+
+        bool is_live = pass.has_side_effects;
+        for (std::uint32_t i = 0; i < pass.write_count && !is_live; ++i) {
+            is_live = needed[writes_[pass.first_write + i].resource] != 0;
+        }
+        if (!is_live) {
+            ++compiled.culled_pass_count_;
+            continue;
+        }
+        live_passes[pass_id] = 1;
+
+        for (std::uint32_t i = 0; i < pass.write_count; ++i) {
+            const auto &write = writes_[pass.first_write + i];
+            compiled.live_writes_[pass.first_write + i] = needed[write.resource];
+
+            // The contents before a full overwrite are never seen.
+            if (write.mode == WriteMode::Overwrite) needed[write.resource] = 0;
+        }
+        for (std::uint32_t i = 0; i < pass.read_count; ++i) {
+            needed[reads_[pass.first_read + i]] = 1;
+        }
+    }
+
+    // --- Find the first and the last use of each resource over the live passes. ---
+    struct Lifetime {
+        std::uint32_t first;
+        std::uint32_t last;
+        bool clear;
+        bool written;
+    };
+    std::vector<Lifetime> lifetimes(resources_.size(), {UNUSED, UNUSED, false, false});
+
+    std::uint32_t step = 0;
+    for (std::size_t pass_id = 0; pass_id < passes_.size(); ++pass_id) {
+        if (!live_passes[pass_id]) continue;
+        const auto &pass = passes_[pass_id];
+
+        // The reads come first, so a resource read and written by the same pass is cleared.
+        const auto use = [&](ResourceId id, bool overwrites) {
+            auto &lifetime = lifetimes[id];
+            if (lifetime.first == UNUSED) {
+                const auto &resource = resources_[id];
+                lifetime.first = step;
+                lifetime.clear = !overwrites && !(resource.imported && resource.preserve_contents);
+            }
+            lifetime.last = step;
+        };
+        for (std::uint32_t i = 0; i < pass.read_count; ++i) {
+            use(reads_[pass.first_read + i], false);
+        }
+        for (std::uint32_t i = 0; i < pass.write_count; ++i) {
+            if (!compiled.live_writes_[pass.first_write + i]) continue;
+            const auto &write = writes_[pass.first_write + i];
+            use(write.resource, write.mode == WriteMode::Overwrite);
+            lifetimes[write.resource].written = true;
+        }
+        ++step;
+    }
+
+    // The transient resources only read are never bound. The reads of no resource return zero,
+    // like a cleared one, without the texture and the clear.
+    for (std::size_t id = 0; id < resources_.size(); ++id) {
+        if (!resources_[id].imported && !lifetimes[id].written) {
+            lifetimes[id] = {UNUSED, UNUSED, false, false};
+        }
+    }
+
+    // --- Emit the steps. ---
+    compiled.steps_.reserve(step);
+    step = 0;
+    for (std::size_t pass_id = 0; pass_id < passes_.size(); ++pass_id) {
+        if (!live_passes[pass_id]) continue;
+
+        CompiledRenderGraph::Step compiled_step{static_cast<PassId>(pass_id),
+                                                static_cast<std::uint32_t>(compiled.acquires_.size()), 0,
+                                                static_cast<std::uint32_t>(compiled.releases_.size()), 0};
+        for (std::size_t id = 0; id < resources_.size(); ++id) {
+            const auto &lifetime = lifetimes[id];
+            if (lifetime.first == step) {
+                compiled.acquires_.push_back({static_cast<ResourceId>(id), lifetime.clear});
+                ++compiled_step.acquire_count;
+            }
+            if (lifetime.last == step && !resources_[id].imported) {
+                compiled.releases_.push_back(static_cast<ResourceId>(id));
+                ++compiled_step.release_count;
+            }
+        }
+        compiled.steps_.push_back(compiled_step);
+        ++step;
+    }
+
+    return compiled;
+}
+
+const CompiledRenderGraph &RenderGraphCache::compile(const RenderGraph &graph) {
+    graph.write_signature(signature_);
+    ++use_count_;
+
+    for (auto &entry : entries_) {
+        if (entry.signature != signature_) continue;
+        entry.last_used = use_count_;
+        return entry.compiled;
+    }
+
+    ++compile_count_;
+    if (entries_.size() < CAPACITY) {
+        entries_.push_back({signature_, graph.compile(), use_count_});
+        return entries_.back().compiled;
+    }
+
+    // Replace the least recently used one.
+    auto &entry = *std::min_element(entries_.begin(), entries_.end(), [](const Entry &lhs, const Entry &rhs) {
+        return lhs.last_used < rhs.last_used;
+    });
+    entry = {signature_, graph.compile(), use_count_};
+    return entry.compiled;
+}
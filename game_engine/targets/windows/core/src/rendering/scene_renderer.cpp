@@ -1,242 +1,349 @@
 
 #include <rendering/scene_renderer.hpp>
 
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
 #include <DirectXMath.h>
 
 #include <nodec/iterator.hpp>
-#include <nodec/unicode.hpp>
 #include <nodec_scene/components/local_to_world.hpp>
 
-#include <Font/FontBackend.hpp>
-
-class MeshDrawCommand : public DrawCommand {
-public:
-    MeshDrawCommand(const DirectX::XMMATRIX &matrix_m,
-                    std::shared_ptr<MeshBackend> mesh,
-                    std::shared_ptr<MaterialBackend> material)
-        : matrix_m(matrix_m), mesh(mesh), material(material) {}
+#include <rendering/parallel_chunks.hpp>
 
-    void draw(const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
-              SceneRendererContext &renderer_context, Graphics &gfx) override {
-        using namespace DirectX;
-        renderer_context.bs_default().bind();
-        auto matrix_m_inverse = DirectX::XMMatrixInverse(nullptr, matrix_m);
-        auto matrix_mvp = matrix_m * matrix_v * matrix_p;
+namespace {
 
-        auto &cb_model_properties = renderer_context.cb_model_properties();
+struct BuiltinPropertyIds {
+    MaterialPropertyId image = MaterialPropertyId::intern("image");
+    MaterialPropertyId mask = MaterialPropertyId::intern("mask");
+    MaterialPropertyId color = MaterialPropertyId::intern("color");
+    MaterialPropertyId sdf = MaterialPropertyId::intern("sdf");
+};
 
-        XMStoreFloat4x4(&cb_model_properties.data().matrix_m, matrix_m);
-        XMStoreFloat4x4(&cb_model_properties.data().matrix_m_inverse, matrix_m_inverse);
-        XMStoreFloat4x4(&cb_model_properties.data().matrix_mvp, matrix_mvp);
-        cb_model_properties.apply();
+const BuiltinPropertyIds &builtin_property_ids() {
+    static const BuiltinPropertyIds ids;
+    return ids;
+}
 
-        renderer_context.bind_material(material.get());
+void draw_mesh(const DrawCommand &command,
+               const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
+               SceneRendererContext &renderer_context, Graphics &gfx) {
+    using namespace DirectX;
+    renderer_context.bs_default().bind();
+    const auto &matrix_m = command.matrix_m;
+    auto matrix_m_inverse = DirectX::XMMatrixInverse(nullptr, matrix_m);
+    auto matrix_mvp = matrix_m * matrix_v * matrix_p;
 
-        mesh->bind(&gfx);
-        gfx.DrawIndexed(static_cast<UINT>(mesh->triangles.size()));
-    }
+    auto &cb_model_properties = renderer_context.cb_model_properties();
 
-    DirectX::XMMATRIX matrix_m;
-    std::shared_ptr<MeshBackend> mesh;
-    std::shared_ptr<MaterialBackend> material;
-};
+    XMStoreFloat4x4(&cb_model_properties.data().matrix_m, matrix_m);
+    XMStoreFloat4x4(&cb_model_properties.data().matrix_m_inverse, matrix_m_inverse);
+    XMStoreFloat4x4(&cb_model_properties.data().matrix_mvp, matrix_mvp);
+    cb_model_properties.apply();
 
-class ImageDrawCommand : public DrawCommand {
-public:
-    ImageDrawCommand(const DirectX::XMMATRIX &matrix_m,
-                     std::shared_ptr<TextureBackend> image,
-                     std::shared_ptr<MaterialBackend> material,
-                     const nodec::Vector4f &color)
-        : matrix_m(matrix_m), image(image), material(material), color(color) {}
+    renderer_context.bind_material(command.material);
 
-    void draw(const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
-              SceneRendererContext &renderer_context, Graphics &gfx) override {
-        using namespace DirectX;
-        renderer_context.bs_alpha_blend().bind();
-        // renderer_context.bs_default().bind(&gfx);
+    // The draws in the same run may have different vertex formats.
+    command.material->shader_backend()->bind_input_layout(command.mesh->vertex_format);
+    command.mesh->bind(&gfx);
+    gfx.DrawIndexed(command.mesh->index_count());
+}
 
-        auto matrix_m_inverse = DirectX::XMMatrixInverse(nullptr, matrix_m);
-        auto matrix_mvp = matrix_m * matrix_v * matrix_p;
+void draw_image(const DrawCommand &command,
+                const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
+                SceneRendererContext &renderer_context, Graphics &gfx) {
+    using namespace DirectX;
+    renderer_context.bs_alpha_blend().bind();
+    // renderer_context.bs_default().bind(&gfx);
 
-        auto &cb_model_properties = renderer_context.cb_model_properties();
+    const auto &matrix_m = command.matrix_m;
+    auto matrix_m_inverse = DirectX::XMMatrixInverse(nullptr, matrix_m);
+    auto matrix_mvp = matrix_m * matrix_v * matrix_p;
 
-        XMStoreFloat4x4(&cb_model_properties.data().matrix_m, matrix_m);
-        XMStoreFloat4x4(&cb_model_properties.data().matrix_m_inverse, matrix_m_inverse);
-        XMStoreFloat4x4(&cb_model_properties.data().matrix_mvp, matrix_mvp);
-        cb_model_properties.apply();
+    auto &cb_model_properties = renderer_context.cb_model_properties();
 
-        auto backup_image = material->get_texture_entry("image");
-        auto backup_color = material->get_vector4_property("color");
+    XMStoreFloat4x4(&cb_model_properties.data().matrix_m, matrix_m);
+    XMStoreFloat4x4(&cb_model_properties.data().matrix_m_inverse, matrix_m_inverse);
+    XMStoreFloat4x4(&cb_model_properties.data().matrix_mvp, matrix_mvp);
+    cb_model_properties.apply();
 
-        material->set_texture_entry(
-            "image", {image, {nodec_rendering::Sampler::FilterMode::Bilinear, nodec_rendering::Sampler::WrapMode::Clamp}});
-        material->set_vector4_property("color", color);
+    const auto &ids = builtin_property_ids();
+    auto &block = renderer_context.property_block();
+    block.clear();
+    block.set_texture(ids.image, command.image,
+                      {nodec_rendering::Sampler::FilterMode::Bilinear, nodec_rendering::Sampler::WrapMode::Clamp});
+    block.set_vector4(ids.color, command.color);
 
-        renderer_context.bind_material(material.get(), true);
+    renderer_context.bind_material(command.material, block);
 
-        auto &mesh = renderer_context.quad_mesh();
-        mesh.bind(&gfx);
-        gfx.DrawIndexed(static_cast<UINT>(mesh.triangles.size()));
+    auto &mesh = renderer_context.quad_mesh();
+    command.material->shader_backend()->bind_input_layout(mesh.vertex_format);
+    mesh.bind(&gfx);
+    gfx.DrawIndexed(mesh.index_count());
+}
 
-        if (backup_image) {
-            material->set_texture_entry("image", *backup_image);
-        }
-        if (backup_color) {
-            material->set_vector4_property("color", *backup_color);
-        }
-    }
+void draw_text(const DrawCommand &command,
+               const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
+               SceneRendererContext &renderer_context, Graphics &gfx) {
+    using namespace DirectX;
+    renderer_context.bs_alpha_blend().bind();
+    // renderer_context.bs_default().bind(&gfx);
 
-    DirectX::XMMATRIX matrix_m;
-    std::shared_ptr<TextureBackend> image;
-    std::shared_ptr<MaterialBackend> material;
-    nodec::Vector4f color;
-};
+    const auto &text_renderer = *command.text_renderer;
+    const auto &matrix_m = command.matrix_m;
 
-class TextDrawCommand : public DrawCommand {
-public:
-    TextDrawCommand(const DirectX::XMMATRIX &matrix_m,
-                    const nodec_rendering::components::TextRenderer &text_renderer)
-        : matrix_m(matrix_m), text_renderer(text_renderer) {}
+    auto *material = command.material;
+    assert(material);
 
-    void draw(const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
-              SceneRendererContext &renderer_context, Graphics &gfx) override {
-        using namespace DirectX;
-        renderer_context.bs_alpha_blend().bind();
-        // renderer_context.bs_default().bind(&gfx);
+    auto &text_layout = *command.text_layout;
+    auto &font_character_database = renderer_context.font_character_database();
 
-        auto material = static_cast<MaterialBackend *>(text_renderer.material.get());
-        assert(material);
+    // The glyphs of this text are kept in the atlas until the draw is issued.
+    font_character_database.BeginBatch();
+    renderer_context.text_layout_cache().resolve(text_layout, text_renderer);
+    if (!text_layout.vertex_buffer) return;
 
-        auto font = static_cast<FontBackend *>(text_renderer.font.get());
-        assert(font);
+    if (!text_layout.sdf_texture) {
+        font_character_database.UploadAtlas();
+    }
 
-        auto backup_mask = material->get_texture_entry("mask");
-        auto backup_color = material->get_vector4_property("color");
+    auto &cb_model_properties = renderer_context.cb_model_properties();
+    XMStoreFloat4x4(&cb_model_properties.data().matrix_m, matrix_m);
+    XMStoreFloat4x4(&cb_model_properties.data().matrix_m_inverse, XMMatrixInverse(nullptr, matrix_m));
+    XMStoreFloat4x4(&cb_model_properties.data().matrix_mvp, matrix_m * matrix_v * matrix_p);
+    cb_model_properties.apply();
+
+    const auto &ids = builtin_property_ids();
+    auto &block = renderer_context.property_block();
+    block.clear();
+    if (text_layout.sdf_texture) {
+        block.set_texture(ids.sdf, text_layout.sdf_texture,
+                          {nodec_rendering::Sampler::FilterMode::Bilinear, nodec_rendering::Sampler::WrapMode::Clamp});
+    } else {
+        block.set_texture(ids.mask, &font_character_database.AtlasTexture(),
+                          {nodec_rendering::Sampler::FilterMode::Bilinear, nodec_rendering::Sampler::WrapMode::Clamp});
+    }
+    block.set_vector4(ids.color, text_renderer.color);
 
-        const auto u32_text = nodec::unicode::utf8to32<std::u32string>(text_renderer.text);
-        const float pixels_per_unit = static_cast<float>(text_renderer.pixels_per_unit);
-        const float pixel_size = text_renderer.pixel_size;
+    renderer_context.bind_material(material, block);
 
-        auto &font_character_database = renderer_context.font_character_database();
+    material->shader_backend()->bind_input_layout(VertexFormat::Float32);
+    text_layout.vertex_buffer->Bind(&gfx);
+    renderer_context.quad_index_buffer().draw(text_layout.quad_count());
+}
 
-        float offset_x = 0.0f;
-        float offset_y = 0.0f;
+std::uint64_t make_draw_sort_key(const DrawCommand &command, const DirectX::XMMATRIX &matrix_v_inverse) {
+    using namespace DirectX;
+    auto *material_backend = command.material;
+    auto *shader_backend = material_backend->shader_backend();
 
-        for (const auto &chCode : u32_text) {
-            if (chCode == '\n') {
-                offset_y -= pixel_size / pixels_per_unit;
-                offset_x = 0.0f;
-                continue;
-            }
+    // Calculate the depth from the camera.
+    auto model_position = command.matrix_m.r[3];
+    auto camera_position = matrix_v_inverse.r[3];
 
-            const auto &character = font_character_database.Get(font->GetFace(), pixel_size, chCode);
+    auto camera_direction = matrix_v_inverse.r[2]; // Assuming the camera looks along the -Z axis
 
-            float pos_x = offset_x + character.bearing.x / pixels_per_unit;
-            float pos_y = offset_y - (character.size.y - character.bearing.y) / pixels_per_unit;
-            float w = character.size.x / pixels_per_unit;
-            float h = character.size.y / pixels_per_unit;
+    // Compute the vector from the camera to the object
+    XMVECTOR camera_to_object = XMVectorSubtract(model_position, camera_position);
 
-            offset_x += (character.advance >> 6) / pixels_per_unit;
+    // Project this vector onto the camera's view direction.
+    // The projected length is the distance from the camera to the object along the view direction
+    auto depth = XMVectorGetX(XMVector3Dot(camera_to_object, camera_direction)) / XMVectorGetX(XMVector3LengthSq(camera_direction));
 
-            if (!character.pFontTexture) {
-                continue;
-            }
+    return material_backend->is_transparent()
+               ? DrawSortKey::make_transparent(shader_backend->rendering_priority(), shader_backend->sort_id(),
+                                               material_backend->sort_id(), depth)
+               : DrawSortKey::make_opaque(shader_backend->rendering_priority(), shader_backend->sort_id(),
+                                          material_backend->sort_id(),
+                                          command.mesh ? command.mesh->sort_id() : 0u, depth);
+}
 
-            material->set_texture_entry("mask",
-                                        {character.pFontTexture, {nodec_rendering::Sampler::FilterMode::Bilinear, nodec_rendering::Sampler::WrapMode::Clamp}});
-            material->set_vector4_property("color", text_renderer.color);
+void draw_mesh_instanced(const DrawCommand &command, const InstanceBatcher::Batch &batch,
+                         SceneRendererContext &renderer_context, Graphics &gfx) {
+    renderer_context.bs_default().bind();
+    renderer_context.bind_material(command.material);
 
-            renderer_context.bind_material(material, true);
+    command.material->shader_backend()->bind_input_layout(command.mesh->vertex_format, true);
+    command.mesh->bind(&gfx);
+    gfx.DrawIndexedInstanced(command.mesh->index_count(),
+                             batch.instance_count(), batch.first_instance);
+}
 
-            XMMATRIX matrix_m_ch{matrix_m};
-            matrix_m_ch = XMMatrixScaling(w / 2, h / 2, 1.0f) * XMMatrixTranslation(pos_x + w / 2, pos_y + h / 2, 0.0f) * matrix_m_ch;
+void draw_sprite_batch(const DrawCommand &command, const SpriteBatcher::Batch &batch,
+                       InstanceBuffer &sprite_vertex_buffer,
+                       SceneRendererContext &renderer_context, Graphics &gfx) {
+    renderer_context.bs_alpha_blend().bind();
 
-            // matrixM
-            auto matrix_m_inverse = XMMatrixInverse(nullptr, matrix_m_ch);
+    // The colors of the sprites are in the vertices, so the material color is overridden with white
+    // like the single image draw overrides it with the renderer color.
+    const auto &ids = builtin_property_ids();
+    auto &block = renderer_context.property_block();
+    block.clear();
+    block.set_texture(ids.image, command.image,
+                      {nodec_rendering::Sampler::FilterMode::Bilinear, nodec_rendering::Sampler::WrapMode::Clamp});
+    block.set_vector4(ids.color, nodec::Vector4f(1.0f, 1.0f, 1.0f, 1.0f));
 
-            // DirectX Math using row-major representation
-            // HLSL using column-major representation
-            auto matrix_mvp = matrix_m_ch * matrix_v * matrix_p;
+    renderer_context.bind_material(command.material, block);
 
-            auto &cb_model_properties = renderer_context.cb_model_properties();
+    sprite_vertex_buffer.bind(0);
+    renderer_context.quad_index_buffer().draw(batch.quad_count(), batch.first_quad);
+}
 
-            XMStoreFloat4x4(&cb_model_properties.data().matrix_m, matrix_m_ch);
-            XMStoreFloat4x4(&cb_model_properties.data().matrix_m_inverse, matrix_m_inverse);
-            XMStoreFloat4x4(&cb_model_properties.data().matrix_mvp, matrix_mvp);
+/**
+ * @brief The bytes of the texture behind the view, for the stats.
+ */
+std::uint64_t render_target_view_bytes(ID3D11RenderTargetView &view) {
+    Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+    view.GetResource(&resource);
 
-            cb_model_properties.apply();
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+    if (FAILED(resource.As(&texture))) return 0;
 
-            auto &mesh = renderer_context.screen_quad_mesh();
-            mesh.bind(&gfx);
-            gfx.DrawIndexed(static_cast<UINT>(mesh.triangles.size()));
-        } // End foreach character.
-        if (backup_mask) {
-            material->set_texture_entry("mask", *backup_mask);
-        }
+    D3D11_TEXTURE2D_DESC desc;
+    texture->GetDesc(&desc);
+    return static_cast<std::uint64_t>(desc.Width) * desc.Height * render_target_format_size(desc.Format);
+}
 
-        if (backup_color) {
-            material->set_vector4_property("color", *backup_color);
-        }
+} // namespace
+
+void execute_draw_command(const DrawCommand &command,
+                          const DirectX::XMMATRIX &matrix_v, const DirectX::XMMATRIX &matrix_p,
+                          SceneRendererContext &context, Graphics &gfx) {
+    switch (command.type) {
+    case DrawCommand::Type::Mesh:
+        draw_mesh(command, matrix_v, matrix_p, context, gfx);
+        break;
+    case DrawCommand::Type::Image:
+        draw_image(command, matrix_v, matrix_p, context, gfx);
+        break;
+    case DrawCommand::Type::Text:
+        draw_text(command, matrix_v, matrix_p, context, gfx);
+        break;
     }
-
-    DirectX::XMMATRIX matrix_m;
-    const nodec_rendering::components::TextRenderer &text_renderer;
-};
+}
 
 SceneRenderer::SceneRenderer(nodec_scene::Scene &scene,
                              Graphics &gfx,
-                             nodec::resource_management::ResourceRegistry &resource_registry)
+                             nodec::resource_management::ResourceRegistry &resource_registry,
+                             const SceneSpatialIndex *spatial_index)
     : logger_(nodec::logging::get_logger("engine.scene-renderer")),
       scene_(scene),
       gfx_(gfx),
-      renderer_context_(logger_, gfx, resource_registry) {
+      spatial_index_(spatial_index),
+      renderer_context_(logger_, gfx, resource_registry),
+      instance_buffer_(gfx, sizeof(InstanceData)),
+      sprite_vertex_buffer_(gfx, sizeof(SpriteVertex)),
+      cluster_range_buffer_(gfx, sizeof(LightClusterGrid::ClusterRange)),
+      cluster_light_index_buffer_(gfx, sizeof(std::uint32_t)),
+      point_light_buffer_(gfx) {
 }
 
-void SceneRenderer::push_draw_command(std::shared_ptr<ShaderBackend> shader, bool is_transparent,
-                                      const std::shared_ptr<MaterialBackend> &material_backend,
-                                      std::unique_ptr<DrawCommand> command,
-                                      const DirectX::XMMATRIX &matrix_m, const DirectX::XMMATRIX &matrix_v_inverse) {
+void SceneRenderer::push_draw_command(const DrawCommand &command,
+                                      const DirectX::XMMATRIX &matrix_v_inverse) {
+    draw_queue_.push(make_draw_sort_key(command, matrix_v_inverse), draw_commands_.push(command));
+}
+
+void SceneRenderer::push_mesh_draw_commands(nodec_scene::Scene &scene, const CameraState &camera_state) {
+    using namespace nodec_scene;
     using namespace DirectX;
-    auto key = DrawGroupPriorityKey(shader, is_transparent);
-    auto &group = draw_groups_[key];
-    if (!group) {
-        if (is_transparent) {
-            group = std::make_unique<TransparentDrawGroup>();
-        } else {
-            group = std::make_unique<OpaqueDrawGroup>();
-        }
-        group->shader = shader;
-    }
-    if (is_transparent) {
-        using namespace DirectX;
-        auto *transparent_group = static_cast<TransparentDrawGroup *>(group.get());
-        // Calculate the depth from the camera.
-        auto model_position = matrix_m.r[3];
-        auto camera_position = matrix_v_inverse.r[3];
-        // auto depth = XMVectorGetX(XMVector3Length(model_position - camera_position));
 
-        auto camera_direction = matrix_v_inverse.r[2]; // Assuming the camera looks along the -Z axis
+    // The chunks smaller than this are not worth the dispatch.
+    // It must be a multiple of 64 so that the chunks never share a word of the visibility bits.
+    constexpr std::size_t MIN_CHUNK_SIZE = 512;
 
-        // Compute the vector from the camera to the object
-        XMVECTOR camera_to_object = XMVectorSubtract(model_position, camera_position);
+    const auto &mesh_sources = snapshot_.mesh_sources();
+    const auto &entity_world_bounds = snapshot_.mesh_world_bounds();
+    const auto &submesh_world_bounds = snapshot_.submesh_world_bounds();
 
-        // Project this vector onto the camera's view direction
-        auto projected_length = XMVectorGetX(XMVector3Dot(camera_to_object, camera_direction)) / XMVectorGetX(XMVector3LengthSq(camera_direction));
+    const auto source_count = mesh_sources.size();
+    entity_visibility_bits_.resize(visibility_word_count(source_count));
+    entity_inside_bits_.resize(visibility_word_count(source_count));
 
-        // The projected length is the distance from the camera to the object along the view direction
-        auto depth = projected_length;
+    const auto &planes = camera_state.culling_planes();
+    const auto &matrix_v_inverse = camera_state.matrix_v_inverse();
 
-        transparent_group->draw_commands.emplace(
-            depth, std::move(command));
-    } else {
-        auto *opaque_group = static_cast<OpaqueDrawGroup *>(group.get());
-        opaque_group->append_draw_command(
-            material_backend, std::move(command));
+    if (spatial_index_) {
+        std::fill(entity_visibility_bits_.begin(), entity_visibility_bits_.end(), 0);
+        std::fill(entity_inside_bits_.begin(), entity_inside_bits_.end(), 0);
+
+        // The index may be one frame behind the registry, so the entities are looked up again.
+        auto &registry = scene.registry();
+        spatial_index_->query_frustum(planes, [&](SceneEntity entity, bool is_inside) {
+            if (!registry.is_valid(entity)) return;
+            const auto source_index = snapshot_.find_mesh_source(registry, entity);
+            if (source_index < 0) return;
+
+            // The enlarged bounds in the tree enclose the tight ones.
+            if (!is_inside) {
+                ++stats_.entity_bounds_tests;
+                if (!test_world_bounds(planes, entity_world_bounds, static_cast<std::size_t>(source_index))) return;
+            }
 
-        // auto material_id = reinterpret_cast<std::intptr_t>(material_backend.get());
-        // opaque_group->draw_commands.emplace(material_id, std::move(command));
+            const auto bit = std::uint64_t{1} << (source_index % 64);
+            entity_visibility_bits_[source_index / 64] |= bit;
+            if (is_inside) entity_inside_bits_[source_index / 64] |= bit;
+        });
     }
+
+    const ChunkPartition partition(source_count, MIN_CHUNK_SIZE);
+
+    const auto collect = [&](DrawCommandChunk &chunk, std::size_t begin, std::size_t end) {
+        chunk.commands.clear();
+        chunk.keys.clear();
+        chunk.stats = {};
+
+        cull_submeshes(
+            planes, entity_world_bounds, submesh_world_bounds, begin, end, !spatial_index_,
+            entity_visibility_bits_.data(), entity_inside_bits_.data(),
+            [&](std::size_t source_index) {
+                const auto &source = mesh_sources[source_index];
+                return std::make_pair(source.first_bounds, source.renderer->meshes.size());
+            },
+            [&](std::size_t source_index, std::size_t i) {
+                const auto &source = mesh_sources[source_index];
+                const auto &renderer = *source.renderer;
+
+                auto *mesh_backend = static_cast<MeshBackend *>(renderer.meshes[i].get());
+                auto *material_backend = static_cast<MaterialBackend *>(renderer.materials[i].get());
+                if (!mesh_backend || !material_backend) return;
+                if (!material_backend->shader_backend()) return;
+
+                chunk.commands.push_back(DrawCommand::make_mesh(XMMATRIX(source.local_to_world->value.m), mesh_backend, material_backend));
+                chunk.keys.push_back(make_draw_sort_key(chunk.commands.back(), matrix_v_inverse));
+            },
+            chunk.stats);
+    };
+
+    const auto merge = [&](const DrawCommandChunk &chunk) {
+        for (std::size_t i = 0; i < chunk.commands.size(); ++i) {
+            draw_queue_.push(chunk.keys[i], draw_commands_.push(chunk.commands[i]));
+        }
+
+        stats_.entity_bounds_tests += chunk.stats.entity_bounds_tests;
+        stats_.submesh_bounds_tests += chunk.stats.submesh_bounds_tests;
+        stats_.submesh_bounds_tests_saved += chunk.stats.submesh_bounds_tests_saved;
+    };
+
+    collect_chunks(executor_, partition, draw_command_chunks_, collect, merge);
+}
+
+void SceneRenderer::prepare_snapshot(nodec_scene::Scene &scene) {
+    if (snapshot_scene_ == &scene) return;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    snapshot_.capture(scene, renderer_context_.text_layout_cache(), executor_, spatial_index_ != nullptr);
+    setup_scene_lighting(scene);
+    snapshot_scene_ = &scene;
+
+    ++stats_.snapshot_captures;
+    stats_.snapshot_microseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+                                        std::chrono::steady_clock::now() - start)
+                                        .count();
 }
+
 void SceneRenderer::setup_scene_lighting(nodec_scene::Scene &scene) {
     using namespace nodec_rendering::components;
     using namespace nodec_scene;
@@ -261,6 +368,55 @@ void SceneRenderer::setup_scene_lighting(nodec_scene::Scene &scene) {
         [&](SceneEntity entt, const nodec_rendering::components::SceneLighting &lighting) {
             cb_scene_properties.data().lights.ambient_color = lighting.ambient_color;
         });
+
+    // Stage the point lights. The light buffer is uploaded later only if they have changed.
+    point_light_buffer_.begin_staging();
+    cluster_lights_.clear();
+    scene.registry().view<const LocalToWorld, const nodec_rendering::components::PointLight>().each(
+        [&](SceneEntity entt, const LocalToWorld &local_to_world, const nodec_rendering::components::PointLight &light) {
+            const auto world_position = local_to_world.value * Vector4f(0, 0, 0, 1.0f);
+
+            PointLightBuffer::PointLight point_light;
+            point_light.position.set(world_position.x, world_position.y, world_position.z);
+            point_light.color.set(light.color.x, light.color.y, light.color.z);
+            point_light.intensity = light.intensity;
+            point_light.range = light.range;
+            point_light_buffer_.push(point_light);
+
+            cluster_lights_.push_back({{world_position.x, world_position.y, world_position.z}, light.range});
+        });
+    point_light_buffer_.end_staging();
+
+    cb_scene_properties.data().lights.num_of_point_lights = static_cast<std::uint32_t>(cluster_lights_.size());
+    stats_.uploaded_bytes += point_light_buffer_.upload();
+}
+
+void SceneRenderer::build_light_clusters(const CameraState &camera_state) {
+    auto &cb_scene_properties = renderer_context_.cb_scene_properties();
+
+    light_cluster_grid_.build(cluster_lights_, camera_state.culling_planes(),
+                              camera_state.matrix_v(), camera_state.matrix_p(),
+                              camera_state.near_clip(), camera_state.far_clip(),
+                              executor_);
+    stats_.visible_point_lights += light_cluster_grid_.visible_light_count();
+
+    auto &clusters = cb_scene_properties.data().clusters;
+    clusters.cluster_count[0] = LightClusterGrid::CLUSTER_COUNT_X;
+    clusters.cluster_count[1] = LightClusterGrid::CLUSTER_COUNT_Y;
+    clusters.cluster_count[2] = LightClusterGrid::CLUSTER_COUNT_Z;
+    clusters.z_slice_scale = light_cluster_grid_.z_slice_scale();
+    clusters.z_slice_bias = light_cluster_grid_.z_slice_bias();
+
+    const auto &ranges = light_cluster_grid_.cluster_ranges();
+    const auto &indices = light_cluster_grid_.light_indices();
+    cluster_range_buffer_.update(ranges.data(), static_cast<UINT>(ranges.size()));
+    cluster_light_index_buffer_.update(indices.data(), static_cast<UINT>(indices.size()));
+    stats_.uploaded_bytes += ranges.size() * sizeof(LightClusterGrid::ClusterRange)
+                             + indices.size() * sizeof(std::uint32_t);
+
+    point_light_buffer_.bind_ps(SceneRenderingConstants::POINT_LIGHTS_SRV_SLOT);
+    cluster_range_buffer_.bind_ps(SceneRenderingConstants::LIGHT_CLUSTER_RANGES_SRV_SLOT);
+    cluster_light_index_buffer_.bind_ps(SceneRenderingConstants::LIGHT_CLUSTER_INDICES_SRV_SLOT);
 }
 
 void SceneRenderer::render(nodec_scene::Scene &scene,
@@ -276,34 +432,25 @@ void SceneRenderer::render(nodec_scene::Scene &scene,
     auto &scene_registry = scene.registry();
 
     renderer_context_.begin_render();
+    context.begin_frame();
 
-    setup_scene_lighting(scene);
+    prepare_snapshot(scene);
 
     // Render the scene per each camera.
     scene.registry().view<const Camera, const LocalToWorld>().each(
         [&](SceneEntity camera_entity, const Camera &camera, const LocalToWorld &camera_local_to_world) {
-            ID3D11RenderTargetView *camera_render_target_view = &render_target;
-
             // --- Get active post process effects. ---
-            std::vector<const PostProcessing::Effect *> activePostProcessEffects;
+            active_effects_.clear();
             {
                 const auto *postProcessing = scene.registry().try_get_component<const PostProcessing>(camera_entity);
 
                 if (postProcessing) {
                     for (const auto &effect : postProcessing->effects) {
                         if (effect.enabled && effect.material && effect.material->shader()) {
-                            activePostProcessEffects.push_back(&effect);
+                            active_effects_.push_back(&effect);
                         }
                     }
                 }
-
-                // If some effects, the off-screen buffer is needed.
-                if (activePostProcessEffects.size() > 0) {
-                    auto &buffer = context.geometry_buffer("screen");
-
-                    // Set the render target.
-                    camera_render_target_view = &buffer.render_target_view();
-                }
             }
 
             auto camera_activity_result = scene_registry.emplace_component<CameraActivity>(camera_entity);
@@ -320,81 +467,7 @@ void SceneRenderer::render(nodec_scene::Scene &scene,
 
             camera_activity.state->update_transform(camera_local_to_world.value);
 
-            render_internal(scene, *camera_activity.state,
-                            camera_render_target_view, context);
-
-            // --- Post Processing ---
-            if (activePostProcessEffects.size() > 0) {
-                gfx_.context().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-                renderer_context_.bs_default().bind();
-
-                for (std::size_t i = 0; i < activePostProcessEffects.size(); ++i) {
-                    if (i != activePostProcessEffects.size() - 1) {
-                        camera_render_target_view = &context.geometry_buffer("screen_back").render_target_view();
-                    } else {
-                        // if last, render target is frame buffer.
-                        camera_render_target_view = &render_target;
-                    }
-
-                    // It is assured that material and shader are exists.
-                    // It is checked at the beginning of rendering pass of camera.
-                    auto material_backend = std::static_pointer_cast<MaterialBackend>(activePostProcessEffects[i]->material);
-                    auto shader_backend = std::static_pointer_cast<ShaderBackend>(material_backend->shader());
-
-                    renderer_context_.bind_material(material_backend.get());
-                    const UINT slot_offset = material_backend->texture_entries().size();
-
-                    for (int passNum = 0; passNum < shader_backend->pass_count(); ++passNum) {
-                        if (passNum == shader_backend->pass_count() - 1) {
-                            // If last pass.
-                            // The render target must be one final target.
-                            D3D11_VIEWPORT vp = CD3D11_VIEWPORT(0.f, 0.f, context.target_width(), context.target_height());
-                            gfx_.context().RSSetViewports(1u, &vp);
-                            gfx_.context().OMSetRenderTargets(1, &camera_render_target_view, nullptr);
-
-                        } else {
-                            // If halfway pass.
-                            // Support the multiple render targets.
-
-                            const auto &targets = shader_backend->render_targets(passNum);
-
-                            std::vector<ID3D11RenderTargetView *> renderTargets(targets.size());
-                            std::vector<D3D11_VIEWPORT> vps(targets.size());
-                            for (size_t i = 0; i < targets.size(); ++i) {
-                                auto &buffer = context.geometry_buffer(targets[i]);
-                                renderTargets[i] = &buffer.render_target_view();
-                                // gfx_.context().ClearRenderTargetView(renderTargets[i], Vector4f::zero.v);
-
-                                vps[i] = CD3D11_VIEWPORT(0.f, 0.f, static_cast<FLOAT>(buffer.width()), static_cast<FLOAT>(buffer.height()));
-                            }
-
-                            gfx_.context().OMSetRenderTargets(static_cast<UINT>(renderTargets.size()), renderTargets.data(), nullptr);
-                            gfx_.context().RSSetViewports(static_cast<UINT>(vps.size()), vps.data());
-                        }
-
-                        // --- Bind texture resources.
-                        // Bind sampler for textures.
-
-                        renderer_context_.sampler_state({Sampler::FilterMode::Bilinear, Sampler::WrapMode::Clamp}).BindPS(&gfx_, slot_offset);
-                        const auto &texture_resources = shader_backend->texture_resources(passNum);
-                        for (std::size_t i = 0; i < texture_resources.size(); ++i) {
-                            auto &buffer = context.geometry_buffer(texture_resources[i]);
-                            auto *view = &buffer.shader_resource_view();
-                            gfx_.context().PSSetShaderResources(slot_offset + i, 1u, &view);
-                        }
-                        shader_backend->bind(passNum);
-
-                        auto &screen_quad_mesh = renderer_context_.screen_quad_mesh();
-
-                        screen_quad_mesh.bind(&gfx_);
-                        gfx_.DrawIndexed(screen_quad_mesh.triangles.size());
-                        renderer_context_.unbind_all_shader_resources(slot_offset, static_cast<UINT>(texture_resources.size()));
-                    } // End foreach pass.
-                    renderer_context_.unbind_all_shader_resources(slot_offset);
-                    context.swap_geometry_buffers("screen", "screen_back");
-                } // End foreach effect.
-            }
+            render_camera(scene, *camera_activity.state, render_target, context);
         }); // End foreach camera
 }
 
@@ -405,17 +478,17 @@ void SceneRenderer::render(nodec_scene::Scene &scene, const CameraState &camera_
     using namespace nodec;
 
     renderer_context_.begin_render();
+    context.begin_frame();
 
-    setup_scene_lighting(scene);
+    prepare_snapshot(scene);
 
-    render_internal(scene, camera_state,
-                    render_target, context);
+    active_effects_.clear();
+    render_camera(scene, camera_state, *render_target, context);
 }
 
-void SceneRenderer::render_internal(nodec_scene::Scene &scene,
-                                    const CameraState &camera_state,
-                                    ID3D11RenderTargetView *render_target, SceneRenderingContext &context) {
-    assert(render_target != nullptr);
+void SceneRenderer::render_camera(nodec_scene::Scene &scene,
+                                  const CameraState &camera_state,
+                                  ID3D11RenderTargetView &output, SceneRenderingContext &context) {
     using namespace nodec;
     using namespace nodec_scene;
     using namespace nodec_scene::components;
@@ -423,97 +496,28 @@ void SceneRenderer::render_internal(nodec_scene::Scene &scene,
     using namespace nodec_rendering;
     using namespace DirectX;
 
-    auto &scene_registry = scene.registry();
+    const auto start = std::chrono::steady_clock::now();
 
     // Group the draw-command by the shader.
     {
-        scene_registry.view<const MeshRenderer, const LocalToWorld>(type_list<NonVisible>{})
-            .each([&](SceneEntity entity, const MeshRenderer &renderer, const LocalToWorld &local_to_world) {
-                if (renderer.meshes.size() != renderer.materials.size()) return;
-
-                for (int i = 0; i < renderer.meshes.size(); ++i) {
-                    auto &mesh = renderer.meshes[i];
-                    auto &material = renderer.materials[i];
-                    if (!mesh || !material) continue;
-
-                    auto mesh_backend = std::static_pointer_cast<MeshBackend>(mesh);
-                    auto material_backend = std::static_pointer_cast<MaterialBackend>(material);
-                    auto shader_backend = std::static_pointer_cast<ShaderBackend>(material->shader());
-                    if (!shader_backend) continue;
-
-                    if (!nodec::gfx::intersects(camera_state.frustum(), mesh_backend->bounds, local_to_world.value)) {
-                        return;
-                    }
+        push_mesh_draw_commands(scene, camera_state);
 
-                    auto matrix_m = XMMATRIX(local_to_world.value.m);
-                    const bool is_transparent = material_backend->is_transparent();
-
-                    auto command = std::make_unique<MeshDrawCommand>(
-                        matrix_m,
-                        mesh_backend,
-                        material_backend);
-
-                    push_draw_command(shader_backend, is_transparent, material_backend, std::move(command), matrix_m, camera_state.matrix_v_inverse());
-                } // End foreach mesh
-            });
-        scene.registry().view<const ImageRenderer, const LocalToWorld>(type_list<NonVisible>{}).each([&](SceneEntity entity, const ImageRenderer &renderer, const LocalToWorld &local_to_world) {
-            auto &image = renderer.image;
-            auto &material = renderer.material;
-            if (!image || !material) return;
-
-            auto image_backend = std::static_pointer_cast<TextureBackend>(image);
-            auto material_backend = std::static_pointer_cast<MaterialBackend>(material);
-            auto shader_backend = std::static_pointer_cast<ShaderBackend>(material->shader());
-            if (!shader_backend) return;
-
-            const auto width = image_backend->width() / (renderer.pixels_per_unit + std::numeric_limits<float>::epsilon());
-            const auto height = image_backend->height() / (renderer.pixels_per_unit + std::numeric_limits<float>::epsilon());
-
-            // auto local_to_world_matrix = local_to_world.value * gfx::scale_matrix(width, height, 1.0f);
-            const gfx::BoundingBox bounds(Vector3f::zero, Vector3f(width, height, 0.0f));
-            if (!nodec::gfx::intersects(camera_state.frustum(), bounds, local_to_world.value)) {
-                return;
+        for (const auto &source : snapshot_.image_sources()) {
+            const gfx::BoundingBox bounds(Vector3f::zero, Vector3f(source.width, source.height, 0.0f));
+            if (!nodec::gfx::intersects(camera_state.frustum(), bounds, source.local_to_world->value)) {
+                continue;
             }
-            
-            auto matrix_m = XMMatrixScaling(width, height, 1.f) * XMMATRIX(local_to_world.value.m);
-
-            auto command = std::make_unique<ImageDrawCommand>(
-                matrix_m,
-                image_backend,
-                material_backend,
-                renderer.color);
-
-            const bool is_transparent = material_backend->is_transparent();
-            push_draw_command(shader_backend, is_transparent, material_backend, std::move(command), matrix_m, camera_state.matrix_v_inverse());
-        });
-
-        scene.registry().view<const TextRenderer, const LocalToWorld>(type_list<NonVisible>{}).each([&](SceneEntity entity, const TextRenderer &renderer, const LocalToWorld &local_to_world) {
-            auto &material = renderer.material;
-            auto &font = renderer.font;
-            if (!material || !font) return;
 
-            auto material_backend = std::static_pointer_cast<MaterialBackend>(material);
-            auto shader_backend = std::static_pointer_cast<ShaderBackend>(material->shader());
-            if (!shader_backend) return;
+            auto matrix_m = XMMatrixScaling(source.width, source.height, 1.f) * XMMATRIX(source.local_to_world->value.m);
 
-            auto matrix_m = XMMATRIX(local_to_world.value.m);
-
-            const bool is_transparent = material_backend->is_transparent();
-            auto command = std::make_unique<TextDrawCommand>(
-                XMMATRIX(local_to_world.value.m),
-                renderer);
-
-            push_draw_command(shader_backend, is_transparent, material_backend, std::move(command), matrix_m, camera_state.matrix_v_inverse());
-        });
-    }
+            push_draw_command(DrawCommand::make_image(matrix_m, source.image, source.material, source.renderer->color),
+                              camera_state.matrix_v_inverse());
+        }
 
-    // Clear render target view with solid color.
-    {
-        gfx_.context().ClearRenderTargetView(render_target, Vector4f::zero.v);
-        for (auto iter = context.geometry_buffer_begin(); iter != context.geometry_buffer_end(); ++iter) {
-            auto &buffer = iter->second;
-            if (!buffer) continue;
-            gfx_.context().ClearRenderTargetView(&buffer->render_target_view(), Vector4f::zero.v);
+        for (const auto &source : snapshot_.text_sources()) {
+            auto *material_backend = static_cast<MaterialBackend *>(source.renderer->material.get());
+            push_draw_command(DrawCommand::make_text(XMMATRIX(source.local_to_world->value.m), material_backend, *source.renderer, *source.layout),
+                              camera_state.matrix_v_inverse());
         }
     }
 
@@ -534,156 +538,446 @@ void SceneRenderer::render_internal(nodec_scene::Scene &scene,
         XMVectorGetByIndex(trans, 2),
         XMVectorGetByIndex(trans, 3));
 
-    // Update active point lights.
-    {
-        auto &lights = cb_scene_properties.data().lights;
-        lights.num_of_point_lights = 0;
-        auto view = scene.registry().view<const LocalToWorld, const nodec_rendering::components::PointLight>();
-        for (const auto &entt : view) {
-            // TODO: Light culling.
-            const auto index = lights.num_of_point_lights;
-            if (index >= nodec::size(lights.point_lights)) break;
-
-            const auto &local_to_world = view.get<const LocalToWorld>(entt);
-            const auto &light = view.get<const nodec_rendering::components::PointLight>(entt);
-            const auto worldPosition = local_to_world.value * Vector4f(0, 0, 0, 1.0f);
-
-            lights.point_lights[index].position.set(worldPosition.x, worldPosition.y, worldPosition.z);
-            lights.point_lights[index].color.set(light.color.x, light.color.y, light.color.z);
-            lights.point_lights[index].intensity = light.intensity;
-            lights.point_lights[index].range = light.range;
-
-            ++lights.num_of_point_lights;
-        }
-    }
+    build_light_clusters(camera_state);
 
     cb_scene_properties.apply();
+    stats_.uploaded_bytes += sizeof(CBSceneProperties::SceneProperties);
 
     // Reset depth buffer.
     gfx_.context().ClearDepthStencilView(&context.depth_stencil_view(), D3D11_CLEAR_DEPTH, 1.0f, 0);
 
-    // Render skybox.
-    [&]() {
-        auto &norm_cube_mesh = renderer_context_.norm_cube_mesh();
+    renderer_context_.cb_model_properties().buffer().bind(SceneRenderingConstants::MODEL_PROPERTIES_CB_SLOT);
+
+    // Opaque first, then by the shader priority, the shader and the material (or the depth for the transparents).
+    draw_queue_.sort();
+    stats_.draw_commands += draw_queue_.size();
+
+    // Merge the adjacent draws of the same mesh and material into the instanced draws.
+    instance_batcher_.build(draw_queue_, draw_commands_, [](const DrawCommand &command) {
+        return command.material->shader_backend()->supports_instancing();
+    });
+    if (!instance_batcher_.instances().empty()) {
+        instance_buffer_.update(instance_batcher_.instances().data(),
+                                static_cast<UINT>(instance_batcher_.instances().size()));
+        stats_.uploaded_bytes += instance_batcher_.instances().size() * sizeof(InstanceData);
+        instance_buffer_.bind(1);
+    }
 
-        auto view = scene.registry().view<nodec_rendering::components::SceneLighting>();
-        if (view.begin() == view.end()) return;
+    // Merge the adjacent images of the same image and material into the sprite batches.
+    sprite_batcher_.build(draw_queue_, draw_commands_, [](const DrawCommand &command) {
+        return command.material->shader_backend()->supports_sprite_batching();
+    });
+    if (!sprite_batcher_.vertices().empty()) {
+        sprite_vertex_buffer_.update(sprite_batcher_.vertices().data(),
+                                     static_cast<UINT>(sprite_batcher_.vertices().size()));
+        stats_.uploaded_bytes += sprite_batcher_.vertices().size() * sizeof(SpriteVertex);
+    }
 
-        auto entt = *view.begin();
-        const auto &lighting = view.get<nodec_rendering::components::SceneLighting>(entt);
+    // --- Describe the passes of the view, and run the ones whose results are used. ---
+    build_render_graph(scene);
 
-        auto material_backend = static_cast<MaterialBackend *>(lighting.skybox.get());
-        if (!material_backend) return;
+    const auto compile_count = render_graph_cache_.compile_count();
+    const auto &compiled_graph = render_graph_cache_.compile(render_graph_);
+    stats_.render_graph_compiles += render_graph_cache_.compile_count() - compile_count;
+    stats_.culled_passes += compiled_graph.culled_pass_count();
 
-        auto shader_backend = static_cast<ShaderBackend *>(material_backend->shader().get());
-        if (!shader_backend) return;
+    execute_render_graph(compiled_graph, camera_state, output, context);
 
-        renderer_context_.bs_default().bind();
+    // The next view reuses the textures.
+    context.release_geometry_buffers();
 
-        gfx_.context().OMSetRenderTargets(1, &render_target, nullptr);
-        D3D11_VIEWPORT vp = CD3D11_VIEWPORT(0.f, 0.f, static_cast<FLOAT>(context.target_width()), static_cast<FLOAT>(context.target_height()));
-        gfx_.context().RSSetViewports(1u, &vp);
-        gfx_.context().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        shader_backend->bind();
+    draw_queue_.clear();
+    draw_commands_.reset();
 
-        renderer_context_.bind_material(material_backend);
+    ++stats_.views;
+    stats_.view_microseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::steady_clock::now() - start)
+                                    .count();
+}
 
-        norm_cube_mesh.bind(&gfx_);
-        gfx_.DrawIndexed(norm_cube_mesh.triangles.size());
+void SceneRenderer::build_render_graph(nodec_scene::Scene &scene) {
+    using namespace nodec_rendering::components;
+    using WriteMode = RenderGraph::WriteMode;
 
-        // // --- Render environment map.
-        // {
-        //     XMStoreFloat4x4(&cb_scene_properties.data().matrix_p, XMMatrixPerspectiveFovLH(XM_PI, 1.0f, 0.1f, 100.0f));
-        //     // XMStoreFloat4x4(&cb_scene_properties.data().matrix_p, XMMatrixIdentity());
-        //     XMStoreFloat4x4(&cb_scene_properties.data().matrix_p_inverse, XMMatrixIdentity());
-        //     XMStoreFloat4x4(&cb_scene_properties.data().matrix_v, XMMatrixIdentity());
-        //     XMStoreFloat4x4(&cb_scene_properties.data().matrix_v_inverse, XMMatrixIdentity());
-        //     cb_scene_properties.apply();
+    render_graph_.clear();
+    render_passes_.clear();
+    render_target_descs_.clear();
 
-        //     auto &environment = context.geometry_buffer("environment");
-        //     auto *target = &environment.render_target_view();
-        //     gfx_.context().OMSetRenderTargets(1, &target, nullptr);
+    const auto write_target = [&](RenderGraph::ResourceId resource, WriteMode mode, const RenderTargetDesc &desc) {
+        render_graph_.write(resource, mode);
+        if (render_target_descs_.size() <= resource) render_target_descs_.resize(resource + 1);
+        if (!render_target_descs_[resource]) render_target_descs_[resource] = desc;
+    };
 
-        //     gfx_.DrawIndexed(norm_cube_mesh.triangles.size());
+    const auto output = render_graph_.import_resource("$output", false);
 
-        //     XMStoreFloat4x4(&cb_scene_properties.data().matrix_p, matrix_p);
-        //     XMStoreFloat4x4(&cb_scene_properties.data().matrix_p_inverse, matrix_p_inverse);
-        //     XMStoreFloat4x4(&cb_scene_properties.data().matrix_v, matrix_v);
-        //     XMStoreFloat4x4(&cb_scene_properties.data().matrix_v_inverse, matrix_v_inverse);
+    // With the effects, the scene is drawn off-screen, and the last effect writes the output.
+    const auto scene_color = active_effects_.empty() ? output : render_graph_.resource("screen");
 
-        //     cb_scene_properties.apply();
-        // }
-    }();
+    // --- Skybox ---
+    skybox_material_ = nullptr;
+    {
+        auto view = scene.registry().view<SceneLighting>();
+        if (view.begin() != view.end()) {
+            const auto &lighting = view.get<SceneLighting>(*view.begin());
+            auto *material_backend = static_cast<MaterialBackend *>(lighting.skybox.get());
+            if (material_backend && material_backend->shader()) {
+                skybox_material_ = material_backend;
+            }
+        }
+    }
+    if (skybox_material_) {
+        // The cube around the camera covers the whole view, so the scene color needs no clear.
+        render_graph_.add_pass("skybox");
+        render_graph_.write(scene_color, WriteMode::Overwrite);
+        render_passes_.push_back({RenderPassWork::Type::Skybox, 0, 0});
+    }
 
-    renderer_context_.cb_model_properties().buffer().bind(SceneRenderingConstants::MODEL_PROPERTIES_CB_SLOT);
+    // --- Scene ---
+    // Split the sorted queue into the runs which share the shader and the transparency.
+    // The shader ids in the sort key are unique, so each shader makes one run per transparency.
+    shader_runs_.clear();
+    for (std::size_t run_begin = 0; run_begin < draw_queue_.size();) {
+        auto *shader = draw_commands_[draw_queue_[run_begin].command].material->shader_backend();
+        const bool is_transparent = DrawSortKey::is_transparent(draw_queue_[run_begin].key);
+
+        auto run_end = run_begin + 1;
+        for (; run_end < draw_queue_.size(); ++run_end) {
+            const auto &item = draw_queue_[run_end];
+            if (draw_commands_[item.command].material->shader_backend() != shader
+                || DrawSortKey::is_transparent(item.key) != is_transparent) {
+                break;
+            }
+        }
+        shader_runs_.push_back({run_begin, run_end, shader});
+        run_begin = run_end;
+    }
 
-    for (auto iter = draw_groups_.begin(); iter != draw_groups_.end();) {
-        auto &draw_group = iter->second;
-        auto shader = draw_group->shader.lock();
-        if (!shader) {
-            iter = draw_groups_.erase(iter);
-            continue;
+    for (std::size_t run_index = 0; run_index < shader_runs_.size(); ++run_index) {
+        auto *shader = shader_runs_[run_index].shader;
+        for (int pass_num = 0; pass_num < shader->pass_count(); ++pass_num) {
+            render_graph_.add_pass(shader->pass_name(pass_num));
+
+            for (const auto &name : shader->texture_resources(pass_num)) {
+                render_graph_.read(render_graph_.resource(name));
+            }
+
+            // The passes may discard the pixels, so the previous contents are kept.
+            const auto &targets = shader->render_targets(pass_num);
+            if (targets.empty()) {
+                render_graph_.write(scene_color, WriteMode::Partial);
+            }
+            for (const auto &name : targets) {
+                if (name == "$target") {
+                    render_graph_.write(scene_color, WriteMode::Partial);
+                    continue;
+                }
+                write_target(render_graph_.resource(name), WriteMode::Partial, shader->render_target_desc(pass_num, name));
+            }
+            render_passes_.push_back({RenderPassWork::Type::Shader, static_cast<std::uint32_t>(run_index), pass_num});
         }
+    }
+
+    // --- Post Processing ---
+    auto *upsample_shader = renderer_context_.bilateral_upsample_shader();
 
-        gfx_.context().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    // The effects ping-pong between "screen" and "screen_back". Each effect reads the result of the previous one as "screen".
+    auto screen = scene_color;
+    for (std::size_t effect_index = 0; effect_index < active_effects_.size(); ++effect_index) {
+        // It is assured that material and shader are exists.
+        auto *shader = static_cast<ShaderBackend *>(active_effects_[effect_index]->material->shader().get());
+
+        const auto next_screen = effect_index + 1 == active_effects_.size()
+                                     ? output
+                                     : render_graph_.resource(effect_index % 2 == 0 ? "screen_back" : "screen");
 
         for (int pass_num = 0; pass_num < shader->pass_count(); ++pass_num) {
-            // --- Set render target and view port --- //
-            auto &render_targets_name = shader->render_targets(pass_num);
+            // --- Upsample the low resolution targets the pass reads. ---
+            // Without the upsample shader, the pass reads the sources directly instead.
+            upsample_aliases_.clear();
+            for (const auto &upsample : shader->bilateral_upsamples(pass_num)) {
+                const auto source = render_graph_.resource(upsample.source);
+                if (!upsample_shader) {
+                    upsample_aliases_.push_back({upsample.target, source});
+                    continue;
+                }
+
+                RenderTargetDesc desc;
+                if (source < render_target_descs_.size() && render_target_descs_[source]) {
+                    desc.format = render_target_descs_[source]->format;
+                }
+
+                render_graph_.add_pass("bilateral_upsample");
+                render_graph_.read(source);
+                render_graph_.read(render_graph_.resource("depth"));
+                write_target(render_graph_.resource(upsample.target), WriteMode::Overwrite, desc);
+                render_passes_.push_back({RenderPassWork::Type::Upsample, 0, 0});
+            }
+
+            const auto resolve = [&](const std::string &name) {
+                if (name == "screen") return screen;
+                for (const auto &alias : upsample_aliases_) {
+                    if (alias.first == name) return alias.second;
+                }
+                return render_graph_.resource(name);
+            };
+
+            render_graph_.add_pass(shader->pass_name(pass_num));
 
-            std::vector<ID3D11RenderTargetView *> render_targets;
-            std::vector<D3D11_VIEWPORT> vps;
+            for (const auto &name : shader->texture_resources(pass_num)) {
+                render_graph_.read(resolve(name));
+            }
 
-            if (render_targets_name.size() == 0) {
-                render_targets.resize(1);
-                vps.resize(1);
-                render_targets[0] = render_target;
-                vps[0] = CD3D11_VIEWPORT(0.f, 0.f, static_cast<FLOAT>(context.target_width()), static_cast<FLOAT>(context.target_height()));
+            // The effect passes draw the full screen quad without discard.
+            if (pass_num == shader->pass_count() - 1) {
+                render_graph_.write(next_screen, WriteMode::Overwrite);
             } else {
-                render_targets.resize(render_targets_name.size());
-                vps.resize(render_targets_name.size());
-                for (int i = 0; i < render_targets_name.size(); ++i) {
-                    auto &name = render_targets_name[i];
-                    if (name == "$target") {
-                        render_targets[i] = render_target;
-                        vps[i] = CD3D11_VIEWPORT(0.f, 0.f, static_cast<FLOAT>(context.target_width()), static_cast<FLOAT>(context.target_height()));
-                        continue;
-                    }
-                    auto &buffer = context.geometry_buffer(name);
-                    render_targets[i] = &buffer.render_target_view();
-                    // gfx_.context().ClearRenderTargetView(render_targets[i], Vector4f::zero.v);
-                    vps[i] = CD3D11_VIEWPORT(0.f, 0.f, static_cast<FLOAT>(buffer.width()), static_cast<FLOAT>(buffer.height()));
+                for (const auto &name : shader->render_targets(pass_num)) {
+                    write_target(render_graph_.resource(name), WriteMode::Overwrite, shader->render_target_desc(pass_num, name));
                 }
             }
+            render_passes_.push_back({RenderPassWork::Type::Effect, static_cast<std::uint32_t>(effect_index), pass_num});
+        }
+        screen = next_screen;
+    }
 
-            ID3D11DepthStencilView *dsv = pass_num == 0 ? &context.depth_stencil_view() : nullptr;
+    render_target_descs_.resize(render_graph_.resources().size());
+}
 
-            gfx_.context().OMSetRenderTargets(static_cast<UINT>(render_targets.size()), render_targets.data(), dsv);
-            gfx_.context().RSSetViewports(static_cast<UINT>(vps.size()), vps.data());
+void SceneRenderer::execute_render_graph(const CompiledRenderGraph &compiled_graph,
+                                         const CameraState &camera_state,
+                                         ID3D11RenderTargetView &output, SceneRenderingContext &context) {
+    using namespace nodec;
+    using namespace nodec_rendering;
+    using namespace DirectX;
+
+    const auto &resources = render_graph_.resources();
+    const auto &passes = render_graph_.passes();
+    const auto &reads = render_graph_.reads();
+    const auto &writes = render_graph_.writes();
+
+    bound_targets_.assign(resources.size(), {});
+    bool is_output_written = false;
+
+    auto next_batch = instance_batcher_.batches().begin();
+    auto next_sprite_batch = sprite_batcher_.batches().begin();
+    auto bound_effect = (std::numeric_limits<std::uint32_t>::max)();
+
+    for (const auto &step : compiled_graph.steps()) {
+        // --- Bind the resources used first by the pass. ---
+        for (std::uint32_t i = 0; i < step.acquire_count; ++i) {
+            const auto &acquire = compiled_graph.acquires()[step.first_acquire + i];
+            const auto &resource = resources[acquire.resource];
+            auto &target = bound_targets_[acquire.resource];
+
+            std::uint64_t bytes = 0;
+            if (resource.imported) {
+                // The output is the only imported resource.
+                target = {&output, nullptr,
+                          static_cast<FLOAT>(context.target_width()), static_cast<FLOAT>(context.target_height())};
+                is_output_written = true;
+                if (acquire.clear) bytes = render_target_view_bytes(output);
+            } else {
+                const auto &desc = render_target_descs_[acquire.resource];
+                auto &buffer = desc ? context.geometry_buffer(resource.name, *desc) : context.geometry_buffer(resource.name);
+                target = {&buffer.render_target_view(), &buffer.shader_resource_view(),
+                          static_cast<FLOAT>(buffer.width()), static_cast<FLOAT>(buffer.height())};
+                bytes = RenderTargetPool::bytes_of(buffer);
+            }
+
+            // The clear is issued right before the first pass using it, and only if that pass leaves texels untouched.
+            if (acquire.clear) {
+                gfx_.context().ClearRenderTargetView(target.render_target_view, Vector4f::zero.v);
+                ++stats_.clears;
+                stats_.cleared_bytes += bytes;
+            }
+        }
+
+        const auto &pass = passes[step.pass];
+        const auto &work = render_passes_[step.pass];
+
+        // --- Set render target and view port --- //
+        // The writes nobody reads are bound to no target.
+        std::array<ID3D11RenderTargetView *, D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT> render_targets{};
+        std::array<D3D11_VIEWPORT, D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT> vps;
+        const UINT target_count = (std::min)(pass.write_count, static_cast<std::uint32_t>(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT));
+        for (UINT i = 0; i < target_count; ++i) {
+            const auto write_index = pass.first_write + i;
+            const auto &target = bound_targets_[writes[write_index].resource];
+            const bool is_live = compiled_graph.is_write_live(write_index);
+
+            render_targets[i] = is_live ? target.render_target_view : nullptr;
+            vps[i] = is_live ? CD3D11_VIEWPORT(0.f, 0.f, target.width, target.height)
+                             : CD3D11_VIEWPORT(0.f, 0.f, static_cast<FLOAT>(context.target_width()), static_cast<FLOAT>(context.target_height()));
+        }
+
+        ID3D11DepthStencilView *dsv = work.type == RenderPassWork::Type::Shader && work.pass_num == 0
+                                          ? &context.depth_stencil_view()
+                                          : nullptr;
+        gfx_.context().OMSetRenderTargets(target_count, render_targets.data(), dsv);
+        gfx_.context().RSSetViewports(target_count, vps.data());
+        // END Set render target and view port --- //
 
-            // END Set render target and view port --- //
+        switch (work.type) {
+        case RenderPassWork::Type::Skybox: {
+            auto *shader_backend = static_cast<ShaderBackend *>(skybox_material_->shader().get());
 
-            const auto &texture_resources_name = shader->texture_resources(pass_num);
-            for (int i = 0; i < texture_resources_name.size(); ++i) {
-                auto &buffer = context.geometry_buffer(texture_resources_name[i]);
-                auto *view = &buffer.shader_resource_view();
+            renderer_context_.bs_default().bind();
+            gfx_.context().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            shader_backend->bind();
+
+            renderer_context_.bind_material(skybox_material_);
+
+            auto &norm_cube_mesh = renderer_context_.norm_cube_mesh();
+            norm_cube_mesh.bind(&gfx_);
+            gfx_.DrawIndexed(norm_cube_mesh.index_count());
+            break;
+        }
+
+        case RenderPassWork::Type::Shader: {
+            const auto &run = shader_runs_[work.index];
+            auto *shader = run.shader;
+
+            for (std::uint32_t i = 0; i < pass.read_count; ++i) {
+                auto *view = bound_targets_[reads[pass.first_read + i]].shader_resource_view;
                 gfx_.context().PSSetShaderResources(i, 1u, &view);
             }
 
-            shader->bind(pass_num);
+            gfx_.context().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            shader->bind(work.pass_num);
+
+            if (work.pass_num == 0) {
+                // The batches of the culled runs are skipped.
+                while (next_batch != instance_batcher_.batches().end() && next_batch->begin < run.begin) ++next_batch;
+                while (next_sprite_batch != sprite_batcher_.batches().end() && next_sprite_batch->begin < run.begin) ++next_sprite_batch;
+
+                enum class Variant {
+                    Default,
+                    Instanced,
+                    Sprite
+                };
+                auto bound_variant = Variant::Default;
+
+                for (auto i = run.begin; i < run.end;) {
+                    const auto &command = draw_commands_[draw_queue_[i].command];
+                    const bool is_batch_begin = next_batch != instance_batcher_.batches().end() && next_batch->begin == i;
+                    const bool is_sprite_batch_begin = next_sprite_batch != sprite_batcher_.batches().end()
+                                                       && next_sprite_batch->begin == i;
+
+                    const auto variant = is_batch_begin          ? Variant::Instanced
+                                         : is_sprite_batch_begin ? Variant::Sprite
+                                                                 : Variant::Default;
+                    if (variant != bound_variant) {
+                        switch (variant) {
+                        case Variant::Instanced:
+                            shader->bind_instanced();
+                            break;
+                        case Variant::Sprite:
+                            shader->bind_sprite();
+                            break;
+                        default:
+                            shader->bind(work.pass_num);
+                            break;
+                        }
+                        bound_variant = variant;
+                    }
+
+                    if (is_batch_begin) {
+                        draw_mesh_instanced(command, *next_batch, renderer_context_, gfx_);
+                        i = next_batch->end;
+                        ++next_batch;
+                        continue;
+                    }
 
-            if (pass_num == 0) {
-                draw_group->draw_all(camera_state.matrix_v(), camera_state.matrix_p(), renderer_context_, gfx_);
+                    if (is_sprite_batch_begin) {
+                        draw_sprite_batch(command, *next_sprite_batch, sprite_vertex_buffer_, renderer_context_, gfx_);
+                        stats_.batched_sprites += next_sprite_batch->quad_count();
+                        ++stats_.sprite_batches;
+                        i = next_sprite_batch->end;
+                        ++next_sprite_batch;
+                        continue;
+                    }
+
+                    execute_draw_command(command, camera_state.matrix_v(), camera_state.matrix_p(), renderer_context_, gfx_);
+                    ++i;
+                }
             } else {
                 auto &screen_quad_mesh = renderer_context_.screen_quad_mesh();
                 screen_quad_mesh.bind(&gfx_);
-                gfx_.DrawIndexed(static_cast<UINT>(screen_quad_mesh.triangles.size()));
+                gfx_.DrawIndexed(screen_quad_mesh.index_count());
+            }
+            renderer_context_.unbind_all_shader_resources(pass.read_count);
+            break;
+        }
+
+        case RenderPassWork::Type::Upsample: {
+            // The source at the slot 0, and the depth as the guide at the slot 1.
+            auto *shader_backend = renderer_context_.bilateral_upsample_shader();
+
+            gfx_.context().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            renderer_context_.bs_default().bind();
+            for (std::uint32_t i = 0; i < pass.read_count; ++i) {
+                auto *view = bound_targets_[reads[pass.first_read + i]].shader_resource_view;
+                gfx_.context().PSSetShaderResources(i, 1u, &view);
             }
-            renderer_context_.unbind_all_shader_resources(static_cast<UINT>(texture_resources_name.size()));
+            shader_backend->bind();
+
+            auto &screen_quad_mesh = renderer_context_.screen_quad_mesh();
+            screen_quad_mesh.bind(&gfx_);
+            gfx_.DrawIndexed(screen_quad_mesh.index_count());
+            renderer_context_.unbind_all_shader_resources(pass.read_count);
+
+            // The effect binds its material again.
+            bound_effect = (std::numeric_limits<std::uint32_t>::max)();
+            break;
         }
 
-        draw_group->clear_draw_commands();
+        case RenderPassWork::Type::Effect: {
+            auto *material_backend = static_cast<MaterialBackend *>(active_effects_[work.index]->material.get());
+            auto *shader_backend = static_cast<ShaderBackend *>(material_backend->shader().get());
+            const auto slot_offset = static_cast<UINT>(material_backend->texture_entries().size());
+
+            if (bound_effect != work.index) {
+                gfx_.context().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+                renderer_context_.bs_default().bind();
+                // An upsample may have replaced the material textures.
+                renderer_context_.bind_material(material_backend, true);
+                bound_effect = work.index;
+            }
+
+            // --- Bind texture resources.
+            // Bind sampler for textures.
+            renderer_context_.sampler_state({Sampler::FilterMode::Bilinear, Sampler::WrapMode::Clamp}).BindPS(&gfx_, slot_offset);
+            for (std::uint32_t i = 0; i < pass.read_count; ++i) {
+                auto *view = bound_targets_[reads[pass.first_read + i]].shader_resource_view;
+                gfx_.context().PSSetShaderResources(slot_offset + i, 1u, &view);
+            }
+            shader_backend->bind(work.pass_num);
+
+            auto &screen_quad_mesh = renderer_context_.screen_quad_mesh();
+            screen_quad_mesh.bind(&gfx_);
+            gfx_.DrawIndexed(screen_quad_mesh.index_count());
+            renderer_context_.unbind_all_shader_resources(slot_offset, pass.read_count);
+
+            if (work.pass_num == shader_backend->pass_count() - 1) {
+                renderer_context_.unbind_all_shader_resources(slot_offset);
+            }
+            break;
+        }
+        }
+
+        // --- Return the resources used last by the pass. ---
+        for (std::uint32_t i = 0; i < step.release_count; ++i) {
+            const auto resource = compiled_graph.releases()[step.first_release + i];
+            context.release_geometry_buffer(resources[resource].name);
+            bound_targets_[resource] = {};
+        }
+    }
 
-        ++iter;
+    // Nothing is drawn in the view.
+    if (!is_output_written) {
+        gfx_.context().ClearRenderTargetView(&output, Vector4f::zero.v);
+        ++stats_.clears;
+        stats_.cleared_bytes += render_target_view_bytes(output);
     }
 }
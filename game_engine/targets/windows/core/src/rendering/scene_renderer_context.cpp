@@ -4,6 +4,9 @@ SceneRendererContext::SceneRendererContext(std::shared_ptr<nodec::logging::Logge
                                            nodec::resource_management::ResourceRegistry &resource_registry)
     : logger_(logger), gfx_(gfx),
       font_character_database_(&gfx),
+      glyph_source_(font_character_database_),
+      text_layout_cache_(&gfx, glyph_source_),
+      quad_index_buffer_(gfx),
       cb_scene_properties_(gfx),
       cb_model_properties_(gfx),
       cb_texture_config_(gfx), rs_cull_none_(gfx, D3D11_CULL_NONE),
@@ -39,6 +42,16 @@ SceneRendererContext::SceneRendererContext(std::shared_ptr<nodec::logging::Logge
         norm_cube_mesh_ = std::static_pointer_cast<MeshBackend>(norm_cube_mesh);
     }
 
+    // Without it, the passes read the low resolution targets with the bilinear filter instead.
+    {
+        auto shader = resource_registry.get_resource_direct<Shader>("org.nodec.game-engine/shaders/post-processings/bilateral-upsample");
+        if (!shader) {
+            logger_->warn(__FILE__, __LINE__) << "Cannot load the resource 'bilateral-upsample' shader. "
+                                                 "The low resolution passes are upsampled with the bilinear filter.";
+        }
+        bilateral_upsample_shader_ = std::static_pointer_cast<ShaderBackend>(shader);
+    }
+
     // Make screen quad mesh in NDC space which is not depend on target view size.
     {
         screen_quad_mesh_.reset(new MeshBackend());
@@ -3,7 +3,7 @@
 SceneRenderingContext::SceneRenderingContext(
     std::uint32_t target_width,
     std::uint32_t target_height, Graphics &gfx)
-    : gfx_(gfx), target_width_(target_width), target_height_(target_height) {
+    : gfx_(gfx), target_width_(target_width), target_height_(target_height), pool_(gfx) {
     {
         // Generate the depth stencil buffer texture.
         D3D11_TEXTURE2D_DESC depth_stencil_buffer_desc{};
@@ -37,4 +37,35 @@ SceneRenderingContext::SceneRenderingContext(
 
         shader_resource_views_["$depth"] = depth_stencil_srv_.Get();
     }
+}
+
+void SceneRenderingContext::begin_frame() {
+    release_geometry_buffers();
+
+    pool_.end_frame([&](GeometryBuffer &buffer) {
+        // Forget the views of the destroyed texture.
+        for (auto iter = shader_resource_views_.begin(); iter != shader_resource_views_.end();) {
+            if (iter->second == &buffer.shader_resource_view()) {
+                iter = shader_resource_views_.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    });
+
+    frame_names_.clear();
+    frame_requested_bytes_ = 0;
+}
+
+GeometryBuffer &SceneRenderingContext::bind_geometry_buffer(const std::string &name, const RenderTargetDesc &desc) {
+    auto &buffer = pool_.acquire(desc.format,
+                                 scaled_render_target_size(target_width_, desc.scale),
+                                 scaled_render_target_size(target_height_, desc.scale));
+    live_buffers_[name] = &buffer;
+    shader_resource_views_[name] = &buffer.shader_resource_view();
+
+    if (frame_names_.insert(name).second) {
+        frame_requested_bytes_ += RenderTargetPool::bytes_of(buffer);
+    }
+    return buffer;
 }
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include <rendering/scene_snapshot.hpp>
+
+#include <cstring>
+#include <limits>
+
+#include <nodec_rendering/components/non_visible.hpp>
+
+#include <rendering/parallel_chunks.hpp>
+
+struct SceneSnapshotActivity {
+    std::uint32_t mesh_source;
+
+    //! The capture the index belongs to. The older ones are stale.
+    std::uint64_t capture;
+};
+
+void SceneSnapshot::capture(nodec_scene::Scene &scene, TextLayoutCache &text_layout_cache,
+                            nodec::concurrent::ThreadPoolExecutor &executor, bool indexed) {
+    using namespace nodec;
+    using namespace nodec_scene;
+    using namespace nodec_scene::components;
+    using namespace nodec_rendering::components;
+    using namespace DirectX;
+
+    // The chunks smaller than this are not worth the dispatch.
+    constexpr std::size_t MIN_CHUNK_SIZE = 512;
+
+    ++capture_count_;
+    auto &scene_registry = scene.registry();
+
+    // --- Collect the mesh renderers. ---
+    mesh_sources_.clear();
+    std::size_t bounds_count = 0;
+    scene_registry.view<const MeshRenderer, const LocalToWorld>(type_list<NonVisible>{}).each([&](SceneEntity entity, const MeshRenderer &renderer, const LocalToWorld &local_to_world) {
+        if (renderer.meshes.size() != renderer.materials.size()) return;
+
+        mesh_sources_.push_back({entity, &renderer, &local_to_world, static_cast<std::uint32_t>(bounds_count)});
+        bounds_count += renderer.meshes.size();
+    });
+
+    if (indexed) {
+        for (std::size_t i = 0; i < mesh_sources_.size(); ++i) {
+            auto &activity = scene_registry.emplace_component<SceneSnapshotActivity>(mesh_sources_[i].entity).first;
+            activity.mesh_source = static_cast<std::uint32_t>(i);
+            activity.capture = capture_count_;
+        }
+    }
+
+    // --- Refresh the moved submesh bounds and combine them per renderer. ---
+    const auto source_count = mesh_sources_.size();
+    entity_world_bounds_.resize(source_count);
+    mesh_bounds_keys_.resize(bounds_count, {nullptr, {}});
+    submesh_world_bounds_.resize(bounds_count);
+
+    const ChunkPartition partition(source_count, MIN_CHUNK_SIZE);
+    run_chunks(executor, partition, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (auto source_index = begin; source_index < end; ++source_index) {
+            const auto &source = mesh_sources_[source_index];
+            const auto &matrix_m = source.local_to_world->value;
+
+            bool has_bounds = false;
+            for (std::size_t i = 0; i < source.renderer->meshes.size(); ++i) {
+                auto *mesh_backend = static_cast<MeshBackend *>(source.renderer->meshes[i].get());
+                if (!mesh_backend) continue;
+
+                const auto bounds_index = source.first_bounds + i;
+                auto &key = mesh_bounds_keys_[bounds_index];
+                if (key.mesh != mesh_backend || std::memcmp(key.matrix_m.m, matrix_m.m, sizeof(matrix_m.m)) != 0) {
+                    key.mesh = mesh_backend;
+                    key.matrix_m = matrix_m;
+                    submesh_world_bounds_.set(bounds_index, mesh_backend->bounds, XMMATRIX(matrix_m.m));
+                }
+
+                if (has_bounds) {
+                    entity_world_bounds_.merge(source_index, submesh_world_bounds_, bounds_index);
+                } else {
+                    entity_world_bounds_.copy(source_index, submesh_world_bounds_, bounds_index);
+                    has_bounds = true;
+                }
+            }
+
+            if (!has_bounds) {
+                entity_world_bounds_.set(source_index, nodec::gfx::BoundingBox(), XMMATRIX(matrix_m.m));
+            }
+        }
+    });
+
+    // --- Collect the images. ---
+    image_sources_.clear();
+    scene_registry.view<const ImageRenderer, const LocalToWorld>(type_list<NonVisible>{}).each([&](SceneEntity entity, const ImageRenderer &renderer, const LocalToWorld &local_to_world) {
+        auto *image_backend = static_cast<TextureBackend *>(renderer.image.get());
+        auto *material_backend = static_cast<MaterialBackend *>(renderer.material.get());
+        if (!image_backend || !material_backend) return;
+        if (!material_backend->shader_backend()) return;
+
+        const auto width = image_backend->width() / (renderer.pixels_per_unit + std::numeric_limits<float>::epsilon());
+        const auto height = image_backend->height() / (renderer.pixels_per_unit + std::numeric_limits<float>::epsilon());
+
+        image_sources_.push_back({&renderer, &local_to_world, image_backend, material_backend, width, height});
+    });
+
+    // --- Lay out the texts. ---
+    text_layout_cache.update(scene_registry);
+
+    text_sources_.clear();
+    scene_registry.view<const TextRenderer, const LocalToWorld>(type_list<NonVisible>{}).each([&](SceneEntity entity, const TextRenderer &renderer, const LocalToWorld &local_to_world) {
+        auto *material_backend = static_cast<MaterialBackend *>(renderer.material.get());
+        if (!material_backend || !renderer.font) return;
+        if (!material_backend->shader_backend()) return;
+
+        auto *text_layout = text_layout_cache.find(scene_registry, entity);
+        if (!text_layout || text_layout->quad_count() == 0) return;
+
+        text_sources_.push_back({&renderer, &local_to_world, text_layout});
+    });
+}
+
+std::int64_t SceneSnapshot::find_mesh_source(nodec_scene::SceneRegistry &scene_registry, nodec_scene::SceneEntity entity) const {
+    auto *activity = scene_registry.try_get_component<SceneSnapshotActivity>(entity);
+    if (!activity || activity->capture != capture_count_) return -1;
+    return activity->mesh_source;
+}
@@ -0,0 +1,164 @@
+#include <rendering/scene_spatial_index.hpp>
+
+#include <cstring>
+#include <functional>
+
+#include <nodec_rendering/components/mesh_renderer.hpp>
+#include <nodec_scene/components/local_to_world.hpp>
+
+#include <rendering/mesh_backend.hpp>
+
+struct SpatialIndexActivity {
+    std::uint32_t entry;
+
+    // The inputs of the bounds. The proxy is moved only when one of them changes.
+    nodec::Matrix4x4f matrix_m;
+    std::size_t meshes_hash;
+};
+
+namespace {
+
+std::size_t hash_meshes(const nodec_rendering::components::MeshRenderer &renderer) {
+    std::size_t hash = renderer.meshes.size();
+    for (const auto &mesh : renderer.meshes) {
+        hash ^= std::hash<const void *>()(mesh.get()) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+AabbTree::Box calculate_world_box(const nodec_rendering::components::MeshRenderer &renderer,
+                                  const nodec::Matrix4x4f &matrix_m) {
+    using namespace DirectX;
+
+    const auto matrix = XMMATRIX(matrix_m.m);
+    const auto abs_row0 = XMVectorAbs(matrix.r[0]);
+    const auto abs_row1 = XMVectorAbs(matrix.r[1]);
+    const auto abs_row2 = XMVectorAbs(matrix.r[2]);
+
+    bool has_bounds = false;
+    XMVECTOR min = XMVectorZero();
+    XMVECTOR max = XMVectorZero();
+    for (const auto &mesh : renderer.meshes) {
+        auto *mesh_backend = static_cast<MeshBackend *>(mesh.get());
+        if (!mesh_backend) continue;
+
+        const auto &bounds = mesh_backend->bounds;
+        const auto center = XMVector3Transform(
+            XMVectorSet(bounds.center.x, bounds.center.y, bounds.center.z, 1.0f), matrix);
+        const auto extents = XMVectorAdd(
+            XMVectorAdd(XMVectorScale(abs_row0, bounds.extents.x), XMVectorScale(abs_row1, bounds.extents.y)),
+            XMVectorScale(abs_row2, bounds.extents.z));
+
+        if (has_bounds) {
+            min = XMVectorMin(min, XMVectorSubtract(center, extents));
+            max = XMVectorMax(max, XMVectorAdd(center, extents));
+        } else {
+            min = XMVectorSubtract(center, extents);
+            max = XMVectorAdd(center, extents);
+            has_bounds = true;
+        }
+    }
+
+    // The renderer without any mesh is kept as a point, so that it can be found once a mesh is set.
+    if (!has_bounds) {
+        min = max = matrix.r[3];
+    }
+
+    AabbTree::Box box;
+    XMStoreFloat3(&box.min, min);
+    XMStoreFloat3(&box.max, max);
+    return box;
+}
+
+} // namespace
+
+std::uint32_t SceneSpatialIndex::allocate_entry() {
+    if (!free_entries_.empty()) {
+        const auto entry = free_entries_.back();
+        free_entries_.pop_back();
+        return entry;
+    }
+    entries_.push_back({});
+    return static_cast<std::uint32_t>(entries_.size() - 1);
+}
+
+void SceneSpatialIndex::update(nodec_scene::SceneRegistry &scene_registry) {
+    using namespace nodec;
+    using namespace nodec_scene;
+    using namespace nodec_scene::components;
+    using namespace nodec_rendering::components;
+
+    // --- Release the activities which are no longer indexed. ---
+    {
+        auto view = scene_registry.view<SpatialIndexActivity>(type_list<MeshRenderer>{});
+        scene_registry.remove_components<SpatialIndexActivity>(view.begin(), view.end());
+    }
+    {
+        auto view = scene_registry.view<SpatialIndexActivity>(type_list<LocalToWorld>{});
+        scene_registry.remove_components<SpatialIndexActivity>(view.begin(), view.end());
+    }
+
+    // --- Sweep the entries of the destroyed entities and the released activities. ---
+    // It runs before the new entries are allocated, so a freed entry is never referred by an activity.
+    for (std::uint32_t i = 0; i < entries_.size(); ++i) {
+        auto &entry = entries_[i];
+        if (entry.proxy == AabbTree::NULL_NODE) continue;
+
+        auto *activity = scene_registry.is_valid(entry.entity)
+                             ? scene_registry.try_get_component<SpatialIndexActivity>(entry.entity)
+                             : nullptr;
+        if (activity && activity->entry == i) continue;
+
+        tree_.destroy_proxy(entry.proxy);
+        entry.proxy = AabbTree::NULL_NODE;
+        free_entries_.push_back(i);
+    }
+
+    // --- Create the proxies of the new mesh renderers. ---
+    scene_registry.view<MeshRenderer, LocalToWorld>(type_list<SpatialIndexActivity>{})
+        .each([&](SceneEntity entity, MeshRenderer &renderer, LocalToWorld &local_to_world) {
+            auto &activity = scene_registry.emplace_component<SpatialIndexActivity>(entity).first;
+            activity.entry = allocate_entry();
+            activity.matrix_m = local_to_world.value;
+            activity.meshes_hash = hash_meshes(renderer);
+
+            auto &entry = entries_[activity.entry];
+            entry.entity = entity;
+            entry.box = calculate_world_box(renderer, local_to_world.value);
+            entry.proxy = tree_.create_proxy(entry.box, activity.entry);
+        });
+
+    // --- Move the proxies whose bounds have changed. ---
+    scene_registry.view<MeshRenderer, SpatialIndexActivity, LocalToWorld>()
+        .each([&](SceneEntity entity, MeshRenderer &renderer, SpatialIndexActivity &activity, LocalToWorld &local_to_world) {
+            const auto meshes_hash = hash_meshes(renderer);
+            if (activity.meshes_hash == meshes_hash
+                && std::memcmp(activity.matrix_m.m, local_to_world.value.m, sizeof(activity.matrix_m.m)) == 0) {
+                return;
+            }
+            activity.matrix_m = local_to_world.value;
+            activity.meshes_hash = meshes_hash;
+
+            auto &entry = entries_[activity.entry];
+            entry.box = calculate_world_box(renderer, local_to_world.value);
+            tree_.move_proxy(entry.proxy, entry.box);
+        });
+}
+
+bool SceneSpatialIndex::raycast(const DirectX::XMFLOAT3 &origin, const DirectX::XMFLOAT3 &direction, float max_distance,
+                                nodec_scene::SceneEntity &hit_entity, float &hit_distance) const {
+    bool hit = false;
+    tree_.raycast(origin, direction, max_distance, [&](std::uint32_t slot, float) {
+        // The fat box is only a conservative bound. Refine by the tight one.
+        const auto &entry = entries_[slot];
+        float distance;
+        if (!AabbTree::intersect_ray(entry.box, origin, direction, max_distance, distance)) return max_distance;
+
+        hit = true;
+        hit_entity = entry.entity;
+        hit_distance = distance;
+        max_distance = distance;
+        return max_distance;
+    });
+    return hit;
+}
@@ -0,0 +1,268 @@
+#include <rendering/text_layout_cache.hpp>
+
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include <nodec/unicode.hpp>
+
+#include <Font/FontBackend.hpp>
+#include <rendering/material_backend.hpp>
+#include <rendering/material_property_id.hpp>
+
+struct TextLayoutActivity {
+    std::uint32_t entry;
+};
+
+namespace {
+
+/**
+ * @brief Returns the baked SDF atlas to lay out the text with, or nullptr to render the glyphs at runtime.
+ */
+const SdfFont *find_sdf_font(TextGlyphSource &glyph_source, const nodec_rendering::components::TextRenderer &renderer) {
+    static const auto sdf_id = MaterialPropertyId::intern("sdf");
+
+    auto *font = renderer.font.get();
+    if (!font || !glyph_source.sdf_font(*font) || !glyph_source.sdf_texture(*font)) return nullptr;
+
+    auto *material = static_cast<MaterialBackend *>(renderer.material.get());
+    if (!material || !material->shader_backend()) return nullptr;
+    if (!material->shader_backend()->get_texture_slot(sdf_id)) return nullptr;
+
+    return glyph_source.sdf_font(*font);
+}
+
+std::size_t hash_source(TextGlyphSource &glyph_source, const nodec_rendering::components::TextRenderer &renderer) {
+    std::size_t hash = std::hash<std::string>()(renderer.text);
+    const auto combine = [&](std::size_t value) {
+        hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+    combine(std::hash<const void *>()(renderer.font.get()));
+    combine(std::hash<int>()(renderer.pixel_size));
+    combine(std::hash<int>()(renderer.pixels_per_unit));
+    combine(std::hash<const void *>()(find_sdf_font(glyph_source, renderer)));
+    return hash;
+}
+
+} // namespace
+
+const FontCharacter &FontBackendGlyphSource::character(nodec_rendering::resources::Font &font, std::uint16_t pixel_size, std::uint32_t code) {
+    return font_character_database_.Get(static_cast<FontBackend &>(font).GetFace(), pixel_size, code);
+}
+
+const GlyphAtlas::Rect *FontBackendGlyphSource::atlas_rect(nodec_rendering::resources::Font &font, std::uint16_t pixel_size, std::uint32_t code) {
+    return font_character_database_.GetAtlasRect(static_cast<FontBackend &>(font).GetFace(), pixel_size, code);
+}
+
+const SdfFont *FontBackendGlyphSource::sdf_font(nodec_rendering::resources::Font &font) {
+    return static_cast<FontBackend &>(font).GetSdfFont();
+}
+
+TextureBackend *FontBackendGlyphSource::sdf_texture(nodec_rendering::resources::Font &font) {
+    return static_cast<FontBackend &>(font).GetSdfTexture();
+}
+
+std::uint32_t TextLayoutCache::allocate_entry() {
+    if (!free_entries_.empty()) {
+        const auto entry = free_entries_.back();
+        free_entries_.pop_back();
+        return entry;
+    }
+    entries_.emplace_back();
+    return static_cast<std::uint32_t>(entries_.size() - 1);
+}
+
+void TextLayoutCache::update(nodec_scene::SceneRegistry &scene_registry) {
+    using namespace nodec;
+    using namespace nodec_scene;
+    using namespace nodec_rendering::components;
+
+    // --- Release the activities of the removed text renderers. ---
+    {
+        auto view = scene_registry.view<TextLayoutActivity>(type_list<TextRenderer>{});
+        scene_registry.remove_components<TextLayoutActivity>(view.begin(), view.end());
+    }
+
+    // --- Sweep the layouts of the destroyed entities and the released activities. ---
+    for (std::uint32_t i = 0; i < entries_.size(); ++i) {
+        auto &layout = entries_[i];
+        if (layout.entity == nodec::entities::null_entity) continue;
+
+        auto *activity = scene_registry.is_valid(layout.entity)
+                             ? scene_registry.try_get_component<TextLayoutActivity>(layout.entity)
+                             : nullptr;
+        if (activity && activity->entry == i) continue;
+
+        layout.entity = nodec::entities::null_entity;
+        layout.glyphs.clear();
+        layout.vertex_buffer.reset();
+        free_entries_.push_back(i);
+    }
+
+    // --- Lay out the new text renderers. ---
+    scene_registry.view<TextRenderer>(type_list<TextLayoutActivity>{})
+        .each([&](SceneEntity entity, TextRenderer &renderer) {
+            auto &activity = scene_registry.emplace_component<TextLayoutActivity>(entity).first;
+            activity.entry = allocate_entry();
+
+            auto &layout = entries_[activity.entry];
+            layout.entity = entity;
+            rebuild(layout, renderer, hash_source(glyph_source_, renderer));
+        });
+
+    // --- Rebuild the layouts whose source has changed. ---
+    scene_registry.view<TextRenderer, TextLayoutActivity>()
+        .each([&](SceneEntity entity, TextRenderer &renderer, TextLayoutActivity &activity) {
+            auto &layout = entries_[activity.entry];
+            const auto source_hash = hash_source(glyph_source_, renderer);
+            if (layout.source_hash == source_hash) return;
+
+            rebuild(layout, renderer, source_hash);
+        });
+}
+
+TextLayout *TextLayoutCache::find(nodec_scene::SceneRegistry &scene_registry, nodec_scene::SceneEntity entity) {
+    auto *activity = scene_registry.try_get_component<TextLayoutActivity>(entity);
+    if (!activity) return nullptr;
+    return &entries_[activity->entry];
+}
+
+void TextLayoutCache::rebuild(TextLayout &layout, const nodec_rendering::components::TextRenderer &renderer,
+                              std::size_t source_hash) {
+    layout.source_hash = source_hash;
+    layout.glyphs.clear();
+    layout.sdf_texture = nullptr;
+    layout.resolved = false;
+    ++rebuild_count_;
+
+    auto *font = renderer.font.get();
+    if (!font || renderer.pixel_size <= 0 || renderer.pixels_per_unit <= 0) return;
+
+    const auto u32_text = nodec::unicode::utf8to32<std::u32string>(renderer.text);
+    const float pixels_per_unit = static_cast<float>(renderer.pixels_per_unit);
+    const auto pixel_size = static_cast<std::uint16_t>(renderer.pixel_size);
+
+    const auto *sdf_font = find_sdf_font(glyph_source_, renderer);
+    if (sdf_font) {
+        layout.sdf_texture = glyph_source_.sdf_texture(*font);
+    }
+
+    float offset_x = 0.0f;
+    float offset_y = 0.0f;
+
+    for (const auto &chCode : u32_text) {
+        if (chCode == '\n') {
+            offset_y -= pixel_size / pixels_per_unit;
+            offset_x = 0.0f;
+            continue;
+        }
+
+        const auto *sdf_glyph = sdf_font ? sdf_font->find(chCode) : nullptr;
+        if (sdf_glyph) {
+            // The baked metrics are scaled to the pixel size. The quad covers the spread border too.
+            const float scale = static_cast<float>(pixel_size) / sdf_font->pixel_size / pixels_per_unit;
+            const float spread = sdf_font->spread;
+
+            float pos_x = offset_x + (sdf_glyph->bearing_x - spread) * scale;
+            float pos_y = offset_y - (sdf_glyph->bitmap_height - sdf_glyph->bearing_y + spread) * scale;
+
+            offset_x += (sdf_glyph->advance / 64.0f) * scale;
+
+            if (sdf_glyph->bitmap_width == 0) continue;
+
+            layout.glyphs.push_back({static_cast<std::uint32_t>(chCode), pos_x, pos_y,
+                                     sdf_glyph->width * scale, sdf_glyph->height * scale,
+                                     {sdf_glyph->x, sdf_glyph->y, sdf_glyph->width, sdf_glyph->height}});
+            continue;
+        }
+
+        if (sdf_font) {
+            // The character is not in the baked set. Keep the spacing, but draw nothing.
+            offset_x += (glyph_source_.character(*font, pixel_size, chCode).advance >> 6) / pixels_per_unit;
+            continue;
+        }
+
+        const auto &character = glyph_source_.character(*font, pixel_size, chCode);
+
+        float pos_x = offset_x + character.bearing.x / pixels_per_unit;
+        float pos_y = offset_y - (character.size.y - character.bearing.y) / pixels_per_unit;
+        float w = character.size.x / pixels_per_unit;
+        float h = character.size.y / pixels_per_unit;
+
+        offset_x += (character.advance >> 6) / pixels_per_unit;
+
+        if (!character.has_bitmap) {
+            continue;
+        }
+
+        layout.glyphs.push_back({static_cast<std::uint32_t>(chCode), pos_x, pos_y, w, h, {}});
+    }
+}
+
+void TextLayoutCache::resolve(TextLayout &layout, const nodec_rendering::components::TextRenderer &renderer) {
+    if (layout.sdf_texture) {
+        // The baked atlas never moves its glyphs, so the rectangles are set by the rebuild.
+        if (layout.resolved) return;
+        layout.resolved = true;
+        build_vertices(layout, layout.sdf_texture->width(), layout.sdf_texture->height());
+        return;
+    }
+
+    const auto &atlas = glyph_source_.atlas();
+    if (layout.resolved && layout.atlas_eviction_count == atlas.eviction_count()) return;
+
+    auto *font = renderer.font.get();
+    if (!font) return;
+    const auto pixel_size = static_cast<std::uint16_t>(renderer.pixel_size);
+
+    // Skip the upload when no glyph has moved.
+    bool changed = !layout.resolved;
+    for (auto &glyph : layout.glyphs) {
+        // The glyph which does not fit in the atlas is left as an empty quad.
+        auto *rect = glyph_source_.atlas_rect(*font, pixel_size, glyph.code);
+        const auto atlas_rect = rect ? *rect : GlyphAtlas::Rect{0, 0, 0, 0};
+        if (std::memcmp(&atlas_rect, &glyph.atlas_rect, sizeof(atlas_rect)) != 0) {
+            glyph.atlas_rect = atlas_rect;
+            changed = true;
+        }
+    }
+
+    // Resolving may evict the other glyphs, so take the count after it.
+    layout.atlas_eviction_count = atlas.eviction_count();
+    layout.resolved = true;
+    if (!changed) return;
+
+    build_vertices(layout, atlas.width(), atlas.height());
+}
+
+void TextLayoutCache::build_vertices(TextLayout &layout, int atlas_width, int atlas_height) {
+    const float atlas_texel_u = 1.0f / atlas_width;
+    const float atlas_texel_v = 1.0f / atlas_height;
+
+    // The bitmap rows go from the top, so v grows downward.
+    const nodec::Vector3f normal{0.0f, 0.0f, -1.0f};
+    const nodec::Vector3f tangent{0.0f, 0.0f, 0.0f};
+
+    vertices_.clear();
+    for (const auto &glyph : layout.glyphs) {
+        const auto &rect = glyph.atlas_rect;
+        const float u0 = rect.x * atlas_texel_u;
+        const float v0 = rect.y * atlas_texel_v;
+        const float u1 = (rect.x + rect.width) * atlas_texel_u;
+        const float v1 = (rect.y + rect.height) * atlas_texel_v;
+
+        vertices_.push_back({{glyph.x, glyph.y, 0.0f}, normal, {u0, v1}, tangent});
+        vertices_.push_back({{glyph.x, glyph.y + glyph.height, 0.0f}, normal, {u0, v0}, tangent});
+        vertices_.push_back({{glyph.x + glyph.width, glyph.y + glyph.height, 0.0f}, normal, {u1, v0}, tangent});
+        vertices_.push_back({{glyph.x + glyph.width, glyph.y, 0.0f}, normal, {u1, v1}, tangent});
+    }
+
+    layout.vertex_buffer.reset();
+    if (vertices_.empty()) return;
+
+    layout.vertex_buffer.reset(new VertexBuffer(
+        gfx_,
+        static_cast<UINT>(vertices_.size() * sizeof(MeshBackend::Vertex)),
+        sizeof(MeshBackend::Vertex),
+        vertices_.data()));
+}
@@ -0,0 +1,167 @@
+#include <resources/load_scheduler.hpp>
+
+#include <algorithm>
+
+LoadScheduler::LoadScheduler(std::size_t worker_count,
+                             std::function<void()> on_worker_begin,
+                             std::function<void()> on_worker_end)
+    : on_worker_begin_(std::move(on_worker_begin)), on_worker_end_(std::move(on_worker_end)) {
+    if (worker_count == 0) {
+        const auto hardware_thread_count = std::thread::hardware_concurrency();
+        worker_count = hardware_thread_count > 1 ? hardware_thread_count - 1 : 1;
+    }
+
+    workers_.reserve(worker_count);
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        workers_.emplace_back([this]() { run_worker(); });
+    }
+}
+
+LoadScheduler::~LoadScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+
+    // The workers are gone and the started loads have finished, so the remaining requests are the ones never started.
+    for (auto &pair : in_flight_) {
+        for (auto &waiter : pair.second->waiters) {
+            waiter.completion(nullptr);
+        }
+    }
+}
+
+void LoadScheduler::schedule(const std::type_info &type, const std::string &key, LoadPriority priority,
+                             const CancellationToken &token, Load load, Completion completion) {
+    if (token.is_cancelled()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.requests;
+            ++stats_.cancelled;
+        }
+        completion(nullptr);
+        return;
+    }
+
+    std::string request_key = type.name();
+    request_key += '\n';
+    request_key += key;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.requests;
+
+        auto iter = in_flight_.find(request_key);
+        if (iter != in_flight_.end()) {
+            auto &request = iter->second;
+            request->waiters.push_back({token, std::move(completion)});
+            ++stats_.deduplicated;
+
+            if (!request->started && priority < request->priority) {
+                request->priority = priority;
+                queues_[static_cast<std::size_t>(priority)].push_back(request);
+            }
+            return;
+        }
+
+        auto request = std::make_shared<Request>();
+        request->key = request_key;
+        request->load = std::move(load);
+        request->waiters.push_back({token, std::move(completion)});
+        request->priority = priority;
+        request->scheduled_at = std::chrono::steady_clock::now();
+
+        in_flight_.emplace(request_key, request);
+        queues_[static_cast<std::size_t>(priority)].push_back(std::move(request));
+    }
+    condition_.notify_one();
+}
+
+LoadSchedulerStats LoadScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::shared_ptr<LoadScheduler::Request> LoadScheduler::pop_request(std::unique_lock<std::mutex> &lock) {
+    while (true) {
+        condition_.wait(lock, [&]() {
+            return stopping_ || std::any_of(queues_.begin(), queues_.end(), [](auto &queue) { return !queue.empty(); });
+        });
+        if (stopping_) return nullptr;
+
+        for (std::size_t priority = 0; priority < LOAD_PRIORITY_COUNT; ++priority) {
+            auto &queue = queues_[priority];
+            while (!queue.empty()) {
+                auto request = std::move(queue.front());
+                queue.pop_front();
+
+                // The stale entry of an upgraded request.
+                if (request->started) continue;
+                request->started = true;
+
+                const auto latency = std::chrono::steady_clock::now() - request->scheduled_at;
+                stats_.queue_latency[priority].record(
+                    std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+                return request;
+            }
+        }
+    }
+}
+
+void LoadScheduler::finish_request(const std::shared_ptr<Request> &request, const std::shared_ptr<void> &result) {
+    std::vector<Waiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // The requests arriving from now start a new load.
+        in_flight_.erase(request->key);
+        waiters = std::move(request->waiters);
+    }
+
+    for (auto &waiter : waiters) {
+        waiter.completion(waiter.token.is_cancelled() ? nullptr : result);
+    }
+}
+
+void LoadScheduler::run_worker() {
+    if (on_worker_begin_) on_worker_begin_();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (auto request = pop_request(lock)) {
+        const bool abandoned = std::all_of(request->waiters.begin(), request->waiters.end(),
+                                           [](const Waiter &waiter) { return waiter.token.is_cancelled(); });
+        if (abandoned) {
+            ++stats_.cancelled;
+        } else {
+            ++stats_.loads;
+        }
+        lock.unlock();
+
+        if (abandoned) {
+            finish_request(request, nullptr);
+        } else {
+            auto finished = std::make_shared<std::atomic<bool>>(false);
+            Completion finish = [this, request, finished](const std::shared_ptr<void> &result) {
+                if (finished->exchange(true)) return;
+                finish_request(request, result);
+            };
+
+            try {
+                request->load(finish);
+            } catch (...) {
+                // The loaders report their own failures. The requesters see null.
+                finish(nullptr);
+            }
+        }
+
+        lock.lock();
+    }
+    lock.unlock();
+
+    if (on_worker_end_) on_worker_end_();
+}
@@ -0,0 +1,166 @@
+#include <resources/resource_file_system.hpp>
+
+#include <filesystem>
+#include <streambuf>
+#include <vector>
+
+#include <resources/mapped_file.hpp>
+
+namespace {
+
+/**
+ * @brief The read-only stream buffer over the memory.
+ */
+class MemoryStreamBuffer : public std::streambuf {
+public:
+    MemoryStreamBuffer(const void *data, std::size_t size) {
+        auto *begin = const_cast<char *>(static_cast<const char *>(data));
+        setg(begin, begin, begin + size);
+    }
+
+protected:
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override {
+        if (!(which & std::ios_base::in)) return pos_type(off_type(-1));
+
+        off_type base = 0;
+        switch (direction) {
+        case std::ios_base::beg: base = 0; break;
+        case std::ios_base::cur: base = gptr() - eback(); break;
+        case std::ios_base::end: base = egptr() - eback(); break;
+        default: return pos_type(off_type(-1));
+        }
+
+        const auto position = base + offset;
+        if (position < 0 || position > egptr() - eback()) return pos_type(off_type(-1));
+        setg(eback(), eback() + position, egptr());
+        return pos_type(position);
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override {
+        return seekoff(off_type(position), std::ios_base::beg, which);
+    }
+};
+
+class ResourceFileStream : public std::istream {
+public:
+    explicit ResourceFileStream(std::shared_ptr<const ResourceFile> file)
+        : std::istream(nullptr), file_(std::move(file)), buffer_(file_->data(), file_->size()) {
+        rdbuf(&buffer_);
+    }
+
+private:
+    std::shared_ptr<const ResourceFile> file_;
+    MemoryStreamBuffer buffer_;
+};
+
+std::string normalize_path(const std::string &path) {
+    std::string normalized = path;
+    for (auto &c : normalized) {
+        if (c == '\\') c = '/';
+    }
+    return normalized;
+}
+
+/**
+ * @brief Maps the loose file. Null if it is missing or cannot be opened.
+ */
+std::shared_ptr<const ResourceFile> read_loose_file(const std::string &path) {
+    std::error_code error;
+    const auto size = std::filesystem::file_size(std::filesystem::u8path(path), error);
+    if (error) return nullptr;
+    if (size == 0) return std::make_shared<ResourceFile>(nullptr, nullptr, 0);
+
+    std::shared_ptr<MappedFile> mapped;
+    try {
+        mapped = std::make_shared<MappedFile>(path);
+    } catch (...) {
+        return nullptr;
+    }
+    return std::make_shared<ResourceFile>(mapped, mapped->data(), mapped->size());
+}
+
+} // namespace
+
+std::unique_ptr<std::istream> open_stream(std::shared_ptr<const ResourceFile> file) {
+    return std::make_unique<ResourceFileStream>(std::move(file));
+}
+
+ResourceFileSystem::ResourceFileSystem() = default;
+
+ResourceFileSystem::~ResourceFileSystem() = default;
+
+void ResourceFileSystem::mount(const std::string &root, const std::string &archive_path) {
+    auto archive = std::make_shared<Archive>();
+    archive->root = normalize_path(root);
+    while (!archive->root.empty() && archive->root.back() == '/') archive->root.pop_back();
+    archive->root += '/';
+
+    archive->file = std::make_shared<MappedFile>(archive_path);
+    archive->view = resource_archive::parse_archive(archive->file->data(), archive->file->size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    archive_ = std::move(archive);
+}
+
+void ResourceFileSystem::unmount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    archive_.reset();
+}
+
+std::size_t ResourceFileSystem::archive_entry_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return archive_ ? archive_->view.header->entry_count : 0;
+}
+
+std::pair<std::shared_ptr<const ResourceFileSystem::Archive>, const resource_archive::IndexEntry *>
+ResourceFileSystem::find(const std::string &path) const {
+    std::shared_ptr<const Archive> archive;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        archive = archive_;
+    }
+    if (!archive) return {};
+
+    const auto normalized = normalize_path(path);
+    if (normalized.compare(0, archive->root.size(), archive->root) != 0) return {};
+
+    const auto *entry = resource_archive::find_entry(archive->view, normalized.substr(archive->root.size()));
+    if (!entry) return {};
+    return {std::move(archive), entry};
+}
+
+std::shared_ptr<const ResourceFile> ResourceFileSystem::read(const std::string &path) const {
+    using namespace resource_archive;
+
+    // The loose file shadows the packed one, so the edits made after the packing are seen.
+    if (auto loose = read_loose_file(path)) return loose;
+
+    auto found = find(path);
+    if (!found.second) return nullptr;
+
+    const auto &archive = found.first;
+    const auto &entry = *found.second;
+    const auto *stored = archive->view.data + entry.offset;
+
+    if (entry.compression == static_cast<std::uint8_t>(Compression::None)) {
+        // Points into the mapping, which the file keeps alive.
+        return std::make_shared<ResourceFile>(archive, stored, static_cast<std::size_t>(entry.stored_size));
+    }
+
+    auto data = std::make_shared<std::vector<std::uint8_t>>(static_cast<std::size_t>(entry.size));
+    lz4_block::decompress(stored, static_cast<std::size_t>(entry.stored_size), data->data(), data->size());
+    return std::make_shared<ResourceFile>(data, data->data(), data->size());
+}
+
+std::unique_ptr<std::istream> ResourceFileSystem::open(const std::string &path) const {
+    auto file = read(path);
+    if (!file) return nullptr;
+    return open_stream(std::move(file));
+}
+
+bool ResourceFileSystem::exists(const std::string &path) const {
+    std::error_code error;
+    if (std::filesystem::is_regular_file(std::filesystem::u8path(path), error)) return true;
+
+    return find(path).second != nullptr;
+}
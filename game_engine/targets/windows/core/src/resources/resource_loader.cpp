@@ -1,8 +1,11 @@
 #include <resources/resource_loader.hpp>
 
-#include <fstream>
 #include <limits>
 
+#include <cereal/archives/json.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
 #include <nodec_animation/serialization/resources/animation_clip.hpp>
 #include <nodec_rendering/serialization/resources/material.hpp>
 #include <nodec_rendering/serialization/resources/mesh.hpp>
@@ -14,28 +17,63 @@
 #include <rendering/image_texture.hpp>
 #include <rendering/material_backend.hpp>
 #include <rendering/mesh_backend.hpp>
+#include <rendering/mesh_file.hpp>
 #include <rendering/shader_backend.hpp>
+#include <rendering/shader_descriptor.hpp>
+#include <rendering/shader_meta.hpp>
 #include <rendering/texture_backend.hpp>
 #include <scene_audio/audio_clip_backend.hpp>
 
 template<>
-std::shared_ptr<MeshBackend>
-ResourceLoader::load_backend<MeshBackend>(const std::string &path) const noexcept {
+StagedResource<MeshBackend>
+ResourceLoader::decode_backend<MeshBackend>(const std::string &path) const noexcept {
     using namespace nodec_rendering::resources;
     using namespace nodec;
 
-    std::ifstream file(path, std::ios::binary);
-
+    // The mesh file is uploaded straight from the mapped pages (or the decompressed archive entry), kept until the upload.
+    auto file = read_file(path);
     if (!file) {
         logger_->warn(__FILE__, __LINE__) << "Failed to open resource file. path: " << path;
-        // return empty mesh.
         return {};
     }
 
-    cereal::PortableBinaryInputArchive archive(file);
+    if (mesh_file::is_mesh_file(file->data(), file->size())) {
+        auto mesh = std::make_shared<MeshBackend>();
+        mesh_file::View view{};
+        try {
+            view = mesh_file::parse_mesh_file(file->data(), file->size());
+        } catch (...) {
+            HandleException(Formatter() << "Mesh::" << path);
+            return {};
+        }
+
+        const auto &header = *view.header;
+        mesh->bounds.center = Vector3f(header.bounds_center[0], header.bounds_center[1], header.bounds_center[2]);
+        mesh->bounds.extents = Vector3f(header.bounds_extents[0], header.bounds_extents[1], header.bounds_extents[2]);
+
+        const auto format = static_cast<VertexFormat>(header.vertex_format);
+        const auto upload_bytes = static_cast<std::uint64_t>(header.vertex_count) * vertex_stride(format)
+                                  + static_cast<std::uint64_t>(header.index_count) * header.index_size;
+
+        auto upload = [this, path, mesh, file, view, format]() {
+            const auto &header = *view.header;
+            try {
+                mesh->update_device_memory(&gfx_, format, view.vertices, header.vertex_count,
+                                           view.indices, header.index_count, header.index_size == 4);
+            } catch (...) {
+                HandleException(Formatter() << "Mesh::" << path);
+                return false;
+            }
+            return true;
+        };
+        return {mesh, upload, upload_bytes, upload_bytes};
+    }
 
+    // The others are the cereal meshes exported before the mesh file.
     SerializableMesh source;
     try {
+        auto stream = open_stream(std::move(file));
+        cereal::PortableBinaryInputArchive archive(*stream);
         archive(source);
     } catch (...) {
         HandleException(Formatter() << "Mesh::" << path);
@@ -58,20 +96,36 @@ ResourceLoader::load_backend<MeshBackend>(const std::string &path) const noexcep
         if (src.position.y > max.y) max.y = src.position.y;
         if (src.position.z > max.z) max.z = src.position.z;
     }
-    mesh->triangles = source.triangles;
+    mesh->triangles.assign(source.triangles.begin(), source.triangles.end());
 
     bounds.center = (min + max) / 2.0f;
     bounds.extents = (max - min) / 2.0f;
     mesh->bounds = bounds;
 
-    try {
-        mesh->update_device_memory(&gfx_);
-    } catch (...) {
-        HandleException(Formatter() << "Mesh::" << path);
-        return {};
-    }
+    const auto upload_bytes = static_cast<std::uint64_t>(mesh->vertices.size()) * vertex_stride(mesh->vertex_format)
+                              + static_cast<std::uint64_t>(mesh->triangles.size()) * sizeof(std::uint32_t);
+
+    // The vertices and the triangles stay on the CPU too.
+    const auto memory_bytes = upload_bytes
+                              + static_cast<std::uint64_t>(mesh->vertices.size()) * sizeof(MeshBackend::Vertex)
+                              + static_cast<std::uint64_t>(mesh->triangles.size()) * sizeof(std::uint32_t);
+
+    auto upload = [this, path, mesh]() {
+        try {
+            mesh->update_device_memory(&gfx_);
+        } catch (...) {
+            HandleException(Formatter() << "Mesh::" << path);
+            return false;
+        }
+        return true;
+    };
+    return {mesh, upload, upload_bytes, memory_bytes};
+}
 
-    return mesh;
+template<>
+std::shared_ptr<MeshBackend>
+ResourceLoader::load_backend<MeshBackend>(const std::string &path) const noexcept {
+    return upload_now(decode_backend<MeshBackend>(path));
 }
 
 template<>
@@ -80,46 +134,116 @@ ResourceLoader::load_backend<ShaderBackend>(const std::string &path) const noexc
     using namespace nodec;
     using namespace nodec_rendering::resources;
 
-    std::ifstream file(Formatter() << path << "/shader.meta", std::ios::binary);
+    shader_descriptor::ShaderDescriptor descriptor;
+    try {
+        const auto open_meta = [&](const std::string &name) {
+            return open_file(Formatter() << path << "/" << name);
+        };
+
+        // The descriptor compiled offline is one file without the JSON parsing.
+        // It is used only while the metas are the ones it was compiled from.
+        // The shaders without it, or with an outdated one, are read from the authoring metas.
+        bool is_compiled = false;
+        if (auto compiled = read_file(Formatter() << path << "/" << shader_descriptor::FILE_NAME)) {
+            std::string details = "The metas were edited after it was compiled.";
+            try {
+                descriptor = shader_descriptor::read_shader_descriptor(compiled->data(), compiled->size());
+                is_compiled = descriptor.source_hash == shader_meta::hash_shader_metas(descriptor, open_meta);
+            } catch (std::exception &e) {
+                details = e.what();
+            }
+
+            if (!is_compiled) {
+                logger_->warn(__FILE__, __LINE__)
+                    << "The shader descriptor is out of date. The metas are read instead. "
+                    << "Run the shader-meta-compiler again. path: " << path << "\n"
+                    << "details: " << details;
+            }
+        }
 
-    if (!file) {
-        logger_->warn(__FILE__, __LINE__) << "Failed to open resource file. path: " << path;
-        // return empty mesh.
+        if (!is_compiled) {
+            descriptor = shader_meta::compile_shader_meta(open_meta);
+        }
+    } catch (...) {
+        HandleException(Formatter() << "Shader::" << path);
         return {};
     }
 
+    // The metas may be ahead of the compiled shaders, like when a pass was added and fxc has not run yet.
+    const auto missingPass = shader_descriptor::drop_unbuilt_passes(descriptor, [&](const std::string &name) {
+        return files_.exists(Formatter() << path << "/" << name << "_vs.cso")
+               && files_.exists(Formatter() << path << "/" << name << "_ps.cso");
+    });
+    if (!missingPass.empty()) {
+        logger_->warn(__FILE__, __LINE__) << "The pass '" << missingPass << "' is not compiled. "
+                                          << "The passes before it are drawn to the screen instead. path: " << path;
+    }
+
     ShaderMetaInfo metaInfo;
-    try {
-        cereal::JSONInputArchive archive(file);
-        archive(metaInfo);
-    } catch (...) {
-        HandleException(Formatter() << "Shader::" << path);
-        return {};
+    metaInfo.rendering_priority = descriptor.rendering_priority;
+    for (const auto &source : descriptor.float_properties) {
+        ShaderMetaInfo::FloatProperty property;
+        property.name = source.name;
+        property.default_value = source.default_value;
+        metaInfo.float_properties.push_back(std::move(property));
+    }
+    for (const auto &source : descriptor.vector4_properties) {
+        ShaderMetaInfo::Vector4Property property;
+        property.name = source.name;
+        property.default_value = Vector4f(source.default_value[0], source.default_value[1],
+                                          source.default_value[2], source.default_value[3]);
+        metaInfo.vector4_properties.push_back(std::move(property));
+    }
+    for (const auto &name : descriptor.texture_entries) {
+        ShaderMetaInfo::TextureEntry entry;
+        entry.name = name;
+        metaInfo.texture_entries.push_back(std::move(entry));
     }
 
     std::vector<SubShaderMetaInfo> subShaderMetaInfos;
-    for (const auto &subShaderName : metaInfo.pass) {
-        std::ifstream file(Formatter() << path << "/" << subShaderName << ".meta");
-        if (!file) return {};
+    for (const auto &pass : descriptor.passes) {
+        metaInfo.pass.push_back(pass.name);
+
         SubShaderMetaInfo info;
-        try {
-            cereal::JSONInputArchive archive(file);
-            archive(info);
-            subShaderMetaInfos.push_back(std::move(info));
-        } catch (...) {
-            HandleException(Formatter() << "Shader::" << path);
-            return {};
-        }
+        info.render_targets = pass.render_targets;
+        info.texture_resources = pass.texture_resources;
+        subShaderMetaInfos.push_back(std::move(info));
     }
 
     std::shared_ptr<ShaderBackend> shader;
     try {
-        shader = std::make_shared<ShaderBackend>(&gfx_, path, metaInfo, subShaderMetaInfos);
+        shader = std::make_shared<ShaderBackend>(&gfx_, files_, path, metaInfo, subShaderMetaInfos);
     } catch (...) {
         HandleException(Formatter() << "Shader::" << path);
         return {};
     }
 
+    for (std::size_t pass = 0; pass < descriptor.passes.size(); ++pass) {
+        const auto &passDesc = descriptor.passes[pass];
+        if (passDesc.resolution_scale > 0.0f) {
+            shader->set_resolution_scale(pass, passDesc.resolution_scale);
+        }
+        for (const auto &upsample : passDesc.bilateral_upsamples) {
+            shader->add_bilateral_upsample(pass, {upsample.source, upsample.target});
+        }
+
+        for (const auto &targetDesc : passDesc.render_target_descs) {
+            RenderTargetDesc desc;
+            desc.scale = shader->resolution_scale(pass);
+            auto format = parse_render_target_format(targetDesc.format);
+            if (format) {
+                desc.format = *format;
+            } else {
+                logger_->warn(__FILE__, __LINE__) << "Unknown render target format '" << targetDesc.format
+                                                  << "'. The default is used. path: " << path;
+            }
+            if (targetDesc.scale > 0.0f) {
+                desc.scale = targetDesc.scale;
+            }
+            shader->set_render_target_desc(pass, targetDesc.name, desc);
+        }
+    }
+
     return shader;
 }
 
@@ -130,7 +254,7 @@ ResourceLoader::load_backend<MaterialBackend>(const std::string &path) const noe
     using namespace nodec::resource_management;
     using namespace nodec_rendering::resources;
 
-    std::ifstream file(path, std::ios::binary);
+    auto file = open_file(path);
 
     if (!file) {
         logger_->warn(__FILE__, __LINE__) << "Failed to open resource file. path: " << path;
@@ -141,7 +265,7 @@ ResourceLoader::load_backend<MaterialBackend>(const std::string &path) const noe
     SerializableMaterial source;
 
     try {
-        cereal::JSONInputArchive archive(file);
+        cereal::JSONInputArchive archive(*file);
         archive(source);
     } catch (...) {
         HandleException(Formatter() << "Material::" << path);
@@ -161,19 +285,42 @@ ResourceLoader::load_backend<MaterialBackend>(const std::string &path) const noe
 }
 
 template<>
-std::shared_ptr<TextureBackend>
-ResourceLoader::load_backend<TextureBackend>(const std::string &path) const noexcept {
+StagedResource<TextureBackend>
+ResourceLoader::decode_backend<TextureBackend>(const std::string &path) const noexcept {
     using namespace nodec;
 
+    auto file = read_file(path);
+    if (!file) {
+        logger_->warn(__FILE__, __LINE__) << "Failed to open resource file. path: " << path;
+        return {};
+    }
+
+    // The image is decoded here, so the file is released before the upload.
+    std::shared_ptr<ImageTexture> texture;
     try {
-        auto texture = std::make_shared<ImageTexture>(&gfx_, path);
-        return texture;
+        texture = std::make_shared<ImageTexture>(&gfx_, path, file->data(), file->size(), false);
     } catch (...) {
         HandleException(Formatter() << "Texture::" << path);
         return {};
     }
 
-    return {};
+    const auto upload_bytes = texture->staged_bytes();
+    auto upload = [this, path, texture]() {
+        try {
+            texture->upload(&gfx_);
+        } catch (...) {
+            HandleException(Formatter() << "Texture::" << path);
+            return false;
+        }
+        return true;
+    };
+    return {texture, upload, upload_bytes, upload_bytes};
+}
+
+template<>
+std::shared_ptr<TextureBackend>
+ResourceLoader::load_backend<TextureBackend>(const std::string &path) const noexcept {
+    return upload_now(decode_backend<TextureBackend>(path));
 }
 
 template<>
@@ -182,7 +329,7 @@ ResourceLoader::load_backend<nodec_scene_serialization::SerializableEntity>(cons
     using namespace nodec;
     using namespace nodec_scene_serialization;
 
-    std::ifstream file(path, std::ios::binary);
+    auto file = open_file(path);
 
     if (!file) {
         logger_->warn(__FILE__, __LINE__) << "Failed to open resource file. path: " << path;
@@ -194,7 +341,7 @@ ResourceLoader::load_backend<nodec_scene_serialization::SerializableEntity>(cons
 
     try {
         ArchiveContext context{scene_serialization_, registry_};
-        cereal::UserDataAdapter<ArchiveContext, cereal::JSONInputArchive> archive(context, file);
+        cereal::UserDataAdapter<ArchiveContext, cereal::JSONInputArchive> archive(context, *file);
         archive(ser_entity);
     } catch (...) {
         HandleException(Formatter() << "SerializableEntity::" << path);
@@ -209,10 +356,16 @@ std::shared_ptr<AudioClipBackend>
 ResourceLoader::load_backend<AudioClipBackend>(const std::string &path) const noexcept {
     using namespace nodec;
 
+    auto file = open_file(path);
+    if (!file) {
+        logger_->warn(__FILE__, __LINE__) << "Failed to open resource file. path: " << path;
+        return {};
+    }
+
     std::shared_ptr<AudioClipBackend> clip;
 
     try {
-        clip = std::make_shared<AudioClipBackend>(path);
+        clip = std::make_shared<AudioClipBackend>(*file, path);
     } catch (...) {
         HandleException(Formatter() << "AudioClip::" << path);
         return {};
@@ -222,19 +375,65 @@ ResourceLoader::load_backend<AudioClipBackend>(const std::string &path) const no
 }
 
 template<>
-std::shared_ptr<FontBackend>
-ResourceLoader::load_backend(const std::string &path) const noexcept {
+StagedResource<AudioClipBackend>
+ResourceLoader::decode_backend<AudioClipBackend>(const std::string &path) const noexcept {
+    auto clip = load_backend<AudioClipBackend>(path);
+    if (!clip) return {};
+    return {clip, {}, 0, clip->samples().size()};
+}
+
+template<>
+StagedResource<FontBackend>
+ResourceLoader::decode_backend<FontBackend>(const std::string &path) const noexcept {
     using namespace nodec;
 
+    auto file = read_file(path);
+    if (!file) {
+        logger_->warn(__FILE__, __LINE__) << "Failed to open resource file. path: " << path;
+        return {};
+    }
+
+    // FreeType reads the glyphs from the memory while the face lives, so the font keeps the file.
     std::shared_ptr<FontBackend> font;
     try {
-        font = std::make_shared<FontBackend>(font_library_, path);
+        font = std::make_shared<FontBackend>(font_library_, file, file->data(), file->size(), path);
     } catch (...) {
         HandleException(Formatter() << "Font::" << path);
         return {};
     }
 
-    return font;
+    // The SDF atlas baked by the font-sdf-baker tool is placed next to the font.
+    auto sdf_file = open_file(path + ".sdf");
+    if (!sdf_file) return {font, {}, 0, 0};
+
+    std::shared_ptr<const SdfFont> sdf_font;
+    try {
+        sdf_font = std::make_shared<const SdfFont>(read_sdf_font(*sdf_file));
+    } catch (...) {
+        // The font is still usable with the glyphs rendered at runtime.
+        HandleException(Formatter() << "Font::" << path << ".sdf");
+        return {font, {}, 0, 0};
+    }
+
+    const auto upload_bytes = static_cast<std::uint64_t>(sdf_font->pixels.size());
+    auto upload = [this, path, font, sdf_font]() {
+        try {
+            std::unique_ptr<SdfFontTexture> sdf_texture(new SdfFontTexture(&gfx_, *sdf_font));
+            font->SetSdf(sdf_font, std::move(sdf_texture));
+        } catch (...) {
+            // The font is still usable with the glyphs rendered at runtime.
+            HandleException(Formatter() << "Font::" << path << ".sdf");
+        }
+        return true;
+    };
+    // The atlas stays on the CPU too, for the glyph lookups.
+    return {font, upload, upload_bytes, upload_bytes * 2};
+}
+
+template<>
+std::shared_ptr<FontBackend>
+ResourceLoader::load_backend(const std::string &path) const noexcept {
+    return upload_now(decode_backend<FontBackend>(path));
 }
 
 template<>
@@ -244,7 +443,7 @@ ResourceLoader::load_backend<nodec_animation::resources::AnimationClip>(const st
     using namespace nodec_animation::resources;
     using namespace nodec_scene_serialization;
 
-    std::ifstream file(path, std::ios::binary);
+    auto file = open_file(path);
 
     if (!file) {
         logger_->warn(__FILE__, __LINE__) << "Failed to open resource file. path: " << path;
@@ -256,7 +455,7 @@ ResourceLoader::load_backend<nodec_animation::resources::AnimationClip>(const st
 
     try {
         ArchiveContext context{scene_serialization_, registry_};
-        cereal::UserDataAdapter<ArchiveContext, cereal::JSONInputArchive> archive(context, file);
+        cereal::UserDataAdapter<ArchiveContext, cereal::JSONInputArchive> archive(context, *file);
         archive(*clip);
     } catch (...) {
         HandleException(Formatter() << "AnimationClip::" << path);
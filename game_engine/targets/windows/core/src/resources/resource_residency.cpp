@@ -0,0 +1,148 @@
+#include <resources/resource_residency.hpp>
+
+#include <algorithm>
+
+void ResourceResidency::track(const std::string &type, const std::string &path, std::shared_ptr<void> resource, std::uint64_t bytes) {
+    std::string key = type;
+    key += '\n';
+    key += path;
+
+    std::shared_ptr<void> replaced;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto &resident = resources_[key];
+        if (resident.resource) {
+            total_bytes_ -= resident.entry.bytes;
+        }
+
+        // Released out of the lock. The last release may run the destructor of the resource.
+        replaced = std::move(resident.resource);
+
+        resident.entry = {type, path, bytes, frame_, true};
+        resident.resource = std::move(resource);
+        total_bytes_ += bytes;
+    }
+}
+
+std::size_t ResourceResidency::update() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++frame_;
+    }
+
+    // Destroying a released material drops its references to the textures,
+    // so the references are refreshed again until nothing more is released.
+    std::size_t released_count = 0;
+    while (true) {
+        auto released = take_unused();
+        if (released.empty()) break;
+        released_count += released.size();
+    }
+    return released_count;
+}
+
+std::vector<std::shared_ptr<void>> ResourceResidency::take_unused() {
+    std::vector<std::shared_ptr<void>> released;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<Resident *> candidates;
+    for (auto &pair : resources_) {
+        auto &resident = pair.second;
+
+        // The tracker holds one of the references.
+        resident.entry.referenced = resident.resource.use_count() > 1;
+        if (resident.entry.referenced) {
+            resident.entry.last_used_frame = frame_;
+        } else {
+            candidates.push_back(&resident);
+        }
+    }
+    if (candidates.empty()) return released;
+
+    const auto release = [&](Resident *resident) {
+        total_bytes_ -= resident->entry.bytes;
+        released.push_back(std::move(resident->resource));
+    };
+
+    if (budget_bytes_ == 0) {
+        for (auto *resident : candidates) release(resident);
+    } else {
+        // The sizeless ones never bring the total down, so they age out instead.
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](Resident *resident) {
+                             if (resident->entry.bytes != 0 || frame_ - resident->entry.last_used_frame < unsized_idle_frames_) {
+                                 return false;
+                             }
+                             release(resident);
+                             return true;
+                         }),
+                         candidates.end());
+
+        if (total_bytes_ > budget_bytes_) {
+            std::sort(candidates.begin(), candidates.end(), [](const Resident *lhs, const Resident *rhs) {
+                if (lhs->entry.last_used_frame != rhs->entry.last_used_frame) {
+                    return lhs->entry.last_used_frame < rhs->entry.last_used_frame;
+                }
+                return lhs->entry.bytes > rhs->entry.bytes;
+            });
+
+            for (auto *resident : candidates) {
+                if (total_bytes_ <= budget_bytes_) break;
+                release(resident);
+            }
+        }
+    }
+
+    if (!released.empty()) {
+        for (auto iter = resources_.begin(); iter != resources_.end();) {
+            if (iter->second.resource) {
+                ++iter;
+            } else {
+                iter = resources_.erase(iter);
+            }
+        }
+        evicted_count_ += released.size();
+    }
+    return released;
+}
+
+std::vector<ResourceResidency::TypeUsage> ResourceResidency::bytes_by_type() const {
+    std::vector<TypeUsage> usages;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &pair : resources_) {
+            const auto &entry = pair.second.entry;
+            auto iter = std::find_if(usages.begin(), usages.end(), [&](const TypeUsage &usage) { return usage.type == entry.type; });
+            if (iter == usages.end()) {
+                usages.push_back({entry.type, 1, entry.bytes});
+            } else {
+                ++iter->count;
+                iter->bytes += entry.bytes;
+            }
+        }
+    }
+
+    std::sort(usages.begin(), usages.end(), [](const TypeUsage &lhs, const TypeUsage &rhs) {
+        return lhs.bytes > rhs.bytes;
+    });
+    return usages;
+}
+
+std::vector<ResourceResidency::Entry> ResourceResidency::largest(std::size_t n) const {
+    std::vector<Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries.reserve(resources_.size());
+        for (auto &pair : resources_) {
+            entries.push_back(pair.second.entry);
+        }
+    }
+
+    n = (std::min)(n, entries.size());
+    std::partial_sort(entries.begin(), entries.begin() + n, entries.end(), [](const Entry &lhs, const Entry &rhs) {
+        return lhs.bytes > rhs.bytes;
+    });
+    entries.resize(n);
+    return entries;
+}
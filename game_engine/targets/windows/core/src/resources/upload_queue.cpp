@@ -0,0 +1,68 @@
+#include <resources/upload_queue.hpp>
+
+bool UploadQueue::push(std::uint64_t bytes, Upload upload, Discard discard) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [&]() {
+        return closed_ || entries_.empty() || pending_bytes_ + bytes <= capacity_bytes_;
+    });
+    if (closed_) return false;
+
+    entries_.push_back({bytes, std::move(upload), std::move(discard), std::chrono::steady_clock::now()});
+    pending_bytes_ += bytes;
+    return true;
+}
+
+std::size_t UploadQueue::drain(const UploadBudget &budget) {
+    using namespace std::chrono;
+
+    const auto start = steady_clock::now();
+    std::uint64_t drained_bytes = 0;
+    std::size_t drained_count = 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++stats_.drains;
+
+    while (!entries_.empty()) {
+        if (drained_count > 0) {
+            const auto elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+            if (static_cast<std::uint64_t>(elapsed) >= budget.microseconds
+                || drained_bytes + entries_.front().bytes > budget.bytes) {
+                ++stats_.budget_exhausted;
+                break;
+            }
+        }
+
+        auto entry = std::move(entries_.front());
+        entries_.pop_front();
+        pending_bytes_ -= entry.bytes;
+        stats_.wait_latency.record(duration_cast<microseconds>(steady_clock::now() - entry.pushed_at).count());
+        lock.unlock();
+        not_full_.notify_all();
+
+        entry.upload();
+        drained_bytes += entry.bytes;
+        ++drained_count;
+
+        lock.lock();
+        ++stats_.uploads;
+        stats_.bytes += entry.bytes;
+    }
+
+    return drained_count;
+}
+
+void UploadQueue::close() {
+    std::deque<Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        entries.swap(entries_);
+        pending_bytes_ = 0;
+        stats_.discarded += entries.size();
+    }
+    not_full_.notify_all();
+
+    for (auto &entry : entries) {
+        if (entry.discard) entry.discard();
+    }
+}
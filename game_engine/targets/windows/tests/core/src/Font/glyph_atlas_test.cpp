@@ -0,0 +1,235 @@
+#include <Font/GlyphAtlas.hpp>
+#include <Font/GlyphAtlasPacker.hpp>
+
+#include "../test_runner.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Rect = GlyphAtlasPacker::Rect;
+
+bool overlaps(const Rect &lhs, const Rect &rhs) {
+    return lhs.x < rhs.x + rhs.width && rhs.x < lhs.x + lhs.width
+           && lhs.y < rhs.y + rhs.height && rhs.y < lhs.y + lhs.height;
+}
+
+bool is_within(const GlyphAtlasPacker &packer, const Rect &rect) {
+    return rect.x + rect.width <= packer.width() && rect.y + rect.height <= packer.height();
+}
+
+/**
+ * @brief The glyphs of the size the key derives, like the characters of a few fonts and sizes.
+ */
+struct GlyphSource {
+    std::vector<std::uint8_t> pixels = std::vector<std::uint8_t>(64 * 64);
+
+    static std::uint16_t width(std::uint64_t key) {
+        return static_cast<std::uint16_t>(4 + key % 29);
+    }
+
+    static std::uint16_t height(std::uint64_t key) {
+        return static_cast<std::uint16_t>(6 + key * 7 % 27);
+    }
+
+    static std::uint8_t value(std::uint64_t key) {
+        return static_cast<std::uint8_t>(key % 251 + 1);
+    }
+
+    const Rect *insert(GlyphAtlas &atlas, std::uint64_t key) {
+        std::fill(pixels.begin(), pixels.end(), value(key));
+        return atlas.insert(key, width(key), height(key), pixels.data(), 64);
+    }
+};
+
+// The glyph of 14 x 14 pixels takes 16 x 16 with the padding.
+const Rect *insert_square(GlyphAtlas &atlas, std::uint64_t key) {
+    const std::vector<std::uint8_t> pixels(14 * 14, static_cast<std::uint8_t>(key));
+    return atlas.insert(key, 14, 14, pixels.data(), 14);
+}
+
+} // namespace
+
+TEST_CASE(glyph_atlas_packer_fits_the_rectangles_without_overlap) {
+    GlyphAtlasPacker packer(256, 256);
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> size(1, 40);
+
+    std::vector<Rect> rects;
+    for (int i = 0; i < 200; ++i) {
+        const auto rect = packer.allocate(static_cast<std::uint16_t>(size(random)), static_cast<std::uint16_t>(size(random)));
+        if (rect) rects.push_back(*rect);
+    }
+    CHECK(rects.size() > 20);
+
+    bool is_valid = true;
+    for (std::size_t i = 0; i < rects.size(); ++i) {
+        is_valid = is_valid && is_within(packer, rects[i]);
+        for (std::size_t j = i + 1; j < rects.size(); ++j) {
+            is_valid = is_valid && !overlaps(rects[i], rects[j]);
+        }
+    }
+    CHECK(is_valid);
+
+    CHECK(!packer.allocate(257, 1));
+    CHECK(!packer.allocate(1, 257));
+    CHECK(!packer.allocate(0, 4));
+}
+
+TEST_CASE(glyph_atlas_packer_rejects_when_full_and_reuses_the_released_space) {
+    GlyphAtlasPacker packer(64, 64);
+
+    std::vector<Rect> rects;
+    for (int i = 0; i < 16; ++i) {
+        const auto rect = packer.allocate(16, 16);
+        CHECK(rect);
+        if (rect) rects.push_back(*rect);
+    }
+    CHECK(!packer.allocate(16, 16));
+    CHECK(!packer.allocate(1, 1));
+
+    // The released rectangle is the only free space, so the next one lands there.
+    packer.release(rects[5]);
+    const auto reused = packer.allocate(16, 16);
+    CHECK(reused && reused->x == rects[5].x && reused->y == rects[5].y);
+    if (reused) rects[5] = *reused;
+
+    // The emptied shelves merge, so a taller rectangle fits in them.
+    for (int i = 0; i < 8; ++i) {
+        packer.release(rects[i]);
+    }
+    CHECK(packer.allocate(64, 32));
+    CHECK(!packer.allocate(1, 1));
+
+    packer.clear();
+    CHECK(packer.shelf_count() == 0);
+    CHECK(packer.allocate(64, 64));
+}
+
+TEST_CASE(glyph_atlas_evicts_the_least_recently_used_glyphs) {
+    // Room for four glyphs.
+    GlyphAtlas atlas(32, 32);
+
+    atlas.begin_batch();
+    for (std::uint64_t key = 1; key <= 4; ++key) {
+        CHECK(insert_square(atlas, key));
+    }
+
+    atlas.begin_batch();
+    CHECK(atlas.find(1)); // 2 is now the coldest.
+
+    atlas.begin_batch();
+    CHECK(insert_square(atlas, 5));
+    CHECK(insert_square(atlas, 6));
+    CHECK(atlas.eviction_count() == 2);
+    CHECK(!atlas.find(2));
+    CHECK(!atlas.find(3));
+
+    // Every glyph is now used by the batch being built, so none is evicted.
+    CHECK(atlas.find(1) && atlas.find(4) && atlas.find(5) && atlas.find(6));
+    CHECK(!insert_square(atlas, 7));
+    CHECK(atlas.glyph_count() == 4);
+
+    atlas.begin_batch();
+    CHECK(insert_square(atlas, 7));
+    CHECK(!atlas.find(1));
+}
+
+TEST_CASE(glyph_atlas_clear_drops_the_glyphs_and_the_dirty_rect) {
+    GlyphAtlas atlas(32, 32);
+
+    atlas.begin_batch();
+    CHECK(insert_square(atlas, 1));
+    CHECK(insert_square(atlas, 2));
+    CHECK(atlas.is_dirty());
+
+    atlas.clear();
+    CHECK(atlas.glyph_count() == 0 && !atlas.find(1));
+    CHECK(!atlas.is_dirty());
+
+    // The next upload covers only the glyph inserted after the clear.
+    auto *rect = insert_square(atlas, 3);
+    CHECK(rect);
+    if (!rect) return;
+    CHECK(atlas.dirty_rect().x + 1 == rect->x && atlas.dirty_rect().width == rect->width + 2);
+}
+
+TEST_CASE(glyph_atlas_keeps_the_pixels_of_the_resident_glyphs) {
+    GlyphAtlas atlas(256, 256);
+    GlyphSource source;
+    std::mt19937 random(2);
+    std::uniform_int_distribution<std::uint64_t> key(0, 1000);
+
+    std::size_t corrupted = 0;
+    for (int i = 0; i < 20000; ++i) {
+        if (i % 16 == 0) atlas.begin_batch();
+
+        const auto glyph_key = key(random);
+        auto *rect = atlas.find(glyph_key);
+        if (!rect) {
+            atlas.clear_dirty();
+            rect = source.insert(atlas, glyph_key);
+            CHECK(rect);
+            if (!rect) return;
+
+            // The dirty rectangle covers the glyph and its padding.
+            const auto &dirty = atlas.dirty_rect();
+            CHECK(atlas.is_dirty());
+            CHECK(dirty.x + 1 == rect->x && dirty.y + 1 == rect->y);
+            CHECK(dirty.width == rect->width + 2 && dirty.height == rect->height + 2);
+        }
+
+        const auto pixel = [&](int x, int y) { return atlas.pixels()[static_cast<std::size_t>(y) * atlas.width() + x]; };
+        for (int y = 0; y < rect->height; ++y) {
+            for (int x = 0; x < rect->width; ++x) {
+                if (pixel(rect->x + x, rect->y + y) != GlyphSource::value(glyph_key)) ++corrupted;
+            }
+        }
+        // The padding is cleared.
+        if (pixel(rect->x - 1, rect->y) != 0 || pixel(rect->x + rect->width, rect->y + rect->height) != 0) ++corrupted;
+    }
+    CHECK(corrupted == 0);
+    CHECK(atlas.eviction_count() > 0);
+}
+
+BENCHMARK(glyph_atlas_churn) {
+    for (const std::uint64_t key_count : {200u, 2000u}) {
+        GlyphAtlas atlas(512, 512);
+        GlyphSource source;
+        std::mt19937 random(3);
+        // Most of the text uses a few characters.
+        std::geometric_distribution<std::uint64_t> key(8.0 / key_count);
+
+        test_runner::measure("10k lookups, " + std::to_string(key_count) + " hot glyphs", 10, [&]() {
+            for (int i = 0; i < 10000; ++i) {
+                if (i % 64 == 0) atlas.begin_batch();
+                const auto glyph_key = key(random);
+                if (!atlas.find(glyph_key)) source.insert(atlas, glyph_key);
+            }
+            test_runner::do_not_optimize(atlas.pixels());
+        });
+        std::printf("  %zu resident glyphs, %zu evictions\n", atlas.glyph_count(), atlas.eviction_count());
+    }
+
+    GlyphAtlasPacker packer(1024, 1024);
+    std::mt19937 random(4);
+    std::uniform_int_distribution<int> size(6, 40);
+    std::vector<Rect> rects;
+    test_runner::measure("packer, 10k allocations and releases", 10, [&]() {
+        for (int i = 0; i < 10000; ++i) {
+            if (rects.size() > 500) {
+                const auto index = static_cast<std::size_t>(random() % rects.size());
+                packer.release(rects[index]);
+                rects[index] = rects.back();
+                rects.pop_back();
+            }
+            const auto rect = packer.allocate(static_cast<std::uint16_t>(size(random)), static_cast<std::uint16_t>(size(random)));
+            if (rect) rects.push_back(*rect);
+        }
+        test_runner::do_not_optimize(rects);
+    });
+}
@@ -0,0 +1,115 @@
+#include <Font/SdfFont.hpp>
+#include <Font/SdfGlyphBaker.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief A 2 x 2 pixel square glyph, oversampled like the baker renders it.
+ */
+std::vector<std::uint8_t> square_coverage() {
+    constexpr int size = 2 * SdfGlyphBaker::OVERSAMPLING;
+    return std::vector<std::uint8_t>(size * size, 255);
+}
+
+SdfFont make_font() {
+    SdfFont font;
+    font.pixel_size = 32;
+    font.spread = 4;
+    font.atlas_width = 64;
+    font.atlas_height = 32;
+    font.pixels.resize(64 * 32);
+    for (std::size_t i = 0; i < font.pixels.size(); ++i) {
+        font.pixels[i] = static_cast<std::uint8_t>(i * 7);
+    }
+    font.glyphs[U'A'] = {0, 0, 24, 30, 1, 20, 16, 22, 18 * 64};
+    font.glyphs[0x3042] = {24, 0, 40, 32, 0, 24, 32, 24, 32 * 64};
+    font.glyphs[U' '] = {0, 0, 0, 0, 0, 0, 0, 0, 8 * 64};
+    return font;
+}
+
+} // namespace
+
+TEST_CASE(sdf_glyph_baker_makes_the_distance_field_of_a_square) {
+    // The baker only touches the face in bake().
+    const SdfGlyphBaker baker(nullptr, 32, 2);
+    constexpr int size = 2 * SdfGlyphBaker::OVERSAMPLING;
+    const auto coverage = square_coverage();
+
+    // The square and the spread border of 2 pixels on every side.
+    std::vector<std::uint8_t> field;
+    baker.make_distance_field(coverage.data(), size, size, size, 6, 6, field);
+    CHECK(field.size() == 36);
+    const auto at = [&](int x, int y) { return field[y * 6 + x]; };
+
+    // The texel centers are 3 and 2 oversampled pixels inside the square, and 2 outside of it.
+    // The value is 0.5 + (distance - 0.5) / (OVERSAMPLING * spread * 2), in 1/255.
+    CHECK(at(2, 2) == 167);
+    CHECK(at(3, 2) == 151);
+    CHECK(at(1, 2) == 104);
+    CHECK(at(0, 0) == 0);
+
+    // The outline is at 0.5, and the field is symmetric about the diagonal like the square.
+    std::size_t misplaced = 0;
+    for (int y = 0; y < 6; ++y) {
+        for (int x = 0; x < 6; ++x) {
+            const bool inside = x >= 2 && x < 4 && y >= 2 && y < 4;
+            if ((at(x, y) >= 128) != inside || at(x, y) != at(y, x)) ++misplaced;
+        }
+    }
+    CHECK(misplaced == 0);
+}
+
+TEST_CASE(sdf_font_reads_back_the_header_and_the_glyphs) {
+    const auto font = make_font();
+    std::stringstream stream;
+    write_sdf_font(stream, font);
+
+    const auto bytes = stream.str();
+    CHECK(bytes.compare(0, 4, "DSDF") == 0);
+    CHECK(bytes.size() == sizeof(sdf_font_io::Header) + 3 * sizeof(sdf_font_io::GlyphRecord) + 64 * 32);
+
+    const auto read = read_sdf_font(stream);
+    CHECK(read.pixel_size == 32 && read.spread == 4);
+    CHECK(read.atlas_width == 64 && read.atlas_height == 32);
+    CHECK(read.glyphs.size() == 3);
+    CHECK(read.pixels == font.pixels);
+
+    const auto *glyph = read.find(0x3042);
+    CHECK(glyph);
+    if (!glyph) return;
+    CHECK(glyph->x == 24 && glyph->y == 0 && glyph->width == 40 && glyph->height == 32);
+    CHECK(glyph->bearing_y == 24 && glyph->bitmap_width == 32 && glyph->advance == 32 * 64);
+    CHECK(read.find(U' ') && read.find(U' ')->width == 0);
+    CHECK(!read.find(U'B'));
+}
+
+TEST_CASE(sdf_font_rejects_the_broken_files) {
+    const auto write = [](const SdfFont &font) {
+        std::stringstream stream;
+        write_sdf_font(stream, font);
+        return stream.str();
+    };
+    const auto bytes = write(make_font());
+
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 1));
+    CHECK_THROWS(read_sdf_font(truncated));
+
+    std::stringstream no_glyphs(bytes.substr(0, sizeof(sdf_font_io::Header) + 4));
+    CHECK_THROWS(read_sdf_font(no_glyphs));
+
+    std::stringstream not_sdf("DXBC" + bytes.substr(4));
+    CHECK_THROWS(read_sdf_font(not_sdf));
+
+    // The glyph must be in the atlas.
+    auto font = make_font();
+    font.glyphs[U'A'].x = 50;
+    std::stringstream out_of_atlas(write(font));
+    CHECK_THROWS(read_sdf_font(out_of_atlas));
+}
@@ -0,0 +1,193 @@
+#include <graphics/render_target_pool.hpp>
+#include <rendering/render_graph.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+struct FakeDevice {
+    std::size_t created_count{0};
+};
+
+/**
+ * @brief The render target of no texture. The pool only looks at the format and the size.
+ */
+class FakeTarget {
+public:
+    FakeTarget(FakeDevice *device, UINT width, UINT height, DXGI_FORMAT format)
+        : width_(width), height_(height), format_(format) {
+        ++device->created_count;
+    }
+
+    DXGI_FORMAT format() const noexcept {
+        return format_;
+    }
+
+    UINT width() const noexcept {
+        return width_;
+    }
+
+    UINT height() const noexcept {
+        return height_;
+    }
+
+private:
+    UINT width_;
+    UINT height_;
+    DXGI_FORMAT format_;
+};
+
+using FakeTargetPool = BasicRenderTargetPool<FakeTarget, FakeDevice>;
+
+/**
+ * @brief Runs the compiled graph like SceneRenderer, binding the transient resources from the pool.
+ *
+ * @return The target each live write of the graph was bound to, indexed like RenderGraph::writes().
+ */
+std::vector<const FakeTarget *> execute(const RenderGraph &graph, const CompiledRenderGraph &compiled,
+                                        const std::vector<RenderTargetDesc> &descs, FakeTargetPool &pool,
+                                        UINT target_width, UINT target_height) {
+    std::vector<FakeTarget *> bound(graph.resources().size(), nullptr);
+    std::vector<const FakeTarget *> written(graph.writes().size(), nullptr);
+
+    for (const auto &step : compiled.steps()) {
+        for (std::uint32_t i = 0; i < step.acquire_count; ++i) {
+            const auto id = compiled.acquires()[step.first_acquire + i].resource;
+            if (graph.resources()[id].imported) continue;
+            bound[id] = &pool.acquire(descs[id].format,
+                                      scaled_render_target_size(target_width, descs[id].scale),
+                                      scaled_render_target_size(target_height, descs[id].scale));
+        }
+
+        const auto &pass = graph.passes()[step.pass];
+        for (std::uint32_t i = 0; i < pass.write_count; ++i) {
+            const auto write_index = pass.first_write + i;
+            if (compiled.is_write_live(write_index)) written[write_index] = bound[graph.writes()[write_index].resource];
+        }
+
+        for (std::uint32_t i = 0; i < step.release_count; ++i) {
+            const auto id = compiled.releases()[step.first_release + i];
+            pool.release(*bound[id]);
+        }
+    }
+    return written;
+}
+
+} // namespace
+
+TEST_CASE(render_target_pool_lends_the_released_texture_of_the_same_format_and_size) {
+    FakeDevice device;
+    FakeTargetPool pool(device);
+
+    auto &color = pool.acquire(DXGI_FORMAT_R16G16B16A16_FLOAT, 1920, 1080);
+    auto &bloom = pool.acquire(DXGI_FORMAT_R16G16B16A16_FLOAT, 1920, 1080);
+    CHECK(&color != &bloom);
+    CHECK(device.created_count == 2);
+
+    // Neither an other format nor an other size takes the released texture.
+    pool.release(color);
+    auto &occlusion = pool.acquire(DXGI_FORMAT_R8_UNORM, 1920, 1080);
+    auto &half_color = pool.acquire(DXGI_FORMAT_R16G16B16A16_FLOAT, 960, 540);
+    CHECK(&occlusion != &color && &half_color != &color);
+    CHECK(device.created_count == 4);
+
+    auto &reflection = pool.acquire(DXGI_FORMAT_R16G16B16A16_FLOAT, 1920, 1080);
+    CHECK(&reflection == &color);
+    CHECK(device.created_count == 4);
+
+    CHECK(pool.texture_count() == 4);
+    CHECK(pool.allocated_bytes() == 2ull * 1920 * 1080 * 8 + 1920 * 1080 + 960 * 540 * 8);
+}
+
+TEST_CASE(render_target_pool_destroys_the_textures_unused_for_long) {
+    FakeDevice device;
+    FakeTargetPool pool(device);
+
+    auto &kept = pool.acquire(DXGI_FORMAT_R32G32B32A32_FLOAT, 64, 64);
+    auto &used = pool.acquire(DXGI_FORMAT_R32G32B32A32_FLOAT, 64, 64);
+    auto &unused = pool.acquire(DXGI_FORMAT_R8_UNORM, 64, 64);
+    pool.release(used);
+    pool.release(unused);
+
+    std::vector<const FakeTarget *> destroyed;
+    for (std::uint64_t frame = 0; frame <= FakeTargetPool::MAX_UNUSED_FRAMES + 1; ++frame) {
+        // Used every frame, and released.
+        pool.release(pool.acquire(DXGI_FORMAT_R32G32B32A32_FLOAT, 64, 64));
+        pool.end_frame([&](FakeTarget &target) { destroyed.push_back(&target); });
+    }
+
+    // The texture still in use is never destroyed.
+    CHECK(destroyed.size() == 1 && destroyed[0] == &unused);
+    CHECK(pool.texture_count() == 2);
+    CHECK(pool.allocated_bytes() == 2ull * 64 * 64 * 16);
+    CHECK(&pool.acquire(DXGI_FORMAT_R32G32B32A32_FLOAT, 64, 64) == &used);
+    CHECK(&kept != &used);
+}
+
+TEST_CASE(render_target_pool_rounds_the_scaled_sizes_up) {
+    CHECK(scaled_render_target_size(1919, 0.5f) == 960);
+    CHECK(scaled_render_target_size(1080, 0.25f) == 270);
+    CHECK(scaled_render_target_size(1, 0.5f) == 1);
+    CHECK(scaled_render_target_size(0, 1.0f) == 1);
+
+    CHECK(parse_render_target_format("R8_UNORM") && *parse_render_target_format("R8_UNORM") == DXGI_FORMAT_R8_UNORM);
+    CHECK(!parse_render_target_format("R8_SNORM"));
+}
+
+TEST_CASE(render_target_pool_aliases_the_targets_whose_lifetimes_do_not_overlap) {
+    using WriteMode = RenderGraph::WriteMode;
+
+    RenderGraph graph;
+    const auto output = graph.import_resource("output", false);
+    const auto albedo = graph.resource("albedo");
+    const auto depth = graph.resource("depth");
+    const auto occlusion = graph.resource("occlusion");
+    const auto lit = graph.resource("lit");
+
+    graph.add_pass("gbuffer");
+    graph.write(albedo, WriteMode::Partial);
+    graph.write(depth, WriteMode::Partial);
+
+    graph.add_pass("ssao");
+    graph.read(depth);
+    graph.write(occlusion, WriteMode::Overwrite);
+
+    graph.add_pass("lighting");
+    graph.read(albedo);
+    graph.read(occlusion);
+    graph.write(lit, WriteMode::Overwrite);
+
+    graph.add_pass("tonemap");
+    graph.read(lit);
+    graph.write(output, WriteMode::Overwrite);
+
+    const auto compiled = graph.compile();
+
+    // The SSAO runs at half resolution.
+    std::vector<RenderTargetDesc> descs(graph.resources().size());
+    descs[occlusion] = {DXGI_FORMAT_R8_UNORM, 0.5f};
+
+    FakeDevice device;
+    FakeTargetPool pool(device);
+    const auto written = execute(graph, compiled, descs, pool, 1919, 1081);
+    const auto &passes = graph.passes();
+
+    // The half size is rounded up.
+    CHECK(written[passes[1].first_write]->width() == 960 && written[passes[1].first_write]->height() == 541);
+
+    // The lit color starts after the depth is released, so it takes the texture of the depth.
+    CHECK(written[passes[2].first_write] == written[passes[0].first_write + 1]);
+    CHECK(written[passes[2].first_write] != written[passes[0].first_write]);
+
+    // albedo and depth / lit in RGBA32F, and the occlusion in R8.
+    CHECK(device.created_count == 3);
+    CHECK(pool.allocated_bytes() == 2ull * 1919 * 1081 * 16 + 960 * 541);
+
+    // The next frame reuses every texture.
+    pool.end_frame([](FakeTarget &) {});
+    execute(graph, compiled, descs, pool, 1919, 1081);
+    CHECK(device.created_count == 3);
+}
@@ -0,0 +1,50 @@
+/**
+ * @brief Runs the CPU side tests of the engine core. No window or device is created.
+ *
+ * Usage:
+ *   nodec_game_engine_core_tests [options] [filter]
+ *
+ * Options:
+ *   --benchmark           Runs the benchmarks instead of the tests.
+ *
+ * Only the cases whose name contains the filter are run.
+ */
+
+#include "test_runner.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char *argv[]) {
+    bool benchmark = false;
+    const char *filter = "";
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--benchmark") == 0) {
+            benchmark = true;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    int run_count = 0;
+    int failed_count = 0;
+    for (const auto &test_case : test_runner::test_cases()) {
+        if (test_case.is_benchmark != benchmark || !std::strstr(test_case.name, filter)) continue;
+
+        std::printf("%s\n", test_case.name);
+        const auto failures = test_runner::failure_count();
+        try {
+            test_case.function();
+        } catch (const std::exception &e) {
+            std::printf("  unexpected exception: %s\n", e.what());
+            ++test_runner::failure_count();
+        }
+
+        ++run_count;
+        if (test_runner::failure_count() != failures) ++failed_count;
+    }
+
+    std::printf("%d of %d %s passed\n", run_count - failed_count, run_count, benchmark ? "benchmarks" : "tests");
+    return failed_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,224 @@
+#include <rendering/aabb_tree.hpp>
+
+#include "../test_runner.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+class BoxGenerator {
+public:
+    explicit BoxGenerator(std::uint32_t seed)
+        : random_(seed) {}
+
+    AabbTree::Box operator()() {
+        const float x = position_(random_);
+        const float y = position_(random_);
+        const float z = position_(random_);
+        const float s = size_(random_);
+        return {{x - s, y - s, z - s}, {x + s, y + s, z + s}};
+    }
+
+    float offset() {
+        return position_(random_) * 0.02f;
+    }
+
+private:
+    std::mt19937 random_;
+    std::uniform_real_distribution<float> position_{-100.0f, 100.0f};
+    std::uniform_real_distribution<float> size_{0.1f, 3.0f};
+};
+
+// The box x in [-20, 30], y in [-50, 50], z in [0, 40] as the planes.
+CullingPlanes make_box_planes() {
+    const float nx[] = {1, -1, 0, 0, 0, 0};
+    const float ny[] = {0, 0, 1, -1, 0, 0};
+    const float nz[] = {0, 0, 0, 0, 1, -1};
+    const float d[] = {20, 30, 50, 50, 0, 40};
+
+    CullingPlanes planes;
+    for (int i = 0; i < CullingPlanes::PLANE_COUNT; ++i) {
+        planes.nx[i] = nx[i];
+        planes.ny[i] = ny[i];
+        planes.nz[i] = nz[i];
+        planes.d[i] = d[i];
+    }
+    return planes;
+}
+
+bool intersects_box_planes(const AabbTree::Box &box) {
+    return box.max.x >= -20 && box.min.x <= 30 && box.max.y >= -50 && box.min.y <= 50 && box.max.z >= 0 && box.min.z <= 40;
+}
+
+// The test of the brute force iteration, the box against each plane.
+bool intersects_planes(const CullingPlanes &planes, const AabbTree::Box &box) {
+    for (int p = 0; p < CullingPlanes::PLANE_COUNT; ++p) {
+        const float x = planes.nx[p] >= 0 ? box.max.x : box.min.x;
+        const float y = planes.ny[p] >= 0 ? box.max.y : box.min.y;
+        const float z = planes.nz[p] >= 0 ? box.max.z : box.min.z;
+        if (planes.nx[p] * x + planes.ny[p] * y + planes.nz[p] * z + planes.d[p] < 0) return false;
+    }
+    return true;
+}
+
+bool inside_box_planes(const AabbTree::Box &box) {
+    return box.min.x >= -20 && box.max.x <= 30 && box.min.y >= -50 && box.max.y <= 50 && box.min.z >= 0 && box.max.z <= 40;
+}
+
+} // namespace
+
+TEST_CASE(aabb_tree_frustum_query_finds_every_intersecting_proxy) {
+    constexpr int COUNT = 20000;
+    BoxGenerator generate(1);
+
+    AabbTree tree;
+    std::vector<AabbTree::Box> boxes;
+    std::vector<int> proxies;
+    for (int i = 0; i < COUNT; ++i) {
+        boxes.push_back(generate());
+        proxies.push_back(tree.create_proxy(boxes.back(), i));
+    }
+
+    // Small moves stay within the fat boxes, the large ones reinsert.
+    for (int i = 0; i < COUNT; i += 7) {
+        const float offset = generate.offset();
+        boxes[i].min.x += offset;
+        boxes[i].max.x += offset;
+        tree.move_proxy(proxies[i], boxes[i]);
+        CHECK(tree.fat_box(proxies[i]).contains(boxes[i]));
+    }
+    for (int i = 0; i < COUNT; i += 3) {
+        tree.destroy_proxy(proxies[i]);
+    }
+    for (int i = 0; i < COUNT; i += 3) {
+        boxes[i] = generate();
+        proxies[i] = tree.create_proxy(boxes[i], i);
+    }
+
+    CHECK(tree.proxy_count() == COUNT);
+    // Balanced: far below the proxy count.
+    CHECK(tree.height() < 40);
+
+    std::vector<int> reported(COUNT);
+    std::size_t wrongly_inside = 0;
+    tree.query_frustum(make_box_planes(), [&](std::uint32_t user_data, bool is_inside) {
+        ++reported[user_data];
+        if (is_inside && !inside_box_planes(tree.fat_box(proxies[user_data]))) ++wrongly_inside;
+    });
+
+    std::size_t missing = 0;
+    std::size_t duplicated = 0;
+    for (int i = 0; i < COUNT; ++i) {
+        if (intersects_box_planes(boxes[i]) && reported[i] == 0) ++missing;
+        if (reported[i] > 1) ++duplicated;
+    }
+    CHECK(missing == 0);
+    CHECK(duplicated == 0);
+    CHECK(wrongly_inside == 0);
+}
+
+TEST_CASE(aabb_tree_move_within_the_margin_keeps_the_fat_box) {
+    AabbTree tree;
+    const AabbTree::Box box{{0, 0, 0}, {1, 1, 1}};
+    const auto proxy = tree.create_proxy(box, 7);
+    CHECK(tree.user_data(proxy) == 7);
+    CHECK(tree.fat_box(proxy).contains(box));
+
+    const AabbTree::Box nudged{{0.01f, 0, 0}, {1.01f, 1, 1}};
+    CHECK(!tree.move_proxy(proxy, nudged));
+
+    const AabbTree::Box far{{50, 0, 0}, {51, 1, 1}};
+    CHECK(tree.move_proxy(proxy, far));
+    CHECK(tree.fat_box(proxy).contains(far));
+
+    tree.destroy_proxy(proxy);
+    CHECK(tree.proxy_count() == 0);
+    CHECK(tree.height() == 0);
+}
+
+TEST_CASE(aabb_tree_raycast_finds_the_closest_box) {
+    constexpr int COUNT = 5000;
+    BoxGenerator generate(2);
+
+    AabbTree tree;
+    std::vector<AabbTree::Box> boxes;
+    for (int i = 0; i < COUNT; ++i) {
+        boxes.push_back(generate());
+        tree.create_proxy(boxes.back(), i);
+    }
+
+    const DirectX::XMFLOAT3 origin{-150.0f, 0.5f, 0.5f};
+    const DirectX::XMFLOAT3 direction{300.0f, 0.0f, 0.0f};
+
+    // The closest hit clips the ray with the tight box of each candidate.
+    int closest = -1;
+    float closest_distance = 1.0f;
+    tree.raycast(origin, direction, 1.0f, [&](std::uint32_t user_data, float) {
+        float distance;
+        if (AabbTree::intersect_ray(boxes[user_data], origin, direction, closest_distance, distance)) {
+            closest = static_cast<int>(user_data);
+            closest_distance = distance;
+        }
+        return closest_distance;
+    });
+
+    int expected = -1;
+    float expected_distance = 1.0f;
+    for (int i = 0; i < COUNT; ++i) {
+        float distance;
+        if (AabbTree::intersect_ray(boxes[i], origin, direction, expected_distance, distance)) {
+            expected = i;
+            expected_distance = distance;
+        }
+    }
+
+    CHECK(expected >= 0);
+    CHECK(closest == expected);
+}
+
+BENCHMARK(aabb_tree_versus_brute_force) {
+    const auto planes = make_box_planes();
+
+    for (const int count : {100000, 1000000}) {
+        const auto suffix = ", " + std::to_string(count) + " proxies";
+
+        BoxGenerator generate(3);
+        std::vector<AabbTree::Box> boxes(count);
+        for (auto &box : boxes) box = generate();
+
+        AabbTree tree;
+        std::vector<int> proxies(count);
+        test_runner::measure("build" + suffix, 1, [&]() {
+            tree = AabbTree();
+            for (int i = 0; i < count; ++i) {
+                proxies[i] = tree.create_proxy(boxes[i], i);
+            }
+        });
+
+        // 1% of the proxies move, both within and out of their margins.
+        test_runner::measure("refit 1%" + suffix, 10, [&]() {
+            for (int i = 0; i < count; i += 100) {
+                const float offset = generate.offset() * 50.0f;
+                boxes[i].min.x += offset;
+                boxes[i].max.x += offset;
+                tree.move_proxy(proxies[i], boxes[i]);
+            }
+        });
+
+        test_runner::measure("frustum query" + suffix, 10, [&]() {
+            std::size_t visible = 0;
+            tree.query_frustum(planes, [&](std::uint32_t, bool) { ++visible; });
+            test_runner::do_not_optimize(visible);
+        });
+
+        test_runner::measure("brute force" + suffix, 10, [&]() {
+            std::size_t visible = 0;
+            for (const auto &box : boxes) {
+                if (intersects_planes(planes, box)) ++visible;
+            }
+            test_runner::do_not_optimize(visible);
+        });
+    }
+}
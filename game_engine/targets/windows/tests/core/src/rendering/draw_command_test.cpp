@@ -0,0 +1,76 @@
+#include <rendering/draw_command.hpp>
+
+#include "../test_runner.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The shape of the draw commands before the buffer, for the comparison.
+// One heap allocation per draw, holding the shared references of the mesh and the material.
+struct LegacyDrawCommand {
+    virtual ~LegacyDrawCommand() = default;
+};
+
+struct LegacyMeshDrawCommand : LegacyDrawCommand {
+    LegacyMeshDrawCommand(std::shared_ptr<void> mesh, std::shared_ptr<void> material, const DirectX::XMMATRIX &matrix_m)
+        : mesh(std::move(mesh)), material(std::move(material)), matrix_m(matrix_m) {}
+
+    std::shared_ptr<void> mesh;
+    std::shared_ptr<void> material;
+    DirectX::XMMATRIX matrix_m;
+};
+
+} // namespace
+
+TEST_CASE(draw_command_buffer_indexes_in_push_order) {
+    DrawCommandBuffer buffer;
+    for (int i = 0; i < 100; ++i) {
+        const auto matrix_m = DirectX::XMMatrixTranslation(static_cast<float>(i), 0.0f, 0.0f);
+        CHECK(buffer.push(DrawCommand::make_mesh(matrix_m, nullptr, nullptr)) == static_cast<DrawCommandBuffer::Index>(i));
+    }
+    CHECK(buffer.size() == 100);
+    CHECK(DirectX::XMVectorGetX(buffer[42].matrix_m.r[3]) == 42.0f);
+    CHECK(buffer[42].type == DrawCommand::Type::Mesh);
+
+    buffer.reset();
+    CHECK(buffer.size() == 0);
+    CHECK(buffer.push(DrawCommand::make_mesh(DirectX::XMMatrixIdentity(), nullptr, nullptr)) == 0);
+}
+
+BENCHMARK(draw_command_buffer_versus_allocated_commands) {
+    const auto mesh = std::make_shared<int>(0);
+    const auto material = std::make_shared<int>(0);
+
+    for (const int count : {20000, 100000}) {
+        const auto label = [&](const char *path) {
+            return std::string(path) + " (" + std::to_string(count) + " draws)";
+        };
+
+        std::vector<std::unique_ptr<LegacyDrawCommand>> legacy_commands;
+        test_runner::measure(label("make_unique per draw"), 20, [&]() {
+            legacy_commands.clear();
+            for (int i = 0; i < count; ++i) {
+                const auto matrix_m = DirectX::XMMatrixTranslation(static_cast<float>(i), 0.0f, 0.0f);
+                legacy_commands.push_back(std::make_unique<LegacyMeshDrawCommand>(mesh, material, matrix_m));
+            }
+            test_runner::do_not_optimize(legacy_commands.back());
+        });
+
+        // The pointees are not touched by the buffer.
+        auto *mesh_backend = reinterpret_cast<MeshBackend *>(mesh.get());
+        auto *material_backend = reinterpret_cast<MaterialBackend *>(material.get());
+
+        DrawCommandBuffer buffer;
+        test_runner::measure(label("DrawCommandBuffer"), 20, [&]() {
+            buffer.reset();
+            for (int i = 0; i < count; ++i) {
+                const auto matrix_m = DirectX::XMMatrixTranslation(static_cast<float>(i), 0.0f, 0.0f);
+                buffer.push(DrawCommand::make_mesh(matrix_m, mesh_backend, material_backend));
+            }
+            test_runner::do_not_optimize(buffer[0]);
+        });
+    }
+}
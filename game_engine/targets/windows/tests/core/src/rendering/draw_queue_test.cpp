@@ -0,0 +1,180 @@
+#include <rendering/draw_queue.hpp>
+#include <rendering/render_sort_id.hpp>
+
+#include "../test_runner.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct SyntheticDraw {
+    int priority;
+    std::uint32_t shader_id;
+    std::uint32_t material_id;
+    std::uint32_t mesh_id;
+    bool is_transparent;
+    float depth;
+
+    std::uint64_t key() const {
+        return is_transparent ? DrawSortKey::make_transparent(priority, shader_id, material_id, depth)
+                              : DrawSortKey::make_opaque(priority, shader_id, material_id, mesh_id, depth);
+    }
+};
+
+std::vector<SyntheticDraw> make_draws(std::size_t count, std::uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> priority(-2, 2);
+    std::uniform_int_distribution<std::uint32_t> shader(0, 15);
+    std::uniform_int_distribution<std::uint32_t> material(0, 255);
+    std::uniform_int_distribution<std::uint32_t> mesh(0, 127);
+    std::uniform_real_distribution<float> depth(0.1f, 1000.0f);
+
+    std::vector<SyntheticDraw> draws(count);
+    for (auto &draw : draws) {
+        draw = {priority(random) * 1000, shader(random), material(random), mesh(random), random() % 8 == 0, depth(random)};
+    }
+    return draws;
+}
+
+struct IndexedKey {
+    std::uint64_t key;
+    std::uint32_t command;
+};
+
+} // namespace
+
+TEST_CASE(draw_queue_sort_matches_stable_sort) {
+    for (const std::size_t count : {0u, 1u, 2u, 3u, 100u, 10000u}) {
+        const auto draws = make_draws(count, static_cast<std::uint32_t>(count));
+
+        DrawQueue queue;
+        std::vector<IndexedKey> expected;
+        for (std::uint32_t i = 0; i < draws.size(); ++i) {
+            // Few distinct keys, so that the stability is exercised.
+            const auto key = draws[i].key() & ~std::uint64_t{0xFFFF};
+            queue.push(key, i);
+            expected.push_back({key, i});
+        }
+
+        queue.sort();
+        std::stable_sort(expected.begin(), expected.end(), [](const IndexedKey &lhs, const IndexedKey &rhs) {
+            return lhs.key < rhs.key;
+        });
+
+        CHECK(queue.size() == expected.size());
+        bool equal = true;
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            equal = equal && queue[i].key == expected[i].key && queue[i].command == expected[i].command;
+        }
+        CHECK(equal);
+    }
+}
+
+TEST_CASE(draw_queue_sort_skips_the_uniform_digits) {
+    // Only the lowest byte differs. The passes of the other bytes are skipped, and the result must still land in items_.
+    DrawQueue queue;
+    const std::uint64_t base = 0x1234567800000000ull;
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        queue.push(base | (255 - i), i);
+    }
+    queue.sort();
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        CHECK(queue[i].key == (base | i));
+    }
+}
+
+TEST_CASE(draw_sort_key_orders_the_passes) {
+    // Opaque before transparent, then the rendering priority, then the shader.
+    CHECK(DrawSortKey::make_opaque(1000, 0, 0, 0, 1.0f) < DrawSortKey::make_transparent(-1000, 0, 0, 1.0f));
+    CHECK(DrawSortKey::make_opaque(-1, 9, 0, 0, 1.0f) < DrawSortKey::make_opaque(0, 0, 0, 0, 1.0f));
+    CHECK(DrawSortKey::make_opaque(0, 1, 9, 9, 1.0f) < DrawSortKey::make_opaque(0, 2, 0, 0, 1.0f));
+    CHECK(!DrawSortKey::is_transparent(DrawSortKey::make_opaque(0, 0, 0, 0, 1.0f)));
+    CHECK(DrawSortKey::is_transparent(DrawSortKey::make_transparent(0, 0, 0, 1.0f)));
+
+    // The priorities beyond 16 bits are clamped, not wrapped.
+    CHECK(DrawSortKey::make_opaque(-100000, 0, 0, 0, 1.0f) < DrawSortKey::make_opaque(-32767, 0, 0, 0, 1.0f));
+    CHECK(DrawSortKey::make_opaque(100000, 0, 0, 0, 1.0f) > DrawSortKey::make_opaque(32766, 0, 0, 0, 1.0f));
+
+    // Opaque front to back, transparent back to front.
+    CHECK(DrawSortKey::make_opaque(0, 0, 0, 0, 1.0f) < DrawSortKey::make_opaque(0, 0, 0, 0, 100.0f));
+    CHECK(DrawSortKey::make_transparent(0, 0, 0, 100.0f) < DrawSortKey::make_transparent(0, 0, 0, 1.0f));
+
+    // The same mesh and material are adjacent regardless of the depth.
+    CHECK(DrawSortKey::make_opaque(0, 0, 1, 1, 1000.0f) < DrawSortKey::make_opaque(0, 0, 1, 2, 1.0f));
+}
+
+TEST_CASE(render_sort_id_stays_within_its_field) {
+    struct Tag {};
+    using Id = RenderSortId<Tag, 2>;
+
+    std::vector<std::unique_ptr<Id>> ids;
+    for (int i = 0; i < 4; ++i) {
+        ids.push_back(std::make_unique<Id>());
+    }
+    CHECK_THROWS(Id());
+
+    // The released id is handed out again.
+    const auto released = ids[1]->value();
+    ids[1].reset();
+    ids[1] = std::make_unique<Id>();
+    CHECK(ids[1]->value() == released);
+
+    std::vector<std::uint32_t> values;
+    for (const auto &id : ids) values.push_back(id->value());
+    std::sort(values.begin(), values.end());
+    CHECK(std::unique(values.begin(), values.end()) == values.end());
+    CHECK(values.back() < 4);
+}
+
+BENCHMARK(draw_queue_versus_node_containers) {
+    constexpr std::size_t COUNT = 100000;
+    const auto draws = make_draws(COUNT, 1);
+
+    // The containers before the queue: the groups by priority, the opaque draws by material
+    // and the transparent ones by depth.
+    struct Group {
+        std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> opaque;
+        std::multimap<float, std::uint32_t> transparent;
+    };
+
+    test_runner::measure("std::map + unordered_map + multimap (100k draws)", 20, [&]() {
+        std::map<std::pair<int, std::uint32_t>, Group> groups;
+        for (std::uint32_t i = 0; i < draws.size(); ++i) {
+            const auto &draw = draws[i];
+            auto &group = groups[{draw.priority, draw.shader_id}];
+            if (draw.is_transparent) {
+                group.transparent.emplace(-draw.depth, i);
+            } else {
+                group.opaque[draw.material_id].push_back(i);
+            }
+        }
+
+        std::uint64_t checksum = 0;
+        for (const auto &group : groups) {
+            for (const auto &material : group.second.opaque) {
+                for (const auto command : material.second) checksum += command;
+            }
+            for (const auto &item : group.second.transparent) checksum += item.second;
+        }
+        test_runner::do_not_optimize(checksum);
+    });
+
+    DrawQueue queue;
+    test_runner::measure("DrawQueue push + radix sort (100k draws)", 20, [&]() {
+        queue.clear();
+        for (std::uint32_t i = 0; i < draws.size(); ++i) {
+            queue.push(draws[i].key(), i);
+        }
+        queue.sort();
+
+        std::uint64_t checksum = 0;
+        for (const auto &item : queue) checksum += item.command;
+        test_runner::do_not_optimize(checksum);
+    });
+}
@@ -0,0 +1,174 @@
+#include <rendering/frustum_culling.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+CullingPlanes make_camera_planes() {
+    using namespace DirectX;
+    const auto matrix_v = XMMatrixInverse(nullptr, XMMatrixRotationY(0.3f) * XMMatrixTranslation(5.0f, 2.0f, -20.0f));
+    const auto matrix_p = XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+    return CullingPlanes::from_view_projection(matrix_v * matrix_p);
+}
+
+struct Box {
+    float center[3];
+    float extents[3];
+};
+
+enum class Classification {
+    Outside,
+    Straddling,
+    Inside
+};
+
+/**
+ * @brief The reference test, in double over the eight corners. Outside if all the corners are behind one plane.
+ *
+ * @param margin Set to the smallest distance of a decision from its threshold, so the ties can be avoided.
+ */
+Classification classify(const CullingPlanes &planes, const Box &box, double &margin) {
+    bool is_inside = true;
+    margin = 1e30;
+    for (int p = 0; p < CullingPlanes::PLANE_COUNT; ++p) {
+        const double normal[3] = {planes.nx[p], planes.ny[p], planes.nz[p]};
+        double min_distance = 1e30;
+        double max_distance = -1e30;
+        for (int corner = 0; corner < 8; ++corner) {
+            double distance = planes.d[p];
+            for (int axis = 0; axis < 3; ++axis) {
+                const double sign = (corner >> axis) & 1 ? 1.0 : -1.0;
+                distance += normal[axis] * (box.center[axis] + sign * box.extents[axis]);
+            }
+            min_distance = (std::min)(min_distance, distance);
+            max_distance = (std::max)(max_distance, distance);
+        }
+
+        const double scale = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        margin = (std::min)(margin, (std::min)(std::abs(min_distance), std::abs(max_distance)) / scale);
+
+        if (max_distance < 0.0) return Classification::Outside;
+        if (min_distance < 0.0) is_inside = false;
+    }
+    return is_inside ? Classification::Inside : Classification::Straddling;
+}
+
+/**
+ * @brief Random boxes around the frustum. Many straddle a plane. The boxes within a tie of a plane are regenerated.
+ */
+std::vector<Box> make_boxes(const CullingPlanes &planes, std::size_t count, std::uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+    std::uniform_real_distribution<float> extent(0.0f, 20.0f);
+
+    std::vector<Box> boxes;
+    while (boxes.size() < count) {
+        Box box{{position(random), position(random), position(random) + 100.0f},
+                {extent(random), extent(random), extent(random)}};
+        double margin;
+        classify(planes, box, margin);
+        if (margin > 1e-3) boxes.push_back(box);
+    }
+    return boxes;
+}
+
+WorldBoundsArray to_bounds_array(const std::vector<Box> &boxes) {
+    WorldBoundsArray bounds;
+    bounds.resize(boxes.size());
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        nodec::gfx::BoundingBox local_bounds;
+        local_bounds.center.set(boxes[i].center[0], boxes[i].center[1], boxes[i].center[2]);
+        local_bounds.extents.set(boxes[i].extents[0], boxes[i].extents[1], boxes[i].extents[2]);
+        bounds.set(i, local_bounds, DirectX::XMMatrixIdentity());
+    }
+    return bounds;
+}
+
+} // namespace
+
+TEST_CASE(cull_world_bounds_matches_the_scalar_test) {
+    const auto planes = make_camera_planes();
+
+    // Not a multiple of 4, so the last group reads the padding.
+    constexpr std::size_t COUNT = 4099;
+    const auto boxes = make_boxes(planes, COUNT, 1);
+    const auto bounds = to_bounds_array(boxes);
+
+    std::vector<std::uint64_t> visible_bits(visibility_word_count(COUNT), ~std::uint64_t{0});
+    std::vector<std::uint64_t> inside_bits(visibility_word_count(COUNT), ~std::uint64_t{0});
+    cull_world_bounds(planes, bounds, 0, COUNT, visible_bits.data(), inside_bits.data());
+
+    std::size_t counts[3]{};
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < COUNT; ++i) {
+        double margin;
+        const auto expected = classify(planes, boxes[i], margin);
+        ++counts[static_cast<int>(expected)];
+
+        const bool visible = test_visibility_bit(visible_bits.data(), i);
+        const bool inside = test_visibility_bit(inside_bits.data(), i);
+        if (visible != (expected != Classification::Outside)
+            || inside != (expected == Classification::Inside)
+            || visible != test_world_bounds(planes, bounds, i)) {
+            ++mismatches;
+        }
+    }
+    CHECK(mismatches == 0);
+
+    // The input exercises all three cases.
+    CHECK(counts[static_cast<int>(Classification::Outside)] > COUNT / 10);
+    CHECK(counts[static_cast<int>(Classification::Straddling)] > COUNT / 10);
+    CHECK(counts[static_cast<int>(Classification::Inside)] > COUNT / 20);
+
+    // The bits past the end are cleared.
+    CHECK((visible_bits.back() >> (COUNT % 64)) == 0);
+    CHECK((inside_bits.back() >> (COUNT % 64)) == 0);
+}
+
+TEST_CASE(cull_world_bounds_writes_only_the_words_of_its_range) {
+    const auto planes = make_camera_planes();
+
+    constexpr std::size_t COUNT = 1001;
+    const auto boxes = make_boxes(planes, COUNT, 2);
+    const auto bounds = to_bounds_array(boxes);
+
+    std::vector<std::uint64_t> whole(visibility_word_count(COUNT));
+    cull_world_bounds(planes, bounds, 0, COUNT, whole.data());
+
+    // Two ranges like two chunks, the first ending within a word of four boxes.
+    std::vector<std::uint64_t> split(visibility_word_count(COUNT), 0x5555555555555555ull);
+    cull_world_bounds(planes, bounds, 512, COUNT, split.data());
+    CHECK(split[0] == 0x5555555555555555ull);
+    cull_world_bounds(planes, bounds, 0, 511, split.data());
+
+    // The box 511 was never tested by the split calls.
+    split[511 / 64] |= whole[511 / 64] & (std::uint64_t{1} << (511 % 64));
+    CHECK(split == whole);
+}
+
+BENCHMARK(cull_world_bounds_throughput) {
+    const auto planes = make_camera_planes();
+
+    for (const std::size_t count : {10000u, 100000u, 1000000u}) {
+        const auto bounds = to_bounds_array(make_boxes(planes, count, 3));
+        std::vector<std::uint64_t> visible_bits(visibility_word_count(count));
+
+        test_runner::measure("test_world_bounds per box, " + std::to_string(count) + " boxes", 10, [&]() {
+            std::fill(visible_bits.begin(), visible_bits.end(), 0);
+            for (std::size_t i = 0; i < count; ++i) {
+                if (test_world_bounds(planes, bounds, i)) visible_bits[i / 64] |= std::uint64_t{1} << (i % 64);
+            }
+            test_runner::do_not_optimize(visible_bits);
+        });
+
+        test_runner::measure("cull_world_bounds, " + std::to_string(count) + " boxes", 10, [&]() {
+            cull_world_bounds(planes, bounds, 0, count, visible_bits.data());
+            test_runner::do_not_optimize(visible_bits);
+        });
+    }
+}
@@ -0,0 +1,131 @@
+#include <rendering/instance_batcher.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace {
+
+// The batcher compares the pointers only, so the backends are stand-in addresses.
+alignas(8) char mesh_storage[4];
+alignas(8) char material_storage[4];
+
+MeshBackend *mesh(int index) {
+    return reinterpret_cast<MeshBackend *>(mesh_storage + index);
+}
+
+MaterialBackend *material(int index) {
+    return reinterpret_cast<MaterialBackend *>(material_storage + index);
+}
+
+struct Submission {
+    DrawCommandBuffer commands;
+    DrawQueue queue;
+
+    void push_mesh(int mesh_index, int material_index, float x, bool is_transparent = false) {
+        const auto command = commands.push(DrawCommand::make_mesh(DirectX::XMMatrixTranslation(x, 0.0f, 0.0f),
+                                                                  mesh(mesh_index), material(material_index)));
+        // The queue is already in the order of the pushes.
+        const std::uint64_t key = is_transparent ? DrawSortKey::make_transparent(0, 0, 0, 1.0f) : command;
+        queue.push(key, command);
+    }
+
+    void push_image(int material_index) {
+        const auto command = commands.push(DrawCommand::make_image(DirectX::XMMatrixIdentity(), nullptr,
+                                                                   material(material_index), {1.0f, 1.0f, 1.0f, 1.0f}));
+        queue.push(command, command);
+    }
+};
+
+const auto instance_all = [](const DrawCommand &) { return true; };
+
+} // namespace
+
+TEST_CASE(instance_batcher_batches_the_runs_of_the_same_mesh_and_material) {
+    Submission submission;
+    submission.push_mesh(0, 0, 1.0f);
+    submission.push_mesh(0, 0, 2.0f);
+    submission.push_mesh(0, 0, 3.0f);
+    submission.push_mesh(1, 0, 4.0f); // Single, not worth an instanced draw.
+    submission.push_mesh(2, 1, 5.0f);
+    submission.push_mesh(2, 1, 6.0f);
+
+    InstanceBatcher batcher;
+    batcher.build(submission.queue, submission.commands, instance_all);
+
+    const auto &batches = batcher.batches();
+    CHECK(batches.size() == 2);
+    if (batches.size() != 2) return;
+
+    CHECK(batches[0].begin == 0 && batches[0].end == 3);
+    CHECK(batches[0].first_instance == 0);
+    CHECK(batches[0].instance_count() == 3);
+    CHECK(batches[1].begin == 4 && batches[1].end == 6);
+    CHECK(batches[1].first_instance == 3);
+
+    // The instances are packed in the batch order.
+    CHECK(batcher.instances().size() == 5);
+    const float expected_x[] = {1.0f, 2.0f, 3.0f, 5.0f, 6.0f};
+    for (std::size_t i = 0; i < batcher.instances().size(); ++i) {
+        const auto &instance = batcher.instances()[i];
+        CHECK(instance.matrix_m.m[3][0] == expected_x[i]);
+        CHECK(instance.matrix_m_inverse.m[3][0] == -expected_x[i]);
+    }
+}
+
+TEST_CASE(instance_batcher_skips_the_transparent_and_the_non_mesh_commands) {
+    Submission submission;
+    submission.push_mesh(0, 0, 1.0f, true);
+    submission.push_mesh(0, 0, 2.0f, true);
+    submission.push_mesh(0, 0, 3.0f);
+    submission.push_image(0);
+    submission.push_mesh(0, 0, 4.0f);
+    submission.push_mesh(0, 0, 5.0f);
+    submission.push_mesh(0, 0, 6.0f, true);
+
+    InstanceBatcher batcher;
+    batcher.build(submission.queue, submission.commands, instance_all);
+
+    // The image and the transparent draw break the run.
+    CHECK(batcher.batches().size() == 1);
+    if (batcher.batches().empty()) return;
+    CHECK(batcher.batches()[0].begin == 4 && batcher.batches()[0].end == 6);
+}
+
+TEST_CASE(instance_batcher_respects_the_shaders_without_instancing) {
+    Submission submission;
+    submission.push_mesh(0, 0, 1.0f);
+    submission.push_mesh(0, 0, 2.0f);
+    submission.push_mesh(0, 1, 3.0f);
+    submission.push_mesh(0, 1, 4.0f);
+
+    InstanceBatcher batcher;
+    batcher.build(submission.queue, submission.commands, [](const DrawCommand &command) {
+        return command.material != material(0);
+    });
+
+    CHECK(batcher.batches().size() == 1);
+    if (batcher.batches().empty()) return;
+    CHECK(batcher.batches()[0].begin == 2);
+
+    // The rebuild starts over.
+    batcher.build(submission.queue, submission.commands, [](const DrawCommand &) { return false; });
+    CHECK(batcher.batches().empty());
+    CHECK(batcher.instances().empty());
+}
+
+BENCHMARK(instance_batcher_build) {
+    for (const int run_length : {1, 16, 256}) {
+        Submission submission;
+        for (int i = 0; i < 100000; ++i) {
+            submission.push_mesh((i / run_length) % 4, 0, static_cast<float>(i));
+        }
+
+        InstanceBatcher batcher;
+        test_runner::measure("build, 100k draws in runs of " + std::to_string(run_length), 20, [&]() {
+            batcher.build(submission.queue, submission.commands, instance_all);
+            test_runner::do_not_optimize(batcher.batches());
+        });
+    }
+}
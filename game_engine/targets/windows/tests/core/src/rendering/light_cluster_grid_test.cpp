@@ -0,0 +1,153 @@
+#include <rendering/light_cluster_grid.hpp>
+
+#include "../test_runner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr float NEAR_CLIP = 0.1f;
+constexpr float FAR_CLIP = 100.0f;
+constexpr float FOV_Y = 1.0471976f; // 60 degrees.
+constexpr float ASPECT = 16.0f / 9.0f;
+
+/**
+ * @brief The view of the camera at the origin looking down +z.
+ */
+struct View {
+    DirectX::XMMATRIX matrix_v{DirectX::XMMatrixIdentity()};
+    DirectX::XMMATRIX matrix_p{DirectX::XMMatrixPerspectiveFovLH(FOV_Y, ASPECT, NEAR_CLIP, FAR_CLIP)};
+    CullingPlanes planes{CullingPlanes::from_view_projection(matrix_v * matrix_p)};
+
+    void build(LightClusterGrid &grid, const std::vector<LightClusterGrid::PointLight> &lights,
+               nodec::concurrent::ThreadPoolExecutor &executor) const {
+        grid.build(lights, planes, matrix_v, matrix_p, NEAR_CLIP, FAR_CLIP, executor);
+    }
+};
+
+std::vector<LightClusterGrid::PointLight> make_lights(std::size_t count, std::uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> x(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> y(-36.0f, 36.0f);
+    // Some behind the camera and beyond the far plane.
+    std::uniform_real_distribution<float> z(-10.0f, 110.0f);
+    std::uniform_real_distribution<float> range(0.5f, 8.0f);
+
+    std::vector<LightClusterGrid::PointLight> lights(count);
+    for (auto &light : lights) {
+        light = {{x(random), y(random), z(random)}, range(random)};
+    }
+    return lights;
+}
+
+bool contains_light(const LightClusterGrid &grid, std::uint32_t cluster, std::uint32_t light) {
+    const auto range = grid.cluster_ranges()[cluster];
+    const auto begin = grid.light_indices().begin() + range.offset;
+    return std::find(begin, begin + range.count, light) != begin + range.count;
+}
+
+} // namespace
+
+TEST_CASE(light_cluster_grid_lists_every_light_reaching_a_point_of_the_cluster) {
+    const View view;
+    const auto lights = make_lights(1000, 1);
+
+    LightClusterGrid grid;
+    nodec::concurrent::ThreadPoolExecutor executor;
+    view.build(grid, lights, executor);
+    CHECK(grid.visible_light_count() > 0);
+    CHECK(grid.visible_light_count() < lights.size());
+
+    // Random points of the frustum, found in their clusters like the lighting shader does.
+    std::mt19937 random(2);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float tan_y = std::tan(FOV_Y * 0.5f);
+    const float tan_x = tan_y * ASPECT;
+
+    std::size_t missing = 0;
+    for (int sample = 0; sample < 2000; ++sample) {
+        const float u = unit(random);
+        const float v = unit(random);
+        const float depth = NEAR_CLIP * std::pow(FAR_CLIP / NEAR_CLIP, unit(random) * 0.999f);
+        const float x = (u * 2.0f - 1.0f) * depth * tan_x;
+        const float y = (1.0f - v * 2.0f) * depth * tan_y;
+
+        const auto cluster_x = (std::min)(static_cast<std::uint32_t>(u * LightClusterGrid::CLUSTER_COUNT_X), LightClusterGrid::CLUSTER_COUNT_X - 1);
+        const auto cluster_y = (std::min)(static_cast<std::uint32_t>(v * LightClusterGrid::CLUSTER_COUNT_Y), LightClusterGrid::CLUSTER_COUNT_Y - 1);
+        const auto slice = static_cast<int>(std::floor(std::log(depth) * grid.z_slice_scale() + grid.z_slice_bias()));
+        const auto cluster_z = static_cast<std::uint32_t>((std::min)((std::max)(slice, 0), static_cast<int>(LightClusterGrid::CLUSTER_COUNT_Z) - 1));
+        const auto cluster = (cluster_z * LightClusterGrid::CLUSTER_COUNT_Y + cluster_y) * LightClusterGrid::CLUSTER_COUNT_X + cluster_x;
+
+        for (std::uint32_t i = 0; i < lights.size(); ++i) {
+            const auto &light = lights[i];
+            const float dx = light.position.x - x;
+            const float dy = light.position.y - y;
+            const float dz = light.position.z - depth;
+            if (dx * dx + dy * dy + dz * dz >= light.range * light.range) continue;
+            if (!contains_light(grid, cluster, i)) ++missing;
+        }
+    }
+    CHECK(missing == 0);
+}
+
+TEST_CASE(light_cluster_grid_packs_the_lists_in_the_light_order) {
+    const View view;
+    auto lights = make_lights(3000, 3);
+
+    // Never listed: no range, behind the camera, beyond the far plane.
+    lights[0] = {{0.0f, 0.0f, 10.0f}, 0.0f};
+    lights[1] = {{0.0f, 0.0f, -20.0f}, 5.0f};
+    lights[2] = {{0.0f, 0.0f, 200.0f}, 5.0f};
+
+    LightClusterGrid grid;
+    nodec::concurrent::ThreadPoolExecutor executor;
+    view.build(grid, lights, executor);
+
+    // The ranges tile the index list, in the cluster order.
+    std::uint32_t offset = 0;
+    bool is_sorted = true;
+    bool is_culled = true;
+    for (const auto &range : grid.cluster_ranges()) {
+        CHECK(range.offset == offset);
+        offset += range.count;
+
+        const auto begin = grid.light_indices().begin() + range.offset;
+        is_sorted = is_sorted && std::adjacent_find(begin, begin + range.count, std::greater_equal<std::uint32_t>()) == begin + range.count;
+        is_culled = is_culled && std::none_of(begin, begin + range.count, [](std::uint32_t light) { return light < 3; });
+    }
+    CHECK(offset == grid.light_indices().size());
+    CHECK(is_sorted);
+    CHECK(is_culled);
+
+    // The rebuild with no lights clears every cluster.
+    view.build(grid, {}, executor);
+    CHECK(grid.visible_light_count() == 0);
+    CHECK(grid.light_indices().empty());
+    CHECK(std::all_of(grid.cluster_ranges().begin(), grid.cluster_ranges().end(),
+                      [](const LightClusterGrid::ClusterRange &range) { return range.count == 0; }));
+}
+
+BENCHMARK(light_cluster_grid_build) {
+    const View view;
+    nodec::concurrent::ThreadPoolExecutor executor;
+
+    for (const std::size_t count : {1000u, 10000u}) {
+        const auto lights = make_lights(count, 4);
+
+        LightClusterGrid grid;
+        test_runner::measure("build, " + std::to_string(count) + " lights", 20, [&]() {
+            view.build(grid, lights, executor);
+            test_runner::do_not_optimize(grid.light_indices());
+        });
+
+        // Each pixel loops over its cluster instead of every light.
+        std::printf("  %zu visible lights, %.1f lights per cluster on average\n", grid.visible_light_count(),
+                    static_cast<double>(grid.light_indices().size()) / LightClusterGrid::CLUSTER_COUNT);
+    }
+}
@@ -0,0 +1,184 @@
+#include <rendering/material_property_block.hpp>
+#include <rendering/material_property_id.hpp>
+#include <rendering/material_property_layout.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The property memory of a shader with the image, mask and color properties, looked up by name.
+ *
+ * This is the lookup before the ids. MaterialPropertyLayout is the one of ShaderBackend.
+ */
+struct TextShaderProperties {
+    std::vector<std::uint8_t> memory = std::vector<std::uint8_t>(32);
+    std::unordered_map<std::string, std::size_t> vector4_offsets{{"color", 0}, {"outline_color", 16}};
+    std::unordered_map<std::string, std::size_t> texture_slots{{"image", 0}, {"mask", 1}};
+};
+
+struct FloatProperty {
+    std::string name;
+    float default_value;
+};
+
+struct Vector4Property {
+    std::string name;
+    nodec::Vector4f default_value;
+};
+
+struct TextureProperty {
+    std::string name;
+};
+
+//! The layout ShaderBackend makes for the text shader.
+MaterialPropertyLayout text_shader_layout() {
+    return MaterialPropertyLayout(std::vector<FloatProperty>{},
+                                  std::vector<Vector4Property>{{"color", {1.0f, 1.0f, 1.0f, 1.0f}}, {"outline_color", {0.0f, 0.0f, 0.0f, 1.0f}}},
+                                  std::vector<TextureProperty>{{"image"}, {"mask"}});
+}
+
+struct TextureEntry {
+    TextureBackend *texture{nullptr};
+    nodec_rendering::Sampler sampler;
+};
+
+} // namespace
+
+TEST_CASE(material_property_id_interns_each_name_once) {
+    const auto color = MaterialPropertyId::intern("material_property_test_color");
+    const auto mask = MaterialPropertyId::intern("material_property_test_mask");
+    CHECK(color != mask);
+    CHECK(MaterialPropertyId::intern("material_property_test_color") == color);
+    CHECK(MaterialPropertyId::find("material_property_test_mask") && *MaterialPropertyId::find("material_property_test_mask") == mask);
+
+    // The names no shader declares are never registered by the lookups.
+    CHECK(!MaterialPropertyId::find("material_property_test_unknown"));
+}
+
+TEST_CASE(material_property_id_interns_from_several_threads) {
+    constexpr int NAME_COUNT = 200;
+    std::vector<std::vector<std::uint32_t>> ids(4, std::vector<std::uint32_t>(NAME_COUNT));
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < ids.size(); ++t) {
+        threads.emplace_back([&ids, t]() {
+            for (int i = 0; i < NAME_COUNT; ++i) {
+                ids[t][i] = MaterialPropertyId::intern("material_property_test_thread_" + std::to_string(i)).value();
+            }
+        });
+    }
+    for (auto &thread : threads) thread.join();
+
+    for (std::size_t t = 1; t < ids.size(); ++t) {
+        CHECK(ids[t] == ids[0]);
+    }
+}
+
+TEST_CASE(material_property_block_overrides_each_property_once) {
+    const auto color = MaterialPropertyId::intern("color");
+    const auto outline_color = MaterialPropertyId::intern("outline_color");
+    const auto image = MaterialPropertyId::intern("image");
+
+    MaterialPropertyBlock block;
+    block.set_vector4(color, {1.0f, 0.0f, 0.0f, 1.0f});
+    block.set_vector4(outline_color, {0.0f, 0.0f, 0.0f, 1.0f});
+    block.set_vector4(color, {0.0f, 1.0f, 0.0f, 1.0f});
+    block.set_texture(image, nullptr, {});
+
+    CHECK(block.vector4_overrides().size() == 2);
+    CHECK(block.vector4_overrides()[0].id == color);
+    CHECK(block.vector4_overrides()[0].value.y == 1.0f);
+    CHECK(block.texture_overrides().size() == 1);
+
+    block.clear();
+    CHECK(block.vector4_overrides().empty());
+    CHECK(block.texture_overrides().empty());
+}
+
+TEST_CASE(material_property_layout_packs_the_constants_and_applies_the_block) {
+    const MaterialPropertyLayout layout(std::vector<FloatProperty>{{"material_property_test_metallic", 0.5f}},
+                                        std::vector<Vector4Property>{{"material_property_test_albedo", {1.0f, 0.0f, 0.0f, 1.0f}}},
+                                        std::vector<TextureProperty>{{"material_property_test_albedo_map"}, {"material_property_test_normal_map"}});
+    const auto metallic = *MaterialPropertyId::find("material_property_test_metallic");
+    const auto albedo = *MaterialPropertyId::find("material_property_test_albedo");
+    const auto normal_map = *MaterialPropertyId::find("material_property_test_normal_map");
+
+    // The float is padded to a register before the vector4.
+    auto memory = layout.create_property_memory();
+    CHECK(memory.size() == 32);
+    CHECK(layout.float_property_offset(metallic) && *layout.float_property_offset(metallic) == 0);
+    CHECK(layout.vector4_property_offset(albedo) && *layout.vector4_property_offset(albedo) == 16);
+    CHECK(!layout.vector4_property_offset(metallic));
+    CHECK(layout.texture_slot(normal_map) && *layout.texture_slot(normal_map) == 1);
+    CHECK(layout.get_float_property(memory, metallic) == 0.5f);
+    CHECK_THROWS(layout.get_float_property(memory, albedo));
+
+    // The overrides of the other shaders are skipped.
+    MaterialPropertyBlock block;
+    block.set_vector4(albedo, {0.0f, 1.0f, 0.0f, 1.0f});
+    block.set_vector4(MaterialPropertyId::intern("material_property_test_other"), {0.0f, 0.0f, 1.0f, 1.0f});
+    block.set_texture(normal_map, nullptr, {});
+    layout.apply_vector4_overrides(memory, block);
+    CHECK(layout.get_vector4_property(memory, albedo)->y == 1.0f);
+    CHECK(layout.find_texture_override(block, 1) == &block.texture_overrides()[0]);
+    CHECK(!layout.find_texture_override(block, 0));
+}
+
+BENCHMARK(material_property_binding_of_10k_glyphs) {
+    constexpr int GLYPH_COUNT = 10000;
+    TextShaderProperties shader;
+    std::vector<TextureEntry> texture_entries(2);
+    const nodec::Vector4f glyph_color{1.0f, 1.0f, 1.0f, 1.0f};
+
+    // Before: each glyph backs up, sets and restores the image, mask and color of the shared material by name.
+    test_runner::measure("backup, set and restore by name", 20, [&]() {
+        for (int i = 0; i < GLYPH_COUNT; ++i) {
+            const auto prev_image = texture_entries[shader.texture_slots.at("image")];
+            const auto prev_mask = texture_entries[shader.texture_slots.at("mask")];
+            nodec::Vector4f prev_color;
+            std::memcpy(&prev_color, &shader.memory[shader.vector4_offsets.at("color")], sizeof(prev_color));
+
+            texture_entries[shader.texture_slots.at("image")] = {};
+            texture_entries[shader.texture_slots.at("mask")] = {};
+            std::memcpy(&shader.memory[shader.vector4_offsets.at("color")], &glyph_color, sizeof(glyph_color));
+            test_runner::do_not_optimize(shader.memory);
+
+            texture_entries[shader.texture_slots.at("image")] = prev_image;
+            texture_entries[shader.texture_slots.at("mask")] = prev_mask;
+            std::memcpy(&shader.memory[shader.vector4_offsets.at("color")], &prev_color, sizeof(prev_color));
+        }
+    });
+
+    // After: the ids are resolved once, and the block is applied through the layout of the shader on a copy of
+    // the constants, as MaterialBackend::bind_constant_buffer and SceneRendererContext::bind_texture_entries do.
+    const auto layout = text_shader_layout();
+    const auto material_memory = layout.create_property_memory();
+    const auto image = MaterialPropertyId::intern("image");
+    const auto mask = MaterialPropertyId::intern("mask");
+    const auto color = MaterialPropertyId::intern("color");
+    MaterialPropertyBlock block;
+    std::vector<std::uint8_t> staging;
+    test_runner::measure("property block by id", 20, [&]() {
+        for (int i = 0; i < GLYPH_COUNT; ++i) {
+            block.clear();
+            block.set_texture(image, nullptr, {});
+            block.set_texture(mask, nullptr, {});
+            block.set_vector4(color, glyph_color);
+
+            staging = material_memory;
+            layout.apply_vector4_overrides(staging, block);
+            for (std::size_t slot = 0; slot < texture_entries.size(); ++slot) {
+                test_runner::do_not_optimize(layout.find_texture_override(block, slot));
+            }
+            test_runner::do_not_optimize(staging);
+        }
+    });
+}
@@ -0,0 +1,214 @@
+#include <rendering/mesh_file.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The file in memory, aligned to 16 bytes like the mapped views are.
+ */
+class AlignedFile {
+public:
+    explicit AlignedFile(const std::string &bytes)
+        : blocks_((bytes.size() + sizeof(Block) - 1) / sizeof(Block)), size_(bytes.size()) {
+        std::memcpy(blocks_.data(), bytes.data(), bytes.size());
+    }
+
+    std::uint8_t *data() noexcept {
+        return reinterpret_cast<std::uint8_t *>(blocks_.data());
+    }
+
+    mesh_file::Header &header() noexcept {
+        return *reinterpret_cast<mesh_file::Header *>(blocks_.data());
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+private:
+    struct alignas(mesh_file::ALIGNMENT) Block {
+        std::uint8_t bytes[mesh_file::ALIGNMENT];
+    };
+
+    std::vector<Block> blocks_;
+    std::size_t size_;
+};
+
+struct SourceMesh {
+    std::vector<CompactVertex> vertices;
+    std::vector<std::uint32_t> indices;
+    nodec::gfx::BoundingBox bounds;
+};
+
+SourceMesh make_grid(std::uint32_t vertex_count) {
+    SourceMesh mesh;
+    for (std::uint32_t i = 0; i < vertex_count; ++i) {
+        const nodec::Vector3f position(static_cast<float>(i % 256), static_cast<float>(i / 256), 0.0f);
+        mesh.vertices.push_back(pack_compact_vertex(position, {0.0f, 0.0f, -1.0f}, {position.x / 256, position.y / 256}, {1.0f, 0.0f, 0.0f}));
+    }
+    // The last vertex comes first, so the index needs all the bits.
+    for (std::uint32_t i = 0; i + 2 < vertex_count; i += 3) {
+        mesh.indices.insert(mesh.indices.end(), {vertex_count - 1 - i, i + 1, i + 2});
+    }
+    mesh.bounds.center.set(127.5f, 0.5f * ((vertex_count - 1) / 256), 0.0f);
+    mesh.bounds.extents.set(127.5f, 0.5f * ((vertex_count - 1) / 256), 0.0f);
+    return mesh;
+}
+
+std::string write(const SourceMesh &mesh) {
+    std::ostringstream out;
+    mesh_file::write_mesh_file(out, VertexFormat::Compact, mesh.vertices.data(), static_cast<std::uint32_t>(mesh.vertices.size()),
+                               mesh.indices.data(), static_cast<std::uint32_t>(mesh.indices.size()), mesh.bounds);
+    return out.str();
+}
+
+template<typename Index>
+bool indices_equal(const void *data, const std::vector<std::uint32_t> &expected) {
+    const auto *indices = static_cast<const Index *>(data);
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        if (indices[i] != expected[i]) return false;
+    }
+    return true;
+}
+
+bool is_rejected(AlignedFile &file, std::size_t size) {
+    try {
+        mesh_file::parse_mesh_file(file.data(), size);
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief The vertex of the cereal meshes, and of MeshBackend::vertices.
+ */
+struct FloatVertex {
+    nodec::Vector3f position;
+    nodec::Vector3f normal;
+    nodec::Vector2f uv;
+    nodec::Vector3f tangent;
+};
+
+} // namespace
+
+TEST_CASE(mesh_file_round_trips_the_vertices_indices_and_bounds) {
+    // 16 bit indices up to 0x10000 vertices, 32 bit above.
+    for (const std::uint32_t vertex_count : {300u, 0x10000u, 0x10001u}) {
+        const auto mesh = make_grid(vertex_count);
+        AlignedFile file(write(mesh));
+        CHECK(mesh_file::is_mesh_file(file.data(), file.size()));
+
+        const auto view = mesh_file::parse_mesh_file(file.data(), file.size());
+        const auto &header = *view.header;
+        const bool is_wide = vertex_count > 0x10000;
+        CHECK(header.index_size == (is_wide ? 4 : 2));
+        CHECK(header.vertex_format == static_cast<std::uint8_t>(VertexFormat::Compact));
+        CHECK(header.vertex_count == vertex_count);
+        CHECK(header.index_count == mesh.indices.size());
+        CHECK(header.bounds_center[0] == mesh.bounds.center.x && header.bounds_center[1] == mesh.bounds.center.y);
+        CHECK(header.bounds_extents[0] == mesh.bounds.extents.x && header.bounds_extents[1] == mesh.bounds.extents.y);
+
+        // The sections are aligned for the buffer creation.
+        CHECK(reinterpret_cast<std::uintptr_t>(view.vertices) % mesh_file::ALIGNMENT == 0);
+        CHECK(reinterpret_cast<std::uintptr_t>(view.indices) % mesh_file::ALIGNMENT == 0);
+        CHECK(std::memcmp(view.vertices, mesh.vertices.data(), mesh.vertices.size() * sizeof(CompactVertex)) == 0);
+        CHECK(is_wide ? indices_equal<std::uint32_t>(view.indices, mesh.indices)
+                      : indices_equal<std::uint16_t>(view.indices, mesh.indices));
+    }
+}
+
+TEST_CASE(mesh_file_rejects_the_broken_headers_and_sections) {
+    const auto mesh = make_grid(300);
+    const auto bytes = write(mesh);
+
+    const auto rejects = [&](void (*corrupt)(mesh_file::Header &), std::size_t size) {
+        AlignedFile file(bytes);
+        corrupt(file.header());
+        return is_rejected(file, size);
+    };
+    const auto keep = [](mesh_file::Header &) {};
+
+    CHECK(!rejects(keep, bytes.size()));
+    CHECK(rejects(keep, sizeof(mesh_file::Header) - 1));
+    CHECK(rejects(keep, bytes.size() - 1));
+    CHECK(rejects([](mesh_file::Header &header) { header.magic ^= 1; }, bytes.size()));
+    CHECK(rejects([](mesh_file::Header &header) { ++header.version; }, bytes.size()));
+    CHECK(rejects([](mesh_file::Header &header) { header.vertex_format = VERTEX_FORMAT_COUNT; }, bytes.size()));
+    CHECK(rejects([](mesh_file::Header &header) { header.index_size = 1; }, bytes.size()));
+    CHECK(rejects([](mesh_file::Header &header) { header.vertex_offset += 4; }, bytes.size()));
+    CHECK(rejects([](mesh_file::Header &header) { ++header.index_count; }, bytes.size()));
+
+    // The offsets and counts that wrap around when added.
+    CHECK(rejects([](mesh_file::Header &header) { header.vertex_offset = std::numeric_limits<std::uint64_t>::max() & ~15ull; }, bytes.size()));
+    CHECK(rejects([](mesh_file::Header &header) { header.index_offset = std::numeric_limits<std::uint64_t>::max() & ~15ull; }, bytes.size()));
+    CHECK(rejects([](mesh_file::Header &header) { header.vertex_count = std::numeric_limits<std::uint32_t>::max(); }, bytes.size()));
+}
+
+BENCHMARK(mesh_file_load) {
+    // 16 meshes of 256k vertices, about 100 MB in the cereal format.
+    constexpr std::uint32_t MESH_COUNT = 16;
+    constexpr std::uint32_t VERTEX_COUNT = 256 * 1024;
+
+    const auto mesh = make_grid(VERTEX_COUNT);
+    std::vector<AlignedFile> files;
+    for (std::uint32_t i = 0; i < MESH_COUNT; ++i) {
+        files.emplace_back(write(mesh));
+    }
+
+    std::vector<FloatVertex> float_vertices(VERTEX_COUNT);
+    for (std::uint32_t i = 0; i < VERTEX_COUNT; ++i) {
+        float_vertices[i].position.set(static_cast<float>(i % 256), static_cast<float>(i / 256), 0.0f);
+        float_vertices[i].normal.set(0.0f, 0.0f, -1.0f);
+        float_vertices[i].tangent.set(1.0f, 0.0f, 0.0f);
+    }
+    std::string cereal_bytes(reinterpret_cast<const char *>(float_vertices.data()), float_vertices.size() * sizeof(FloatVertex));
+    cereal_bytes.append(reinterpret_cast<const char *>(mesh.indices.data()), mesh.indices.size() * sizeof(std::uint32_t));
+
+    // Before: the archive is read into the serializable mesh, then copied vertex by vertex into the backend with the bounds.
+    test_runner::measure("cereal path, " + std::to_string(MESH_COUNT) + " meshes", 5, [&]() {
+        for (std::uint32_t m = 0; m < MESH_COUNT; ++m) {
+            std::vector<FloatVertex> source(VERTEX_COUNT);
+            std::vector<std::uint32_t> source_indices(mesh.indices.size());
+            std::memcpy(source.data(), cereal_bytes.data(), source.size() * sizeof(FloatVertex));
+            std::memcpy(source_indices.data(), cereal_bytes.data() + source.size() * sizeof(FloatVertex),
+                        source_indices.size() * sizeof(std::uint32_t));
+
+            std::vector<FloatVertex> vertices;
+            vertices.reserve(source.size());
+            nodec::Vector3f min = {(std::numeric_limits<float>::max)(), (std::numeric_limits<float>::max)(), (std::numeric_limits<float>::max)()};
+            nodec::Vector3f max = {-(std::numeric_limits<float>::max)(), -(std::numeric_limits<float>::max)(), -(std::numeric_limits<float>::max)()};
+            for (const auto &src : source) {
+                vertices.push_back(src);
+                min.x = (std::min)(min.x, src.position.x);
+                min.y = (std::min)(min.y, src.position.y);
+                min.z = (std::min)(min.z, src.position.z);
+                max.x = (std::max)(max.x, src.position.x);
+                max.y = (std::max)(max.y, src.position.y);
+                max.z = (std::max)(max.z, src.position.z);
+            }
+            const std::vector<std::uint32_t> triangles(source_indices.begin(), source_indices.end());
+            test_runner::do_not_optimize(vertices);
+            test_runner::do_not_optimize(triangles);
+            test_runner::do_not_optimize(max);
+        }
+    });
+
+    // After: the header is validated and the sections go to the buffer creation as they are.
+    test_runner::measure("mesh file, " + std::to_string(MESH_COUNT) + " meshes", 5, [&]() {
+        for (auto &file : files) {
+            const auto view = mesh_file::parse_mesh_file(file.data(), file.size());
+            test_runner::do_not_optimize(view);
+        }
+    });
+
+    std::printf("  %zu bytes per mesh in the cereal format, %zu in the mesh file\n", cereal_bytes.size(), files.front().size());
+}
@@ -0,0 +1,305 @@
+#include <rendering/frustum_culling.hpp>
+#include <rendering/parallel_chunks.hpp>
+
+#include "../test_executor.hpp"
+#include "../test_runner.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+WorldBoundsArray make_scattered_bounds(std::size_t count, std::uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+
+    nodec::gfx::BoundingBox local_bounds;
+    local_bounds.center.set(0.0f, 0.0f, 0.0f);
+    local_bounds.extents.set(1.0f, 1.0f, 1.0f);
+
+    WorldBoundsArray bounds;
+    bounds.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        bounds.set(i, local_bounds, DirectX::XMMatrixTranslation(position(random), position(random), position(random)));
+    }
+    return bounds;
+}
+
+CullingPlanes make_camera_planes() {
+    using namespace DirectX;
+    return CullingPlanes::from_view_projection(XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f));
+}
+
+/**
+ * @brief Entities of several submeshes laid out like the scene snapshot.
+ */
+struct SyntheticScene {
+    std::vector<std::uint32_t> first_submesh;
+    std::vector<std::uint32_t> submesh_count;
+    WorldBoundsArray entity_bounds;
+    WorldBoundsArray submesh_bounds;
+};
+
+SyntheticScene make_scene(std::size_t entity_count, std::uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+    std::uniform_real_distribution<float> offset(-30.0f, 30.0f);
+    std::uniform_int_distribution<std::uint32_t> count(1, 4);
+
+    nodec::gfx::BoundingBox local_bounds;
+    local_bounds.center.set(0.0f, 0.0f, 0.0f);
+    local_bounds.extents.set(2.0f, 2.0f, 2.0f);
+
+    SyntheticScene scene;
+    std::vector<DirectX::XMMATRIX> submesh_matrices;
+    for (std::size_t i = 0; i < entity_count; ++i) {
+        scene.first_submesh.push_back(static_cast<std::uint32_t>(submesh_matrices.size()));
+        scene.submesh_count.push_back(count(random));
+
+        const float x = position(random);
+        const float y = position(random);
+        const float z = position(random) + 100.0f;
+        for (std::uint32_t j = 0; j < scene.submesh_count.back(); ++j) {
+            submesh_matrices.push_back(DirectX::XMMatrixTranslation(x + offset(random), y + offset(random), z + offset(random)));
+        }
+    }
+
+    scene.submesh_bounds.resize(submesh_matrices.size());
+    for (std::size_t i = 0; i < submesh_matrices.size(); ++i) {
+        scene.submesh_bounds.set(i, local_bounds, submesh_matrices[i]);
+    }
+
+    scene.entity_bounds.resize(entity_count);
+    for (std::size_t i = 0; i < entity_count; ++i) {
+        scene.entity_bounds.copy(i, scene.submesh_bounds, scene.first_submesh[i]);
+        for (std::uint32_t j = 1; j < scene.submesh_count[i]; ++j) {
+            scene.entity_bounds.merge(i, scene.submesh_bounds, scene.first_submesh[i] + j);
+        }
+    }
+    return scene;
+}
+
+struct VisibleSubmesh {
+    std::uint32_t entity;
+    std::uint32_t submesh;
+
+    bool operator==(const VisibleSubmesh &other) const {
+        return entity == other.entity && submesh == other.submesh;
+    }
+};
+
+struct CullingOutput {
+    std::vector<VisibleSubmesh> submeshes;
+    SubmeshCullingStats stats;
+};
+
+/**
+ * @brief Culls the scene in chunks through cull_submeshes, the way SceneRenderer::push_mesh_draw_commands does.
+ *
+ * If @p preset_bits is not null, the entity bits are taken from it like from the spatial index query.
+ */
+CullingOutput cull_scene(TestExecutor &executor, const CullingPlanes &planes, const SyntheticScene &scene,
+                         std::size_t max_chunk_count, const std::vector<std::uint64_t> *preset_bits = nullptr) {
+    const auto entity_count = scene.entity_bounds.size();
+    std::vector<std::uint64_t> visible_bits(visibility_word_count(entity_count));
+    std::vector<std::uint64_t> inside_bits(visibility_word_count(entity_count));
+    if (preset_bits) visible_bits = *preset_bits;
+
+    const ChunkPartition partition(entity_count, 64, max_chunk_count);
+    std::vector<CullingOutput> chunk_outputs;
+    CullingOutput merged;
+
+    collect_chunks(
+        executor, partition, chunk_outputs,
+        [&](CullingOutput &output, std::size_t begin, std::size_t end) {
+            output = {};
+            cull_submeshes(
+                planes, scene.entity_bounds, scene.submesh_bounds, begin, end, preset_bits == nullptr,
+                visible_bits.data(), inside_bits.data(),
+                [&](std::size_t entity) {
+                    return std::make_pair(scene.first_submesh[entity], scene.submesh_count[entity]);
+                },
+                [&](std::size_t entity, std::size_t submesh) {
+                    output.submeshes.push_back({static_cast<std::uint32_t>(entity), static_cast<std::uint32_t>(submesh)});
+                },
+                output.stats);
+        },
+        [&](const CullingOutput &output) {
+            merged.submeshes.insert(merged.submeshes.end(), output.submeshes.begin(), output.submeshes.end());
+            merged.stats.entity_bounds_tests += output.stats.entity_bounds_tests;
+            merged.stats.submesh_bounds_tests += output.stats.submesh_bounds_tests;
+            merged.stats.submesh_bounds_tests_saved += output.stats.submesh_bounds_tests_saved;
+        });
+
+    return merged;
+}
+
+} // namespace
+
+TEST_CASE(chunk_partition_covers_the_range_in_aligned_chunks) {
+    for (const std::size_t count : {0u, 1u, 63u, 64u, 65u, 1000u, 4096u}) {
+        for (const std::size_t max_chunk_count : {1u, 2u, 3u, 7u, 16u}) {
+            const ChunkPartition partition(count, 64, max_chunk_count);
+            CHECK(partition.chunk_count() >= 1);
+            CHECK(partition.chunk_count() <= max_chunk_count);
+            CHECK(partition.begin(0) == 0);
+            CHECK(partition.end(partition.chunk_count() - 1) == count);
+
+            for (std::size_t i = 0; i < partition.chunk_count(); ++i) {
+                CHECK(partition.begin(i) % 64 == 0);
+                CHECK(partition.begin(i) <= partition.end(i));
+            }
+        }
+    }
+
+    // No more chunks than the units of the minimum size.
+    CHECK(ChunkPartition(100, 64, 16).chunk_count() == 2);
+}
+
+TEST_CASE(run_chunks_runs_every_chunk_once) {
+    TestExecutor executor(3);
+    const ChunkPartition partition(10000, 64, 8);
+
+    std::vector<std::atomic<int>> visits(10000);
+    run_chunks(executor, partition, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i) ++visits[i];
+    });
+
+    bool once = true;
+    for (const auto &visit : visits) once = once && visit == 1;
+    CHECK(once);
+}
+
+TEST_CASE(run_chunks_waits_for_every_chunk_before_rethrowing) {
+    TestExecutor executor(4);
+    const ChunkPartition partition(8 * 64, 64, 8);
+
+    std::atomic<int> finished{0};
+    bool thrown = false;
+    try {
+        run_chunks(executor, partition, [&](std::size_t chunk_index, std::size_t, std::size_t) {
+            if (chunk_index == 0) throw std::runtime_error("chunk 0");
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            if (chunk_index == 3) throw std::logic_error("chunk 3");
+            ++finished;
+        });
+    } catch (const std::runtime_error &) {
+        // The exception of the calling thread comes first.
+        thrown = true;
+    }
+
+    CHECK(thrown);
+    CHECK(finished == static_cast<int>(partition.chunk_count()) - 2);
+}
+
+TEST_CASE(collect_chunks_merges_like_one_chunk) {
+    const auto planes = make_camera_planes();
+    const auto scene = make_scene(5000, 1);
+
+    TestExecutor executor(4);
+    const auto expected = cull_scene(executor, planes, scene, 1);
+
+    // Some entities straddle the frustum, so their submeshes are tested and some of them are culled.
+    CHECK(expected.stats.entity_bounds_tests == 5000);
+    CHECK(expected.stats.submesh_bounds_tests > 0);
+    CHECK(expected.stats.submesh_bounds_tests_saved > 0);
+    CHECK(expected.submeshes.size() < expected.stats.submesh_bounds_tests + expected.stats.submesh_bounds_tests_saved);
+
+    for (const std::size_t chunk_count : {2u, 3u, 5u, 8u, 16u, 79u}) {
+        // Run a few times, so that the chunks finish in different orders.
+        for (int run = 0; run < 4; ++run) {
+            const auto actual = cull_scene(executor, planes, scene, chunk_count);
+            CHECK(actual.submeshes == expected.submeshes);
+            CHECK(actual.stats.submesh_bounds_tests == expected.stats.submesh_bounds_tests);
+            CHECK(actual.stats.submesh_bounds_tests_saved == expected.stats.submesh_bounds_tests_saved);
+            CHECK(actual.stats.entity_bounds_tests == expected.stats.entity_bounds_tests);
+        }
+    }
+}
+
+TEST_CASE(collect_chunks_keeps_the_submeshes_after_a_culled_one) {
+    // One entity straddling the left plane: the first submesh is out of the frustum, the second in it.
+    nodec::gfx::BoundingBox local_bounds;
+    local_bounds.center.set(0.0f, 0.0f, 0.0f);
+    local_bounds.extents.set(1.0f, 1.0f, 1.0f);
+
+    SyntheticScene scene;
+    scene.first_submesh = {0};
+    scene.submesh_count = {2};
+    scene.submesh_bounds.resize(2);
+    scene.submesh_bounds.set(0, local_bounds, DirectX::XMMatrixTranslation(-500.0f, 0.0f, 100.0f));
+    scene.submesh_bounds.set(1, local_bounds, DirectX::XMMatrixTranslation(0.0f, 0.0f, 100.0f));
+    scene.entity_bounds.resize(1);
+    scene.entity_bounds.copy(0, scene.submesh_bounds, 0);
+    scene.entity_bounds.merge(0, scene.submesh_bounds, 1);
+
+    TestExecutor executor(1);
+    const auto output = cull_scene(executor, make_camera_planes(), scene, 1);
+    CHECK(output.submeshes.size() == 1);
+    CHECK(output.submeshes.size() == 1 && output.submeshes[0].submesh == 1);
+    CHECK(output.stats.submesh_bounds_tests == 2);
+}
+
+TEST_CASE(cull_submeshes_takes_the_entity_bits_of_the_spatial_index) {
+    const auto planes = make_camera_planes();
+    const auto scene = make_scene(300, 2);
+
+    // The query reported the even entities, none of them as entirely inside.
+    std::vector<std::uint64_t> reported(visibility_word_count(300));
+    std::size_t reported_submeshes = 0;
+    for (std::size_t i = 0; i < 300; i += 2) {
+        reported[i / 64] |= std::uint64_t{1} << (i % 64);
+        if (scene.submesh_count[i] > 1) reported_submeshes += scene.submesh_count[i];
+    }
+
+    TestExecutor executor(2);
+    const auto output = cull_scene(executor, planes, scene, 3, &reported);
+    CHECK(output.stats.entity_bounds_tests == 0);
+    CHECK(output.stats.submesh_bounds_tests == reported_submeshes);
+
+    bool only_reported = true;
+    for (const auto &submesh : output.submeshes) only_reported = only_reported && submesh.entity % 2 == 0;
+    CHECK(only_reported);
+}
+
+BENCHMARK(parallel_culling_scaling) {
+    const auto planes = make_camera_planes();
+
+    for (const std::size_t count : {50000u, 200000u, 1000000u}) {
+        const auto bounds = make_scattered_bounds(count, 1);
+        std::vector<std::uint64_t> visible_bits(visibility_word_count(count));
+
+        for (const std::size_t thread_count : {1u, 2u, 4u, 8u, 16u}) {
+            // The calling thread takes the first chunk.
+            TestExecutor executor(thread_count - 1);
+            const ChunkPartition partition(count, 512, thread_count);
+
+            std::vector<std::vector<std::uint32_t>> chunk_outputs(partition.chunk_count());
+            std::vector<std::uint32_t> visible;
+
+            const auto label = std::to_string(count) + " entities, " + std::to_string(thread_count) + " threads";
+            test_runner::measure(label, 10, [&]() {
+                run_chunks(executor, partition, [&](std::size_t chunk_index, std::size_t begin, std::size_t end) {
+                    cull_world_bounds(planes, bounds, begin, end, visible_bits.data());
+
+                    auto &output = chunk_outputs[chunk_index];
+                    output.clear();
+                    for (auto i = begin; i < end; ++i) {
+                        if (test_visibility_bit(visible_bits.data(), i)) output.push_back(static_cast<std::uint32_t>(i));
+                    }
+                });
+
+                visible.clear();
+                for (const auto &output : chunk_outputs) {
+                    visible.insert(visible.end(), output.begin(), output.end());
+                }
+                test_runner::do_not_optimize(visible);
+            });
+        }
+    }
+}
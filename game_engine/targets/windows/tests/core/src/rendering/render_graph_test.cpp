@@ -0,0 +1,226 @@
+#include <rendering/render_graph.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+using WriteMode = RenderGraph::WriteMode;
+
+std::vector<std::string> step_names(const RenderGraph &graph, const CompiledRenderGraph &compiled) {
+    std::vector<std::string> names;
+    for (const auto &step : compiled.steps()) {
+        names.push_back(graph.passes()[step.pass].name);
+    }
+    return names;
+}
+
+/**
+ * @brief The deferred passes with the half resolution SSAO and its upsample.
+ */
+void describe_deferred_graph(RenderGraph &graph, bool with_debug_view) {
+    graph.clear();
+    const auto output = graph.import_resource("output", false);
+    const auto albedo = graph.resource("albedo");
+    const auto normal = graph.resource("normal");
+    const auto depth = graph.resource("depth");
+    const auto occlusion = graph.resource("occlusion");
+    const auto occlusion_full = graph.resource("occlusion_full");
+    const auto lit = graph.resource("lit");
+
+    graph.add_pass("gbuffer");
+    graph.write(albedo, WriteMode::Partial);
+    graph.write(normal, WriteMode::Partial);
+    graph.write(depth, WriteMode::Partial);
+
+    graph.add_pass("ssao");
+    graph.read(normal);
+    graph.read(depth);
+    graph.write(occlusion, WriteMode::Overwrite);
+
+    graph.add_pass("bilateral_upsample");
+    graph.read(occlusion);
+    graph.read(depth);
+    graph.write(occlusion_full, WriteMode::Overwrite);
+
+    if (with_debug_view) {
+        // Nothing reads it.
+        graph.add_pass("debug_normals");
+        graph.read(normal);
+        graph.write(graph.resource("debug"), WriteMode::Overwrite);
+    }
+
+    graph.add_pass("lighting");
+    graph.read(albedo);
+    graph.read(normal);
+    graph.read(occlusion_full);
+    graph.write(lit, WriteMode::Overwrite);
+
+    graph.add_pass("tonemap");
+    graph.read(lit);
+    graph.write(output, WriteMode::Overwrite);
+}
+
+} // namespace
+
+TEST_CASE(render_graph_culls_the_passes_whose_writes_nobody_reads) {
+    RenderGraph graph;
+    const auto output = graph.import_resource("output", true);
+    const auto color = graph.resource("color");
+    const auto unused = graph.resource("unused");
+    const auto history = graph.resource("history");
+
+    graph.add_pass("opaque");
+    graph.write(color, WriteMode::Partial);
+    graph.write(unused, WriteMode::Partial); // A dead write of a live pass.
+
+    graph.add_pass("unused_blur");
+    graph.read(color);
+    graph.write(unused, WriteMode::Overwrite);
+
+    graph.add_pass("capture");
+    graph.read(color);
+    graph.write(history, WriteMode::Overwrite);
+    graph.set_side_effects();
+
+    graph.add_pass("present");
+    graph.read(color);
+    graph.write(output, WriteMode::Partial);
+
+    // Overwritten before anything reads it.
+    graph.add_pass("overwritten");
+    graph.write(color, WriteMode::Overwrite);
+
+    const auto compiled = graph.compile();
+    CHECK(step_names(graph, compiled) == (std::vector<std::string>{"opaque", "capture", "present"}));
+    CHECK(compiled.culled_pass_count() == 2);
+    CHECK(compiled.is_write_live(0));
+    CHECK(!compiled.is_write_live(1));
+}
+
+TEST_CASE(render_graph_acquires_at_the_first_use_and_releases_at_the_last) {
+    RenderGraph graph;
+    describe_deferred_graph(graph, false);
+    const auto compiled = graph.compile();
+    CHECK(compiled.steps().size() == 5);
+
+    std::vector<std::uint32_t> first(graph.resources().size(), ~0u);
+    std::vector<std::uint32_t> last(graph.resources().size(), ~0u);
+    for (std::uint32_t s = 0; s < compiled.steps().size(); ++s) {
+        const auto &step = compiled.steps()[s];
+        for (std::uint32_t i = 0; i < step.acquire_count; ++i) {
+            const auto &acquire = compiled.acquires()[step.first_acquire + i];
+            CHECK(first[acquire.resource] == ~0u);
+            first[acquire.resource] = s;
+        }
+        for (std::uint32_t i = 0; i < step.release_count; ++i) {
+            last[compiled.releases()[step.first_release + i]] = s;
+        }
+    }
+
+    const auto id = [&](const char *name) { return graph.resource(name); };
+    CHECK(first[id("albedo")] == 0 && last[id("albedo")] == 3);
+    CHECK(first[id("depth")] == 0 && last[id("depth")] == 2);
+    CHECK(first[id("occlusion")] == 1 && last[id("occlusion")] == 2);
+    CHECK(first[id("occlusion_full")] == 2 && last[id("occlusion_full")] == 3);
+    CHECK(first[id("lit")] == 3 && last[id("lit")] == 4);
+
+    // The imported output is acquired, but never released to the pool.
+    CHECK(first[id("output")] == 4 && last[id("output")] == ~0u);
+}
+
+TEST_CASE(render_graph_clears_only_the_partial_first_writes) {
+    RenderGraph graph;
+    describe_deferred_graph(graph, false);
+    const auto compiled = graph.compile();
+
+    std::vector<int> cleared(graph.resources().size(), -1);
+    for (const auto &acquire : compiled.acquires()) {
+        cleared[acquire.resource] = acquire.clear ? 1 : 0;
+    }
+
+    // The G-buffer draws only the covered pixels, and the full screen passes write every pixel.
+    const auto id = [&](const char *name) { return graph.resource(name); };
+    CHECK(cleared[id("albedo")] == 1);
+    CHECK(cleared[id("normal")] == 1);
+    CHECK(cleared[id("occlusion")] == 0);
+    CHECK(cleared[id("lit")] == 0);
+    CHECK(cleared[id("output")] == 0);
+}
+
+TEST_CASE(render_graph_cache_compiles_once_per_topology) {
+    RenderGraphCache cache;
+    RenderGraph graph;
+
+    describe_deferred_graph(graph, false);
+    const auto *compiled = &cache.compile(graph);
+    describe_deferred_graph(graph, false);
+    CHECK(&cache.compile(graph) == compiled);
+    CHECK(cache.compile_count() == 1);
+    const auto step_count = compiled->steps().size();
+
+    // The debug view changes the topology, even though its pass is culled.
+    describe_deferred_graph(graph, true);
+    CHECK(cache.compile(graph).culled_pass_count() == 1);
+    CHECK(cache.compile_count() == 2);
+
+    describe_deferred_graph(graph, false);
+    CHECK(cache.compile(graph).steps().size() == step_count);
+    CHECK(cache.compile_count() == 2);
+
+    // The names are not part of the signature.
+    RenderGraph renamed;
+    renamed.add_pass("a");
+    renamed.write(renamed.resource("x"), WriteMode::Overwrite);
+    renamed.set_side_effects();
+    cache.compile(renamed);
+    renamed.clear();
+    renamed.add_pass("b");
+    renamed.write(renamed.resource("y"), WriteMode::Overwrite);
+    renamed.set_side_effects();
+    cache.compile(renamed);
+    CHECK(cache.compile_count() == 3);
+
+    // A write mode is.
+    renamed.clear();
+    renamed.add_pass("b");
+    renamed.write(renamed.resource("y"), WriteMode::Partial);
+    renamed.set_side_effects();
+    cache.compile(renamed);
+    CHECK(cache.compile_count() == 4);
+}
+
+TEST_CASE(render_graph_cache_replaces_the_least_recently_used_topology) {
+    RenderGraphCache cache;
+    RenderGraph graph;
+
+    // The topologies of 1 to CAPACITY + 1 passes.
+    const auto describe = [&](std::size_t pass_count) {
+        graph.clear();
+        for (std::size_t i = 0; i < pass_count; ++i) {
+            graph.add_pass("pass");
+            graph.set_side_effects();
+        }
+    };
+
+    for (std::size_t count = 1; count <= RenderGraphCache::CAPACITY; ++count) {
+        describe(count);
+        cache.compile(graph);
+    }
+    describe(1);
+    cache.compile(graph);
+    CHECK(cache.compile_count() == RenderGraphCache::CAPACITY);
+
+    // The one of 2 passes is the least recently used now.
+    describe(RenderGraphCache::CAPACITY + 1);
+    cache.compile(graph);
+    describe(1);
+    cache.compile(graph);
+    CHECK(cache.compile_count() == RenderGraphCache::CAPACITY + 1);
+    describe(2);
+    CHECK(cache.compile(graph).steps().size() == 2);
+    CHECK(cache.compile_count() == RenderGraphCache::CAPACITY + 2);
+}
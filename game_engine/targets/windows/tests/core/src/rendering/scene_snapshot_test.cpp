@@ -0,0 +1,280 @@
+#include <rendering/scene_snapshot.hpp>
+
+#include <nodec_rendering/components/mesh_renderer.hpp>
+#include <nodec_rendering/components/non_visible.hpp>
+#include <nodec_scene/components/local_to_world.hpp>
+#include <nodec_scene/scene.hpp>
+
+#include <rendering/parallel_chunks.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The source of no glyph. The scenes of these tests have no text.
+ */
+class NoGlyphSource : public TextGlyphSource {
+public:
+    const FontCharacter &character(nodec_rendering::resources::Font &, std::uint16_t, std::uint32_t) override {
+        return character_;
+    }
+
+    const GlyphAtlas::Rect *atlas_rect(nodec_rendering::resources::Font &, std::uint16_t, std::uint32_t) override {
+        return nullptr;
+    }
+
+    const GlyphAtlas &atlas() const override {
+        return atlas_;
+    }
+
+    const SdfFont *sdf_font(nodec_rendering::resources::Font &) override {
+        return nullptr;
+    }
+
+    TextureBackend *sdf_texture(nodec_rendering::resources::Font &) override {
+        return nullptr;
+    }
+
+private:
+    FontCharacter character_;
+    GlyphAtlas atlas_{1, 1};
+};
+
+/**
+ * @brief The mesh renderers of a large scene with one to three submeshes each, spread around the origin.
+ */
+struct MeshScene {
+    nodec_scene::Scene scene;
+    std::vector<std::shared_ptr<MeshBackend>> meshes;
+    std::vector<nodec_scene::SceneEntity> entities;
+
+    MeshScene(std::size_t entity_count, std::uint32_t seed) {
+        using namespace nodec_rendering::components;
+        using namespace nodec_scene::components;
+
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+        std::uniform_real_distribution<float> extent(0.5f, 4.0f);
+        std::uniform_int_distribution<std::size_t> mesh_index(0, 15);
+        std::uniform_int_distribution<std::size_t> submesh_count(1, 3);
+
+        for (int i = 0; i < 16; ++i) {
+            meshes.push_back(std::make_shared<MeshBackend>());
+            meshes.back()->bounds.center.set(0.0f, extent(random), 0.0f);
+            meshes.back()->bounds.extents.set(extent(random), extent(random), extent(random));
+        }
+
+        auto &registry = scene.registry();
+        for (std::size_t i = 0; i < entity_count; ++i) {
+            const auto entity = registry.create_entity();
+            auto &renderer = registry.emplace_component<MeshRenderer>(entity).first;
+            for (auto count = submesh_count(random); count > 0; --count) {
+                renderer.meshes.push_back(meshes[mesh_index(random)]);
+                renderer.materials.push_back(nullptr);
+            }
+
+            auto &local_to_world = registry.emplace_component<LocalToWorld>(entity).first;
+            DirectX::XMFLOAT4X4 matrix;
+            DirectX::XMStoreFloat4x4(&matrix, DirectX::XMMatrixTranslation(position(random), position(random), position(random)));
+            std::memcpy(local_to_world.value.m, &matrix, sizeof(matrix));
+            entities.push_back(entity);
+        }
+    }
+
+    /**
+     * @brief Moves one in a hundred of the entities, a different hundredth each frame.
+     */
+    void move(std::size_t frame) {
+        auto &registry = scene.registry();
+        for (std::size_t i = frame % 100; i < entities.size(); i += 100) {
+            registry.get_component<nodec_scene::components::LocalToWorld>(entities[i]).value.m[12] += 0.01f;
+        }
+    }
+};
+
+/**
+ * @brief The mesh extraction each view ran before the views shared the snapshot.
+ *
+ * Like the renderer did then, it walks the registry and refreshes the cached world bounds of the moved submeshes
+ * in the chunks, then culls the combined bounds. The cache is kept across the views and the frames.
+ */
+class PerViewExtraction {
+public:
+    std::size_t cull(nodec_scene::Scene &scene, const CullingPlanes &planes,
+                     nodec::concurrent::ThreadPoolExecutor &executor) {
+        using namespace nodec_rendering::components;
+        using namespace nodec_scene::components;
+
+        constexpr std::size_t MIN_CHUNK_SIZE = 512;
+
+        sources_.clear();
+        std::size_t bounds_count = 0;
+        scene.registry().view<const MeshRenderer, const LocalToWorld>(nodec::type_list<NonVisible>{}).each([&](nodec_scene::SceneEntity, const MeshRenderer &renderer, const LocalToWorld &local_to_world) {
+            if (renderer.meshes.size() != renderer.materials.size()) return;
+
+            sources_.push_back({&renderer, &local_to_world, static_cast<std::uint32_t>(bounds_count)});
+            bounds_count += renderer.meshes.size();
+        });
+
+        const auto source_count = sources_.size();
+        entity_bounds_.resize(source_count);
+        visible_bits_.resize(visibility_word_count(source_count));
+        keys_.resize(bounds_count, {nullptr, {}});
+        submesh_bounds_.resize(bounds_count);
+
+        const ChunkPartition partition(source_count, MIN_CHUNK_SIZE);
+        run_chunks(executor, partition, [&](std::size_t, std::size_t begin, std::size_t end) {
+            for (auto source_index = begin; source_index < end; ++source_index) {
+                const auto &source = sources_[source_index];
+                const auto &matrix_m = source.local_to_world->value;
+
+                for (std::size_t i = 0; i < source.renderer->meshes.size(); ++i) {
+                    auto *mesh_backend = static_cast<MeshBackend *>(source.renderer->meshes[i].get());
+                    const auto bounds_index = source.first_bounds + i;
+                    auto &key = keys_[bounds_index];
+                    if (key.mesh != mesh_backend || std::memcmp(key.matrix_m.m, matrix_m.m, sizeof(matrix_m.m)) != 0) {
+                        key.mesh = mesh_backend;
+                        key.matrix_m = matrix_m;
+                        submesh_bounds_.set(bounds_index, mesh_backend->bounds, DirectX::XMMATRIX(matrix_m.m));
+                    }
+
+                    if (i == 0) {
+                        entity_bounds_.copy(source_index, submesh_bounds_, bounds_index);
+                    } else {
+                        entity_bounds_.merge(source_index, submesh_bounds_, bounds_index);
+                    }
+                }
+            }
+            cull_world_bounds(planes, entity_bounds_, begin, end, visible_bits_.data());
+        });
+
+        return count_visible(visible_bits_, source_count);
+    }
+
+    static std::size_t count_visible(const std::vector<std::uint64_t> &visible_bits, std::size_t count) {
+        std::size_t visible_count = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (test_visibility_bit(visible_bits.data(), i)) ++visible_count;
+        }
+        return visible_count;
+    }
+
+private:
+    struct Source {
+        const nodec_rendering::components::MeshRenderer *renderer;
+        const nodec_scene::components::LocalToWorld *local_to_world;
+        std::uint32_t first_bounds;
+    };
+
+    struct BoundsKey {
+        const MeshBackend *mesh;
+        nodec::Matrix4x4f matrix_m;
+    };
+
+    std::vector<Source> sources_;
+    std::vector<BoundsKey> keys_;
+    WorldBoundsArray submesh_bounds_;
+    WorldBoundsArray entity_bounds_;
+    std::vector<std::uint64_t> visible_bits_;
+};
+
+std::vector<CullingPlanes> make_views(std::size_t count) {
+    using namespace DirectX;
+    const auto matrix_p = XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+
+    // The editor view and the game cameras, looking around the scene.
+    std::vector<CullingPlanes> views;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto matrix_v = XMMatrixInverse(nullptr, XMMatrixRotationY(1.5f * i) * XMMatrixTranslation(0.0f, 10.0f, -50.0f));
+        views.push_back(CullingPlanes::from_view_projection(matrix_v * matrix_p));
+    }
+    return views;
+}
+
+} // namespace
+
+TEST_CASE(scene_snapshot_captures_the_visible_mesh_renderers) {
+    using namespace nodec_rendering::components;
+
+    MeshScene scene(8, 1);
+    auto &registry = scene.scene.registry();
+    registry.emplace_component<NonVisible>(scene.entities[2]);
+    registry.get_component<MeshRenderer>(scene.entities[5]).materials.push_back(nullptr);
+
+    NoGlyphSource glyph_source;
+    TextLayoutCache text_layout_cache(nullptr, glyph_source);
+    nodec::concurrent::ThreadPoolExecutor executor;
+    SceneSnapshot snapshot;
+    snapshot.capture(scene.scene, text_layout_cache, executor, true);
+
+    // The hidden renderer and the one whose meshes and materials do not match are left out.
+    CHECK(snapshot.mesh_sources().size() == 6);
+    CHECK(snapshot.find_mesh_source(registry, scene.entities[2]) == -1);
+    CHECK(snapshot.find_mesh_source(registry, scene.entities[5]) == -1);
+
+    const auto index = snapshot.find_mesh_source(registry, scene.entities[7]);
+    CHECK(index >= 0);
+    if (index < 0) return;
+    const auto &source = snapshot.mesh_sources()[static_cast<std::size_t>(index)];
+    CHECK(source.entity == scene.entities[7]);
+    CHECK(source.renderer == &registry.get_component<MeshRenderer>(scene.entities[7]));
+
+    // The sources of the last capture are stale after the next one.
+    registry.emplace_component<NonVisible>(scene.entities[7]);
+    snapshot.capture(scene.scene, text_layout_cache, executor, true);
+    CHECK(snapshot.capture_count() == 2);
+    CHECK(snapshot.find_mesh_source(registry, scene.entities[7]) == -1);
+    CHECK(snapshot.mesh_sources().size() == 5);
+}
+
+BENCHMARK(scene_snapshot_shared_across_views) {
+    constexpr std::size_t ENTITY_COUNT = 200000;
+    MeshScene scene(ENTITY_COUNT, 2);
+    NoGlyphSource glyph_source;
+    TextLayoutCache text_layout_cache(nullptr, glyph_source);
+    nodec::concurrent::ThreadPoolExecutor executor;
+    std::vector<std::uint64_t> visible_bits(visibility_word_count(ENTITY_COUNT));
+
+    // Both move the same entities each frame, and refresh only the bounds of the moved ones.
+    for (const std::size_t view_count : {1u, 2u, 4u}) {
+        const auto views = make_views(view_count);
+        const auto suffix = ", " + std::to_string(view_count) + (view_count == 1 ? " view" : " views");
+        std::size_t frame = 0;
+
+        // Before: each view walks the registry, refreshes the bounds and culls.
+        PerViewExtraction per_view;
+        per_view.cull(scene.scene, views[0], executor);
+        test_runner::measure("extract per view" + suffix, 10, [&]() {
+            scene.move(++frame);
+
+            std::size_t visible_count = 0;
+            for (const auto &planes : views) {
+                visible_count += per_view.cull(scene.scene, planes, executor);
+            }
+            test_runner::do_not_optimize(visible_count);
+        });
+
+        // After: SceneSnapshot::capture() once, like SceneRenderer::prepare_snapshot(), then each view only culls.
+        SceneSnapshot snapshot;
+        snapshot.capture(scene.scene, text_layout_cache, executor, false);
+        test_runner::measure("one snapshot" + suffix, 10, [&]() {
+            scene.move(++frame);
+            snapshot.capture(scene.scene, text_layout_cache, executor, false);
+
+            const auto &bounds = snapshot.mesh_world_bounds();
+            std::size_t visible_count = 0;
+            for (const auto &planes : views) {
+                cull_world_bounds(planes, bounds, 0, bounds.size(), visible_bits.data());
+                visible_count += PerViewExtraction::count_visible(visible_bits, bounds.size());
+            }
+            test_runner::do_not_optimize(visible_count);
+        });
+    }
+}
@@ -0,0 +1,166 @@
+#include <rendering/cb_scene_properties.hpp>
+#include <rendering/point_light_buffer.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// D3D_SHADER_INPUT_TYPE
+constexpr std::uint32_t SIT_CBUFFER = 0;
+constexpr std::uint32_t SIT_STRUCTURED = 5;
+
+/**
+ * @brief The constant buffers and the bound resources a compiled shader declares.
+ */
+struct ShaderReflection {
+    struct Binding {
+        std::uint32_t type;
+        std::uint32_t bind_point;
+    };
+
+    //! The sizes of the constant buffers, and the strides of the structured buffers, by their names.
+    std::map<std::string, std::uint32_t> buffer_sizes;
+
+    std::map<std::string, Binding> bindings;
+};
+
+std::uint32_t read_u32(const std::string &bytes, std::size_t offset) {
+    if (offset > bytes.size() || bytes.size() - offset < sizeof(std::uint32_t)) {
+        throw std::runtime_error("The shader binary is truncated.");
+    }
+    std::uint32_t value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(value));
+    return value;
+}
+
+std::string read_name(const std::string &chunk, std::size_t offset) {
+    const auto end = chunk.find('\0', offset);
+    if (offset >= chunk.size() || end == std::string::npos) throw std::runtime_error("The shader binary is truncated.");
+    return chunk.substr(offset, end - offset);
+}
+
+/**
+ * @brief Reads the RDEF chunk of a DXBC container, which is what D3DReflect reads.
+ */
+ShaderReflection reflect(const std::string &bytes) {
+    if (bytes.compare(0, 4, "DXBC") != 0) throw std::runtime_error("Not a DXBC container.");
+
+    const auto chunk_count = read_u32(bytes, 28);
+    for (std::uint32_t i = 0; i < chunk_count; ++i) {
+        const auto chunk_offset = read_u32(bytes, 32 + i * sizeof(std::uint32_t));
+        const auto chunk_size = read_u32(bytes, chunk_offset + 4);
+        if (bytes.compare(chunk_offset, 4, "RDEF") != 0) continue;
+        if (bytes.size() - chunk_offset - 8 < chunk_size) throw std::runtime_error("The shader binary is truncated.");
+
+        const auto chunk = bytes.substr(chunk_offset + 8, chunk_size);
+        const auto buffer_count = read_u32(chunk, 0);
+        const auto buffer_offset = read_u32(chunk, 4);
+        const auto binding_count = read_u32(chunk, 8);
+        const auto binding_offset = read_u32(chunk, 12);
+
+        ShaderReflection reflection;
+        for (std::uint32_t j = 0; j < buffer_count; ++j) {
+            // name, variable count, variables, size, flags, type
+            const std::size_t desc = buffer_offset + j * 24;
+            reflection.buffer_sizes[read_name(chunk, read_u32(chunk, desc))] = read_u32(chunk, desc + 12);
+        }
+        for (std::uint32_t j = 0; j < binding_count; ++j) {
+            // name, type, return type, dimension, sample count, bind point, bind count, flags
+            const std::size_t desc = binding_offset + j * 32;
+            reflection.bindings[read_name(chunk, read_u32(chunk, desc))] = {read_u32(chunk, desc + 4), read_u32(chunk, desc + 20)};
+        }
+        return reflection;
+    }
+    throw std::runtime_error("The shader binary has no resource definitions.");
+}
+
+std::filesystem::path shader_directory() {
+    return std::filesystem::u8path(NODEC_GAME_ENGINE_RESOURCES_DIR) / "shaders";
+}
+
+std::map<std::string, ShaderReflection> reflect_engine_shaders() {
+    namespace fs = std::filesystem;
+
+    std::map<std::string, ShaderReflection> shaders;
+    for (const auto &entry : fs::recursive_directory_iterator(shader_directory())) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".cso") continue;
+
+        std::ifstream in(entry.path(), std::ios::binary);
+        const std::string bytes(std::istreambuf_iterator<char>(in), {});
+        shaders[fs::relative(entry.path(), shader_directory()).generic_u8string()] = reflect(bytes);
+    }
+    return shaders;
+}
+
+//! The constant buffer registers hold 16-byte vectors.
+constexpr std::uint32_t register_size(std::size_t size) {
+    return static_cast<std::uint32_t>((size + 15) / 16 * 16);
+}
+
+} // namespace
+
+TEST_CASE(shader_binaries_declare_the_scene_constants_of_the_renderer) {
+    const auto shaders = reflect_engine_shaders();
+    CHECK(!shaders.empty());
+
+    // A .cso built before the last change of interface_scene.hlsl reads the constants at the old offsets.
+    std::size_t stale = 0;
+    for (const auto &shader : shaders) {
+        const auto iter = shader.second.buffer_sizes.find("cbSceneProperties");
+        if (iter == shader.second.buffer_sizes.end()) continue;
+        if (iter->second == register_size(sizeof(CBSceneProperties::SceneProperties))) continue;
+
+        std::printf("  %s: cbSceneProperties of %u bytes, the renderer uploads %u\n", shader.first.c_str(), iter->second,
+                    register_size(sizeof(CBSceneProperties::SceneProperties)));
+        ++stale;
+    }
+    CHECK(stale == 0);
+}
+
+TEST_CASE(shader_binaries_read_the_point_lights_from_the_structured_buffer) {
+    const auto shaders = reflect_engine_shaders();
+    const auto iter = shaders.find("pbr-defer/lighting_ps.cso");
+    CHECK(iter != shaders.end());
+    if (iter == shaders.end()) return;
+    const auto &shader = iter->second;
+
+    // SceneRenderer binds the point lights at t18, and the clusters at t16 and t17.
+    const auto binding = shader.bindings.find("pointLights");
+    CHECK(binding != shader.bindings.end());
+    if (binding == shader.bindings.end()) return;
+    CHECK(binding->second.type == SIT_STRUCTURED && binding->second.bind_point == 18);
+    CHECK(shader.buffer_sizes.count("pointLights") && shader.buffer_sizes.at("pointLights") == sizeof(PointLightBuffer::PointLight));
+    CHECK(shader.bindings.count("clusterRanges") && shader.bindings.at("clusterRanges").bind_point == 16);
+    CHECK(shader.bindings.count("clusterLightIndices") && shader.bindings.at("clusterLightIndices").bind_point == 17);
+    CHECK(shader.bindings.count("cbSceneProperties") && shader.bindings.at("cbSceneProperties").type == SIT_CBUFFER);
+}
+
+TEST_CASE(shader_binary_reflection_rejects_the_broken_files) {
+    const auto is_rejected = [](const std::string &bytes) {
+        try {
+            reflect(bytes);
+        } catch (const std::runtime_error &) {
+            return true;
+        }
+        return false;
+    };
+
+    std::ifstream in(shader_directory() / "pbr-defer" / "lighting_vs.cso", std::ios::binary);
+    const std::string bytes(std::istreambuf_iterator<char>(in), {});
+    CHECK(!is_rejected(bytes));
+    CHECK(is_rejected(""));
+    CHECK(is_rejected("DXBC"));
+    CHECK(is_rejected(bytes.substr(0, 40)));
+    CHECK(is_rejected(bytes.substr(0, bytes.find("RDEF") + 16)));
+}
@@ -0,0 +1,282 @@
+#include <rendering/shader_descriptor.hpp>
+#include <rendering/shader_meta.hpp>
+
+#include "../test_runner.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace shader_descriptor;
+
+//! The metas of a shader by their names, like "shader.meta".
+using Metas = std::map<std::string, std::string>;
+
+// The SSAO shader of the engine, with a vector property and a priority added.
+const Metas ssao_metas = {
+    {"shader.meta", R"({
+        "meta": {
+            "float_properties": [{"name": "radius", "default_value": 0.5}, {"name": "bias", "default_value": 0.12}],
+            "vector4_properties": [{"name": "tint", "default_value": {"x": 1.0, "y": 0.5, "z": 0.25, "w": 1.0}}],
+            "texture_entries": [{"name": "noise"}, {"name": "samples"}],
+            "pass": ["occlusion", "composite"],
+            "rendering_priority": -5
+        }
+    })"},
+    {"occlusion.meta", R"({
+        "meta": {
+            "render_targets": ["occlusion"],
+            "resolution_scale": 0.5,
+            "render_target_descs": [{"name": "occlusion", "format": "R8_UNORM"}],
+            "texture_resources": ["depth", "normal", "screen"]
+        }
+    })"},
+    {"composite.meta", R"({
+        "meta": {
+            "render_targets": [],
+            "bilateral_upsamples": [{"source": "occlusion", "target": "occlusion_full"}],
+            "texture_resources": ["screen", "occlusion_full"]
+        }
+    })"},
+};
+
+shader_meta::OpenMeta open_in(const Metas &metas) {
+    return [&metas](const std::string &name) -> std::unique_ptr<std::istream> {
+        auto iter = metas.find(name);
+        if (iter == metas.end()) return nullptr;
+        return std::make_unique<std::istringstream>(iter->second);
+    };
+}
+
+/**
+ * @brief The metas of every engine shader, read into memory so that the disk does not count.
+ */
+std::vector<Metas> read_engine_shaders() {
+    namespace fs = std::filesystem;
+
+    std::vector<Metas> shaders;
+    for (const auto &entry : fs::recursive_directory_iterator(fs::u8path(NODEC_GAME_ENGINE_RESOURCES_DIR) / "shaders")) {
+        if (!entry.is_regular_file() || entry.path().filename() != "shader.meta") continue;
+
+        Metas metas;
+        for (const auto &file : fs::directory_iterator(entry.path().parent_path())) {
+            if (file.path().extension() != ".meta") continue;
+            std::ifstream in(file.path(), std::ios::binary);
+            metas[file.path().filename().u8string()].assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        shaders.push_back(std::move(metas));
+    }
+    return shaders;
+}
+
+std::string write(const ShaderDescriptor &descriptor) {
+    std::ostringstream out;
+    write_shader_descriptor(out, descriptor);
+    return out.str();
+}
+
+ShaderDescriptor round_trip(const ShaderDescriptor &descriptor) {
+    const auto bytes = write(descriptor);
+    return read_shader_descriptor(bytes.data(), bytes.size());
+}
+
+bool same(const ShaderDescriptor &lhs, const ShaderDescriptor &rhs) {
+    if (lhs.rendering_priority != rhs.rendering_priority || lhs.source_hash != rhs.source_hash
+        || lhs.texture_entries != rhs.texture_entries
+        || lhs.float_properties.size() != rhs.float_properties.size()
+        || lhs.vector4_properties.size() != rhs.vector4_properties.size()
+        || lhs.passes.size() != rhs.passes.size()) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < lhs.float_properties.size(); ++i) {
+        const auto &l = lhs.float_properties[i];
+        const auto &r = rhs.float_properties[i];
+        if (l.name != r.name || l.default_value != r.default_value) return false;
+    }
+    for (std::size_t i = 0; i < lhs.vector4_properties.size(); ++i) {
+        const auto &l = lhs.vector4_properties[i];
+        const auto &r = rhs.vector4_properties[i];
+        if (l.name != r.name || !std::equal(l.default_value, l.default_value + 4, r.default_value)) return false;
+    }
+
+    for (std::size_t i = 0; i < lhs.passes.size(); ++i) {
+        const auto &l = lhs.passes[i];
+        const auto &r = rhs.passes[i];
+        if (l.name != r.name || l.render_targets != r.render_targets || l.texture_resources != r.texture_resources
+            || l.resolution_scale != r.resolution_scale
+            || l.render_target_descs.size() != r.render_target_descs.size()
+            || l.bilateral_upsamples.size() != r.bilateral_upsamples.size()) {
+            return false;
+        }
+        for (std::size_t j = 0; j < l.render_target_descs.size(); ++j) {
+            const auto &ld = l.render_target_descs[j];
+            const auto &rd = r.render_target_descs[j];
+            if (ld.name != rd.name || ld.format != rd.format || ld.scale != rd.scale) return false;
+        }
+        for (std::size_t j = 0; j < l.bilateral_upsamples.size(); ++j) {
+            if (l.bilateral_upsamples[j].source != r.bilateral_upsamples[j].source
+                || l.bilateral_upsamples[j].target != r.bilateral_upsamples[j].target) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE(shader_descriptor_round_trips_to_the_compiled_metas) {
+    const auto compiled = shader_meta::compile_shader_meta(open_in(ssao_metas));
+
+    CHECK(compiled.rendering_priority == -5);
+    CHECK(compiled.float_properties.size() == 2 && compiled.float_properties[1].name == "bias");
+    CHECK(compiled.vector4_properties.size() == 1 && compiled.vector4_properties[0].default_value[2] == 0.25f);
+    CHECK(compiled.texture_entries == (std::vector<std::string>{"noise", "samples"}));
+    CHECK(compiled.passes.size() == 2);
+    if (compiled.passes.size() != 2) return;
+
+    // The fields left out take their defaults.
+    const auto &occlusion = compiled.passes[0];
+    CHECK(occlusion.name == "occlusion" && occlusion.resolution_scale == 0.5f);
+    CHECK(occlusion.render_target_descs.size() == 1 && occlusion.render_target_descs[0].format == "R8_UNORM");
+    CHECK(occlusion.render_target_descs.size() == 1 && occlusion.render_target_descs[0].scale == 0.0f);
+    CHECK(occlusion.bilateral_upsamples.empty());
+
+    const auto &composite = compiled.passes[1];
+    CHECK(composite.resolution_scale == 1.0f && composite.render_target_descs.empty());
+    CHECK(composite.bilateral_upsamples.size() == 1 && composite.bilateral_upsamples[0].target == "occlusion_full");
+
+    CHECK(same(round_trip(compiled), compiled));
+}
+
+TEST_CASE(shader_descriptor_round_trips_every_engine_shader) {
+    const auto shaders = read_engine_shaders();
+    CHECK(!shaders.empty());
+
+    std::size_t mismatched = 0;
+    for (const auto &metas : shaders) {
+        const auto compiled = shader_meta::compile_shader_meta(open_in(metas));
+        if (!same(round_trip(compiled), compiled)) ++mismatched;
+    }
+    CHECK(mismatched == 0);
+}
+
+TEST_CASE(shader_descriptor_is_out_of_date_once_a_meta_is_edited) {
+    const auto compiled = shader_meta::compile_shader_meta(open_in(ssao_metas));
+    CHECK(shader_meta::hash_shader_metas(compiled, open_in(ssao_metas)) == compiled.source_hash);
+    CHECK(round_trip(compiled).source_hash == compiled.source_hash);
+
+    // The meta of a pass, and the shader.meta, like a pass added.
+    auto edited_pass = ssao_metas;
+    edited_pass["occlusion.meta"].replace(edited_pass["occlusion.meta"].find("0.5"), 3, "0.25");
+    CHECK(shader_meta::hash_shader_metas(compiled, open_in(edited_pass)) != compiled.source_hash);
+
+    auto added_pass = ssao_metas;
+    auto &shader_meta_json = added_pass["shader.meta"];
+    shader_meta_json.replace(shader_meta_json.find("\"composite\""), 11, "\"composite\", \"blur\"");
+    CHECK(shader_meta::hash_shader_metas(compiled, open_in(added_pass)) != compiled.source_hash);
+
+    // A byte moved from the end of one meta to the start of the next still changes it.
+    auto moved = ssao_metas;
+    moved["shader.meta"] += " ";
+    auto moved_over = ssao_metas;
+    moved_over["occlusion.meta"] = " " + moved_over["occlusion.meta"];
+    CHECK(shader_meta::hash_shader_metas(compiled, open_in(moved)) != shader_meta::hash_shader_metas(compiled, open_in(moved_over)));
+
+    // The missing meta cannot be checked.
+    auto missing = ssao_metas;
+    missing.erase("composite.meta");
+    CHECK_THROWS(shader_meta::hash_shader_metas(compiled, open_in(missing)));
+}
+
+TEST_CASE(shader_descriptor_rejects_the_broken_files) {
+    const auto bytes = write(shader_meta::compile_shader_meta(open_in(ssao_metas)));
+
+    const auto is_rejected = [](const std::string &bytes) {
+        try {
+            read_shader_descriptor(bytes.data(), bytes.size());
+        } catch (const std::runtime_error &) {
+            return true;
+        }
+        return false;
+    };
+
+    // Every truncation, the trailing bytes and the bad magic.
+    std::size_t accepted = 0;
+    for (std::size_t size = 0; size < bytes.size(); ++size) {
+        if (!is_rejected(bytes.substr(0, size))) ++accepted;
+    }
+    CHECK(accepted == 0);
+    CHECK(is_rejected(bytes + '\0'));
+    CHECK(is_rejected('x' + bytes.substr(1)));
+
+    // The count the rest of the file cannot hold is rejected before anything is allocated.
+    auto forged = bytes;
+    const std::uint32_t count = 0x7fffffff;
+    std::memcpy(&forged[offsetof(Header, pass_count)], &count, sizeof(count));
+    CHECK(is_rejected(forged));
+
+    // Without the shader.meta, or the meta of a pass.
+    auto missing = ssao_metas;
+    missing.erase("composite.meta");
+    CHECK_THROWS(shader_meta::compile_shader_meta(open_in(missing)));
+}
+
+TEST_CASE(shader_descriptor_falls_back_to_the_passes_built) {
+    const auto compiled = shader_meta::compile_shader_meta(open_in(ssao_metas));
+
+    auto all_built = compiled;
+    CHECK(drop_unbuilt_passes(all_built, [](const std::string &) { return true; }).empty());
+    CHECK(same(all_built, compiled));
+
+    // The composite pass is not compiled yet, so the occlusion pass draws to the screen like the shader before the split.
+    auto occlusion_only = compiled;
+    CHECK(drop_unbuilt_passes(occlusion_only, [](const std::string &name) { return name != "composite"; }) == "composite");
+    CHECK(occlusion_only.passes.size() == 1);
+    if (occlusion_only.passes.size() != 1) return;
+    const auto &occlusion = occlusion_only.passes[0];
+    CHECK(occlusion.name == "occlusion" && occlusion.render_targets.empty());
+    CHECK(occlusion.resolution_scale == 1.0f && occlusion.render_target_descs.empty());
+    CHECK(occlusion.texture_resources == compiled.passes[0].texture_resources);
+
+    // The first pass is always kept, so the load still fails on its missing shaders.
+    auto none_built = compiled;
+    CHECK(drop_unbuilt_passes(none_built, [](const std::string &) { return false; }) == "composite");
+    CHECK(none_built.passes.size() == 1);
+}
+
+BENCHMARK(shader_descriptor_load_of_the_engine_shaders) {
+    const auto shaders = read_engine_shaders();
+
+    std::vector<std::string> descriptors;
+    for (const auto &metas : shaders) {
+        descriptors.push_back(write(shader_meta::compile_shader_meta(open_in(metas))));
+    }
+
+    // The loader before: shader.meta and the meta of each pass through the JSON archives.
+    test_runner::measure("JSON metas of " + std::to_string(shaders.size()) + " shaders", 20, [&]() {
+        for (const auto &metas : shaders) {
+            test_runner::do_not_optimize(shader_meta::compile_shader_meta(open_in(metas)));
+        }
+    });
+
+    // The loader after: the descriptor, and the hash of the metas it is checked against.
+    test_runner::measure("descriptors of " + std::to_string(shaders.size()) + " shaders", 20, [&]() {
+        for (std::size_t i = 0; i < shaders.size(); ++i) {
+            const auto &bytes = descriptors[i];
+            const auto descriptor = read_shader_descriptor(bytes.data(), bytes.size());
+            test_runner::do_not_optimize(shader_meta::hash_shader_metas(descriptor, open_in(shaders[i])) == descriptor.source_hash);
+        }
+    });
+}
@@ -0,0 +1,130 @@
+#include <rendering/sprite_batcher.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+// The batcher compares the pointers only, so the backends are stand-in addresses.
+alignas(8) char image_storage[8];
+alignas(8) char material_storage[4];
+
+TextureBackend *image(int index) {
+    return reinterpret_cast<TextureBackend *>(image_storage + index);
+}
+
+MaterialBackend *material(int index) {
+    return reinterpret_cast<MaterialBackend *>(material_storage + index);
+}
+
+struct Submission {
+    DrawCommandBuffer commands;
+    DrawQueue queue;
+
+    void push_image(int image_index, int material_index, const DirectX::XMMATRIX &matrix_m = DirectX::XMMatrixIdentity(),
+                    const nodec::Vector4f &color = {1.0f, 1.0f, 1.0f, 1.0f}) {
+        // The queue is already in the order of the pushes.
+        const auto command = commands.push(DrawCommand::make_image(matrix_m, image(image_index), material(material_index), color));
+        queue.push(command, command);
+    }
+
+    void push_mesh() {
+        const auto command = commands.push(DrawCommand::make_mesh(DirectX::XMMatrixIdentity(), nullptr, material(0)));
+        queue.push(command, command);
+    }
+};
+
+const auto batch_all = [](const DrawCommand &) { return true; };
+
+bool near(const DirectX::XMFLOAT3 &value, float x, float y, float z) {
+    return std::abs(value.x - x) < 1e-5f && std::abs(value.y - y) < 1e-5f && std::abs(value.z - z) < 1e-5f;
+}
+
+} // namespace
+
+TEST_CASE(sprite_batcher_batches_the_runs_of_the_same_image_and_material) {
+    Submission submission;
+    submission.push_image(0, 0);
+    submission.push_image(0, 0);
+    submission.push_image(0, 0);
+    submission.push_image(1, 0); // Single, drawn alone.
+    submission.push_image(2, 0);
+    submission.push_image(2, 0);
+    submission.push_mesh();
+    submission.push_image(2, 0);
+    submission.push_image(2, 0);
+    submission.push_image(2, 1);
+    submission.push_image(2, 1);
+
+    SpriteBatcher batcher;
+    batcher.build(submission.queue, submission.commands, batch_all);
+
+    const auto &batches = batcher.batches();
+    CHECK(batches.size() == 4);
+    if (batches.size() != 4) return;
+
+    // The mesh and the change of the material split the runs.
+    CHECK(batches[0].begin == 0 && batches[0].end == 3 && batches[0].first_quad == 0);
+    CHECK(batches[1].begin == 4 && batches[1].end == 6 && batches[1].first_quad == 3);
+    CHECK(batches[2].begin == 7 && batches[2].end == 9 && batches[2].first_quad == 5);
+    CHECK(batches[3].begin == 9 && batches[3].end == 11 && batches[3].first_quad == 7);
+    CHECK(batcher.vertices().size() == 9 * 4);
+
+    // The rebuild without the sprite shader variant starts over.
+    batcher.build(submission.queue, submission.commands, [](const DrawCommand &) { return false; });
+    CHECK(batcher.batches().empty());
+    CHECK(batcher.vertices().empty());
+}
+
+TEST_CASE(sprite_batcher_expands_the_quads_in_the_world_space) {
+    using namespace DirectX;
+
+    Submission submission;
+    submission.push_image(0, 0, XMMatrixScaling(2.0f, 4.0f, 1.0f) * XMMatrixTranslation(10.0f, 20.0f, 5.0f), {1.0f, 0.5f, 0.25f, 0.75f});
+    submission.push_image(0, 0, XMMatrixTranslation(-1.0f, 0.0f, 0.0f));
+
+    SpriteBatcher batcher;
+    batcher.build(submission.queue, submission.commands, batch_all);
+
+    const auto &vertices = batcher.vertices();
+    CHECK(vertices.size() == 8);
+    if (vertices.size() != 8) return;
+
+    // From the bottom left, clockwise.
+    CHECK(near(vertices[0].position, 9.0f, 18.0f, 5.0f));
+    CHECK(near(vertices[1].position, 9.0f, 22.0f, 5.0f));
+    CHECK(near(vertices[2].position, 11.0f, 22.0f, 5.0f));
+    CHECK(near(vertices[3].position, 11.0f, 18.0f, 5.0f));
+    CHECK(vertices[0].texcoord.x == 0.0f && vertices[0].texcoord.y == 1.0f);
+    CHECK(vertices[2].texcoord.x == 1.0f && vertices[2].texcoord.y == 0.0f);
+
+    for (int i = 0; i < 4; ++i) {
+        CHECK(near(vertices[i].normal, 0.0f, 0.0f, -1.0f));
+        CHECK(vertices[i].color.y == 0.5f && vertices[i].color.w == 0.75f);
+    }
+    CHECK(near(vertices[4].position, -1.5f, -0.5f, 0.0f));
+    CHECK(vertices[4].color.y == 1.0f);
+}
+
+BENCHMARK(sprite_batcher_build) {
+    // The UI scenes have about 5k sprites a frame.
+    for (const int run_length : {1, 16, 256}) {
+        Submission submission;
+        for (int i = 0; i < 5000; ++i) {
+            submission.push_image((i / run_length) % 8, 0, DirectX::XMMatrixTranslation(static_cast<float>(i % 100), static_cast<float>(i / 100), 0.0f));
+        }
+
+        SpriteBatcher batcher;
+        test_runner::measure("build, 5k sprites in runs of " + std::to_string(run_length), 20, [&]() {
+            batcher.build(submission.queue, submission.commands, batch_all);
+            test_runner::do_not_optimize(batcher.vertices());
+        });
+
+        // One draw per batch and per sprite left out, instead of one per sprite.
+        std::printf("  %zu draws instead of %zu\n", batcher.batches().size() + submission.queue.size() - batcher.vertices().size() / 4,
+                    submission.queue.size());
+    }
+}
@@ -0,0 +1,201 @@
+#include <rendering/text_layout_cache.hpp>
+
+#include <DirectXMath.h>
+
+#include <nodec/unicode.hpp>
+#include <nodec_rendering/resources/font.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+class StubFont : public nodec_rendering::resources::Font {};
+
+/**
+ * @brief The glyphs of the stub fonts: every character is 14 x 18 pixels with 16 pixels of advance, but the space.
+ *
+ * The cache never resolves the atlas in these tests, so no glyph is put in it.
+ */
+class StubGlyphSource : public TextGlyphSource {
+public:
+    const FontCharacter &character(nodec_rendering::resources::Font &, std::uint16_t, std::uint32_t code) override {
+        auto &character = characters_[code];
+        if (!character.initialized) {
+            character.initialized = true;
+            character.has_bitmap = code != U' ';
+            character.size.set(character.has_bitmap ? 14 : 0, character.has_bitmap ? 18 : 0);
+            character.bearing.set(1, 16);
+            character.advance = 16 * 64;
+        }
+        return character;
+    }
+
+    const GlyphAtlas::Rect *atlas_rect(nodec_rendering::resources::Font &, std::uint16_t, std::uint32_t) override {
+        return nullptr;
+    }
+
+    const GlyphAtlas &atlas() const override {
+        return atlas_;
+    }
+
+    const SdfFont *sdf_font(nodec_rendering::resources::Font &) override {
+        return nullptr;
+    }
+
+    TextureBackend *sdf_texture(nodec_rendering::resources::Font &) override {
+        return nullptr;
+    }
+
+private:
+    std::unordered_map<std::uint32_t, FontCharacter> characters_;
+    GlyphAtlas atlas_{64, 64};
+};
+
+nodec_scene::SceneEntity add_label(nodec_scene::SceneRegistry &registry, const std::string &text,
+                                   std::shared_ptr<nodec_rendering::resources::Font> font) {
+    const auto entity = registry.create_entity();
+    auto &renderer = registry.emplace_component<nodec_rendering::components::TextRenderer>(entity).first;
+    renderer.text = text;
+    renderer.font = std::move(font);
+    renderer.pixel_size = 24;
+    renderer.pixels_per_unit = 100;
+    return entity;
+}
+
+bool near(float a, float b) {
+    return std::abs(a - b) < 1e-5f;
+}
+
+std::string make_label_text(std::mt19937 &random) {
+    // ASCII and hiragana, like the UI texts.
+    const char *const words[] = {"Score", "Level", "HP", " ", "1234", "\xE3\x81\x82\xE3\x81\x84", "\xE3\x81\x86\xE3\x81\x88\xE3\x81\x8A", "OK"};
+    std::uniform_int_distribution<int> word(0, 7);
+    std::uniform_int_distribution<int> word_count(3, 8);
+
+    std::string text;
+    for (int i = word_count(random); i > 0; --i) {
+        text += words[word(random)];
+    }
+    return text;
+}
+
+} // namespace
+
+TEST_CASE(text_layout_cache_rebuilds_only_when_the_source_changes) {
+    using namespace nodec_rendering::components;
+
+    nodec_scene::SceneRegistry registry;
+    StubGlyphSource glyph_source;
+    TextLayoutCache cache(nullptr, glyph_source);
+    auto font = std::make_shared<StubFont>();
+
+    const auto label = add_label(registry, "OK A", font);
+    add_label(registry, "HP", font);
+    cache.update(registry);
+    CHECK(cache.layout_count() == 2 && cache.rebuild_count() == 2);
+
+    // The space has no quad, but keeps the spacing.
+    auto *layout = cache.find(registry, label);
+    CHECK(layout && layout->quad_count() == 3);
+    if (!layout) return;
+    CHECK(near(layout->glyphs[0].x, 0.01f) && near(layout->glyphs[2].x, 0.01f + 3 * 0.16f));
+    CHECK(near(layout->glyphs[0].width, 0.14f) && near(layout->glyphs[0].y, -0.02f));
+
+    // Neither the next frames nor the color lay the text out again.
+    auto &renderer = registry.get_component<TextRenderer>(label);
+    cache.update(registry);
+    renderer.color = {1.0f, 0.0f, 0.0f, 1.0f};
+    cache.update(registry);
+    CHECK(cache.rebuild_count() == 2);
+
+    renderer.text = "OK B";
+    cache.update(registry);
+    CHECK(cache.rebuild_count() == 3);
+
+    renderer.font = std::make_shared<StubFont>();
+    cache.update(registry);
+    CHECK(cache.rebuild_count() == 4);
+
+    renderer.pixel_size = 32;
+    cache.update(registry);
+    CHECK(cache.rebuild_count() == 5);
+
+    renderer.pixels_per_unit = 50;
+    cache.update(registry);
+    CHECK(cache.rebuild_count() == 6);
+    CHECK(near(cache.find(registry, label)->glyphs[0].x, 0.02f));
+
+    // The layout of the removed text renderer is released, and its entry reused.
+    registry.remove_component<TextRenderer>(label);
+    cache.update(registry);
+    CHECK(cache.layout_count() == 1 && !cache.find(registry, label));
+    add_label(registry, "Level", font);
+    cache.update(registry);
+    CHECK(cache.layout_count() == 2 && cache.rebuild_count() == 7);
+}
+
+BENCHMARK(text_layout_of_2000_static_labels) {
+    using namespace DirectX;
+
+    nodec_scene::SceneRegistry registry;
+    StubGlyphSource glyph_source;
+    auto font = std::make_shared<StubFont>();
+
+    std::mt19937 random(1);
+    std::vector<nodec_scene::SceneEntity> labels;
+    std::vector<XMMATRIX> label_matrices;
+    for (int i = 0; i < 2000; ++i) {
+        labels.push_back(add_label(registry, make_label_text(random), font));
+        label_matrices.push_back(XMMatrixTranslation(static_cast<float>(random() % 100), static_cast<float>(random() % 100), 0.0f));
+    }
+    const auto matrix_vp = XMMatrixPerspectiveFovLH(1.0f, 16.0f / 9.0f, 0.1f, 100.0f);
+
+    // Before: each frame decodes the text, walks the metrics and makes the matrices of every glyph.
+    std::vector<XMFLOAT4X4> glyph_matrices;
+    test_runner::measure("lay out every frame", 20, [&]() {
+        glyph_matrices.clear();
+        for (std::size_t i = 0; i < labels.size(); ++i) {
+            const auto &renderer = registry.get_component<nodec_rendering::components::TextRenderer>(labels[i]);
+            const auto u32_text = nodec::unicode::utf8to32<std::u32string>(renderer.text);
+            const float pixels_per_unit = static_cast<float>(renderer.pixels_per_unit);
+            const auto pixel_size = static_cast<std::uint16_t>(renderer.pixel_size);
+
+            float offset_x = 0.0f;
+            for (const auto code : u32_text) {
+                const auto &character = glyph_source.character(*renderer.font, pixel_size, code);
+                const float pos_x = offset_x + character.bearing.x / pixels_per_unit;
+                const float pos_y = -(character.size.y - character.bearing.y) / pixels_per_unit;
+                const float w = character.size.x / pixels_per_unit;
+                const float h = character.size.y / pixels_per_unit;
+                offset_x += (character.advance >> 6) / pixels_per_unit;
+                if (!character.has_bitmap) continue;
+
+                const auto matrix_m = XMMatrixScaling(w / 2, h / 2, 1.0f) * XMMatrixTranslation(pos_x + w / 2, pos_y + h / 2, 0.0f) * label_matrices[i];
+                XMFLOAT4X4 stored[3];
+                XMStoreFloat4x4(&stored[0], matrix_m);
+                XMStoreFloat4x4(&stored[1], XMMatrixInverse(nullptr, matrix_m));
+                XMStoreFloat4x4(&stored[2], matrix_m * matrix_vp);
+                glyph_matrices.insert(glyph_matrices.end(), stored, stored + 3);
+            }
+        }
+        test_runner::do_not_optimize(glyph_matrices);
+    });
+
+    // After: the cache lays the labels out once, and each frame only compares their source hashes.
+    TextLayoutCache cache(nullptr, glyph_source);
+    cache.update(registry);
+    const auto rebuild_count = cache.rebuild_count();
+    test_runner::measure("TextLayoutCache::update of the static labels", 20, [&]() {
+        cache.update(registry);
+        test_runner::do_not_optimize(cache.layout_count());
+    });
+    CHECK(cache.rebuild_count() == rebuild_count);
+}
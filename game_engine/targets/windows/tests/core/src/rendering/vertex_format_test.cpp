@@ -0,0 +1,68 @@
+#include <rendering/vertex_format.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+float unpack_half(std::uint16_t half) {
+    const float sign = (half & 0x8000u) ? -1.0f : 1.0f;
+    const int exponent = (half >> 10) & 0x1f;
+    const int mantissa = half & 0x3ff;
+    if (exponent == 0) return sign * std::ldexp(static_cast<float>(mantissa), -24);
+    if (exponent == 31) return mantissa ? std::numeric_limits<float>::quiet_NaN() : sign * std::numeric_limits<float>::infinity();
+    return sign * std::ldexp(static_cast<float>(mantissa + 1024), exponent - 25);
+}
+
+} // namespace
+
+TEST_CASE(vertex_format_packs_the_halves_rounding_to_the_nearest_even) {
+    CHECK(pack_half(0.0f) == 0x0000);
+    CHECK(pack_half(-0.0f) == 0x8000);
+    CHECK(pack_half(1.0f) == 0x3c00);
+    CHECK(pack_half(-2.0f) == 0xc000);
+    CHECK(pack_half(0.5f) == 0x3800);
+    CHECK(pack_half(65504.0f) == 0x7bff);
+
+    // The ties between two halves go to the even one.
+    CHECK(pack_half(1.0f + std::ldexp(1.0f, -11)) == 0x3c00);
+    CHECK(pack_half(1.0f + 3 * std::ldexp(1.0f, -11)) == 0x3c02);
+
+    // The subnormals, and the overflow to the infinity.
+    CHECK(pack_half(std::ldexp(1.0f, -24)) == 0x0001);
+    CHECK(pack_half(std::ldexp(1.0f, -26)) == 0x0000);
+    CHECK(pack_half(65520.0f) == 0x7c00);
+    CHECK(pack_half(-1e10f) == 0xfc00);
+    CHECK(pack_half(std::numeric_limits<float>::infinity()) == 0x7c00);
+    CHECK((pack_half(std::numeric_limits<float>::quiet_NaN()) & 0x7fffu) > 0x7c00);
+
+    // Every finite half comes back as itself.
+    std::uint32_t mismatched = 0;
+    for (std::uint32_t half = 0; half < 0x10000; ++half) {
+        if ((half & 0x7c00u) == 0x7c00u) continue;
+        if (pack_half(unpack_half(static_cast<std::uint16_t>(half))) != half) ++mismatched;
+    }
+    CHECK(mismatched == 0);
+}
+
+TEST_CASE(vertex_format_packs_the_directions_in_snorm8) {
+    CHECK(pack_snorm8(1.0f) == 127);
+    CHECK(pack_snorm8(-1.0f) == -127);
+    CHECK(pack_snorm8(0.0f) == 0);
+    CHECK(pack_snorm8(0.5f) == 64);
+    CHECK(pack_snorm8(2.0f) == 127);
+    CHECK(pack_snorm8(-2.0f) == -127);
+
+    const auto vertex = pack_compact_vertex({1.0f, 2.0f, 3.0f}, {0.0f, 1.0f, 0.0f}, {0.5f, 0.25f}, {1.0f, 0.0f, 0.0f});
+    CHECK(vertex.position.x == 1.0f && vertex.position.z == 3.0f);
+    CHECK(vertex.normal[1] == 127 && vertex.normal[3] == 0);
+    CHECK(vertex.uv[0] == 0x3800 && vertex.uv[1] == 0x3400);
+    CHECK(vertex.tangent[0] == 127);
+
+    // 24 bytes against the 44 of Float32.
+    CHECK(vertex_stride(VertexFormat::Compact) == 24);
+    CHECK(vertex_stride(VertexFormat::Float32) == 44);
+}
@@ -0,0 +1,224 @@
+#include <resources/load_scheduler.hpp>
+
+#include "../test_runner.hpp"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The loader of no file. It records the order of the loads and returns the key.
+ */
+class StubLoader {
+public:
+    LoadScheduler::Load load(const std::string &key) {
+        return [this, key](const LoadScheduler::Completion &finish) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                loaded_.push_back(key);
+            }
+            finish(std::make_shared<std::string>(key));
+        };
+    }
+
+    /**
+     * @brief The load that holds the only worker until open(), so the requests after it stay queued.
+     */
+    LoadScheduler::Load gate() {
+        return [this](const LoadScheduler::Completion &finish) {
+            gate_opened_.wait();
+            finish(nullptr);
+        };
+    }
+
+    void open() {
+        gate_.set_value();
+    }
+
+    std::vector<std::string> loaded() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return loaded_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::string> loaded_;
+    std::promise<void> gate_;
+    std::shared_future<void> gate_opened_{gate_.get_future().share()};
+};
+
+/**
+ * @brief The results the completions received, in the order of the completions.
+ */
+class Results {
+public:
+    LoadScheduler::Completion completion(const std::string &name) {
+        return [this, name](const std::shared_ptr<void> &result) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            completed_.push_back(name + "=" + (result ? *std::static_pointer_cast<std::string>(result) : "null"));
+        };
+    }
+
+    std::vector<std::string> completed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return completed_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::string> completed_;
+};
+
+using Strings = std::vector<std::string>;
+
+} // namespace
+
+TEST_CASE(load_scheduler_loads_in_the_priority_order) {
+    StubLoader loader;
+    Results results;
+    {
+        LoadScheduler scheduler(1);
+        scheduler.schedule(typeid(void), "gate", LoadPriority::Critical, {}, loader.gate(), results.completion("gate"));
+
+        // The same class is first in first out.
+        scheduler.schedule(typeid(int), "a", LoadPriority::Background, {}, loader.load("a"), results.completion("a"));
+        scheduler.schedule(typeid(int), "b", LoadPriority::Normal, {}, loader.load("b"), results.completion("b"));
+        scheduler.schedule(typeid(int), "c", LoadPriority::High, {}, loader.load("c"), results.completion("c"));
+        scheduler.schedule(typeid(int), "d", LoadPriority::Critical, {}, loader.load("d"), results.completion("d"));
+        scheduler.schedule(typeid(int), "e", LoadPriority::Normal, {}, loader.load("e"), results.completion("e"));
+        loader.open();
+
+        while (results.completed().size() < 6) std::this_thread::yield();
+        const auto stats = scheduler.stats();
+        CHECK(stats.requests == 6 && stats.loads == 6 && stats.deduplicated == 0);
+        CHECK(stats.queue_latency[static_cast<std::size_t>(LoadPriority::Normal)].count() == 2);
+    }
+    CHECK(loader.loaded() == (Strings{"d", "c", "b", "e", "a"}));
+}
+
+TEST_CASE(load_scheduler_upgrades_a_queued_request_to_the_higher_priority) {
+    StubLoader loader;
+    Results results;
+    {
+        LoadScheduler scheduler(1);
+        scheduler.schedule(typeid(void), "gate", LoadPriority::Critical, {}, loader.gate(), results.completion("gate"));
+        scheduler.schedule(typeid(int), "a", LoadPriority::Normal, {}, loader.load("a"), results.completion("a"));
+        scheduler.schedule(typeid(int), "prefetch", LoadPriority::Background, {}, loader.load("prefetch"), results.completion("prefetch"));
+
+        // The prefetched resource is needed now. Its load is shared, not run again.
+        scheduler.schedule(typeid(int), "prefetch", LoadPriority::Critical, {}, loader.load("unused"), results.completion("now"));
+        loader.open();
+
+        while (results.completed().size() < 4) std::this_thread::yield();
+        const auto stats = scheduler.stats();
+        CHECK(stats.requests == 4 && stats.deduplicated == 1 && stats.loads == 3);
+    }
+
+    // The stale entry left in the background queue is skipped.
+    CHECK(loader.loaded() == (Strings{"prefetch", "a"}));
+    CHECK(results.completed() == (Strings{"gate=null", "prefetch=prefetch", "now=prefetch", "a=a"}));
+}
+
+TEST_CASE(load_scheduler_skips_the_load_all_its_requesters_cancelled) {
+    StubLoader loader;
+    Results results;
+    {
+        LoadScheduler scheduler(1);
+        scheduler.schedule(typeid(void), "gate", LoadPriority::Critical, {}, loader.gate(), results.completion("gate"));
+
+        auto token_a1 = CancellationToken::create();
+        auto token_a2 = CancellationToken::create();
+        scheduler.schedule(typeid(int), "a", LoadPriority::Normal, token_a1, loader.load("a"), results.completion("a1"));
+        scheduler.schedule(typeid(int), "a", LoadPriority::Normal, token_a2, loader.load("a"), results.completion("a2"));
+
+        // One of the two gives up, so the load still runs for the other.
+        auto token_b1 = CancellationToken::create();
+        scheduler.schedule(typeid(int), "b", LoadPriority::Normal, token_b1, loader.load("b"), results.completion("b1"));
+        scheduler.schedule(typeid(int), "b", LoadPriority::Normal, {}, loader.load("b"), results.completion("b2"));
+
+        token_a1.cancel();
+        token_a2.cancel();
+        token_b1.cancel();
+
+        // Already cancelled, so completed on this thread before schedule returns.
+        scheduler.schedule(typeid(int), "c", LoadPriority::Normal, token_b1, loader.load("c"), results.completion("c"));
+        CHECK(results.completed() == (Strings{"c=null"}));
+        loader.open();
+
+        while (results.completed().size() < 6) std::this_thread::yield();
+        const auto stats = scheduler.stats();
+        CHECK(stats.requests == 6 && stats.cancelled == 2 && stats.loads == 2);
+    }
+
+    CHECK(loader.loaded() == (Strings{"b"}));
+    CHECK(results.completed() == (Strings{"c=null", "gate=null", "a1=null", "a2=null", "b1=null", "b2=b"}));
+}
+
+TEST_CASE(load_scheduler_shares_the_load_of_the_same_type_and_key) {
+    StubLoader loader;
+    Results results;
+    {
+        LoadScheduler scheduler(1);
+        scheduler.schedule(typeid(void), "gate", LoadPriority::Critical, {}, loader.gate(), results.completion("gate"));
+
+        scheduler.schedule(typeid(int), "texture", LoadPriority::Normal, {}, loader.load("texture"), results.completion("int1"));
+        scheduler.schedule(typeid(int), "texture", LoadPriority::Normal, {}, loader.load("texture"), results.completion("int2"));
+
+        // The same path of another resource type is another load.
+        scheduler.schedule(typeid(float), "texture", LoadPriority::Normal, {}, loader.load("texture"), results.completion("float"));
+        loader.open();
+
+        while (results.completed().size() < 4) std::this_thread::yield();
+
+        // Once finished, the next request loads again.
+        scheduler.schedule(typeid(int), "texture", LoadPriority::Normal, {}, loader.load("texture"), results.completion("int3"));
+        while (results.completed().size() < 5) std::this_thread::yield();
+        CHECK(scheduler.stats().deduplicated == 1);
+    }
+
+    CHECK(loader.loaded() == (Strings{"texture", "texture", "texture"}));
+}
+
+TEST_CASE(load_scheduler_completes_the_requests_never_started_with_null_on_destruction) {
+    StubLoader loader;
+    Results results;
+    std::thread destroyer;
+    {
+        auto scheduler = std::make_unique<LoadScheduler>(1);
+        scheduler->schedule(typeid(void), "gate", LoadPriority::Critical, {}, loader.gate(), results.completion("gate"));
+        scheduler->schedule(typeid(int), "a", LoadPriority::Normal, {}, loader.load("a"), results.completion("a"));
+        scheduler->schedule(typeid(int), "b", LoadPriority::Background, {}, loader.load("b"), results.completion("b"));
+
+        // The destructor waits for the running gate, so it runs on another thread while the gate is opened.
+        destroyer = std::thread([&scheduler]() { scheduler.reset(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        loader.open();
+        destroyer.join();
+    }
+
+    CHECK(loader.loaded().empty());
+    CHECK(results.completed() == (Strings{"gate=null", "a=null", "b=null"}) || results.completed() == (Strings{"gate=null", "b=null", "a=null"}));
+}
+
+TEST_CASE(load_scheduler_typed_schedule_returns_the_result_in_the_future) {
+    LoadScheduler scheduler(2);
+    std::shared_ptr<int> completed;
+    auto future = scheduler.schedule<int>(
+        "answer", LoadPriority::High, {}, []() { return std::make_shared<int>(42); },
+        [&](const std::shared_ptr<int> &result) { completed = result; });
+
+    const auto result = future.get();
+    CHECK(result && *result == 42);
+    CHECK(completed == result);
+
+    // A throwing load completes with null.
+    auto failed = scheduler.schedule<int>("broken", LoadPriority::High, {}, []() -> std::shared_ptr<int> { throw std::runtime_error("broken"); });
+    CHECK(!failed.get());
+}
@@ -0,0 +1,133 @@
+#include <resources/lz4_block.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Bytes = std::vector<std::uint8_t>;
+
+bool round_trips(const Bytes &source) {
+    const auto compressed = lz4_block::compress(source.data(), source.size());
+    Bytes restored(source.size());
+    lz4_block::decompress(compressed.data(), compressed.size(), restored.data(), restored.size());
+    return restored == source;
+}
+
+Bytes random_bytes(std::size_t size, std::uint32_t seed) {
+    std::mt19937 random(seed);
+    Bytes bytes(size);
+    for (auto &byte : bytes) {
+        byte = static_cast<std::uint8_t>(random());
+    }
+    return bytes;
+}
+
+/**
+ * @brief The text of the shader metas and the scenes, repeating with small changes.
+ */
+Bytes text_like(std::size_t size) {
+    std::mt19937 random(3);
+    Bytes bytes;
+    for (int i = 0; bytes.size() < size; ++i) {
+        const auto line = "{\"name\": \"property_" + std::to_string(i % 37) + "\", \"type\": \"float4\", \"default\": ["
+                          + std::to_string(random() % 1000) + ", 0, " + std::to_string(random() % 100) + ", 1]},\n";
+        bytes.insert(bytes.end(), line.begin(), line.end());
+    }
+    bytes.resize(size);
+    return bytes;
+}
+
+bool is_rejected(const Bytes &compressed, std::size_t size) {
+    Bytes restored(size);
+    try {
+        lz4_block::decompress(compressed.data(), compressed.size(), restored.data(), restored.size());
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+TEST_CASE(lz4_block_round_trips_the_empty_and_the_short_inputs) {
+    CHECK(round_trips({}));
+    CHECK(lz4_block::compress(nullptr, 0).size() == 1);
+
+    // Around the sizes below which everything is literals.
+    bool is_valid = true;
+    for (std::size_t size = 1; size <= 40; ++size) {
+        is_valid = is_valid && round_trips(Bytes(size, 7)) && round_trips(random_bytes(size, static_cast<std::uint32_t>(size)));
+    }
+    CHECK(is_valid);
+}
+
+TEST_CASE(lz4_block_round_trips_the_incompressible_input) {
+    const auto source = random_bytes(100000, 1);
+    CHECK(round_trips(source));
+
+    // Only the literal lengths are added.
+    const auto compressed = lz4_block::compress(source.data(), source.size());
+    CHECK(compressed.size() <= source.size() + source.size() / 255 + 16);
+}
+
+TEST_CASE(lz4_block_round_trips_the_repetitive_input) {
+    // The overlapping matches of the offset 1, and the lengths of several 255 bytes.
+    const Bytes zeros(1 << 20, 0);
+    CHECK(round_trips(zeros));
+    CHECK(lz4_block::compress(zeros.data(), zeros.size()).size() < 5000);
+
+    const auto text = text_like(300000);
+    CHECK(round_trips(text));
+    CHECK(lz4_block::compress(text.data(), text.size()).size() < text.size() / 4);
+
+    // The repeat farther than the 64 KiB window, which the matches cannot refer.
+    auto far = random_bytes(70000, 2);
+    far.insert(far.end(), far.begin(), far.begin() + 70000);
+    CHECK(round_trips(far));
+}
+
+TEST_CASE(lz4_block_rejects_the_malformed_blocks) {
+    const auto text = text_like(10000);
+    const auto compressed = lz4_block::compress(text.data(), text.size());
+    CHECK(!is_rejected(compressed, text.size()));
+
+    CHECK(is_rejected({}, text.size()));
+    CHECK(is_rejected(Bytes(compressed.begin(), compressed.end() - 1), text.size()));
+    CHECK(is_rejected(compressed, text.size() - 1));
+    CHECK(is_rejected(compressed, text.size() + 1));
+
+    // The match before the start, and the match of the offset 0.
+    CHECK(is_rejected({0x10, 'a', 0x02, 0x00, 0x00}, 16));
+    CHECK(is_rejected({0x10, 'a', 0x00, 0x00, 0x00}, 16));
+
+    // The literal length running past the block.
+    CHECK(is_rejected({0xf0, 255, 255}, 1000));
+}
+
+BENCHMARK(lz4_block_decompress) {
+    // The scene and the shader meta texts.
+    const auto source = text_like(8 << 20);
+    const auto compressed = lz4_block::compress(source.data(), source.size());
+    Bytes restored(source.size());
+
+    test_runner::measure("compress 8 MB of text", 5, [&]() {
+        test_runner::do_not_optimize(lz4_block::compress(source.data(), source.size()));
+    });
+    const auto decompress = test_runner::measure("decompress 8 MB of text", 20, [&]() {
+        lz4_block::decompress(compressed.data(), compressed.size(), restored.data(), restored.size());
+        test_runner::do_not_optimize(restored);
+    });
+    const auto copy = test_runner::measure("copy 8 MB", 20, [&]() {
+        std::memcpy(restored.data(), source.data(), source.size());
+        test_runner::do_not_optimize(restored);
+    });
+
+    std::printf("  ratio %.2f, decompress %.0f MB/s, copy %.0f MB/s\n", static_cast<double>(compressed.size()) / source.size(),
+                source.size() / decompress, source.size() / copy);
+}
@@ -0,0 +1,195 @@
+#include <resources/resource_archive.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace resource_archive;
+
+/**
+ * @brief The archive in memory, aligned like the mapped views are.
+ */
+class AlignedArchive {
+public:
+    explicit AlignedArchive(const std::string &bytes)
+        : words_((bytes.size() + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t)), size_(bytes.size()) {
+        std::memcpy(words_.data(), bytes.data(), bytes.size());
+    }
+
+    std::uint8_t *data() noexcept {
+        return reinterpret_cast<std::uint8_t *>(words_.data());
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+    Header &header() noexcept {
+        return *reinterpret_cast<Header *>(words_.data());
+    }
+
+    IndexEntry &entry(std::size_t index) noexcept {
+        return reinterpret_cast<IndexEntry *>(data() + header().index_offset)[index];
+    }
+
+private:
+    std::vector<std::uint64_t> words_;
+    std::size_t size_;
+};
+
+struct SourceFile {
+    std::string name;
+    std::string data;
+    bool compress;
+};
+
+std::vector<SourceFile> make_files() {
+    std::mt19937 random(1);
+    std::string noise(5000, '\0');
+    for (auto &c : noise) {
+        c = static_cast<char>(random());
+    }
+
+    std::string meta;
+    while (meta.size() < 5000) {
+        meta += "{\"name\": \"albedo\", \"type\": \"texture\", \"slot\": 0},\n";
+    }
+
+    return {
+        {"shaders/standard/shader.meta", meta, true},
+        {"textures/noise.dds", noise, true}, // Not worth compressing, so stored.
+        {"meshes/cube.mesh", std::string(3000, 'm'), false},
+        {"empty.txt", "", true},
+        {"scenes/level 1/\xE3\x81\x82.scene", meta.substr(0, 100), true},
+    };
+}
+
+std::string write_archive(const std::vector<SourceFile> &files) {
+    std::ostringstream out;
+    ArchiveWriter writer(out);
+    for (const auto &file : files) {
+        writer.add(file.name, file.data.data(), file.data.size(), file.compress);
+    }
+    writer.finish();
+    return out.str();
+}
+
+std::string read_entry(const View &view, const IndexEntry &entry) {
+    std::string data(static_cast<std::size_t>(entry.size), '\0');
+    if (entry.compression == static_cast<std::uint8_t>(Compression::None)) {
+        std::memcpy(&data[0], view.data + entry.offset, data.size());
+    } else {
+        lz4_block::decompress(view.data + entry.offset, static_cast<std::size_t>(entry.stored_size), &data[0], data.size());
+    }
+    return data;
+}
+
+bool is_rejected(AlignedArchive &archive, std::size_t size) {
+    try {
+        parse_archive(archive.data(), size);
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+TEST_CASE(resource_archive_finds_every_entry_written) {
+    const auto files = make_files();
+    AlignedArchive archive(write_archive(files));
+    const auto view = parse_archive(archive.data(), archive.size());
+    CHECK(view.header->entry_count == files.size());
+
+    for (const auto &file : files) {
+        const auto *entry = find_entry(view, file.name);
+        CHECK(entry);
+        if (!entry) continue;
+
+        CHECK(entry->offset % ALIGNMENT == 0);
+        CHECK(entry->size == file.data.size());
+        CHECK(read_entry(view, *entry) == file.data);
+    }
+
+    const auto compression = [&](const char *name) { return static_cast<Compression>(find_entry(view, name)->compression); };
+    CHECK(compression("shaders/standard/shader.meta") == Compression::Lz4);
+    CHECK(compression("textures/noise.dds") == Compression::None);
+    CHECK(compression("meshes/cube.mesh") == Compression::None);
+    CHECK(compression("empty.txt") == Compression::None);
+
+    CHECK(!find_entry(view, "shaders/standard/shader.met"));
+    CHECK(!find_entry(view, "Shaders/standard/shader.meta"));
+    CHECK(!find_entry(view, ""));
+}
+
+TEST_CASE(resource_archive_of_no_entries) {
+    AlignedArchive archive(write_archive({}));
+    const auto view = parse_archive(archive.data(), archive.size());
+    CHECK(view.header->entry_count == 0);
+    CHECK(!find_entry(view, "a"));
+}
+
+TEST_CASE(resource_archive_rejects_the_broken_headers_and_index) {
+    const auto bytes = write_archive(make_files());
+
+    // Each corrupts one copy of the archive.
+    const auto rejects = [&](void (*corrupt)(AlignedArchive &)) {
+        AlignedArchive archive(bytes);
+        corrupt(archive);
+        return is_rejected(archive, archive.size());
+    };
+
+    CHECK(!rejects([](AlignedArchive &) {}));
+    CHECK(rejects([](AlignedArchive &archive) { archive.header().magic ^= 1; }));
+    CHECK(rejects([](AlignedArchive &archive) { ++archive.header().version; }));
+    CHECK(rejects([](AlignedArchive &archive) { ++archive.header().entry_count; }));
+    CHECK(rejects([](AlignedArchive &archive) { archive.header().index_offset += 4; }));
+    CHECK(rejects([](AlignedArchive &archive) { archive.header().names_size += 1; }));
+    CHECK(rejects([](AlignedArchive &archive) { archive.header().index_offset = ~0ull & ~7ull; }));
+
+    CHECK(rejects([](AlignedArchive &archive) {
+        // Only the empty entry fits there.
+        for (std::uint32_t i = 0; i < archive.header().entry_count; ++i) archive.entry(i).offset = archive.size();
+    }));
+    CHECK(rejects([](AlignedArchive &archive) { archive.entry(0).offset = ~0ull; }));
+    CHECK(rejects([](AlignedArchive &archive) { archive.entry(1).name_size = 0xffffffffu; }));
+    CHECK(rejects([](AlignedArchive &archive) { archive.entry(1).compression = 2; }));
+    CHECK(rejects([](AlignedArchive &archive) { std::swap(archive.entry(0).hash, archive.entry(1).hash); }));
+
+    {
+        AlignedArchive archive(bytes);
+        CHECK(is_rejected(archive, sizeof(Header) - 1));
+        CHECK(is_rejected(archive, archive.size() - 1));
+    }
+}
+
+TEST_CASE(resource_archive_rejects_the_sizes_disagreeing_with_the_stored_bytes) {
+    const auto bytes = write_archive(make_files());
+    const auto view_of = [](AlignedArchive &archive) { return parse_archive(archive.data(), archive.size()); };
+
+    {
+        // A stored entry exposed past its bytes.
+        AlignedArchive archive(bytes);
+        auto *entry = const_cast<IndexEntry *>(find_entry(view_of(archive), "meshes/cube.mesh"));
+        entry->size += 1;
+        CHECK(is_rejected(archive, archive.size()));
+    }
+    {
+        // An LZ4 entry claiming more than its block can expand to, which the reader would allocate.
+        AlignedArchive archive(bytes);
+        auto *entry = const_cast<IndexEntry *>(find_entry(view_of(archive), "shaders/standard/shader.meta"));
+        entry->size = entry->stored_size * 255 + 16;
+        CHECK(!is_rejected(archive, archive.size()));
+        entry->size += 1;
+        CHECK(is_rejected(archive, archive.size()));
+        entry->size = ~0ull;
+        CHECK(is_rejected(archive, archive.size()));
+    }
+}
@@ -0,0 +1,209 @@
+#include <resources/resource_file_system.hpp>
+
+#include "../test_runner.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The resource directory and its archive, written under the temporary directory and removed at the end.
+ */
+class ResourceDirectory {
+public:
+    explicit ResourceDirectory(const std::string &name)
+        : root_(std::filesystem::temp_directory_path() / name) {
+        std::filesystem::remove_all(root_);
+        std::filesystem::create_directories(root_ / "resources");
+    }
+
+    ~ResourceDirectory() {
+        std::error_code error;
+        std::filesystem::remove_all(root_, error);
+    }
+
+    /**
+     * @param name The path relative to the resource directory.
+     */
+    void write(const std::string &name, const std::string &data) {
+        const auto path = root_ / "resources" / std::filesystem::u8path(name);
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream out(path, std::ios::binary);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    /**
+     * @brief Packs the given files like the resource packer does, compressing when it is worth.
+     */
+    void pack(const std::vector<std::string> &names) {
+        std::ofstream out(archive_path(), std::ios::binary);
+        resource_archive::ArchiveWriter writer(out);
+        for (const auto &name : names) {
+            const auto data = read_loose(name);
+            writer.add(name, data.data(), data.size(), true);
+        }
+        writer.finish();
+    }
+
+    void remove(const std::string &name) {
+        std::filesystem::remove(root_ / "resources" / std::filesystem::u8path(name));
+    }
+
+    /**
+     * @brief Leaves only the archive, like the shipped build.
+     */
+    void remove_loose_files() {
+        std::filesystem::remove_all(root_ / "resources");
+    }
+
+    std::string read_loose(const std::string &name) const {
+        std::ifstream in(root_ / "resources" / std::filesystem::u8path(name), std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    std::string resource_path() const {
+        return (root_ / "resources").u8string();
+    }
+
+    std::string archive_path() const {
+        return (root_ / "resources.nodecpack").u8string();
+    }
+
+private:
+    std::filesystem::path root_;
+};
+
+std::string read(const ResourceFileSystem &files, const std::string &path) {
+    const auto file = files.read(path);
+    if (!file) return "<null>";
+    return std::string(static_cast<const char *>(file->data()), file->size());
+}
+
+/**
+ * @brief The small text and binary assets, like the shader metas, the materials and the scenes.
+ */
+std::string make_asset(std::mt19937 &random) {
+    std::string data;
+    const auto line_count = 16 + random() % 100;
+    for (std::uint32_t i = 0; i < line_count; ++i) {
+        data += "{\"name\": \"property_" + std::to_string(random() % 50) + "\", \"value\": " + std::to_string(random() % 1000) + "},\n";
+    }
+    return data;
+}
+
+} // namespace
+
+TEST_CASE(resource_file_system_reads_the_packed_files) {
+    ResourceDirectory directory("nodec_resource_file_system_test");
+    std::mt19937 random(1);
+    const auto meta = make_asset(random);
+    const auto noise = [&]() {
+        std::string data(3000, '\0');
+        for (auto &c : data) c = static_cast<char>(random());
+        return data;
+    }();
+
+    directory.write("shaders/standard/shader.meta", meta);
+    directory.write("textures/noise.dds", noise);
+    directory.write("empty.txt", "");
+    directory.pack({"shaders/standard/shader.meta", "textures/noise.dds", "empty.txt"});
+    directory.remove("shaders/standard/shader.meta");
+    directory.remove("textures/noise.dds");
+    directory.remove("empty.txt");
+
+    ResourceFileSystem files;
+    const auto resources = directory.resource_path();
+    CHECK(read(files, resources + "/textures/noise.dds") == "<null>");
+
+    files.mount(resources, directory.archive_path());
+    CHECK(files.archive_entry_count() == 3);
+
+    // The compressed one, the stored one and the empty one.
+    CHECK(read(files, resources + "/shaders/standard/shader.meta") == meta);
+    CHECK(read(files, resources + "/textures/noise.dds") == noise);
+    CHECK(read(files, resources + "\\textures\\noise.dds") == noise);
+    CHECK(read(files, resources + "/empty.txt").empty());
+    CHECK(files.exists(resources + "/textures/noise.dds"));
+    CHECK(read(files, resources + "/missing.txt") == "<null>");
+    CHECK(!files.exists(resources + "/missing.txt"));
+
+    std::string streamed;
+    auto stream = files.open(resources + "/shaders/standard/shader.meta");
+    CHECK(stream != nullptr);
+    if (stream) streamed.assign(std::istreambuf_iterator<char>(*stream), std::istreambuf_iterator<char>());
+    CHECK(streamed == meta);
+
+    files.unmount();
+    CHECK(files.archive_entry_count() == 0);
+    CHECK(read(files, resources + "/textures/noise.dds") == "<null>");
+}
+
+TEST_CASE(resource_file_system_reads_the_loose_files_before_a_stale_archive) {
+    ResourceDirectory directory("nodec_resource_file_system_stale_test");
+    directory.write("textures/noise.dds", "packed");
+    directory.write("shaders/standard/shader.meta", "packed meta");
+    directory.pack({"textures/noise.dds", "shaders/standard/shader.meta"});
+
+    // Edited after the packing, and added later.
+    directory.write("textures/noise.dds", "edited");
+    directory.write("scenes/new.scene", "new");
+
+    ResourceFileSystem files;
+    const auto resources = directory.resource_path();
+    files.mount(resources, directory.archive_path());
+
+    CHECK(read(files, resources + "/textures/noise.dds") == "edited");
+    CHECK(read(files, resources + "/scenes/new.scene") == "new");
+    CHECK(files.exists(resources + "/scenes/new.scene"));
+
+    // The packed copy is read once the loose file is gone.
+    directory.remove("textures/noise.dds");
+    CHECK(read(files, resources + "/textures/noise.dds") == "packed");
+    CHECK(read(files, resources + "/shaders/standard/shader.meta") == "packed meta");
+}
+
+BENCHMARK(resource_file_system_startup_10k_assets) {
+    constexpr int ASSET_COUNT = 10000;
+
+    ResourceDirectory directory("nodec_resource_file_system_benchmark");
+    std::mt19937 random(2);
+    std::vector<std::string> names;
+    std::uint64_t total_bytes = 0;
+    for (int i = 0; i < ASSET_COUNT; ++i) {
+        names.push_back("assets_" + std::to_string(i % 100) + "/asset_" + std::to_string(i) + ".meta");
+        const auto data = make_asset(random);
+        directory.write(names.back(), data);
+        total_bytes += data.size();
+    }
+    directory.pack(names);
+
+    const auto resources = directory.resource_path();
+    const auto read_all = [&](const ResourceFileSystem &files) {
+        std::uint64_t read_bytes = 0;
+        for (const auto &name : names) {
+            const auto file = files.read(resources + "/" + name);
+            if (file) read_bytes += file->size();
+        }
+        test_runner::do_not_optimize(read_bytes);
+    };
+
+    // The file cache is warm for both. The cold start costs the loose files more, one open and seek each.
+    ResourceFileSystem loose;
+    test_runner::measure("10k loose files", 3, [&]() { read_all(loose); });
+
+    // The loose files would be read first, so only the archive is left like in the shipped build.
+    const auto archive_bytes = std::filesystem::file_size(std::filesystem::u8path(directory.archive_path()));
+    directory.remove_loose_files();
+    ResourceFileSystem packed;
+    packed.mount(resources, directory.archive_path());
+    test_runner::measure("10k files from the archive", 3, [&]() { read_all(packed); });
+
+    std::printf("  %llu bytes loose, %llu bytes packed\n", static_cast<unsigned long long>(total_bytes),
+                static_cast<unsigned long long>(archive_bytes));
+}
@@ -0,0 +1,176 @@
+#include <resources/resource_residency.hpp>
+
+#include "../test_runner.hpp"
+
+#include <memory>
+#include <string>
+
+namespace {
+
+/**
+ * @brief The resource of a fixed size. The material like ones refer the textures like ones.
+ */
+struct StubResource {
+    std::shared_ptr<StubResource> dependency;
+};
+
+std::shared_ptr<StubResource> track(ResourceResidency &residency, const std::string &type, const std::string &path,
+                                    std::uint64_t bytes, std::shared_ptr<StubResource> dependency = {}) {
+    auto resource = std::make_shared<StubResource>();
+    resource->dependency = std::move(dependency);
+    residency.track(type, path, resource, bytes);
+    return resource;
+}
+
+} // namespace
+
+TEST_CASE(resource_residency_releases_the_least_recently_used_over_the_budget) {
+    ResourceResidency residency(1000);
+    auto a = track(residency, "Texture", "a", 40);
+    auto b = track(residency, "Texture", "b", 40);
+    auto c = track(residency, "Texture", "c", 40);
+    auto d = track(residency, "Texture", "d", 40);
+    std::weak_ptr<StubResource> weak_a = a, weak_b = b, weak_c = c, weak_d = d;
+    residency.update();
+
+    // Within the budget, the unreferenced ones stay cached.
+    c.reset();
+    residency.update();
+    a.reset();
+    residency.update();
+    b.reset();
+    residency.update();
+    CHECK(residency.count() == 4);
+    CHECK(residency.total_bytes() == 160);
+
+    // c, then a, is the least recently used.
+    residency.set_budget(90);
+    CHECK(residency.update() == 2);
+    CHECK(weak_c.expired() && weak_a.expired());
+    CHECK(!weak_b.expired() && !weak_d.expired());
+    CHECK(residency.total_bytes() == 80);
+    CHECK(residency.evicted_count() == 2);
+}
+
+TEST_CASE(resource_residency_releases_the_larger_first_among_the_same_frame) {
+    ResourceResidency residency(1000);
+    std::weak_ptr<StubResource> small = track(residency, "Mesh", "small", 10);
+    std::weak_ptr<StubResource> large = track(residency, "Mesh", "large", 100);
+    std::weak_ptr<StubResource> medium = track(residency, "Mesh", "medium", 50);
+
+    residency.set_budget(60);
+    CHECK(residency.update() == 1);
+    CHECK(large.expired() && !medium.expired() && !small.expired());
+}
+
+TEST_CASE(resource_residency_never_releases_the_referenced_resources) {
+    ResourceResidency residency(10);
+    auto held = track(residency, "Texture", "held", 40);
+    std::weak_ptr<StubResource> cached = track(residency, "Texture", "cached", 5);
+
+    // Over the budget, but only the unreferenced one can go.
+    CHECK(residency.update() == 1);
+    CHECK(cached.expired());
+    CHECK(residency.count() == 1);
+    CHECK(residency.total_bytes() == 40);
+
+    CHECK(residency.update() == 0);
+    CHECK(residency.count() == 1);
+}
+
+TEST_CASE(resource_residency_budget_0_releases_every_unreferenced_resource) {
+    ResourceResidency residency(0);
+    auto held = track(residency, "Texture", "held", 40);
+    std::weak_ptr<StubResource> texture = track(residency, "Texture", "texture", 1);
+    std::weak_ptr<StubResource> shader = track(residency, "Shader", "shader", 0);
+
+    CHECK(residency.update() == 2);
+    CHECK(texture.expired() && shader.expired());
+
+    held.reset();
+    CHECK(residency.update() == 1);
+    CHECK(residency.count() == 0);
+    CHECK(residency.total_bytes() == 0);
+}
+
+TEST_CASE(resource_residency_ages_out_the_resources_of_0_bytes) {
+    ResourceResidency residency(1000);
+    residency.set_unsized_idle_frames(3);
+    std::weak_ptr<StubResource> shader = track(residency, "Shader", "shader", 0);
+    std::weak_ptr<StubResource> texture = track(residency, "Texture", "texture", 10);
+
+    CHECK(residency.update() == 0);
+    CHECK(residency.update() == 0);
+    CHECK(!shader.expired());
+
+    // The sized one is within the budget, so it stays.
+    CHECK(residency.update() == 1);
+    CHECK(shader.expired());
+    CHECK(!texture.expired());
+
+    // A use restarts the idle frames.
+    auto material = track(residency, "Material", "material", 0);
+    std::weak_ptr<StubResource> weak_material = material;
+    residency.update();
+    residency.update();
+    material.reset();
+    residency.update();
+    residency.update();
+    CHECK(!weak_material.expired());
+    residency.update();
+    CHECK(weak_material.expired());
+}
+
+TEST_CASE(resource_residency_releases_what_the_released_resources_referred) {
+    ResourceResidency residency(0);
+    std::weak_ptr<StubResource> texture;
+    std::weak_ptr<StubResource> material;
+    {
+        auto held_texture = track(residency, "Texture", "albedo", 100);
+        texture = held_texture;
+        material = track(residency, "Material", "material", 0, held_texture);
+    }
+
+    // The texture is referenced by the material until the material goes, in the same update.
+    CHECK(residency.update() == 2);
+    CHECK(material.expired() && texture.expired());
+    CHECK(residency.total_bytes() == 0);
+
+    // With a budget, the aged out material leaves its texture cached within the budget.
+    residency.set_budget(1000);
+    residency.set_unsized_idle_frames(2);
+    {
+        auto held_texture = track(residency, "Texture", "albedo", 100);
+        texture = held_texture;
+        material = track(residency, "Material", "material", 0, held_texture);
+    }
+    residency.update();
+    CHECK(residency.update() == 1);
+    CHECK(material.expired() && !texture.expired());
+
+    residency.set_budget(50);
+    CHECK(residency.update() == 1);
+    CHECK(texture.expired());
+}
+
+TEST_CASE(resource_residency_accounts_the_bytes_per_type) {
+    ResourceResidency residency(1000);
+    auto a = track(residency, "Texture", "a", 300);
+    auto b = track(residency, "Texture", "b", 200);
+    auto c = track(residency, "Mesh", "c", 400);
+
+    // Tracking the same path again replaces the entry.
+    auto replaced = track(residency, "Mesh", "c", 100);
+    CHECK(residency.count() == 3);
+    CHECK(residency.total_bytes() == 600);
+
+    const auto usages = residency.bytes_by_type();
+    CHECK(usages.size() == 2);
+    CHECK(usages[0].type == "Texture" && usages[0].count == 2 && usages[0].bytes == 500);
+    CHECK(usages[1].type == "Mesh" && usages[1].bytes == 100);
+
+    const auto largest = residency.largest(2);
+    CHECK(largest.size() == 2);
+    CHECK(largest[0].path == "a" && largest[1].path == "b");
+    CHECK(residency.largest(10).size() == 3);
+}
@@ -0,0 +1,192 @@
+#include <resources/upload_queue.hpp>
+
+#include "../test_runner.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The uploader of no device. It records the uploads and the discards by their ids.
+ */
+struct FakeUploader {
+    std::vector<int> uploaded;
+    std::vector<int> discarded;
+
+    bool push(UploadQueue &queue, int id, std::uint64_t bytes) {
+        return queue.push(
+            bytes, [this, id]() { uploaded.push_back(id); }, [this, id]() { discarded.push_back(id); });
+    }
+};
+
+// Busy, since the sleeps are too coarse for the budgets of a frame.
+void spin_for(std::chrono::microseconds duration) {
+    const auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+} // namespace
+
+TEST_CASE(upload_queue_drains_in_the_push_order_within_the_byte_budget) {
+    UploadQueue queue;
+    FakeUploader uploader;
+    for (int id = 0; id < 5; ++id) {
+        CHECK(uploader.push(queue, id, 10));
+    }
+    CHECK(queue.pending_count() == 5 && queue.pending_bytes() == 50);
+
+    UploadBudget budget;
+    budget.bytes = 25;
+    CHECK(queue.drain(budget) == 2);
+    CHECK(uploader.uploaded == (std::vector<int>{0, 1}));
+    CHECK(queue.drain(budget) == 2);
+    CHECK(queue.drain(budget) == 1);
+    CHECK(queue.drain(budget) == 0);
+    CHECK(uploader.uploaded == (std::vector<int>{0, 1, 2, 3, 4}));
+
+    const auto stats = queue.stats();
+    CHECK(stats.uploads == 5 && stats.bytes == 50);
+    CHECK(stats.drains == 4 && stats.budget_exhausted == 2);
+    CHECK(stats.wait_latency.count() == 5);
+    CHECK(queue.pending_bytes() == 0);
+}
+
+TEST_CASE(upload_queue_runs_at_least_one_upload_per_drain) {
+    UploadQueue queue;
+    FakeUploader uploader;
+
+    // Larger than the byte budget.
+    uploader.push(queue, 0, 100);
+    uploader.push(queue, 1, 1);
+    UploadBudget budget;
+    budget.bytes = 10;
+    CHECK(queue.drain(budget) == 1);
+    CHECK(uploader.uploaded == (std::vector<int>{0}));
+
+    // No time left from the start.
+    uploader.push(queue, 2, 1);
+    budget.bytes = 1000;
+    budget.microseconds = 0;
+    CHECK(queue.drain(budget) == 1);
+    CHECK(queue.drain(budget) == 1);
+    CHECK(uploader.uploaded == (std::vector<int>{0, 1, 2}));
+}
+
+TEST_CASE(upload_queue_stops_on_the_time_budget) {
+    UploadQueue queue;
+    for (int i = 0; i < 10; ++i) {
+        queue.push(1, []() { spin_for(std::chrono::microseconds(1000)); }, {});
+    }
+
+    UploadBudget budget;
+    budget.microseconds = 2500;
+    const auto drained_count = queue.drain(budget);
+
+    // Each upload starts within the budget, so the last one ends past it by one upload at most.
+    CHECK(drained_count >= 1 && drained_count <= 3);
+    CHECK(queue.pending_count() == 10 - drained_count);
+}
+
+TEST_CASE(upload_queue_holds_the_pushers_while_full) {
+    UploadQueue queue(100);
+    FakeUploader uploader;
+
+    // An empty queue takes any size.
+    CHECK(uploader.push(queue, 0, 1000));
+    queue.drain(UploadBudget{});
+
+    uploader.push(queue, 1, 60);
+    std::atomic<bool> pushed{false};
+    std::thread loader([&]() {
+        uploader.push(queue, 2, 60);
+        pushed = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!pushed);
+    CHECK(queue.pending_bytes() == 60);
+
+    // The drain makes the room.
+    UploadBudget budget;
+    budget.bytes = 60;
+    CHECK(queue.drain(budget) == 1);
+    loader.join();
+    CHECK(pushed);
+    CHECK(queue.pending_bytes() == 60);
+    queue.drain(budget);
+    CHECK(uploader.uploaded == (std::vector<int>{0, 1, 2}));
+}
+
+TEST_CASE(upload_queue_close_discards_the_queued_uploads) {
+    UploadQueue queue(100);
+    FakeUploader uploader;
+    uploader.push(queue, 0, 60);
+    uploader.push(queue, 1, 30);
+
+    bool refused = false;
+    std::thread loader([&]() { refused = !uploader.push(queue, 2, 60); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // The waiting pusher is released with false.
+    queue.close();
+    loader.join();
+    CHECK(refused);
+    CHECK(uploader.discarded == (std::vector<int>{0, 1}));
+    CHECK(queue.stats().discarded == 2);
+    CHECK(queue.pending_count() == 0 && queue.pending_bytes() == 0);
+
+    CHECK(!uploader.push(queue, 3, 1));
+    CHECK(queue.drain(UploadBudget{}) == 0);
+    CHECK(uploader.uploaded.empty());
+    CHECK(uploader.discarded.size() == 2);
+}
+
+BENCHMARK(upload_queue_drain) {
+    using namespace std::chrono;
+
+    // A level load: 4 loader threads push 400 resources of 0.1 to 1.6 ms of device work.
+    constexpr int RESOURCE_COUNT = 400;
+    constexpr int LOADER_COUNT = 4;
+
+    for (const bool is_budgeted : {false, true}) {
+        UploadQueue queue;
+        std::vector<std::thread> loaders;
+        for (int t = 0; t < LOADER_COUNT; ++t) {
+            loaders.emplace_back([&queue, t]() {
+                for (int i = t; i < RESOURCE_COUNT; i += LOADER_COUNT) {
+                    const auto cost = microseconds(100 << (i % 5));
+                    queue.push(1ull << 19, [cost]() { spin_for(cost); }, {});
+                }
+            });
+        }
+        for (auto &loader : loaders) {
+            loader.join();
+        }
+
+        // The render thread drains once a frame.
+        UploadBudget budget;
+        if (!is_budgeted) {
+            budget.microseconds = ~0ull;
+            budget.bytes = ~0ull;
+        }
+        std::size_t frame_count = 0;
+        std::int64_t worst_drain = 0;
+        while (queue.pending_count() > 0) {
+            const auto start = steady_clock::now();
+            queue.drain(budget);
+            worst_drain = (std::max)(worst_drain, duration_cast<microseconds>(steady_clock::now() - start).count());
+            ++frame_count;
+        }
+
+        // A frame hitches by the longest drain.
+        std::printf("  %-56s %12lld us\n", is_budgeted ? "the worst drain within 2 ms / 32 MB" : "the worst drain of all at once",
+                    static_cast<long long>(worst_drain));
+        std::printf("  %zu frames to upload all\n", frame_count);
+    }
+}
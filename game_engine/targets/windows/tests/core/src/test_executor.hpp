@@ -0,0 +1,67 @@
+#ifndef NODEC_GAME_ENGINE_CORE_TESTS__TEST_EXECUTOR_HPP_
+#define NODEC_GAME_ENGINE_CORE_TESTS__TEST_EXECUTOR_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The thread pool of a fixed size, for the tests and the scaling benchmarks of the chunked work.
+ *
+ * It has the submit() of nodec::concurrent::ThreadPoolExecutor the chunk helpers take.
+ */
+class TestExecutor {
+public:
+    explicit TestExecutor(std::size_t thread_count) {
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            threads_.emplace_back([this]() { run(); });
+        }
+    }
+
+    ~TestExecutor() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_all();
+        for (auto &thread : threads_) thread.join();
+    }
+
+    std::future<void> submit(std::function<void()> function) {
+        std::packaged_task<void()> task(std::move(function));
+        auto future = task.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        condition_.notify_one();
+        return future;
+    }
+
+private:
+    void run() {
+        while (true) {
+            std::packaged_task<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock, [&]() { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::packaged_task<void()>> tasks_;
+    bool stopping_{false};
+    std::vector<std::thread> threads_;
+};
+
+#endif
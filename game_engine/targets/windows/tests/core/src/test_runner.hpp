@@ -0,0 +1,106 @@
+#ifndef NODEC_GAME_ENGINE_CORE_TESTS__TEST_RUNNER_HPP_
+#define NODEC_GAME_ENGINE_CORE_TESTS__TEST_RUNNER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The minimal runner of the engine core tests.
+ *
+ * TEST_CASE registers a test run by default. BENCHMARK registers a timing run only with --benchmark.
+ * A failed CHECK is reported and the test goes on, so one run lists every failure.
+ */
+namespace test_runner {
+
+struct TestCase {
+    const char *name;
+    void (*function)();
+    bool is_benchmark;
+};
+
+inline std::vector<TestCase> &test_cases() {
+    static std::vector<TestCase> test_cases;
+    return test_cases;
+}
+
+inline int &failure_count() {
+    static int count = 0;
+    return count;
+}
+
+struct Registrar {
+    Registrar(const char *name, void (*function)(), bool is_benchmark) {
+        test_cases().push_back({name, function, is_benchmark});
+    }
+};
+
+inline void fail(const char *file, int line, const char *expression) {
+    std::printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+    ++failure_count();
+}
+
+/**
+ * @brief Runs the function the times, and prints the average time of a run.
+ *
+ * @return The average microseconds.
+ */
+template<typename Function>
+double measure(const std::string &label, int iterations, Function &&function) {
+    function(); // Warm up the caches and the allocations.
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        function();
+    }
+    const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    const auto average = elapsed / iterations;
+    std::printf("  %-56s %12.1f us\n", label.c_str(), average);
+    return average;
+}
+
+/**
+ * @brief Keeps the result of the benchmarked code from being optimized away.
+ */
+template<typename T>
+void do_not_optimize(const T &value) {
+    static const void *volatile sink;
+    sink = &value;
+    // The address escaped, so the value must be in memory at the fence.
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+} // namespace test_runner
+
+#define TEST_RUNNER_CONCAT_IMPL(a, b) a##b
+#define TEST_RUNNER_CONCAT(a, b) TEST_RUNNER_CONCAT_IMPL(a, b)
+
+#define TEST_RUNNER_REGISTER(name, is_benchmark)                                                                       \
+    static void name();                                                                                                \
+    static const test_runner::Registrar TEST_RUNNER_CONCAT(name, _registrar)(#name, name, is_benchmark);                \
+    static void name()
+
+#define TEST_CASE(name) TEST_RUNNER_REGISTER(name, false)
+#define BENCHMARK(name) TEST_RUNNER_REGISTER(name, true)
+
+#define CHECK(expression)                                                                                              \
+    do {                                                                                                               \
+        if (!(expression)) test_runner::fail(__FILE__, __LINE__, #expression);                                         \
+    } while (false)
+
+#define CHECK_THROWS(expression)                                                                                       \
+    do {                                                                                                               \
+        bool thrown = false;                                                                                           \
+        try {                                                                                                          \
+            expression;                                                                                                \
+        } catch (...) {                                                                                                \
+            thrown = true;                                                                                             \
+        }                                                                                                              \
+        if (!thrown) test_runner::fail(__FILE__, __LINE__, "throws " #expression);                                     \
+    } while (false)
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @brief Bakes the SDF atlas of a font, so that the engine draws its common characters without FreeType.
+ *
+ * Usage:
+ *   nodec_font_sdf_baker <font> [options]
+ *
+ * Options:
+ *   --output <path>       The output file. Defaults to "<font>.sdf", which the engine loads with the font.
+ *   --pixel-size <n>      The pixel size to bake at. Defaults to 48.
+ *   --spread <n>          The distance range in pixels at the pixel size. Defaults to 6.
+ *   --atlas-size <n>      The width and height of the atlas. Defaults to 1024.
+ *   --ranges <ranges>     The code point ranges like "0x20-0x7E,0x3000-0x30FF", clamped to 0x10FFFF.
+ *                         Defaults to the printable ASCII.
+ */
+
+#include <Font/FontFace.hpp>
+#include <Font/FontLibrary.hpp>
+#include <Font/SdfGlyphBaker.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+//! The last code point of Unicode.
+constexpr unsigned long MAX_CODE_POINT = 0x10FFFF;
+
+std::vector<std::uint32_t> parse_ranges(const std::string &text) {
+    std::vector<std::uint32_t> codes;
+
+    std::istringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty()) continue;
+
+        const auto separator = range.find('-');
+        const auto first = std::stoul(range.substr(0, separator), nullptr, 0);
+        const auto last = separator == std::string::npos
+                              ? first
+                              : std::stoul(range.substr(separator + 1), nullptr, 0);
+        if (last < first) {
+            throw std::invalid_argument("The range is reversed: " + range);
+        }
+        if (first > MAX_CODE_POINT) {
+            throw std::out_of_range("The range is beyond U+10FFFF: " + range);
+        }
+
+        // Clamped to the code points, so the code never wraps around.
+        const auto clamped_last = static_cast<std::uint32_t>((std::min)(last, MAX_CODE_POINT));
+        for (auto code = static_cast<std::uint32_t>(first); code <= clamped_last; ++code) {
+            codes.push_back(code);
+        }
+    }
+    return codes;
+}
+
+int print_usage() {
+    std::cerr << "Usage: nodec_font_sdf_baker <font> [--output <path>] [--pixel-size <n>] [--spread <n>]"
+                 " [--atlas-size <n>] [--ranges <ranges>]"
+              << std::endl;
+    return EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) return print_usage();
+
+    const std::string font_path = argv[1];
+    std::string output_path = font_path + ".sdf";
+    int pixel_size = 48;
+    int spread = 6;
+    int atlas_size = 1024;
+    std::string ranges = "0x20-0x7E";
+
+    try {
+        for (int i = 2; i < argc; ++i) {
+            const std::string option = argv[i];
+            if (i + 1 >= argc) return print_usage();
+            const std::string value = argv[++i];
+
+            if (option == "--output") {
+                output_path = value;
+            } else if (option == "--pixel-size") {
+                pixel_size = std::stoi(value);
+            } else if (option == "--spread") {
+                spread = std::stoi(value);
+            } else if (option == "--atlas-size") {
+                atlas_size = std::stoi(value);
+            } else if (option == "--ranges") {
+                ranges = value;
+            } else {
+                return print_usage();
+            }
+        }
+
+        if (pixel_size <= 0 || pixel_size > 1024 || spread <= 0 || spread > 64
+            || atlas_size <= 0 || atlas_size > 16384) {
+            std::cerr << "The pixel size, the spread or the atlas size is out of range." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        FontLibrary library;
+        FontFace face(library.GetLibrary(), font_path);
+
+        SdfGlyphBaker baker(face.GetFace(), static_cast<std::uint16_t>(pixel_size), static_cast<std::uint16_t>(spread));
+        const auto font = baker.bake(parse_ranges(ranges),
+                                     static_cast<std::uint16_t>(atlas_size), static_cast<std::uint16_t>(atlas_size));
+
+        std::ofstream file(output_path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Failed to open the output. path: " << output_path << std::endl;
+            return EXIT_FAILURE;
+        }
+        write_sdf_font(file, font);
+
+        std::cout << "Baked " << font.glyphs.size() << " glyphs into " << output_path << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+/**
+ * @brief Packs a resource directory into one archive, so that the engine reads the resources without opening each file.
+ *
+ * Usage:
+ *   nodec_resource_packer <resource-dir> [options]
+ *
+ * Options:
+ *   --output <path>       The output file. Defaults to "<resource-dir>.nodecpack", which the engine mounts.
+ *   --no-compress         Stores every file as is. By default, the files LZ4 shrinks by 10% or more are compressed.
+ *
+ * The engine reads a loose file still in the resource directory before its packed copy,
+ * so the shipped build has the archive without the directory.
+ */
+
+#include <resources/resource_archive.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<char> read_file(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Failed to open the file. path: " + path.u8string());
+    }
+
+    std::vector<char> data(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+        throw std::runtime_error("Failed to read the file. path: " + path.u8string());
+    }
+    return data;
+}
+
+int print_usage() {
+    std::cerr << "Usage: nodec_resource_packer <resource-dir> [--output <path>] [--no-compress]" << std::endl;
+    return EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    namespace fs = std::filesystem;
+
+    if (argc < 2) return print_usage();
+
+    std::string resource_dir = argv[1];
+    while (resource_dir.size() > 1 && (resource_dir.back() == '/' || resource_dir.back() == '\\')) {
+        resource_dir.pop_back();
+    }
+    std::string output_path = resource_dir + ".nodecpack";
+    bool compress = true;
+
+    for (int i = 2; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--no-compress") {
+            compress = false;
+        } else if (option == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else {
+            return print_usage();
+        }
+    }
+
+    try {
+        const auto root = fs::u8path(resource_dir);
+        if (!fs::is_directory(root)) {
+            std::cerr << "Not a directory. path: " << resource_dir << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // Sorted, so that the same directory packs into the same archive.
+        std::vector<fs::path> files;
+        for (const auto &entry : fs::recursive_directory_iterator(root)) {
+            if (entry.is_regular_file()) files.push_back(entry.path());
+        }
+        std::sort(files.begin(), files.end());
+
+        std::ofstream output(fs::u8path(output_path), std::ios::binary);
+        if (!output) {
+            std::cerr << "Failed to open the output. path: " << output_path << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        resource_archive::ArchiveWriter writer(output);
+        std::uint64_t total_bytes = 0;
+        std::uint64_t stored_bytes = 0;
+        for (const auto &path : files) {
+            // The names are the paths the engine asks for, relative to the resource directory.
+            const auto name = path.lexically_relative(root).generic_u8string();
+            const auto data = read_file(path);
+
+            total_bytes += data.size();
+            stored_bytes += writer.add(name, data.data(), data.size(), compress);
+        }
+        writer.finish();
+
+        std::cout << "Packed " << writer.entry_count() << " files (" << total_bytes << " bytes, "
+                  << stored_bytes << " bytes stored) into " << output_path << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
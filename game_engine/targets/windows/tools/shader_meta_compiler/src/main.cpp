@@ -0,0 +1,103 @@
+/**
+ * @brief Compiles the JSON metas of the shaders into the binary descriptors the engine loads without parsing.
+ *
+ * Every directory with a shader.meta under the resource directory gets a shader.meta.bin next to it.
+ * The descriptor keeps the hash of the metas. While the metas differ from it, the engine reads them instead
+ * and warns, so run this again after editing the metas.
+ *
+ * Usage:
+ *   nodec_shader_meta_compiler <resource-dir> [options]
+ *
+ * Options:
+ *   --remove              Removes the descriptors instead, so that the engine reads the metas again.
+ */
+
+#include <rendering/shader_descriptor.hpp>
+#include <rendering/shader_meta.hpp>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int print_usage() {
+    std::cerr << "Usage: nodec_shader_meta_compiler <resource-dir> [--remove]" << std::endl;
+    return EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    namespace fs = std::filesystem;
+
+    if (argc < 2) return print_usage();
+
+    const std::string resource_dir = argv[1];
+    bool remove = false;
+
+    for (int i = 2; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--remove") {
+            remove = true;
+        } else {
+            return print_usage();
+        }
+    }
+
+    try {
+        const auto root = fs::u8path(resource_dir);
+        if (!fs::is_directory(root)) {
+            std::cerr << "Not a directory. path: " << resource_dir << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::vector<fs::path> shader_dirs;
+        for (const auto &entry : fs::recursive_directory_iterator(root)) {
+            if (entry.is_regular_file() && entry.path().filename() == "shader.meta") {
+                shader_dirs.push_back(entry.path().parent_path());
+            }
+        }
+
+        int failed_count = 0;
+        for (const auto &shader_dir : shader_dirs) {
+            const auto output_path = shader_dir / shader_descriptor::FILE_NAME;
+
+            if (remove) {
+                fs::remove(output_path);
+                continue;
+            }
+
+            try {
+                const auto descriptor = shader_meta::compile_shader_meta([&](const std::string &name) -> std::unique_ptr<std::istream> {
+                    auto file = std::make_unique<std::ifstream>(shader_dir / fs::u8path(name), std::ios::binary);
+                    if (!*file) return nullptr;
+                    return file;
+                });
+
+                std::ofstream output(output_path, std::ios::binary);
+                if (!output) {
+                    throw std::runtime_error("Failed to open the output. path: " + output_path.u8string());
+                }
+                shader_descriptor::write_shader_descriptor(output, descriptor);
+            } catch (const std::exception &e) {
+                // The others are still compiled. The engine reads the metas of the failed one.
+                std::cerr << shader_dir.u8string() << ": " << e.what() << std::endl;
+                fs::remove(output_path);
+                ++failed_count;
+            }
+        }
+
+        std::cout << (remove ? "Removed the descriptors of " : "Compiled ")
+                  << shader_dirs.size() - failed_count << " shaders" << std::endl;
+        if (failed_count > 0) return EXIT_FAILURE;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}